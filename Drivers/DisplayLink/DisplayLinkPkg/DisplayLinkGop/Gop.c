@@ -69,6 +69,27 @@ CheckBounds (
   return EFI_SUCCESS;
 }
 
+/**
+ * Extend the area of the screen that is "dirty" - that we need to send in the next screen update.
+ * @param UsbDisplayLinkDev
+ * @param Y               First line that has changed
+ * @param Height          Number of lines that have changed
+ */
+STATIC VOID
+MarkLinesDirty (
+  IN  USB_DISPLAYLINK_DEV                     *UsbDisplayLinkDev,
+  IN  UINTN                                   Y,
+  IN  UINTN                                   Height
+)
+{
+  if (Y < UsbDisplayLinkDev->LastY1) {
+    UsbDisplayLinkDev->LastY1 = Y;
+  }
+  if ((Y + Height) > UsbDisplayLinkDev->LastY2) {
+    UsbDisplayLinkDev->LastY2 = Y + Height;
+  }
+}
+
 /**
  * Update the local copy of the Frame Buffer. This local copy is periodically transmitted to the
  * DisplayLink device (via DlGopSendScreenUpdate)
@@ -100,76 +121,108 @@ BuildBackBuffer (
 )
 {
   UINTN H;
-  UINTN W;
+  UINTN RowBytes;
+  UINTN ScreenStride;
+
+  RowBytes = Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+  ScreenStride = PixelsPerScanLine * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+
+  // Whole rows are copied with CopyMem/SetMem32 rather than a pixel at a time. The driver itself
+  // uses no vector instructions; any such speed-up comes from the BaseMemoryLib instance the
+  // platform selects. When both sides are fully packed the whole rectangle is one operation.
   switch (BltOperation) {
   case EfiBltVideoToBltBuffer:
   {
-    EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Blt;
-    EFI_GRAPHICS_OUTPUT_BLT_PIXEL* SrcB;
-    Blt = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL*)((UINT8 *)BltBuffer + (DestinationY * BltBufferStride) + DestinationX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
-    SrcB = UsbDisplayLinkDev->Screen + SourceY * PixelsPerScanLine + SourceX;
+    UINT8* Blt;
+    UINT8* SrcB;
+    Blt = (UINT8 *)BltBuffer + (DestinationY * BltBufferStride) + DestinationX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+    SrcB = (UINT8 *)(UsbDisplayLinkDev->Screen + SourceY * PixelsPerScanLine + SourceX);
+
+    if ((BltBufferStride == RowBytes) && (ScreenStride == RowBytes)) {
+      CopyMem (Blt, SrcB, RowBytes * Height);
+      break;
+    }
 
     for (H = 0; H < Height; H++) {
-      for (W = 0; W < Width; W++) {
-        Blt[W] = *SrcB++;
-      }
-      Blt = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL*)(((UINT8*)Blt) + BltBufferStride);
-      SrcB += PixelsPerScanLine - Width;
+      CopyMem (Blt, SrcB, RowBytes);
+      Blt += BltBufferStride;
+      SrcB += ScreenStride;
     }
   }
   break;
 
   case EfiBltBufferToVideo:
   {
-    // Update the store of the area of the screen that is "dirty" - that we need to send in the next screen update.
-    if (DestinationY < UsbDisplayLinkDev->LastY1) {
-      UsbDisplayLinkDev->LastY1 = DestinationY;
-    }
-    if ((DestinationY + Height) > UsbDisplayLinkDev->LastY2) {
-      UsbDisplayLinkDev->LastY2 = DestinationY + Height;
-    }
+    MarkLinesDirty (UsbDisplayLinkDev, DestinationY, Height);
+
+    UINT8* Blt;
+    UINT8* DstB;
+    Blt = (UINT8 *)BltBuffer + (SourceY * BltBufferStride) + SourceX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+    DstB = (UINT8 *)(UsbDisplayLinkDev->Screen + DestinationY * PixelsPerScanLine + DestinationX);
 
-    EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Blt;
-    EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
-    Blt = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *)(((UINT8 *)BltBuffer) + (SourceY * BltBufferStride) + SourceX * sizeof *Blt);
-    DstB = UsbDisplayLinkDev->Screen + DestinationY * PixelsPerScanLine + DestinationX;
+    if ((BltBufferStride == RowBytes) && (ScreenStride == RowBytes)) {
+      CopyMem (DstB, Blt, RowBytes * Height);
+      break;
+    }
 
     for (H = 0; H < Height; H++) {
-      for (W = 0; W < Width; W++) {
-        *DstB++ = Blt[W];
-      }
-      Blt = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL*)(((UINT8*)Blt) + BltBufferStride);
-      DstB += PixelsPerScanLine - Width;
+      CopyMem (DstB, Blt, RowBytes);
+      Blt += BltBufferStride;
+      DstB += ScreenStride;
     }
   }
   break;
 
   case EfiBltVideoToVideo:
   {
-    EFI_GRAPHICS_OUTPUT_BLT_PIXEL* SrcB;
-    EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
-    SrcB = UsbDisplayLinkDev->Screen + SourceY * PixelsPerScanLine + SourceX;
-    DstB = UsbDisplayLinkDev->Screen + DestinationY * PixelsPerScanLine + DestinationX;
+    MarkLinesDirty (UsbDisplayLinkDev, DestinationY, Height);
+
+    UINT8* SrcB;
+    UINT8* DstB;
+    INTN   Step;
+    SrcB = (UINT8 *)(UsbDisplayLinkDev->Screen + SourceY * PixelsPerScanLine + SourceX);
+    DstB = (UINT8 *)(UsbDisplayLinkDev->Screen + DestinationY * PixelsPerScanLine + DestinationX);
+
+    if (ScreenStride == RowBytes) {
+      // CopyMem copes with overlapping buffers
+      CopyMem (DstB, SrcB, RowBytes * Height);
+      break;
+    }
+
+    // Moving the image down the screen: copy from the bottom row up, so that overlapping rows
+    // are read before they are overwritten.
+    Step = (INTN)ScreenStride;
+    if (DestinationY > SourceY) {
+      SrcB += (Height - 1) * ScreenStride;
+      DstB += (Height - 1) * ScreenStride;
+      Step = -Step;
+    }
 
     for (H = 0; H < Height; H++) {
-      for (W = 0; W < Width; W++) {
-        *DstB++ = *SrcB++;
-      }
-      SrcB += PixelsPerScanLine - Width;
-      DstB += PixelsPerScanLine - Width;
+      CopyMem (DstB, SrcB, RowBytes);
+      SrcB += Step;
+      DstB += Step;
     }
   }
   break;
 
   case EfiBltVideoFill:
   {
-    EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
-    DstB = UsbDisplayLinkDev->Screen + DestinationY * PixelsPerScanLine + DestinationX;
+    MarkLinesDirty (UsbDisplayLinkDev, DestinationY, Height);
+
+    UINT32 FillValue;
+    UINT8* DstB;
+    FillValue = *(UINT32 *)BltBuffer;
+    DstB = (UINT8 *)(UsbDisplayLinkDev->Screen + DestinationY * PixelsPerScanLine + DestinationX);
+
+    if (ScreenStride == RowBytes) {
+      SetMem32 (DstB, RowBytes * Height, FillValue);
+      break;
+    }
+
     for (H = 0; H < Height; H++) {
-      for (W = 0; W < Width; W++) {
-        *DstB++ = *BltBuffer;
-      }
-      DstB += PixelsPerScanLine - Width;
+      SetMem32 (DstB, RowBytes, FillValue);
+      DstB += ScreenStride;
     }
   }
   break;
@@ -252,7 +305,74 @@ DlGopSendTestPattern (
 
 
 /**
- * Transfer the latest copy of the Blt buffer over USB to the DisplayLink device
+ * Pack the red, green and blue bytes of a BGRX pixel into the low 24 bits of a UINT32, in the
+ * order that the DisplayLink device expects them on the wire.
+ */
+#define BGRX_TO_RGB(Pixel) \
+  ((((Pixel) >> 16) & 0xFF) | ((Pixel) & 0xFF00) | (((Pixel) & 0xFF) << 16))
+
+/**
+ * Convert one line of the back buffer into the RGB888 layout expected by the DisplayLink device.
+ *
+ * This is a portable scalar loop, there is no SSE2/NEON path. Four pixels are converted at a time
+ * into three 32-bit stores, which needs Dst to be 32-bit aligned; any remaining pixels are
+ * converted a byte at a time.
+ * @param Dst             Destination in the transfer buffer, 32-bit aligned
+ * @param Src             Source line in the back buffer
+ * @param Width           Number of pixels in the line
+ */
+STATIC VOID
+ConvertLineToRgb888 (
+    OUT UINT8                               *Dst,
+    IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Src,
+    IN  UINTN                               Width
+    )
+{
+  CONST UINT32 *Src32;
+  UINT32       *Dst32;
+  UINT32       P0;
+  UINT32       P1;
+  UINT32       P2;
+  UINT32       P3;
+  UINTN        W;
+
+  ASSERT (((UINTN)Dst & (sizeof (UINT32) - 1)) == 0);
+
+  Src32 = (CONST UINT32 *)Src;
+  Dst32 = (UINT32 *)Dst;
+
+  for (W = 0; W + 4 <= Width; W += 4) {
+    P0 = BGRX_TO_RGB (Src32[0]);
+    P1 = BGRX_TO_RGB (Src32[1]);
+    P2 = BGRX_TO_RGB (Src32[2]);
+    P3 = BGRX_TO_RGB (Src32[3]);
+    Dst32[0] = P0 | (P1 << 24);
+    Dst32[1] = (P1 >> 8) | (P2 << 16);
+    Dst32[2] = (P2 >> 16) | (P3 << 8);
+    Src32 += 4;
+    Dst32 += 3;
+  }
+
+  Src = (CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL *)Src32;
+  Dst = (UINT8 *)Dst32;
+
+  for (; W < Width; W++) {
+    // Need to swap round the RGB values
+    Dst[0] = Src->Red;
+    Dst[1] = Src->Green;
+    Dst[2] = Src->Blue;
+    Src++;
+    Dst += 3;
+  }
+}
+
+/**
+ * Transfer the latest copy of the Blt buffer over USB to the DisplayLink device.
+ *
+ * Only the lines that have been BLTted to since the last update are converted. The device fills
+ * its frame buffer from the top and has no way to address a start line, so the unchanged lines
+ * above the dirty area are resent from the (already converted) transfer buffer, but everything
+ * below the dirty area is skipped.
  * @param UsbDisplayLinkDev
  * @return
  */
@@ -263,83 +383,86 @@ DlGopSendScreenUpdate (
 {
   EFI_STATUS Status;
   UINT32 USBStatus;
+  EFI_TPL OriginalTPL;
+  UINTN Width;
+  UINTN Height;
+  UINTN LineLen;
+  UINTN LineStride;
+  UINTN FirstLine;
+  UINTN EndLine;
+  UINTN H;
+
   Status = EFI_SUCCESS;
 
+  if (UsbDisplayLinkDev->TransferBuffer == NULL) {
+    return EFI_NOT_READY;
+  }
+
+  Width = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution;
+  Height = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution;
+  LineLen = UsbDisplayLinkDev->TransferLineLength;
+  LineStride = UsbDisplayLinkDev->TransferLineStride;
+
+  // Lock so that we take a consistent snapshot of the dirty area and the back buffer.
+  OriginalTPL = gBS->RaiseTPL (TPL_NOTIFY);
+
   // If it has been a while since we sent an update, send a full screen.
   // This allows us to update a hot-plugged monitor quickly.
   if (UsbDisplayLinkDev->TimeSinceLastScreenUpdate > DISPLAYLINK_FULL_SCREEN_UPDATE_PERIOD) {
     UsbDisplayLinkDev->LastY1 = 0;
-    UsbDisplayLinkDev->LastY2 = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution - 1;
+    UsbDisplayLinkDev->LastY2 = Height;
   }
 
   // If there has been no BLT since the last update/poll, drop out quietly.
-  if (UsbDisplayLinkDev->LastY2 < UsbDisplayLinkDev->LastY1) {
+  if (UsbDisplayLinkDev->LastY2 <= UsbDisplayLinkDev->LastY1) {
     UsbDisplayLinkDev->TimeSinceLastScreenUpdate += (DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 1000);  // Convert us to ms
+    gBS->RestoreTPL (OriginalTPL);
     return EFI_SUCCESS;
   }
 
   UsbDisplayLinkDev->TimeSinceLastScreenUpdate = 0;
 
-  EFI_TPL OriginalTPL = gBS->RaiseTPL (TPL_NOTIFY);
+  FirstLine = UsbDisplayLinkDev->LastY1;
+  EndLine = MIN (UsbDisplayLinkDev->LastY2, Height);
 
-  UINTN DataLen;
-  UINTN Width;
-  UINTN Height;
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* SrcPtr;
-  UINT8* DstPtr;
-  UINT8 DstBuffer[1920 * 3]; // Get rid of the magic numbers at some point
-                             // Could also use a buffer allocated at runtime to store the line, stored in the USB_DISPLAYLINK_DEV structure.
-  UINTN H;
+  for (H = FirstLine; H < EndLine; H++) {
+    ConvertLineToRgb888 (
+      UsbDisplayLinkDev->TransferBuffer + H * LineStride,
+      UsbDisplayLinkDev->Screen + H * Width,
+      Width);
+  }
 
-  DataLen = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution * 3; // Send 1 line @ 24 bits per pixel
-  Width = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution;
-  Height = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution;
-  SrcPtr = UsbDisplayLinkDev->Screen;
-  DstPtr = DstBuffer;
-
-  for (H = 0; H < Height; H++) {
-    DstPtr = DstBuffer;
-
-    UINTN W;
-    for (W = 0; W < Width; W++) {
-      // Need to swap round the RGB values
-      DstPtr[0] = ((UINT8 *)SrcPtr)[2];
-      DstPtr[1] = ((UINT8 *)SrcPtr)[1];
-      DstPtr[2] = ((UINT8 *)SrcPtr)[0];
-      SrcPtr++;
-      DstPtr += 3;
-    }
+  // Any Blt from here on will be picked up by the next update.
+  UsbDisplayLinkDev->LastY2 = 0;
+  UsbDisplayLinkDev->LastY1 = (UINTN)-1;
+
+  gBS->RestoreTPL (OriginalTPL);
 
-    Status = DlUsbBulkWrite (UsbDisplayLinkDev, DstBuffer, DataLen, &USBStatus);
+  // The USB transfers work from the transfer buffer, so they do not need to hold off Blt.
+  // Each line needs a bulk transfer of its own: the device only tells lines apart by the short
+  // packet that ends every transfer, so adjacent dirty lines cannot be merged into one.
+  for (H = 0; H < EndLine; H++) {
+    Status = DlUsbBulkWrite (UsbDisplayLinkDev, UsbDisplayLinkDev->TransferBuffer + H * LineStride, LineLen, &USBStatus);
 
     // USBStatus values defined in usbio.h, e.g. EFI_USB_ERR_TIMEOUT 0x40
     if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "Screen update - USB bulk transfer of pixel data failed. Line %d len %d, failure code %r USB status x%x\n", H, DataLen, Status, USBStatus));
+      DEBUG ((DEBUG_ERROR, "Screen update - USB bulk transfer of pixel data failed. Line %d len %d, failure code %r USB status x%x\n", H, LineLen, Status, USBStatus));
       break;
     }
-    // Need an extra DlUsbBulkWrite if the data length is divisible by USB MaxPacketSize. This spare data will just get written into the (invisible) stride area.
-    // Note that the API doesn't let us do a bulk write of 0.
-    if ((DataLen & (UsbDisplayLinkDev->BulkOutEndpointDescriptor.MaxPacketSize - 1)) == 0) {
-      Status = DlUsbBulkWrite (UsbDisplayLinkDev, DstBuffer, 2, &USBStatus);
-      if (EFI_ERROR (Status)) {
-        DEBUG ((DEBUG_ERROR, "Screen update - USB bulk transfer of pixel data failed. Line %d len %d, failure code %r USB status x%x\n", H, DataLen, Status, USBStatus));
-        break;
-      }
-    }
+    UsbDisplayLinkDev->DataSent += LineLen;
   }
 
-  if (!EFI_ERROR (Status)) {
-    // If we've successfully transmitted the frame, reset the values that store which area of the screen has been BLTted to.
-    // If we haven't succeeded, this will mean we'll try to resend it after the next poll period.
-    UsbDisplayLinkDev->LastY2 = 0;
-    UsbDisplayLinkDev->LastY1 = (UINTN)-1;
+  if (EFI_ERROR (Status)) {
+    // If we haven't succeeded, mark the lines we converted as dirty again so that we try to resend
+    // them after the next poll period.
+    OriginalTPL = gBS->RaiseTPL (TPL_NOTIFY);
+    MarkLinesDirty (UsbDisplayLinkDev, FirstLine, EndLine - FirstLine);
+    gBS->RestoreTPL (OriginalTPL);
   }
 
   // Payload with length of 1 to terminate the frame
   // We need to do this even if we had an error, to indicate to the DL device that it should now expect a new frame.
-  DlUsbBulkWrite (UsbDisplayLinkDev, DstBuffer, 1, &USBStatus);
-
-  gBS->RestoreTPL (OriginalTPL);
+  DlUsbBulkWrite (UsbDisplayLinkDev, UsbDisplayLinkDev->TransferBuffer, 1, &USBStatus);
 
   return Status;
 }
@@ -486,6 +609,34 @@ DisplayLinkSetMode (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  //
+  // Allocate the transfer buffer. Each line is sent in a single bulk transfer @ 24 bits per pixel.
+  // If the line length is divisible by the USB MaxPacketSize the device would not see a short packet
+  // at the end of the line, so pad the line with 2 extra bytes. This spare data will just get written
+  // into the (invisible) stride area. Note that the API doesn't let us do a bulk write of 0.
+  //
+  if (UsbDisplayLinkDev->TransferBuffer != NULL) {
+    FreePool (UsbDisplayLinkDev->TransferBuffer);
+  }
+
+  UsbDisplayLinkDev->TransferLineLength = Gop->Mode->Info->HorizontalResolution * 3;
+  if ((UsbDisplayLinkDev->TransferLineLength & (UsbDisplayLinkDev->BulkOutEndpointDescriptor.MaxPacketSize - 1)) == 0) {
+    UsbDisplayLinkDev->TransferLineLength += 2;
+  }
+
+  // Keep each line 32-bit aligned for the pixel conversion
+  UsbDisplayLinkDev->TransferLineStride = ALIGN_VALUE (UsbDisplayLinkDev->TransferLineLength, sizeof (UINT32));
+
+  UsbDisplayLinkDev->TransferBuffer = (UINT8*)AllocateZeroPool (
+    UsbDisplayLinkDev->TransferLineStride *
+    Gop->Mode->Info->VerticalResolution);
+
+  if (UsbDisplayLinkDev->TransferBuffer == NULL) {
+    FreePool (UsbDisplayLinkDev->Screen);
+    UsbDisplayLinkDev->Screen = NULL;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
   DEBUG ((DEBUG_INFO, "Video mode %d selected by BIOS - %d x %d.\n", ModeNumber, VideoMode->HActive, VideoMode->VActive));
   // Wait until we are sure that we can set the video mode before we tell the firmware
   Status = DlUsbSendControlWriteMessage (UsbDisplayLinkDev, SET_VIDEO_MODE, 0, VideoMode, sizeof (struct VideoMode));
@@ -496,6 +647,8 @@ DisplayLinkSetMode (
     Gop->Mode->Mode = GRAPHICS_OUTPUT_INVALID_MODE_NUMBER;
     FreePool (UsbDisplayLinkDev->Screen);
     UsbDisplayLinkDev->Screen = NULL;
+    FreePool (UsbDisplayLinkDev->TransferBuffer);
+    UsbDisplayLinkDev->TransferBuffer = NULL;
   } else {
     BuildBackBuffer (
       UsbDisplayLinkDev,
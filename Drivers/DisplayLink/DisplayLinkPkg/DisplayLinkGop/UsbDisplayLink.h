@@ -80,13 +80,16 @@ typedef struct {
   EFI_EDID_ACTIVE_PROTOCOL      EdidActive;
   EFI_UNICODE_STRING_TABLE      *ControllerNameTable;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Screen;
+  UINT8                         *TransferBuffer;               /** RGB888 copy of Screen, one TransferLineStride slot per line */
+  UINTN                         TransferLineLength;            /** Bytes sent per line, including any short-packet padding */
+  UINTN                         TransferLineStride;            /** Offset between lines in TransferBuffer */
   UINTN                         DataSent;                       /** Debug - used to track the bandwidth */
   EFI_EVENT                     TimerEvent;
   EFI_EVENT                     DriverExitBootServicesEvent;
   BOOLEAN                       ShowBandwidth;                 /** Debugging - show the bandwidth on the screen */
   BOOLEAN                       ShowTestPattern;               /** Show a colourbar pattern instead of the BLTd contents of the framebuffer */
-  UINTN                         LastY1;                        /** Used to track if we can do a partial screen update */
-  UINTN                         LastY2;
+  UINTN                         LastY1;                        /** First dirty line since the last screen update */
+  UINTN                         LastY2;                        /** Line after the last dirty line (exclusive) */
   UINTN                         LastWidth;
   UINTN                         TimeSinceLastScreenUpdate;     /** Do a full screen update every (x) seconds */
 } USB_DISPLAYLINK_DEV;
@@ -110,6 +110,230 @@ ReadWriteRpmb (
   return Status;
 }
 
+/**
+  Write all the pending dirty ranges of the memory copy to the RPMB partition.
+
+  Ranges are written oldest first, so the order in which the upper layers
+  (variable driver, FTW) updated different parts of the store is preserved
+  on the device.
+
+  @param[in,out] Instance        MEM_INSTANCE pointer describing the device
+
+  @retval EFI_SUCCESS            All pending ranges have been written
+  @retval Others                 The write of a range failed. That range and
+                                 all younger ones are still pending.
+**/
+STATIC
+EFI_STATUS
+FlushDirtyRanges (
+  IN OUT MEM_INSTANCE *Instance
+  )
+{
+  RPMB_DIRTY_RANGE *Range;
+  EFI_STATUS       Status;
+  UINTN            Index;
+
+  Status = EFI_SUCCESS;
+  for (Index = 0; Index < Instance->NDirtyRanges; Index++) {
+    Range = &Instance->DirtyRanges[Index];
+    Status = ReadWriteRpmb (
+               SP_SVC_RPMB_WRITE,
+               (UINTN)Instance->MemBaseAddress + Range->Offset,
+               Range->Length,
+               Range->Offset
+               );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    Instance->RpmbWrites++;
+  }
+
+  // Drop the ranges that made it to the device
+  Instance->NDirtyRanges -= Index;
+  CopyMem (
+    Instance->DirtyRanges,
+    &Instance->DirtyRanges[Index],
+    Instance->NDirtyRanges * sizeof (RPMB_DIRTY_RANGE)
+    );
+
+  DEBUG ((DEBUG_VERBOSE, "%a: %Lu FVB updates, %Lu RPMB writes, %Lu avoided\n",
+    __FUNCTION__, (UINT64)Instance->FvbUpdates, (UINT64)Instance->RpmbWrites,
+    (UINT64)(Instance->FvbUpdates - Instance->RpmbWrites)));
+
+  return Status;
+}
+
+/**
+  Check whether a part of the memory copy is in the erased (all 1s) state.
+
+  @param[in] Instance        MEM_INSTANCE pointer describing the device
+  @param[in] Offset          Offset of the area into the FV
+  @param[in] Length          Length of the area
+
+  @retval TRUE               Every byte of the area reads as 0xFF
+  @retval FALSE              At least one bit has been programmed
+**/
+STATIC
+BOOLEAN
+IsErased (
+  IN MEM_INSTANCE *Instance,
+  IN UINTN        Offset,
+  IN UINTN        Length
+  )
+{
+  UINT8 *Ptr;
+
+  Ptr = (UINT8 *)(UINTN)Instance->MemBaseAddress + Offset;
+  while (Length-- > 0) {
+    if (*Ptr++ != 0xFF) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+  Apply a write or erase to the memory copy and record it as dirty.
+
+  Updates are merged into the youngest pending range when they extend it, or
+  when they only program bytes of it that are still erased. Any update that
+  would overwrite a pending programmed byte, or that touches an older range,
+  flushes the pending ranges first. This way every intermediate state that
+  the variable driver relies on for fault tolerance (e.g. the
+  VAR_HEADER_VALID_ONLY -> VAR_ADDED state transition) still reaches the
+  device, and in order.
+
+  @param[in,out] Instance        MEM_INSTANCE pointer describing the device
+  @param[in]     Offset          Offset into the FV of the update
+  @param[in]     Buffer          Data to write, or NULL to erase the range
+  @param[in]     Length          Number of bytes to update
+
+  @retval EFI_SUCCESS            The memory copy has been updated
+  @retval Others                 A flush failed. If it was needed to overwrite
+                                 pending data the memory copy has not been
+                                 updated, otherwise it has and the update is
+                                 still recorded as dirty.
+**/
+STATIC
+EFI_STATUS
+UpdateMemoryCopy (
+  IN OUT MEM_INSTANCE *Instance,
+  IN     UINTN        Offset,
+  IN     CONST UINT8  *Buffer,  OPTIONAL
+  IN     UINTN        Length
+  )
+{
+  RPMB_DIRTY_RANGE *Range;
+  EFI_STATUS       Status;
+  UINTN            Index;
+  UINTN            Start;
+  UINTN            End;
+  BOOLEAN          NeedFlush;
+
+  NeedFlush = FALSE;
+  for (Index = 0; Index < Instance->NDirtyRanges && !NeedFlush; Index++) {
+    Range = &Instance->DirtyRanges[Index];
+    Start = MAX (Offset, Range->Offset);
+    End   = MIN (Offset + Length, Range->Offset + Range->Length);
+    if (Start >= End) {
+      continue;
+    }
+    if (Index != Instance->NDirtyRanges - 1 ||
+        !IsErased (Instance, Start, End - Start)) {
+      NeedFlush = TRUE;
+    }
+  }
+
+  if (NeedFlush) {
+    Status = FlushDirtyRanges (Instance);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  if (Buffer != NULL) {
+    CopyMem ((UINT8 *)(UINTN)Instance->MemBaseAddress + Offset, Buffer, Length);
+  } else {
+    SetMem ((UINT8 *)(UINTN)Instance->MemBaseAddress + Offset, Length, 0xFF);
+  }
+  Instance->FvbUpdates++;
+
+  if (Instance->NDirtyRanges > 0) {
+    Range = &Instance->DirtyRanges[Instance->NDirtyRanges - 1];
+    if (Offset <= Range->Offset + Range->Length &&
+        Offset + Length >= Range->Offset) {
+      Start = MIN (Offset, Range->Offset);
+      End   = MAX (Offset + Length, Range->Offset + Range->Length);
+      Range->Offset = Start;
+      Range->Length = End - Start;
+      return EFI_SUCCESS;
+    }
+  }
+
+  Status = EFI_SUCCESS;
+  if (Instance->NDirtyRanges == RPMB_MAX_DIRTY_RANGES) {
+    Status = FlushDirtyRanges (Instance);
+  }
+
+  if (Instance->NDirtyRanges == RPMB_MAX_DIRTY_RANGES) {
+    // The flush failed but the memory copy already holds the new data, so
+    // the update must stay pending. Widen the youngest range to cover it:
+    // the bytes in between are rewritten too, but they only hold what the
+    // older ranges or the device already have.
+    Range = &Instance->DirtyRanges[Instance->NDirtyRanges - 1];
+    Start = MIN (Offset, Range->Offset);
+    End   = MAX (Offset + Length, Range->Offset + Range->Length);
+    Range->Offset = Start;
+    Range->Length = End - Start;
+    return Status;
+  }
+
+  Range = &Instance->DirtyRanges[Instance->NDirtyRanges++];
+  Range->Offset = Offset;
+  Range->Length = Length;
+
+  return Status;
+}
+
+/**
+  Root MMI handler, called by the MM core after the handler of every MM
+  communication has run. This is where the updates of a SetVariable() call,
+  a variable reclaim or an ExitBootServices notification of the variable
+  driver are written to the RPMB partition, merged into as few requests as
+  possible.
+
+  @param[in]     DispatchHandle  The unique handle assigned to this handler
+  @param[in]     Context         Unused
+  @param[in,out] CommBuffer      Unused
+  @param[in,out] CommBufferSize  Unused
+
+  @retval EFI_INTERRUPT_PENDING  This handler does not service an interrupt
+                                 source.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+OpTeeRpmbFvbFlushHandler (
+  IN     EFI_HANDLE  DispatchHandle,
+  IN     CONST VOID  *Context,        OPTIONAL
+  IN OUT VOID        *CommBuffer,     OPTIONAL
+  IN OUT UINTN       *CommBufferSize  OPTIONAL
+  )
+{
+  EFI_STATUS Status;
+
+  if (mInstance.NDirtyRanges > 0) {
+    Status = FlushDirtyRanges (&mInstance);
+    if (EFI_ERROR (Status)) {
+      // The ranges stay pending and are retried on the next MMI
+      DEBUG ((DEBUG_ERROR, "%a: Failed to flush %Lu range(s) - %r\n",
+        __FUNCTION__, (UINT64)mInstance.NDirtyRanges, Status));
+    }
+  }
+
+  return EFI_INTERRUPT_PENDING;
+}
+
 /**
   The GetAttributes() function retrieves the attributes and
   current settings of the block.
@@ -379,7 +603,6 @@ OpTeeRpmbFvbWrite (
 {
   MEM_INSTANCE *Instance;
   EFI_STATUS   Status;
-  VOID         *Base;
 
   Instance = INSTANCE_FROM_FVB_THIS (This);
   if (!Instance->Initialized) {
@@ -388,20 +611,14 @@ OpTeeRpmbFvbWrite (
       return Status;
     }
   }
-  Base = (VOID *)(UINTN)Instance->MemBaseAddress + (Lba * Instance->BlockSize) +
-         Offset;
-  Status = ReadWriteRpmb (
-             SP_SVC_RPMB_WRITE,
-             (UINTN)Buffer,
-             *NumBytes,
-             (Lba * Instance->BlockSize) + Offset
-             );
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
 
-  // Update the memory copy
-  CopyMem (Base, Buffer, *NumBytes);
+  // Update the memory copy. The RPMB is written when the current MMI completes.
+  Status = UpdateMemoryCopy (
+             Instance,
+             (Lba * Instance->BlockSize) + Offset,
+             Buffer,
+             *NumBytes
+             );
 
   return Status;
 }
@@ -460,51 +677,48 @@ OpTeeRpmbFvbErase (
   )
 {
   MEM_INSTANCE *Instance;
-  UINTN   NumBytes;
   UINTN   NumLba;
   EFI_LBA Start;
-  VOID    *Base;
-  VOID    *Buf;
   VA_LIST Args;
   EFI_STATUS Status;
 
   Instance = INSTANCE_FROM_FVB_THIS (This);
 
+  // The whole list has to be verified before erasing any blocks
   VA_START (Args, This);
   for (Start = VA_ARG (Args, EFI_LBA);
        Start != EFI_LBA_LIST_TERMINATOR;
        Start = VA_ARG (Args, EFI_LBA)) {
     NumLba = VA_ARG (Args, UINTN);
     if (NumLba == 0 || Start + NumLba > Instance->NBlocks) {
+      VA_END (Args);
       return EFI_INVALID_PARAMETER;
     }
-    NumBytes = NumLba * Instance->BlockSize;
-    Base = (VOID *)(UINTN)Instance->MemBaseAddress +
-           (Start * Instance->BlockSize);
-    Buf = AllocatePool (NumLba * Instance->BlockSize);
-    if (Buf == NULL) {
-      return EFI_DEVICE_ERROR;
-    }
-    SetMem64 (Buf, NumLba * Instance->BlockSize, ~0UL);
-    // Write the device
-    Status = ReadWriteRpmb (
-               SP_SVC_RPMB_WRITE,
-               (UINTN)Buf,
-               NumBytes,
-               Start * Instance->BlockSize
+  }
+  VA_END (Args);
+
+  Status = EFI_SUCCESS;
+  VA_START (Args, This);
+  for (Start = VA_ARG (Args, EFI_LBA);
+       Start != EFI_LBA_LIST_TERMINATOR;
+       Start = VA_ARG (Args, EFI_LBA)) {
+    NumLba = VA_ARG (Args, UINTN);
+    // Update the in memory copy. The RPMB is written when the current MMI
+    // completes.
+    Status = UpdateMemoryCopy (
+               Instance,
+               Start * Instance->BlockSize,
+               NULL,
+               NumLba * Instance->BlockSize
                );
     if (EFI_ERROR (Status)) {
-      FreePool (Buf);
-      return Status;
+      break;
     }
-    // Update the in memory copy
-    SetMem64 (Base, NumLba * Instance->BlockSize, ~0UL);
-    FreePool (Buf);
   }
 
   VA_END (Args);
 
-  return EFI_SUCCESS;
+  return Status;
 }
 
 /**
@@ -812,6 +1026,7 @@ OpTeeRpmbFvbInit (
   VOID         *Addr;
   UINTN        FvLength;
   UINTN        NBlocks;
+  EFI_HANDLE   DispatchHandle;
 
   FvLength = PcdGet32 (PcdFlashNvStorageVariableSize) +
              PcdGet32 (PcdFlashNvStorageFtwWorkingSize) +
@@ -853,6 +1068,14 @@ OpTeeRpmbFvbInit (
     PcdGet32 (PcdFlashNvStorageFtwWorkingSize)
     );
 
+  // Register a root MMI handler to write the updates of each MMI to the RPMB
+  Status = gMmst->MmiHandlerRegister (
+                    OpTeeRpmbFvbFlushHandler,
+                    NULL,
+                    &DispatchHandle
+                    );
+  ASSERT_EFI_ERROR (Status);
+
   Status = gMmst->MmInstallProtocolInterface (
                     &mInstance.Handle,
                     &gEfiSmmFirmwareVolumeBlockProtocolGuid,
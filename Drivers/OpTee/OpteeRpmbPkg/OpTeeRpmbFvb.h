@@ -32,6 +32,18 @@
 #define INSTANCE_FROM_FVB_THIS(a)  CR (a, MEM_INSTANCE, FvbProtocol, \
                                       FLASH_SIGNATURE)
 
+// Maximum number of separate dirty ranges held before a flush is forced
+#define RPMB_MAX_DIRTY_RANGES      8
+
+/**
+  A range of the in-memory copy that has been updated but not yet written
+  to the RPMB partition. Offset is relative to the start of the FV.
+**/
+typedef struct {
+  UINTN                               Offset;
+  UINTN                               Length;
+} RPMB_DIRTY_RANGE;
+
 typedef struct _MEM_INSTANCE         MEM_INSTANCE;
 typedef EFI_STATUS (*MEM_INITIALIZE) (MEM_INSTANCE* Instance);
 
@@ -58,6 +70,14 @@ struct _MEM_INSTANCE
     UINT16                              BlockSize;
     /// Number of allocated blocks
     UINT16                              NBlocks;
+    /// Ranges of the memory copy pending a write to the RPMB, oldest first
+    RPMB_DIRTY_RANGE                    DirtyRanges[RPMB_MAX_DIRTY_RANGES];
+    /// Number of valid entries in DirtyRanges
+    UINTN                               NDirtyRanges;
+    /// Number of FVB write/erase requests applied to the memory copy
+    UINTN                               FvbUpdates;
+    /// Number of write requests sent to the storage SP
+    UINTN                               RpmbWrites;
 };
 
 #endif
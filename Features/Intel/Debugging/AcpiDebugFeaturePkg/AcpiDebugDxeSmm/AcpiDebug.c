@@ -43,15 +43,26 @@ typedef struct {
   UINT8  Wrap;              // If current Tail < Head
   UINT8  SmmVersion;        // If SMM version
   UINT8  Truncate;          // If the input from ASL > MAX_BUFFER_SIZE
+  UINT32 SmiHighWater;      // Pending records for ASL to trigger the SMI
+  UINT32 PendingCount;      // Records written by ASL since the last drain
+  UINT32 RecordCount;       // Records written by ASL
+  UINT32 SmiCount;          // SMIs handled, RecordCount - SmiCount SMIs are saved
+  UINT32 DrainCount;        // Records printed
+  UINT8  Reserved[12];
 } ACPI_DEBUG_HEAD;
 #pragma pack()
 
-#define AD_SIZE             sizeof (ACPI_DEBUG_HEAD) // This is 0x20
+#define AD_SIZE             sizeof (ACPI_DEBUG_HEAD) // This is 0x40
 
+//
+// Every record is MAX_BUFFER_SIZE bytes, the string and the truncate status in the last byte.
+//
 #define MAX_BUFFER_SIZE     32
+#define RECORD_TRUNCATE     (MAX_BUFFER_SIZE - 1)
 
 UINT32                      mBufferEnd = 0;
 ACPI_DEBUG_HEAD             *mAcpiDebug = NULL;
+EFI_EVENT                   mAcpiDebugTimerEvent = NULL;
 
 EFI_SMM_SYSTEM_TABLE2       *mSmst = NULL;
 
@@ -260,6 +271,12 @@ AcpiDebugEndOfDxeNotification (
     mAcpiDebug->Head = BufferIndex;
     mAcpiDebug->Tail = BufferIndex;
     mAcpiDebug->BufferSize = BufferSize;
+
+    //
+    // ASL triggers the SMI only after this many records, at most half of the buffer to not overrun it.
+    //
+    mAcpiDebug->SmiHighWater = MIN (PcdGet32 (PcdAcpiDebugSmiHighWater), (BufferSize - AD_SIZE) / MAX_BUFFER_SIZE / 2);
+    mAcpiDebug->SmiHighWater = MAX (mAcpiDebug->SmiHighWater, 1);
   }
 
   //
@@ -270,6 +287,182 @@ AcpiDebugEndOfDxeNotification (
   return ;
 }
 
+/**
+  Print all pending records of the Acpi Debug buffer.
+
+  The header is in memory the OS can modify, so it is validated and only read once.
+
+**/
+VOID
+AcpiDebugDrain (
+  VOID
+  )
+{
+  UINT8             Buffer[MAX_BUFFER_SIZE];
+  UINT32            BufferStart;
+  UINT32            Head;
+  UINT32            Tail;
+  BOOLEAN           Wrap;
+  BOOLEAN           Truncate;
+  UINT32            Count;
+
+  if (mAcpiDebug == NULL) {
+    return;
+  }
+
+  BufferStart = (UINT32) ((UINTN) mAcpiDebug + AD_SIZE);
+  Head        = mAcpiDebug->Head;
+  Tail        = mAcpiDebug->Tail;
+  Wrap        = (BOOLEAN) (mAcpiDebug->Wrap != 0);
+
+  //
+  // Validate the fields in mAcpiDebug to ensure there is no harm to SMI handler.
+  // mAcpiDebug is below 4GB and the start address of whole buffer.
+  //
+  if ((mAcpiDebug->BufferSize != (mBufferEnd - (UINT32) (UINTN) mAcpiDebug)) ||
+      (Head < BufferStart) || (Head > mBufferEnd) || (((Head - BufferStart) % MAX_BUFFER_SIZE) != 0) ||
+      (Tail < BufferStart) || (Tail > mBufferEnd) || (((Tail - BufferStart) % MAX_BUFFER_SIZE) != 0)) {
+    //
+    // If some fields in mAcpiDebug are invaid, return directly.
+    //
+    return;
+  }
+
+  //
+  // Not wrapped: Data to print is from Head to Tail.
+  // Wrapped:     Data to print is from Head to buffer end, then from buffer start to Tail.
+  //
+  Count = 0;
+  while (TRUE) {
+    if (Wrap) {
+      if (Head >= mBufferEnd) {
+        Head = BufferStart;
+        Wrap = FALSE;
+        continue;
+      }
+    } else if (Head >= Tail) {
+      break;
+    }
+
+    CopyMem (Buffer, (VOID *) (UINTN) Head, MAX_BUFFER_SIZE);
+    Head += MAX_BUFFER_SIZE;
+
+    //
+    // skip NULL record
+    //
+    if (Buffer[0] == '\0') {
+      continue;
+    }
+    Truncate = (BOOLEAN) (Buffer[RECORD_TRUNCATE] != 0);
+    Buffer[RECORD_TRUNCATE] = '\0';
+    DEBUG ((DEBUG_INFO | DEBUG_ERROR, "%a%a\n", Buffer, Truncate ? "..." : ""));
+    Count++;
+  }
+
+  mAcpiDebug->Head         = Head;
+  mAcpiDebug->Wrap         = 0;
+  mAcpiDebug->PendingCount = 0;
+  mAcpiDebug->DrainCount  += Count;
+}
+
+/**
+  Acpi Debug periodic timer to print the records written during boot.
+
+  @param[in] Event      Event whose notification function is being invoked.
+  @param[in] Context    Pointer to the notification function's context.
+
+**/
+VOID
+EFIAPI
+AcpiDebugTimerHandler (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  AcpiDebugDrain ();
+}
+
+/**
+  Acpi Debug ExitBootServices notification.
+
+  @param[in] Event      Event whose notification function is being invoked.
+  @param[in] Context    Pointer to the notification function's context.
+
+**/
+VOID
+EFIAPI
+AcpiDebugExitBootServicesNotification (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  //
+  // Stop the timer, the records written by ASL under OS stay in the buffer.
+  //
+  gBS->SetTimer (mAcpiDebugTimerEvent, TimerCancel, 0);
+  AcpiDebugDrain ();
+
+  DEBUG ((DEBUG_INFO, "AcpiDebug - %d records, %d printed, %d SMIs\n",
+    mAcpiDebug->RecordCount, mAcpiDebug->DrainCount, mAcpiDebug->SmiCount));
+}
+
+/**
+  Acpi Debug EndOfDxe notification for the DXE version.
+
+  Besides setting up the buffer, start a periodic timer to print the records
+  written during boot, as there is no SMI handler.
+
+  @param[in] Event      Event whose notification function is being invoked.
+  @param[in] Context    Pointer to the notification function's context.
+
+**/
+VOID
+EFIAPI
+AcpiDebugDxeEndOfDxeNotification (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS    Status;
+  EFI_EVENT     ExitBootServicesEvent;
+  UINT32        Period;
+
+  AcpiDebugEndOfDxeNotification (Event, Context);
+
+  Period = PcdGet32 (PcdAcpiDebugDrainPeriod);
+  if ((mAcpiDebug == NULL) || (Period == 0)) {
+    return;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  AcpiDebugTimerHandler,
+                  NULL,
+                  &mAcpiDebugTimerEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  //
+  // Timer period is in 100ns units.
+  //
+  Status = gBS->SetTimer (mAcpiDebugTimerEvent, TimerPeriodic, MultU64x32 (Period, 10000));
+  ASSERT_EFI_ERROR (Status);
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  AcpiDebugExitBootServicesNotification,
+                  NULL,
+                  &gEfiEventExitBootServicesGuid,
+                  &ExitBootServicesEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+}
+
 /**
   Initialize ACPI Debug.
 
@@ -300,7 +493,7 @@ InitializeAcpiDebugDxe (
   Status = gBS->CreateEventEx (
                   EVT_NOTIFY_SIGNAL,
                   TPL_CALLBACK,
-                  AcpiDebugEndOfDxeNotification,
+                  AcpiDebugDxeEndOfDxeNotification,
                   NULL,
                   &gEfiEndOfDxeEventGroupGuid,
                   &EndOfDxeEvent
@@ -332,82 +525,11 @@ AcpiDebugSmmCallback (
   IN OUT UINTN      *CommBufferSize
   )
 {
-  UINT8             Buffer[MAX_BUFFER_SIZE];
-
   //
-  // Validate the fields in mAcpiDebug to ensure there is no harm to SMI handler.
-  // mAcpiDebug is below 4GB and the start address of whole buffer.
+  // Print all pending records, ASL only triggers the SMI at the high water mark or on flush.
   //
-  if ((mAcpiDebug->BufferSize != (mBufferEnd - (UINT32) (UINTN) mAcpiDebug)) ||
-      (mAcpiDebug->Head < (UINT32) ((UINTN) mAcpiDebug + AD_SIZE)) ||
-      (mAcpiDebug->Head > mBufferEnd) ||
-      (mAcpiDebug->Tail < (UINT32) ((UINTN) mAcpiDebug + AD_SIZE)) ||
-      (mAcpiDebug->Tail > mBufferEnd)) {
-    //
-    // If some fields in mAcpiDebug are invaid, return directly.
-    //
-    return EFI_SUCCESS;
-  }
-
-  if (!(BOOLEAN)mAcpiDebug->Wrap && ((mAcpiDebug->Head >= (UINT32) ((UINTN) mAcpiDebug + AD_SIZE))
-    && (mAcpiDebug->Head < mAcpiDebug->Tail))){
-    //
-    // If curent ----- buffer + 020
-    //                 ...
-    //                 ... Head
-    //                 ... Data for SMM print
-    //                 ... Tail
-    //                 ... Vacant for ASL input
-    //           ----- buffer end
-    //
-    // skip NULL block
-    //
-    while ((*(CHAR8 *) (UINTN) mAcpiDebug->Head == '\0') && (mAcpiDebug->Head < mAcpiDebug->Tail)) {
-      mAcpiDebug->Head ++;
-    }
-
-    if (mAcpiDebug->Head < mAcpiDebug->Tail) {
-      ZeroMem (Buffer, MAX_BUFFER_SIZE);
-      AsciiStrnCpyS ((CHAR8 *) Buffer, MAX_BUFFER_SIZE, (CHAR8 *) (UINTN) mAcpiDebug->Head, MAX_BUFFER_SIZE - 1);
-
-      DEBUG ((DEBUG_INFO | DEBUG_ERROR, "%a%a\n", Buffer, (BOOLEAN) mAcpiDebug->Truncate ? "..." : ""));
-      mAcpiDebug->Head += MAX_BUFFER_SIZE;
-
-      if (mAcpiDebug->Head >= (mAcpiDebug->Tail)) {
-        //
-        // When head == tail, we do nothing in handler.
-        //
-        mAcpiDebug->Head = mAcpiDebug->Tail;
-      }
-    }
-  } else if ((BOOLEAN) mAcpiDebug->Wrap && ((mAcpiDebug->Head > mAcpiDebug->Tail)
-    && (mAcpiDebug->Head < (UINT32) ((UINTN) mAcpiDebug + mAcpiDebug->BufferSize)))){
-    //
-    // If curent ----- buffer + 020
-    //                 ... Tail
-    //                 ... Vacant for ASL input
-    //                 ... Head
-    //                 ... Data for SMM print
-    //           ----- buffer end
-    //
-    while ((*(CHAR8 *) (UINTN) mAcpiDebug->Head == '\0') && (mAcpiDebug->Head < (UINT32) ((UINTN) mAcpiDebug + mAcpiDebug->BufferSize))) {
-      mAcpiDebug->Head ++;
-    }
-    if (mAcpiDebug->Head < (UINT32) ((UINTN) mAcpiDebug + mAcpiDebug->BufferSize)){
-      ZeroMem (Buffer, MAX_BUFFER_SIZE);
-      AsciiStrnCpyS ((CHAR8 *) Buffer, MAX_BUFFER_SIZE, (CHAR8 *) (UINTN) mAcpiDebug->Head, MAX_BUFFER_SIZE - 1);
-      DEBUG ((DEBUG_INFO | DEBUG_ERROR, "%a%a\n", Buffer, (BOOLEAN) mAcpiDebug->Truncate ? "..." : ""));
-      mAcpiDebug->Head += MAX_BUFFER_SIZE;
-
-      if (mAcpiDebug->Head >= (UINT32) ((UINTN) mAcpiDebug + mAcpiDebug->BufferSize)) {
-        //
-        // We met end of buffer.
-        //
-        mAcpiDebug->Wrap = 0;
-        mAcpiDebug->Head = (UINT32) ((UINTN) mAcpiDebug + AD_SIZE);
-      }
-    }
-  }
+  mAcpiDebug->SmiCount++;
+  AcpiDebugDrain ();
 
   return EFI_SUCCESS;
 }
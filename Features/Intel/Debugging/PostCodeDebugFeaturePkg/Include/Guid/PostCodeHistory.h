@@ -0,0 +1,55 @@
+/** @file
+  Definitions for the post code history.
+
+  The post code status code handlers keep the last post codes in a circular
+  buffer together with the time they were reported. In PEI the buffer lives in
+  a GUID HOB, in DXE and SMM it lives in reserved memory published through the
+  EFI System Table under the same GUID, so it can be inspected after a hang or
+  from the OS.
+
+  Copyright (c) 2020, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __POST_CODE_HISTORY_H__
+#define __POST_CODE_HISTORY_H__
+
+#define POST_CODE_HISTORY_GUID \
+  { \
+    0x7b0a5f4c, 0x2d61, 0x4e8b, { 0x9c, 0x13, 0x55, 0xa8, 0x0f, 0x6e, 0xd2, 0x47 } \
+  }
+
+extern EFI_GUID gPostCodeHistoryGuid;
+
+#define POST_CODE_HISTORY_SIGNATURE  SIGNATURE_32 ('P', 'C', 'H', 'S')
+
+typedef struct {
+  UINT64    TimeStamp;            ///< GetPerformanceCounter () value when the code was reported.
+  UINT32    StatusCodeValue;      ///< EFI_STATUS_CODE_VALUE that was reported.
+  UINT32    PostCode;             ///< Post code written for it.
+} POST_CODE_HISTORY_ENTRY;
+
+typedef struct {
+  UINT32    Signature;            ///< POST_CODE_HISTORY_SIGNATURE.
+  UINT32    Depth;                ///< Number of entries in the buffer.
+  UINT32    Count;                ///< Number of post codes recorded so far. The next one goes
+                                  ///< to entry Count % Depth, the oldest kept one is at
+                                  ///< (Count - MIN (Count, Depth)) % Depth.
+  UINT32    Reserved;
+  UINT64    Frequency;            ///< Performance counter frequency in Hz.
+  UINT64    CounterStart;         ///< Performance counter start value, as returned by
+  UINT64    CounterEnd;           ///< GetPerformanceCounterProperties (), so the counting
+                                  ///< direction can be told.
+  //
+  // POST_CODE_HISTORY_ENTRY  Entry[Depth];
+  //
+} POST_CODE_HISTORY;
+
+#define POST_CODE_HISTORY_SIZE(Depth) \
+  (sizeof (POST_CODE_HISTORY) + (Depth) * sizeof (POST_CODE_HISTORY_ENTRY))
+
+#define POST_CODE_HISTORY_ENTRIES(History) \
+  ((POST_CODE_HISTORY_ENTRY *) ((POST_CODE_HISTORY *) (History) + 1))
+
+#endif
@@ -16,6 +16,11 @@ typedef struct{
   UINT32                Data;
 } STATUS_CODE_TO_DATA_MAP;
 
+typedef struct{
+  CONST STATUS_CODE_TO_DATA_MAP *Map;
+  UINTN                         Count;
+} STATUS_CODE_MAP_TABLE;
+
 //
 // Enable PEI/DXE status code
 //
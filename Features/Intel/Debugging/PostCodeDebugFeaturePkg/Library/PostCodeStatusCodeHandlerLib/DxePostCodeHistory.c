@@ -0,0 +1,83 @@
+/** @file
+  Post code history in reserved memory for the RuntimeDxe and SMM post code
+  status code handler libraries.
+
+  Copyright (c) 2020, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/HobLib.h>
+#include <Library/PcdLib.h>
+#include <Library/DebugLib.h>
+
+#include "PostCodeHistory.h"
+
+/**
+  Get the post code history of the DXE and SMM handlers.
+
+  The history is created in reserved memory on first use, seeded with the
+  entries of the PEI history HOB and published as configuration table, so
+  that both handlers and later consumers share it.
+
+  This uses boot services. The SMM handler may only call it from its library
+  constructor, which runs while SMM drivers are dispatched in the DXE phase.
+
+  @return The post code history, NULL if it is disabled or could not be created.
+
+**/
+POST_CODE_HISTORY *
+GetDxePostCodeHistory (
+  VOID
+  )
+{
+  EFI_STATUS                Status;
+  POST_CODE_HISTORY         *History;
+  EFI_PHYSICAL_ADDRESS      Address;
+  UINTN                     Pages;
+  UINT32                    Depth;
+  EFI_HOB_GUID_TYPE         *GuidHob;
+
+  Depth = FixedPcdGet32 (PcdPostCodeHistoryDepth);
+  if (Depth == 0) {
+    return NULL;
+  }
+
+  Status = EfiGetSystemConfigurationTable (&gPostCodeHistoryGuid, (VOID **) &History);
+  if (!EFI_ERROR (Status) && History != NULL) {
+    return History;
+  }
+
+  //
+  // Reserved memory survives into the OS and stays accessible to SMM.
+  //
+  Pages  = EFI_SIZE_TO_PAGES (POST_CODE_HISTORY_SIZE (Depth));
+  Status = gBS->AllocatePages (
+                  AllocateAnyPages,
+                  EfiReservedMemoryType,
+                  Pages,
+                  &Address
+                  );
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+  History = (POST_CODE_HISTORY *) (UINTN) Address;
+  PostCodeHistoryInitialize (History, Depth);
+
+  GuidHob = GetFirstGuidHob (&gPostCodeHistoryGuid);
+  if (GuidHob != NULL) {
+    PostCodeHistoryMigrate (History, GET_GUID_HOB_DATA (GuidHob));
+  }
+
+  Status = gBS->InstallConfigurationTable (&gPostCodeHistoryGuid, History);
+  if (EFI_ERROR (Status)) {
+    gBS->FreePages (Address, Pages);
+    return NULL;
+  }
+
+  DEBUG ((DEBUG_INFO, "PostCode history at 0x%lx, %d entries\n", Address, Depth));
+  return History;
+}
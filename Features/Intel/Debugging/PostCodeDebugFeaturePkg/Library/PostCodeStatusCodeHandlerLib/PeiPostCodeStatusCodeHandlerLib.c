@@ -8,6 +8,7 @@
 
 #include <Library/PeiServicesLib.h>
 #include <Library/PeimEntryPoint.h>
+#include <Library/HobLib.h>
 #include <Library/PcdLib.h>
 #include <Library/DebugLib.h>
 #include <Library/ReportStatusCodeLib.h>
@@ -16,6 +17,43 @@
 #include <Library/PostCodeMapLib.h>
 #include <Library/PostCodeLib.h>
 
+#include "PostCodeHistory.h"
+
+/**
+  Get the post code history HOB, and create it on first use.
+
+  PEI cannot keep the pointer in a global and the HOB list moves when memory
+  is installed, so the HOB is looked up on every call.
+
+  @return The post code history, NULL if it is disabled or could not be created.
+
+**/
+POST_CODE_HISTORY *
+GetPeiPostCodeHistory (
+  VOID
+  )
+{
+  EFI_HOB_GUID_TYPE         *GuidHob;
+  POST_CODE_HISTORY         *History;
+  UINT32                    Depth;
+
+  Depth = FixedPcdGet32 (PcdPostCodeHistoryDepth);
+  if (Depth == 0) {
+    return NULL;
+  }
+
+  GuidHob = GetFirstGuidHob (&gPostCodeHistoryGuid);
+  if (GuidHob != NULL) {
+    return GET_GUID_HOB_DATA (GuidHob);
+  }
+
+  History = BuildGuidHob (&gPostCodeHistoryGuid, POST_CODE_HISTORY_SIZE (Depth));
+  if (History != NULL) {
+    PostCodeHistoryInitialize (History, Depth);
+  }
+  return History;
+}
+
 /**
   Convert status code value and write data to post code.
 
@@ -50,12 +88,18 @@ PostCodeStatusCodeReportWorker (
   IN CONST EFI_STATUS_CODE_DATA     *Data OPTIONAL
   )
 {
-  UINT32 PostCodeValue;
+  UINT32               PostCodeValue;
+  POST_CODE_HISTORY    *History;
 
   PostCodeValue = GetPostCodeFromStatusCode (CodeType, Value);
   if (PostCodeValue != 0) {
     DEBUG ((EFI_D_INFO, "POSTCODE=<%02x>\n", PostCodeValue));
     PostCode (PostCodeValue);
+
+    History = GetPeiPostCodeHistory ();
+    if (History != NULL) {
+      PostCodeHistoryRecord (History, History->Depth, Value, PostCodeValue);
+    }
   }
 
   return EFI_SUCCESS;
@@ -0,0 +1,112 @@
+/** @file
+  Post code history shared by the post code status code handler libraries.
+
+  Copyright (c) 2020, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/TimerLib.h>
+
+#include "PostCodeHistory.h"
+
+/**
+  Initialize an empty post code history.
+
+  @param  History          The history to initialize.
+  @param  Depth            The number of entries following the header.
+
+**/
+VOID
+PostCodeHistoryInitialize (
+  OUT POST_CODE_HISTORY     *History,
+  IN  UINT32                Depth
+  )
+{
+  ZeroMem (History, POST_CODE_HISTORY_SIZE (Depth));
+  History->Signature = POST_CODE_HISTORY_SIGNATURE;
+  History->Depth     = Depth;
+  History->Frequency = GetPerformanceCounterProperties (
+                         &History->CounterStart,
+                         &History->CounterEnd
+                         );
+}
+
+/**
+  Record a post code in the history.
+
+  The slot is claimed atomically, so handlers of different phases or
+  processors writing the same history do not overwrite each other.
+
+  @param  History          The history to record in.
+  @param  Depth            The number of entries of History. It is passed by
+                           the caller so that SMM does not take it from
+                           memory outside SMRAM.
+  @param  Value            The status code value that was reported.
+  @param  PostCode         The post code written for it.
+
+**/
+VOID
+PostCodeHistoryRecord (
+  IN OUT POST_CODE_HISTORY  *History,
+  IN     UINT32             Depth,
+  IN     UINT32             Value,
+  IN     UINT32             PostCode
+  )
+{
+  POST_CODE_HISTORY_ENTRY   *Entry;
+  UINT32                    Index;
+
+  if (Depth == 0) {
+    return;
+  }
+
+  Index = InterlockedIncrement (&History->Count) - 1;
+  Entry = POST_CODE_HISTORY_ENTRIES (History) + (Index % Depth);
+
+  Entry->TimeStamp       = GetPerformanceCounter ();
+  Entry->StatusCodeValue = Value;
+  Entry->PostCode        = PostCode;
+}
+
+/**
+  Copy the entries of a history into another one, oldest first.
+
+  The destination keeps its own depth. Only the newest entries are copied if
+  it is smaller than the source.
+
+  @param  Destination      The initialized history to copy to.
+  @param  Source           The history to copy from.
+
+**/
+VOID
+PostCodeHistoryMigrate (
+  IN OUT POST_CODE_HISTORY        *Destination,
+  IN     CONST POST_CODE_HISTORY  *Source
+  )
+{
+  CONST POST_CODE_HISTORY_ENTRY  *SourceEntry;
+  POST_CODE_HISTORY_ENTRY        *DestinationEntry;
+  UINT32                         Kept;
+  UINT32                         Index;
+
+  if (Source->Signature != POST_CODE_HISTORY_SIGNATURE || Source->Depth == 0) {
+    return;
+  }
+
+  SourceEntry      = POST_CODE_HISTORY_ENTRIES (Source);
+  DestinationEntry = POST_CODE_HISTORY_ENTRIES (Destination);
+
+  Kept = MIN (Source->Count, MIN (Source->Depth, Destination->Depth));
+  for (Index = Source->Count - Kept; Index != Source->Count; Index++) {
+    CopyMem (
+      &DestinationEntry[Index % Destination->Depth],
+      &SourceEntry[Index % Source->Depth],
+      sizeof (POST_CODE_HISTORY_ENTRY)
+      );
+  }
+  Destination->Count = Source->Count;
+}
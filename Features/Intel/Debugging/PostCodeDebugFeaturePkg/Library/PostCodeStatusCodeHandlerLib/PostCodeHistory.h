@@ -0,0 +1,84 @@
+/** @file
+  Internal definitions for the post code history of the post code status code
+  handler libraries.
+
+  Copyright (c) 2020, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __POST_CODE_HISTORY_INTERNAL_H__
+#define __POST_CODE_HISTORY_INTERNAL_H__
+
+#include <Guid/PostCodeHistory.h>
+
+/**
+  Initialize an empty post code history.
+
+  @param  History          The history to initialize.
+  @param  Depth            The number of entries following the header.
+
+**/
+VOID
+PostCodeHistoryInitialize (
+  OUT POST_CODE_HISTORY     *History,
+  IN  UINT32                Depth
+  );
+
+/**
+  Record a post code in the history.
+
+  The slot is claimed atomically, so handlers of different phases or
+  processors writing the same history do not overwrite each other.
+
+  @param  History          The history to record in.
+  @param  Depth            The number of entries of History. It is passed by
+                           the caller so that SMM does not take it from
+                           memory outside SMRAM.
+  @param  Value            The status code value that was reported.
+  @param  PostCode         The post code written for it.
+
+**/
+VOID
+PostCodeHistoryRecord (
+  IN OUT POST_CODE_HISTORY  *History,
+  IN     UINT32             Depth,
+  IN     UINT32             Value,
+  IN     UINT32             PostCode
+  );
+
+/**
+  Copy the entries of a history into another one, oldest first.
+
+  The destination keeps its own depth. Only the newest entries are copied if
+  it is smaller than the source.
+
+  @param  Destination      The initialized history to copy to.
+  @param  Source           The history to copy from.
+
+**/
+VOID
+PostCodeHistoryMigrate (
+  IN OUT POST_CODE_HISTORY        *Destination,
+  IN     CONST POST_CODE_HISTORY  *Source
+  );
+
+/**
+  Get the post code history of the DXE and SMM handlers.
+
+  The history is created in reserved memory on first use, seeded with the
+  entries of the PEI history HOB and published as configuration table, so
+  that both handlers and later consumers share it.
+
+  This uses boot services. The SMM handler may only call it from its library
+  constructor, which runs while SMM drivers are dispatched in the DXE phase.
+
+  @return The post code history, NULL if it is disabled or could not be created.
+
+**/
+POST_CODE_HISTORY *
+GetDxePostCodeHistory (
+  VOID
+  );
+
+#endif
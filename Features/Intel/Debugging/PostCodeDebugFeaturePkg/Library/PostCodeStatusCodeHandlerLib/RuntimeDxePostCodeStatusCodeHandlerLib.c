@@ -18,9 +18,12 @@
 #include <Library/PostCodeMapLib.h>
 #include <Library/PostCodeLib.h>
 
+#include "PostCodeHistory.h"
+
 EFI_RSC_HANDLER_PROTOCOL  *mPostCodeRscHandlerProtocol       = NULL;
 EFI_EVENT                 mPostCodeExitBootServicesEvent     = NULL;
 BOOLEAN                   mPostCodeRegisted                  = FALSE;
+POST_CODE_HISTORY         *mPostCodeHistory                  = NULL;
 
 /**
   Convert status code value and write data to post code.
@@ -60,6 +63,10 @@ PostCodeStatusCodeReportWorker (
   if (PostCodeValue != 0) {
     DEBUG ((EFI_D_INFO, "POSTCODE=<%02x>\n", PostCodeValue));
     PostCode (PostCodeValue);
+
+    if (mPostCodeHistory != NULL) {
+      PostCodeHistoryRecord (mPostCodeHistory, mPostCodeHistory->Depth, Value, PostCodeValue);
+    }
   }
 
   return EFI_SUCCESS;
@@ -155,6 +162,8 @@ RuntimeDxePostCodeStatusCodeHandlerLibConstructor (
     return EFI_SUCCESS;
   }
 
+  mPostCodeHistory = GetDxePostCodeHistory ();
+
   Status = gBS->LocateProtocol (
                   &gEfiRscHandlerProtocolGuid,
                   NULL,
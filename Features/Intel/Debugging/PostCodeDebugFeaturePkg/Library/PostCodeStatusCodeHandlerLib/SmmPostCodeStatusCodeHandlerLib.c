@@ -8,15 +8,26 @@
 
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/SmmServicesTableLib.h>
+#include <Library/SmmMemLib.h>
 #include <Library/HobLib.h>
 #include <Library/PcdLib.h>
 #include <Library/DebugLib.h>
 #include <Library/ReportStatusCodeLib.h>
 #include <Protocol/SmmReportStatusCodeHandler.h>
+#include <Protocol/SmmExitBootServices.h>
+#include <Protocol/SmmLegacyBoot.h>
 
 #include <Library/PostCodeLib.h>
 #include <Library/PostCodeMapLib.h>
 
+#include "PostCodeHistory.h"
+
+//
+// The history buffer is outside SMRAM and visible to the OS, so its depth is
+// kept here and it is only written until the OS takes over.
+//
+POST_CODE_HISTORY  *mPostCodeHistory      = NULL;
+UINT32             mPostCodeHistoryDepth  = 0;
 
 /**
   Convert status code value and write data to post code.
@@ -56,11 +67,38 @@ PostCodeStatusCodeReportWorker (
   if (PostCodeValue != 0) {
     DEBUG ((EFI_D_INFO, "POSTCODE=<%02x>\n", PostCodeValue));
     PostCode (PostCodeValue);
+
+    if (mPostCodeHistory != NULL) {
+      PostCodeHistoryRecord (mPostCodeHistory, mPostCodeHistoryDepth, Value, PostCodeValue);
+    }
   }
 
   return EFI_SUCCESS;
 }
 
+/**
+  Stop recording into the post code history when the OS takes over, as the
+  OS owns the memory from then on.
+
+  @param Protocol       Points to the protocol's unique identifier.
+  @param Interface      Points to the interface instance.
+  @param Handle         The handle on which the interface was installed.
+
+  @retval EFI_SUCCESS   Notification runs successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+StopPostCodeHistory (
+  IN CONST EFI_GUID        *Protocol,
+  IN VOID                  *Interface,
+  IN EFI_HANDLE            Handle
+  )
+{
+  mPostCodeHistory = NULL;
+  return EFI_SUCCESS;
+}
+
 /**
   Register status code callback function only when Report Status Code protocol
   is installed.
@@ -122,6 +160,34 @@ SmmPostCodeStatusCodeHandlerLibConstructor (
     return EFI_SUCCESS;
   }
 
+  //
+  // The history is shared with the RuntimeDxe handler and lives outside SMRAM.
+  // It is looked up through boot services, which only works because library
+  // constructors of SMM drivers run during SMM driver dispatch in the DXE phase.
+  // The depth is captured now, and the buffer is checked against SMRAM.
+  //
+  mPostCodeHistory = GetDxePostCodeHistory ();
+  if (mPostCodeHistory != NULL) {
+    mPostCodeHistoryDepth = MIN (mPostCodeHistory->Depth, FixedPcdGet32 (PcdPostCodeHistoryDepth));
+    if (!SmmIsBufferOutsideSmmValid (
+           (EFI_PHYSICAL_ADDRESS) (UINTN) mPostCodeHistory,
+           POST_CODE_HISTORY_SIZE (mPostCodeHistoryDepth)
+           )) {
+      mPostCodeHistory = NULL;
+    } else {
+      gSmst->SmmRegisterProtocolNotify (
+               &gEdkiiSmmExitBootServicesProtocolGuid,
+               StopPostCodeHistory,
+               &Registration
+               );
+      gSmst->SmmRegisterProtocolNotify (
+               &gEdkiiSmmLegacyBootProtocolGuid,
+               StopPostCodeHistory,
+               &Registration
+               );
+    }
+  }
+
   Status = gSmst->SmmLocateProtocol (
                     &gEfiSmmRscHandlerProtocolGuid,
                     NULL,
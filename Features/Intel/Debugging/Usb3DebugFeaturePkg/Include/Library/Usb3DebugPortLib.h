@@ -9,6 +9,18 @@
 #ifndef __USB3_DEBUG_PORT_LIB__
 #define __USB3_DEBUG_PORT_LIB__
 
+///
+/// Statistics of the debug output sent over the USB3 debug port.
+///
+typedef struct {
+  UINT64    Transfers;          ///< Number of bulk-out transfers, one per door bell ring.
+  UINT64    Bytes;              ///< Number of bytes sent.
+  UINT64    MaxTransferBytes;   ///< Size of the largest transfer in bytes.
+  UINT64    SyncFlushes;        ///< Number of flushes that waited for the transfer to complete.
+  UINT64    Errors;             ///< Number of transfers completed with error, their data is dropped.
+  UINT64    TransportTime;      ///< Time spent in the transport, in nanoseconds.
+} USB3_DEBUG_PORT_STATISTICS;
+
 /**
   Initialize the USB3 debug port hardware.
 
@@ -68,4 +80,42 @@ Usb3DebugPortPoll (
   VOID
   );
 
+/**
+  Flush the buffered output of the USB3 debug port.
+
+  Sends all buffered data and returns after the XHCI controller completed it.
+  Data of a failed transfer is dropped and counted in the statistics.
+
+  Buffered output is only sent when PcdUsb3DebugPortOutFlushThreshold or
+  PcdUsb3DebugPortOutFlushTimeout is reached. The DebugLib calls this from
+  DebugAssert () before the dead loop or break point, and anywhere else the
+  output has to reach the host before execution continues.
+
+  @retval RETURN_SUCCESS        The buffered data was handled.
+
+**/
+RETURN_STATUS
+EFIAPI
+Usb3DebugPortFlush (
+  VOID
+  );
+
+/**
+  Get the statistics of the output sent over the USB3 debug port.
+
+  The average transfer size is Bytes / Transfers.
+
+  @param[out] Statistics        Pointer to the statistics to fill.
+
+  @retval RETURN_SUCCESS        The statistics were returned.
+  @retval RETURN_NOT_READY      The USB3 debug port is not initialized.
+  @retval RETURN_UNSUPPORTED    The USB3 debug port is not supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+Usb3DebugPortGetStatistics (
+  OUT USB3_DEBUG_PORT_STATISTICS  *Statistics
+  );
+
 #endif
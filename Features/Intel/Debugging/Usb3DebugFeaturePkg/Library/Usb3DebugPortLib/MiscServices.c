@@ -160,6 +160,61 @@ Usb3DebugPortPoll (
   return FALSE;
 }
 
+/**
+  Flush the buffered output of the USB3 debug port.
+
+  Sends all buffered data and returns after the XHCI controller completed it.
+  Data of a failed transfer is dropped and counted in the statistics.
+
+  @retval RETURN_SUCCESS        The buffered data was handled.
+
+**/
+RETURN_STATUS
+EFIAPI
+Usb3DebugPortFlush (
+  VOID
+  )
+{
+  Usb3DbgFlush ();
+  return RETURN_SUCCESS;
+}
+
+/**
+  Get the statistics of the output sent over the USB3 debug port.
+
+  The average transfer size is Bytes / Transfers.
+
+  @param[out] Statistics        Pointer to the statistics to fill.
+
+  @retval RETURN_SUCCESS        The statistics were returned.
+  @retval RETURN_NOT_READY      The USB3 debug port is not initialized.
+  @retval RETURN_UNSUPPORTED    The USB3 debug port is not supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+Usb3DebugPortGetStatistics (
+  OUT USB3_DEBUG_PORT_STATISTICS  *Statistics
+  )
+{
+  USB3_DEBUG_PORT_INSTANCE        *Instance;
+
+  ASSERT (Statistics != NULL);
+
+  Instance = GetUsb3DebugPortInstance ();
+  if (Instance == NULL) {
+    return RETURN_NOT_READY;
+  }
+  if (!Instance->DebugSupport) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  CopyMem (Statistics, &Instance->OutStatistics, sizeof (USB3_DEBUG_PORT_STATISTICS));
+  Statistics->TransportTime = GetTimeInNanoSecond (Instance->OutStatistics.TransportTime);
+
+  return RETURN_SUCCESS;
+}
+
 /**
   Write the data to the XHCI debug register.
 
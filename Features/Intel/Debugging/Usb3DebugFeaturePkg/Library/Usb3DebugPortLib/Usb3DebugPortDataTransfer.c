@@ -21,6 +21,7 @@ EFI_SMRAM_DESCRIPTOR        mSmramCheckRanges[MAX_SMRAM_RANGE];
 UINTN                       mSmramCheckRangeCount = 0;
 BOOLEAN                     mUsb3InSmm            = FALSE;
 UINT64                      mUsb3MmioSize         = 0;
+BOOLEAN                     mUsb3AsyncOut         = FALSE;
 
 /**
   Synchronize the specified transfer ring to update the enqueue and dequeue pointer.
@@ -400,6 +401,51 @@ XhcRingDoorBell (
   return EFI_SUCCESS;
 }
 
+/**
+  Restore the transfer ring to the value before the URB when the URB transfer failed.
+
+  This will make the current transfer TRB is always at the latest unused one in transfer ring.
+  Without this code, when there is read TRB from target, but host does not write anything, this TRB (A)
+  will be still here, next read TRB (B) will be put next to TRB (A), when host write then, the TRB (A)
+  will be used to contain data, not TRB(B), this will cause Finished flag will not be set and return error.
+
+  @param  Urb               The failed URB.
+
+**/
+VOID
+XhcRestoreTransferRing (
+  IN  URB                      *Urb
+  )
+{
+  TRB_TEMPLATE            *Trb;
+  TRANSFER_RING           *Ring;
+  UINT32                  Pcs;
+  UINT32                  Index;
+
+  Ring = (TRANSFER_RING *)(UINTN) Urb->Ring;
+  //
+  // Clear CCS flag for next use. A URB may wrap around the ring through the
+  // link TRB, the cycle state toggles there.
+  //
+  Pcs   = Urb->StartPCS & BIT0;
+  Trb   = (TRB_TEMPLATE *)(UINTN) Urb->TrbStart;
+  Index = 0;
+  while (Index < Urb->TrbNum) {
+    if ((UINT8) Trb->Type == TRB_TYPE_LINK) {
+      ((LINK_TRB *) Trb)->CycleBit = (~Pcs) & BIT0;
+      Pcs = Pcs ^ BIT0;
+      Trb = (TRB_TEMPLATE *)(UINTN)((Trb->Parameter1 | LShiftU64 ((UINT64)Trb->Parameter2, 32)) & ~0x0F);
+      continue;
+    }
+    Trb->CycleBit = (~Pcs) & BIT0;
+    Trb++;
+    Index++;
+  }
+
+  Ring->RingEnqueue = Urb->TrbStart;
+  Ring->RingPCS     = Urb->StartPCS;
+}
+
 /**
   Execute the transfer by polling the URB. This is a synchronous operation.
 
@@ -422,10 +468,6 @@ XhcExecTransfer (
   EFI_STATUS              Status;
   UINTN                   Index;
   UINTN                   Loop;
-  TRB_TEMPLATE            *Trb;
-  TRANSFER_RING           *Ring;
-  TRB_TEMPLATE            *TrbStart;
-  TRB_TEMPLATE            *TrbEnd;
 
   Status = EFI_SUCCESS;
 
@@ -451,22 +493,9 @@ XhcExecTransfer (
 
   //
   // If URB transfer is error, restore transfer ring to original value before URB transfer
-  // This will make the current transfer TRB is always at the latest unused one in transfer ring.
-  // Without this code, when there is read TRB from target, but host does not write anything, this TRB (A)
-  // will be still here, next read TRB (B) will be put next to TRB (A), when host write then, the TRB (A)
-  // will be used to contain data, not TRB(B), this will cause Finished flag will not be set and return error in this function.
   //
-  Ring = (TRANSFER_RING *)(UINTN) Urb->Ring;
   if (Urb->Result != EFI_USB_NOERROR) {
-    Ring->RingEnqueue = Urb->TrbStart;
-    //
-    // Clear CCS flag for next use
-    //
-    TrbStart = (TRB_TEMPLATE *)(UINTN) Urb->TrbStart;
-    TrbEnd   = (TRB_TEMPLATE *)(UINTN) Urb->TrbEnd;
-    for (Trb = TrbStart; Trb <= TrbEnd; Trb++) {
-      Trb->CycleBit = ((~Ring->RingPCS) & BIT0);
-    }
+    XhcRestoreTransferRing (Urb);
   }
   return Status;
 }
@@ -510,7 +539,8 @@ XhcCreateTransferTrb (
   //
   XhcSyncTrsRing (Xhc, EPRing);
 
-  Urb->TrbStart = EPRing->RingEnqueue;
+  Urb->TrbStart  = EPRing->RingEnqueue;
+  Urb->StartPCS  = EPRing->RingPCS;
 
   TotalLen = 0;
   Len      = 0;
@@ -663,6 +693,281 @@ ON_EXIT:
   return Status;
 }
 
+/**
+  Return the performance counter ticks elapsed between two counter values.
+
+  @param  Begin     The counter value at the beginning.
+  @param  End       The counter value at the end.
+
+  @return The elapsed ticks.
+
+**/
+UINT64
+Usb3ElapsedTicks (
+  IN UINT64                     Begin,
+  IN UINT64                     End
+  )
+{
+  UINT64                        CounterStart;
+  UINT64                        CounterEnd;
+
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart > CounterEnd) {
+    //
+    // Count down counter
+    //
+    if (End <= Begin) {
+      return Begin - End;
+    }
+    return (Begin - CounterEnd) + (CounterStart - End);
+  }
+
+  if (End >= Begin) {
+    return End - Begin;
+  }
+  return (CounterEnd - Begin) + (End - CounterStart);
+}
+
+/**
+  Queue the pending bytes of the output buffer on the bulk-out transfer ring
+  and ring the door bell once.
+
+  Every TRB is a TD of its own, so the controller never sees a partial TD while
+  earlier ones are running. Only the last TRB interrupts on completion; the
+  endpoint completes TDs in order, so its event retires all queued output.
+
+  @param  Xhc          The XHCI Instance.
+
+**/
+VOID
+XhcQueueOutBuffer (
+  IN USB3_DEBUG_PORT_INSTANCE   *Xhc
+  )
+{
+  TRANSFER_RING                 *EPRing;
+  URB                           *Urb;
+  TRB                           *Trb;
+  EFI_PHYSICAL_ADDRESS          Address;
+  UINT32                        Offset;
+  UINT32                        Remaining;
+  UINT32                        Len;
+
+  Urb    = &Xhc->UrbOut;
+  EPRing = &Xhc->TransferRingOut;
+
+  XhcSyncTrsRing (Xhc, EPRing);
+
+  if (Xhc->OutQueued == 0) {
+    ZeroMem (Urb, sizeof (URB));
+    Urb->Signature = USB3_DEBUG_PORT_INSTANCE_SIGNATURE;
+    Urb->Direction = EfiUsbDataOut;
+    Urb->Data      = Xhc->OutBuffer;
+    Urb->Ring      = (EFI_PHYSICAL_ADDRESS)(UINTN) EPRing;
+    Urb->TrbStart  = EPRing->RingEnqueue;
+    Urb->StartPCS  = EPRing->RingPCS;
+    Urb->Result    = EFI_USB_NOERROR;
+    //
+    // No event is generated for the first TRB
+    //
+    Urb->StartDone = TRUE;
+  }
+
+  Offset    = (Xhc->OutHead + Xhc->OutQueued) % Xhc->OutBufferSize;
+  Remaining = Xhc->OutPending;
+  Trb       = NULL;
+
+  while (Remaining > 0) {
+    Address = Xhc->OutBuffer + Offset;
+    Len     = MIN (Remaining, Xhc->OutBufferSize - Offset);
+    Len     = MIN (Len, SIZE_64KB - (UINT32) (Address & (SIZE_64KB - 1)));
+
+    Trb = (TRB *)(UINTN) EPRing->RingEnqueue;
+    Trb->TrbNormal.TRBPtrLo  = XHC_LOW_32BIT (Address);
+    Trb->TrbNormal.TRBPtrHi  = XHC_HIGH_32BIT (Address);
+    Trb->TrbNormal.Length    = Len;
+    Trb->TrbNormal.TDSize    = 0;
+    Trb->TrbNormal.IntTarget = 0;
+    Trb->TrbNormal.ISP       = 1;
+    Trb->TrbNormal.IOC       = (Len == Remaining) ? 1 : 0;
+    Trb->TrbNormal.Type      = TRB_TYPE_NORMAL;
+
+    //
+    // Update the cycle bit
+    //
+    Trb->TrbNormal.CycleBit = EPRing->RingPCS & BIT0;
+
+    XhcSyncTrsRing (Xhc, EPRing);
+    Urb->TrbNum++;
+    Remaining -= Len;
+    Offset     = (Offset + Len) % Xhc->OutBufferSize;
+  }
+
+  Urb->TrbEnd   = (EFI_PHYSICAL_ADDRESS)(UINTN) Trb;
+  Urb->DataLen += Xhc->OutPending;
+  Urb->EndDone  = FALSE;
+  Urb->Finished = FALSE;
+
+  Xhc->OutStatistics.Transfers++;
+  Xhc->OutStatistics.Bytes += Xhc->OutPending;
+  if (Xhc->OutPending > Xhc->OutStatistics.MaxTransferBytes) {
+    Xhc->OutStatistics.MaxTransferBytes = Xhc->OutPending;
+  }
+
+  Xhc->OutQueued += Xhc->OutPending;
+  Xhc->OutPending = 0;
+
+  XhcRingDoorBell (Xhc, Urb);
+}
+
+/**
+  Release the queued output once the XHC completed it.
+
+  @param  Xhc          The XHCI Instance.
+  @param  Wait         TRUE to poll until the queued output is completed,
+                       FALSE to only check it once.
+
+**/
+VOID
+XhcRetireOutBuffer (
+  IN USB3_DEBUG_PORT_INSTANCE   *Xhc,
+  IN BOOLEAN                    Wait
+  )
+{
+  URB                           *Urb;
+  UINTN                         Index;
+  UINTN                         Loop;
+  UINTN                         Timeout;
+
+  if (Xhc->OutQueued == 0) {
+    return;
+  }
+
+  Urb = &Xhc->UrbOut;
+  XhcCheckUrbResult (Xhc, Urb);
+
+  if (Wait && !Urb->Finished) {
+    Timeout = DATA_TRANSFER_TIME_OUT;
+    Loop    = (Timeout * XHC_1_MILLISECOND / XHC_OUT_POLL_DELAY) + 1;
+    if (Timeout == 0) {
+      Loop = 0xFFFFFFFF;
+    }
+    for (Index = 0; Index < Loop; Index++) {
+      MicroSecondDelay (XHC_OUT_POLL_DELAY);
+      XhcCheckUrbResult (Xhc, Urb);
+      if (Urb->Finished) {
+        break;
+      }
+    }
+    if (Index == Loop) {
+      Urb->Result   = EFI_USB_ERR_TIMEOUT;
+      Urb->Finished = TRUE;
+    }
+  }
+
+  if (!Urb->Finished) {
+    return;
+  }
+
+  if (Urb->Result != EFI_USB_NOERROR) {
+    //
+    // The queued output is dropped
+    //
+    Xhc->OutStatistics.Errors++;
+    XhcRestoreTransferRing (Urb);
+  }
+
+  Xhc->OutHead   = (Xhc->OutHead + Xhc->OutQueued) % Xhc->OutBufferSize;
+  Xhc->OutQueued = 0;
+}
+
+/**
+  Send the pending output of the output buffer.
+
+  @param  Xhc          The XHCI Instance.
+  @param  Wait         TRUE to return after the XHC completed all output,
+                       FALSE to return once the output is queued.
+
+**/
+VOID
+XhcFlushOutBuffer (
+  IN USB3_DEBUG_PORT_INSTANCE   *Xhc,
+  IN BOOLEAN                    Wait
+  )
+{
+  XhcRetireOutBuffer (Xhc, FALSE);
+
+  if (Xhc->OutPending != 0) {
+    if (Xhc->UrbOut.TrbNum >= XHC_OUT_MAX_QUEUED_TRB) {
+      XhcRetireOutBuffer (Xhc, TRUE);
+    }
+    XhcQueueOutBuffer (Xhc);
+  }
+
+  if (Wait && (Xhc->OutQueued != 0)) {
+    Xhc->OutStatistics.SyncFlushes++;
+    XhcRetireOutBuffer (Xhc, TRUE);
+  }
+}
+
+/**
+  Copy output into the output buffer and flush it when the size or time
+  threshold is reached.
+
+  With Async set the flush only queues the output, the completion is checked on
+  the next call. Otherwise the flush waits for the XHC to complete the output.
+  Output that must reach the host right away, like an assertion message, is
+  flushed by the caller through Usb3DebugPortFlush ().
+
+  @param  Xhc          The XHCI Instance.
+  @param  Data         Data buffer.
+  @param  Length       Data length.
+  @param  Async        TRUE if the output may be left in flight on return.
+
+**/
+VOID
+XhcBufferedOut (
+  IN USB3_DEBUG_PORT_INSTANCE   *Xhc,
+  IN UINT8                      *Data,
+  IN UINTN                      Length,
+  IN BOOLEAN                    Async
+  )
+{
+  UINT8                         *Source;
+  UINTN                         Remaining;
+  UINT32                        Free;
+  UINT32                        Tail;
+  UINT32                        Len;
+  UINT32                        Timeout;
+
+  XhcRetireOutBuffer (Xhc, FALSE);
+
+  Source    = Data;
+  Remaining = Length;
+  while (Remaining > 0) {
+    Free = Xhc->OutBufferSize - Xhc->OutQueued - Xhc->OutPending;
+    if (Free == 0) {
+      XhcFlushOutBuffer (Xhc, TRUE);
+      continue;
+    }
+    if (Xhc->OutPending == 0) {
+      Xhc->OutPendingTick = GetPerformanceCounter ();
+    }
+    Tail = (Xhc->OutHead + Xhc->OutQueued + Xhc->OutPending) % Xhc->OutBufferSize;
+    Len  = (UINT32) MIN (Remaining, MIN (Free, Xhc->OutBufferSize - Tail));
+    CopyMem ((VOID *)(UINTN) (Xhc->OutBuffer + Tail), Source, Len);
+    Xhc->OutPending += Len;
+    Source          += Len;
+    Remaining       -= Len;
+  }
+
+  Timeout = PcdGet32 (PcdUsb3DebugPortOutFlushTimeout);
+  if ((Timeout == 0) ||
+      (Xhc->OutPending >= PcdGet32 (PcdUsb3DebugPortOutFlushThreshold)) ||
+      (GetTimeInNanoSecond (Usb3ElapsedTicks (Xhc->OutPendingTick, GetPerformanceCounter ())) >= MultU64x32 (Timeout, 1000))) {
+    XhcFlushOutBuffer (Xhc, (BOOLEAN) !Async);
+  }
+}
+
 /**
   Check whether the MMIO Bar is within any of the SMRAM ranges.
 
@@ -700,6 +1005,9 @@ Usb3DebugIsAddressInSmram (
 /**
   Transfer data via XHC controller.
 
+  Output goes through the output buffer when it is available. EfiUsbNoData
+  only flushes the output buffer.
+
   @param  Data         Data buffer.
   @param  Length       Data length.
   @param  Direction    Transfer direction.
@@ -725,6 +1033,9 @@ Usb3DebugPortDataTransfer (
   USB3_DEBUG_PORT_CONTROLLER      UsbDebugPort;
   EFI_STATUS                      Status;
   USB3_DEBUG_PORT_INSTANCE        UsbDbgInstance;
+  UINT64                          StartTick;
+
+  StartTick = GetPerformanceCounter ();
 
   UsbDebugPort.Controller = GetUsb3DebugPortController();
   Bus      = UsbDebugPort.PciAddress.Bus;
@@ -832,6 +1143,34 @@ Usb3DebugPortDataTransfer (
     }
   }
 
+  if (Instance->OutBufferSize != 0) {
+    if (Direction == EfiUsbDataOut) {
+      //
+      // Output may only stay in flight when the Command register is not
+      // restored under it, i.e. MSE and BME were already set.
+      //
+      XhcBufferedOut (
+        Instance,
+        Data,
+        *Length,
+        (BOOLEAN) (mUsb3AsyncOut &&
+                   ((Command & (EFI_PCI_COMMAND_MEMORY_SPACE | EFI_PCI_COMMAND_BUS_MASTER)) ==
+                    (EFI_PCI_COMMAND_MEMORY_SPACE | EFI_PCI_COMMAND_BUS_MASTER)))
+        );
+      *Length = 0;
+    } else {
+      //
+      // Drain the output first, checking the IN transfer would drop its events.
+      //
+      XhcFlushOutBuffer (Instance, TRUE);
+    }
+    Instance->OutStatistics.TransportTime += Usb3ElapsedTicks (StartTick, GetPerformanceCounter ());
+  }
+
+  if (Direction == EfiUsbNoData) {
+    goto Done;
+  }
+
   BytesToSend = 0;
   while (*Length > 0) {
     BytesToSend = ((*Length) > XHC_DEBUG_PORT_DATA_LENGTH) ? XHC_DEBUG_PORT_DATA_LENGTH : *Length;
@@ -851,6 +1190,14 @@ Usb3DebugPortDataTransfer (
   }
 
 Done:
+  //
+  // Output queued by an earlier call must not lose BME under it
+  //
+  if ((Instance != NULL) && Instance->Ready && (Instance->OutQueued != 0) &&
+      ((Command & EFI_PCI_COMMAND_BUS_MASTER) == 0)) {
+    XhcRetireOutBuffer (Instance, TRUE);
+  }
+
   //
   // Restore Command Register
   //
@@ -890,3 +1237,18 @@ Usb3DbgOut (
 {
   Usb3DebugPortDataTransfer (Data, Length, EfiUsbDataOut);
 }
+
+/**
+  Send the buffered output over the USB3 debug cable and wait for its completion.
+
+**/
+VOID
+Usb3DbgFlush (
+  VOID
+  )
+{
+  UINTN                                    Length;
+
+  Length = 0;
+  Usb3DebugPortDataTransfer (NULL, &Length, EfiUsbNoData);
+}
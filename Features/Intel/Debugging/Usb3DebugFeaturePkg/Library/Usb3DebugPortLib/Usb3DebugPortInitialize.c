@@ -525,6 +525,7 @@ InitializeUsb3DebugPort (
   CHAR8                           *TestString;
   UINTN                           Length;
   UINT32                          TransferResult;
+  UINT32                          OutBufferSize;
 
   Bus      = Instance->PciBusNumber;
   Device   = Instance->PciDeviceNumber;
@@ -593,6 +594,25 @@ InitializeUsb3DebugPort (
   //
   Instance->Urb.Data = (EFI_PHYSICAL_ADDRESS) (UINTN) AllocateAlignBuffer (XHC_DEBUG_PORT_DATA_LENGTH);
 
+  //
+  // Init output buffer, the transfer rings are new so anything buffered before is dropped.
+  // Without the buffer the output is sent directly.
+  //
+  ZeroMem (&Instance->UrbOut, sizeof (URB));
+  Instance->OutBuffer     = 0;
+  Instance->OutBufferSize = 0;
+  Instance->OutHead       = 0;
+  Instance->OutQueued     = 0;
+  Instance->OutPending    = 0;
+  OutBufferSize = PcdGet32 (PcdUsb3DebugPortOutBufferSize);
+  if (OutBufferSize != 0) {
+    OutBufferSize = MIN ((UINT32) EFI_PAGES_TO_SIZE (EFI_SIZE_TO_PAGES (OutBufferSize)), XHC_OUT_BUFFER_MAX_SIZE);
+    Instance->OutBuffer = (EFI_PHYSICAL_ADDRESS) (UINTN) AllocateAlignBuffer (OutBufferSize);
+    if (Instance->OutBuffer != 0) {
+      Instance->OutBufferSize = OutBufferSize;
+    }
+  }
+
   //
   // Init DCDDI1 and DCDDI2
   //
@@ -25,6 +25,7 @@ extern EFI_SMRAM_DESCRIPTOR mSmramCheckRanges[MAX_SMRAM_RANGE];
 extern UINTN                mSmramCheckRangeCount;
 extern BOOLEAN              mUsb3InSmm;
 extern UINT64               mUsb3MmioSize;
+extern BOOLEAN              mUsb3AsyncOut;
 extern BOOLEAN              mUsb3GetCapSuccess;
 
 GUID                        gUsb3DbgGuid =  USB3_DBG_GUID;
@@ -378,6 +379,11 @@ Usb3DebugPortLibDxeConstructor (
       SmmBase->InSmm(SmmBase, &mUsb3InSmm);
     }
 
+    //
+    // Boot services outside of SMM keep running while the output is sent.
+    //
+    mUsb3AsyncOut = (BOOLEAN) !mUsb3InSmm;
+
     if (mUsb3InSmm) {
       //
       // Get SMRAM information
@@ -21,6 +21,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/BaseLib.h>
 #include <Library/TimerLib.h>
+#include <Library/Usb3DebugPortLib.h>
 
 //
 // USB Debug GUID value
@@ -66,6 +67,17 @@
 //
 #define DATA_TRANSFER_TIME_OUT       0
 
+//
+// A TRB data buffer must not cross a 64KB boundary, so the output buffer
+// is limited to 64KB and a flush needs at most 4 TRBs.
+//
+#define XHC_OUT_BUFFER_MAX_SIZE      SIZE_64KB
+
+//
+// Limit of TRBs queued on the bulk-out ring before the output waits for completion
+//
+#define XHC_OUT_MAX_QUEUED_TRB       (TR_RING_TRB_NUMBER / 2)
+
 //
 // USB debug device string descritpor (header size + unicode string length)
 //
@@ -166,6 +178,7 @@
 #define XHC_1_MILLISECOND                     (1000)
 #define XHC_POLL_DELAY                        (1000)
 #define XHC_GENERIC_TIMEOUT                   (10 * 1000)
+#define XHC_OUT_POLL_DELAY                    (10)
 
 #define EFI_USB_SPEED_FULL                    0x0000  ///< 12 Mb/s, USB 1.1 OHCI and UHCI HC.
 #define EFI_USB_SPEED_LOW                     0x0001  ///< 1 Mb/s, USB 1.1 OHCI and UHCI HC.
@@ -433,6 +446,10 @@ typedef struct _URB {
   EFI_PHYSICAL_ADDRESS            TrbStart;
   EFI_PHYSICAL_ADDRESS            TrbEnd;
   UINT32                          TrbNum;
+  //
+  // Producer cycle state of the ring at TrbStart
+  //
+  UINT32                          StartPCS;
   BOOLEAN                         StartDone;
   BOOLEAN                         EndDone;
   BOOLEAN                         Finished;
@@ -509,6 +526,31 @@ typedef struct _USB3_DEBUG_PORT_INSTANCE {
   // URB
   //
   URB                                     Urb;
+
+  //
+  // URB tracking the TRBs queued from the output buffer
+  //
+  URB                                     UrbOut;
+
+  //
+  // Output buffer, used as ring. OutQueued bytes from OutHead are queued on the
+  // transfer ring, OutPending bytes behind them are not sent yet.
+  //
+  EFI_PHYSICAL_ADDRESS                    OutBuffer;
+  UINT32                                  OutBufferSize;
+  UINT32                                  OutHead;
+  UINT32                                  OutQueued;
+  UINT32                                  OutPending;
+
+  //
+  // Performance counter when the oldest pending byte was buffered
+  //
+  UINT64                                  OutPendingTick;
+
+  //
+  // Output statistics, TransportTime is kept in performance counter ticks
+  //
+  USB3_DEBUG_PORT_STATISTICS              OutStatistics;
 } USB3_DEBUG_PORT_INSTANCE;
 
 #pragma pack()
@@ -715,6 +757,15 @@ Usb3DbgOut (
   IN OUT   UINTN                           *Length
   );
 
+/**
+  Send the buffered output over the USB3 debug cable and wait for its completion.
+
+**/
+VOID
+Usb3DbgFlush (
+  VOID
+  );
+
 /**
   Receive data over the USB3 debug cable.
 
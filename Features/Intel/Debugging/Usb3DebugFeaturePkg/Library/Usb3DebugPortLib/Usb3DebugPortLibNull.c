@@ -7,6 +7,7 @@
 **/
 
 #include <Base.h>
+#include <Library/Usb3DebugPortLib.h>
 
 /**
   Initialize the USB3 debug port hardware.
@@ -101,3 +102,42 @@ Usb3DebugPortPoll (
 {
   return FALSE;
 }
+
+/**
+  Flush the buffered output of the USB3 debug port.
+
+  Sends all buffered data and returns after the XHCI controller completed it.
+  Data of a failed transfer is dropped and counted in the statistics.
+
+  @retval RETURN_SUCCESS        The buffered data was handled.
+
+**/
+RETURN_STATUS
+EFIAPI
+Usb3DebugPortFlush (
+  VOID
+  )
+{
+  return RETURN_SUCCESS;
+}
+
+/**
+  Get the statistics of the output sent over the USB3 debug port.
+
+  The average transfer size is Bytes / Transfers.
+
+  @param[out] Statistics        Pointer to the statistics to fill.
+
+  @retval RETURN_SUCCESS        The statistics were returned.
+  @retval RETURN_NOT_READY      The USB3 debug port is not initialized.
+  @retval RETURN_UNSUPPORTED    The USB3 debug port is not supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+Usb3DebugPortGetStatistics (
+  OUT USB3_DEBUG_PORT_STATISTICS  *Statistics
+  )
+{
+  return RETURN_UNSUPPORTED;
+}
@@ -461,8 +461,7 @@ VkTimer (
   CheckScreenCleared (VkContext);
   CheckBackgroundChanged (VkContext);
   if (VkContext->IsRedrawUpdateUI) {
-    HideVkBody (VkContext);
-    DrawKeyboardLayout (VkContext);
+    UpdateVkBody (VkContext);
     VkContext->IsRedrawUpdateUI = FALSE;
   }
 
@@ -839,6 +838,8 @@ VkApiStart (
   VkContext->VkBodyBltStartY                    = 0;
   VkContext->VkBodyBltHeight                    = 0;
   VkContext->VkBodyBltWidth                     = 0;
+  VkContext->VkBodyImage                        = NULL;
+  VkContext->VkBodyShiftPressed                 = FALSE;
   VkContext->IconBltBuffer                      = NULL;
   VkContext->IconBltSize                        = 0;
   VkContext->IconReDrawCheck                    = 0;
@@ -1241,8 +1242,7 @@ VkKeyboardSetState (
     VkContext->PageNumber = VkContext->IsCapsLockFlag ? VkPage1 : VkPage0;
   }
 
-  HideVkBody (VkContext);
-  DrawKeyboardLayout (VkContext);
+  UpdateVkBody (VkContext);
 
   DEBUG ((DEBUG_VK_KEYS | DEBUG_INFO, "VkContext->KeyToggleState:      %02x\n", VkContext->KeyToggleState));
   DEBUG ((DEBUG_VK_KEYS | DEBUG_INFO, "VkContext->IsCapsLockFlag:      %02x\n", VkContext->IsCapsLockFlag));
@@ -177,60 +177,49 @@ VK_STRUCT mSimpleKeyboardBody[] = {
 };
 
 /**
-  Modify the color of key if Shift or CapsLock is pressed.
+  Blend a keyboard pixel with a background pixel.
 
-  @param[in]       VkContext   Address of an VK_CONTEXT structure.
-  @param[in, out]  BltBuffer   Address of a blt buffer.
+  The weights are 8.8 fixed point and add up to 256, so red and blue are blended
+  together in one 32-bit multiply without carrying into each other.
 
-  @retval EFI_SUCCESS          Success for the function.
+  @param[in] Keyboard      Keyboard pixel.
+  @param[in] Background    Background pixel.
+
+  @return The blended pixel, with the reserved byte cleared.
 
 **/
-EFI_STATUS
-ModifyShiftKeyColor (
-  IN     VK_CONTEXT                    *VkContext,
-  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL **BltBuffer
+STATIC
+UINT32
+BlendPixel (
+  IN UINT32 Keyboard,
+  IN UINT32 Background
   )
 {
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *TempBltBuffer;
-  UINTN                         BltSize;
-  BOOLEAN                       IsPressed;
-
-  TempBltBuffer = *BltBuffer;
-  BltSize       = VkContext->VkBodyBltHeight * VkContext->VkBodyBltWidth;
-  IsPressed     = VkContext->PageNumber <= VkPage1 ?
-                  VkContext->IsCapsLockFlag :
-                  VkContext->IsShiftKeyFlag;
+  UINT32 RedBlue;
+  UINT32 Green;
 
-  while (BltSize-- != 0) {
-    //
-    // Color gradient issue
-    //
-    if (((TempBltBuffer->Red - TempBltBuffer->Green) > 0x20) &&
-        ((TempBltBuffer->Red - TempBltBuffer->Blue)  > 0x20)) {
-      if (IsPressed) {
-        TempBltBuffer->Red   = 0;
-        TempBltBuffer->Green = 255;
-        TempBltBuffer->Blue  = 255;
-      } else {
-        TempBltBuffer->Red   = 255;
-        TempBltBuffer->Green = 255;
-        TempBltBuffer->Blue  = 255;
-      }
-    }
-    TempBltBuffer++;
-  }
+  RedBlue = ((Keyboard & 0x00FF00FF) * TRANSPARENCY_KEYBOARD_WEIGHT_FP +
+             (Background & 0x00FF00FF) * TRANSPARENCY_BACKGROUND_WEIGHT_FP) >> 8;
+  Green   = ((Keyboard & 0x0000FF00) * TRANSPARENCY_KEYBOARD_WEIGHT_FP +
+             (Background & 0x0000FF00) * TRANSPARENCY_BACKGROUND_WEIGHT_FP) >> 8;
 
-  return EFI_SUCCESS;
+  return (RedBlue & 0x00FF00FF) | (Green & 0x0000FF00);
 }
 
 /**
-  Make the keyboard transparent.
+  Make a rectangle of the keyboard transparent.
 
-  @param[in]      VkContext      Address of an VK_CONTEXT structure.
-  @param[in]      IsTransparent  TRUE for set keyboard transparent.
-  @param[in]      BltIn          Address of keyboard blt buffer.
-  @param[in, out] BltOut         Address of output blt buffer.
-                                 NULL will allocate it.
+  Compose the keyboard image over the saved background into the compound blt buffer.
+  The color of the Shift or CapsLock key is modified on the fly if it is pressed.
+
+  @param[in]  VkContext      Address of an VK_CONTEXT structure.
+  @param[in]  VkImage        Keyboard image, same size as the keyboard body.
+  @param[in]  IsPressed      TRUE if Shift or CapsLock is pressed.
+  @param[in]  StartX         X of the rectangle in the keyboard body.
+  @param[in]  StartY         Y of the rectangle in the keyboard body.
+  @param[in]  Width          Width of the rectangle.
+  @param[in]  Height         Height of the rectangle.
+  @param[out] IsChanged      TRUE if any pixel of the compound blt buffer changed.
 
   @retval EFI_SUCCESS            Success for the function.
   @retval EFI_OUT_OF_RESOURCES   Allocate memory failed.
@@ -238,38 +227,57 @@ ModifyShiftKeyColor (
 **/
 EFI_STATUS
 MakeKeyboardTransparent (
-  IN     VK_CONTEXT                    *VkContext,
-  IN     BOOLEAN                       IsTransparent,
-  IN     EFI_GRAPHICS_OUTPUT_BLT_PIXEL *BltIn,
-  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL **BltOut
+  IN  VK_CONTEXT      *VkContext,
+  IN  EFI_IMAGE_INPUT *VkImage,
+  IN  BOOLEAN         IsPressed,
+  IN  UINTN           StartX,
+  IN  UINTN           StartY,
+  IN  UINTN           Width,
+  IN  UINTN           Height,
+  OUT BOOLEAN         *IsChanged
   )
 {
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Compound;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Keyboard;
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Background;
-  UINTN                         BltSize;
-
-  if (*BltOut == NULL) {
-    *BltOut = AllocateZeroPool (VkContext->VkBodyBltSize);
-    if (*BltOut == NULL) {
+  UINT32                        *Background;
+  UINT32                        *Compound;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL Pixel;
+  UINT32                        KeyboardPixel;
+  UINT32                        CompoundPixel;
+  UINTN                         Offset;
+  UINTN                         X;
+  UINTN                         Y;
+
+  *IsChanged = FALSE;
+  if (VkContext->VkBodyCompoundBltBuffer == NULL) {
+    VkContext->VkBodyCompoundBltBuffer = AllocateZeroPool (VkContext->VkBodyBltSize);
+    if (VkContext->VkBodyCompoundBltBuffer == NULL) {
       return EFI_OUT_OF_RESOURCES;
     }
   }
-  Compound   = *BltOut;
-  Keyboard   = BltIn;
-  Background = VkContext->VkBodyBackgroundBltBuffer;
-  BltSize    = VkContext->VkBodyBltHeight * VkContext->VkBodyBltWidth;
-  while (BltSize-- != 0) {
-    if (IsTransparent) {
-      Compound->Red   = (Keyboard->Red * TRANSPARENCY_WEIGHT) / 100 + (Background->Red * (100 - TRANSPARENCY_WEIGHT)) / 100;
-      Compound->Green = (Keyboard->Green * TRANSPARENCY_WEIGHT) / 100 + (Background->Green * (100 - TRANSPARENCY_WEIGHT)) / 100;
-      Compound->Blue  = (Keyboard->Blue * TRANSPARENCY_WEIGHT) / 100 + (Background->Blue * (100 - TRANSPARENCY_WEIGHT)) / 100;
-    } else {
-      *Compound = *Keyboard;
+
+  for (Y = StartY; Y < StartY + Height; Y++) {
+    Offset     = Y * VkContext->VkBodyBltWidth + StartX;
+    Keyboard   = &VkImage->Bitmap[Offset];
+    Background = (UINT32 *) &VkContext->VkBodyBackgroundBltBuffer[Offset];
+    Compound   = (UINT32 *) &VkContext->VkBodyCompoundBltBuffer[Offset];
+    for (X = 0; X < Width; X++) {
+      Pixel = Keyboard[X];
+      //
+      // Color gradient issue
+      //
+      if (((Pixel.Red - Pixel.Green) > 0x20) &&
+          ((Pixel.Red - Pixel.Blue)  > 0x20)) {
+        Pixel.Red   = IsPressed ? 0 : 255;
+        Pixel.Green = 255;
+        Pixel.Blue  = 255;
+      }
+      KeyboardPixel = Pixel.Blue | (Pixel.Green << 8) | (Pixel.Red << 16);
+      CompoundPixel = BlendPixel (KeyboardPixel, Background[X]);
+      if (Compound[X] != CompoundPixel) {
+        Compound[X] = CompoundPixel;
+        *IsChanged  = TRUE;
+      }
     }
-    Compound++;
-    Keyboard++;
-    Background++;
   }
 
   return EFI_SUCCESS;
@@ -801,7 +809,8 @@ DrawVkBody (
   UINTN                         Height;
   UINTN                         Width;
   UINTN                         CoordinateY;
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *BltIn;
+  BOOLEAN                       IsPressed;
+  BOOLEAN                       IsChanged;
   EFI_GRAPHICS_OUTPUT_PROTOCOL  *GraphicsOutput;
 
   Status         = EFI_SUCCESS;
@@ -812,11 +821,9 @@ DrawVkBody (
   Height         = VkImage->Height;
   Width          = VkImage->Width;
   BltSize        = sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL) * (UINT32)(Width * Height);
-  BltIn          = AllocateCopyPool (BltSize, VkImage->Bitmap);
-
-  if (BltIn == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
+  IsPressed      = VkContext->PageNumber <= VkPage1 ?
+                   VkContext->IsCapsLockFlag :
+                   VkContext->IsShiftKeyFlag;
 
   //
   // Calculate the display position according to Attribute.
@@ -874,8 +881,13 @@ DrawVkBody (
       FreePool (VkContext->VkBodyCompoundBltBuffer);
     }
     VkContext->VkBodyCompoundBltBuffer = NULL;
-    ModifyShiftKeyColor (VkContext, &BltIn);
-    MakeKeyboardTransparent (VkContext, TRUE, BltIn, &(VkContext->VkBodyCompoundBltBuffer));
+    VkContext->VkBodyImage             = NULL;
+    Status = MakeKeyboardTransparent (VkContext, VkImage, IsPressed, 0, 0, Width, Height, &IsChanged);
+    if (EFI_ERROR (Status)) {
+      goto DVKBODY_Exit;
+    }
+    VkContext->VkBodyImage        = VkImage;
+    VkContext->VkBodyShiftPressed = IsPressed;
 
     //
     // Draw keyboard body
@@ -896,10 +908,6 @@ DrawVkBody (
 
 
 DVKBODY_Exit:
-  if (BltIn != NULL) {
-    FreePool (BltIn);
-  }
-
   return Status;
 }
 
@@ -918,10 +926,147 @@ HideVkBody (
 {
   RestoreVkBodyBackgroundBltBuffer (VkContext);
   VkContext->CurrentKeyboardDisplay = VkDisplayAttributeNone;
+  VkContext->VkBodyImage            = NULL;
 
   return EFI_SUCCESS;
 }
 
+/**
+  Update the displayed keyboard body after the page, Shift or CapsLock changed.
+
+  The keyboard stays at the same place, so the saved background is still valid and
+  the body is composed again without hiding it. If only the Shift or CapsLock key
+  color changed, only the keys whose pixels changed are sent to the display.
+
+  @param[in] VkContext          Code context.
+
+  @retval EFI_SUCCESS           Keyboard body is updated.
+  @retval Others                An unexpected error occurred.
+
+**/
+EFI_STATUS
+UpdateVkBody (
+  IN VK_CONTEXT *VkContext
+  )
+{
+  EFI_STATUS      Status;
+  EFI_IMAGE_INPUT *VkImage;
+  BOOLEAN         IsPressed;
+  BOOLEAN         IsChanged;
+  UINTN           Index;
+  UINTN           StartX;
+  UINTN           StartY;
+  UINTN           Width;
+  UINTN           Height;
+
+  switch (VkContext->CurrentKeyboardDisplay) {
+  case VkDisplayAttributeSimpleTop:
+  case VkDisplayAttributeSimpleBottom:
+    VkImage = VkContext->SimKeyBody;
+    break;
+
+  case VkDisplayAttributeFullTop:
+  case VkDisplayAttributeFullBottom:
+    VkImage = VkContext->PageNumber <= VkPage1 ? VkContext->CapLeKeyBody : VkContext->DigKeyBody;
+    break;
+
+  default:
+    VkImage = NULL;
+    break;
+  }
+
+  if ((VkImage == NULL) ||
+      (VkContext->VkBodyImage == NULL) ||
+      (VkContext->VkBodyBackgroundBltBuffer == NULL) ||
+      (VkContext->VkBodyCompoundBltBuffer == NULL) ||
+      (VkImage->Width != VkContext->VkBodyBltWidth) ||
+      (VkImage->Height != VkContext->VkBodyBltHeight)) {
+    HideVkBody (VkContext);
+    return DrawKeyboardLayout (VkContext);
+  }
+
+  IsPressed = VkContext->PageNumber <= VkPage1 ?
+              VkContext->IsCapsLockFlag :
+              VkContext->IsShiftKeyFlag;
+  if ((VkImage == VkContext->VkBodyImage) && (IsPressed == VkContext->VkBodyShiftPressed)) {
+    return EFI_SUCCESS;
+  }
+
+  if (VkImage != VkContext->VkBodyImage) {
+    //
+    // Page changed, redraw the whole body.
+    //
+    VkContext->VkBodyImage = NULL;
+    Status = MakeKeyboardTransparent (VkContext, VkImage, IsPressed, 0, 0, VkImage->Width, VkImage->Height, &IsChanged);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Status = VkContext->GraphicsOutput->Blt (
+                                          VkContext->GraphicsOutput,
+                                          VkContext->VkBodyCompoundBltBuffer,
+                                          EfiBltBufferToVideo,
+                                          0,
+                                          0,
+                                          VkContext->VkBodyBltStartX,
+                                          VkContext->VkBodyBltStartY,
+                                          VkContext->VkBodyBltWidth,
+                                          VkContext->VkBodyBltHeight,
+                                          VkContext->VkBodyBltWidth * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+                                          );
+  } else {
+    //
+    // Only the Shift or CapsLock key color changed, redraw the keys that changed.
+    // The last four entries are the screen corner icons.
+    //
+    Status = EFI_SUCCESS;
+    for (Index = 0; Index < (VkContext->NumOfKeysInfo - 4); Index++) {
+      //
+      // Skip the keys that are not fully inside the keyboard body.
+      //
+      if ((VkContext->KeyboardBodyPtr[Index].DisStartX < VkContext->VkBodyBltStartX) ||
+          (VkContext->KeyboardBodyPtr[Index].DisStartY < VkContext->VkBodyBltStartY) ||
+          (VkContext->KeyboardBodyPtr[Index].DisEndX < VkContext->KeyboardBodyPtr[Index].DisStartX) ||
+          (VkContext->KeyboardBodyPtr[Index].DisEndY < VkContext->KeyboardBodyPtr[Index].DisStartY)) {
+        continue;
+      }
+
+      StartX = VkContext->KeyboardBodyPtr[Index].DisStartX - VkContext->VkBodyBltStartX;
+      StartY = VkContext->KeyboardBodyPtr[Index].DisStartY - VkContext->VkBodyBltStartY;
+      Width  = VkContext->KeyboardBodyPtr[Index].DisEndX - VkContext->KeyboardBodyPtr[Index].DisStartX;
+      Height = VkContext->KeyboardBodyPtr[Index].DisEndY - VkContext->KeyboardBodyPtr[Index].DisStartY;
+      if ((StartX > VkContext->VkBodyBltWidth) || (Width > VkContext->VkBodyBltWidth - StartX) ||
+          (StartY > VkContext->VkBodyBltHeight) || (Height > VkContext->VkBodyBltHeight - StartY)) {
+        continue;
+      }
+
+      Status = MakeKeyboardTransparent (VkContext, VkImage, IsPressed, StartX, StartY, Width, Height, &IsChanged);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+      if (!IsChanged) {
+        continue;
+      }
+      Status = VkContext->GraphicsOutput->Blt (
+                                            VkContext->GraphicsOutput,
+                                            VkContext->VkBodyCompoundBltBuffer,
+                                            EfiBltBufferToVideo,
+                                            StartX,
+                                            StartY,
+                                            VkContext->VkBodyBltStartX + StartX,
+                                            VkContext->VkBodyBltStartY + StartY,
+                                            Width,
+                                            Height,
+                                            VkContext->VkBodyBltWidth * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+                                            );
+    }
+  }
+
+  VkContext->VkBodyImage        = VkImage;
+  VkContext->VkBodyShiftPressed = IsPressed;
+
+  return Status;
+}
+
 
 /**
   Clear the keyboard icon
@@ -103,6 +103,12 @@ extern EFI_COMPONENT_NAME2_PROTOCOL  gVirtualKeyboardComponentName2;
 ///
 #define TRANSPARENCY_WEIGHT 50
 
+///
+/// Transparent weight of keyboard and background in 1/256 for the fixed-point blend
+///
+#define TRANSPARENCY_KEYBOARD_WEIGHT_FP    ((TRANSPARENCY_WEIGHT * 256 + 50) / 100)
+#define TRANSPARENCY_BACKGROUND_WEIGHT_FP  (256 - TRANSPARENCY_KEYBOARD_WEIGHT_FP)
+
 typedef struct _VK_CONTEXT VK_CONTEXT;
 
 typedef enum _VK_KEY_TYPE {
@@ -272,6 +278,13 @@ struct _VK_CONTEXT {
   UINTN                             VkBodyBltWidth;
   BOOLEAN                           IsBackgroundChanged;
 
+  ///
+  /// Keyboard image and Shift/CapsLock key color in the compound buffer,
+  /// used to redraw only the keys that changed
+  ///
+  EFI_IMAGE_INPUT                   *VkBodyImage;
+  BOOLEAN                           VkBodyShiftPressed;
+
   ///
   /// Icon buffer information
   ///
@@ -607,6 +620,20 @@ HideVkBody (
   IN VK_CONTEXT *VkContext
   );
 
+/**
+  Update the displayed keyboard body after the page, Shift or CapsLock changed.
+
+  @param[in] VkContext          Code context.
+
+  @retval EFI_SUCCESS           Keyboard body is updated.
+  @retval Others                An unexpected error occurred.
+
+**/
+EFI_STATUS
+UpdateVkBody (
+  IN VK_CONTEXT *VkContext
+  );
+
 /**
   Clear the keyboard icon
 
@@ -264,6 +264,22 @@ TestPointEndOfDxeDmaProtectionEnabled (
   VOID
   );
 
+/**
+  This service records the end of DXE for the boot performance budget check.
+
+  Test subject: Boot performance.
+  Test overview: Takes the End Of DXE timestamp, which has no FPDT record of its own.
+  Reporting mechanism: None. The result is checked at Ready To Boot.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfDxeBootPerformance (
+  VOID
+  );
+
 /**
   This service verifies the validity of System Management RAM (SMRAM) alignment at SMM Ready To Lock.
 
@@ -521,6 +537,26 @@ TestPointReadyToBootTcgMorEnabled (
   VOID
   );
 
+/**
+  This service verifies the boot phases and modules stay within the platform time budgets.
+
+  Test subject: Boot performance.
+  Test overview: Splits the FPDT boot records into the PreMem, PostMem, End Of DXE and
+                 Ready To Boot phases, attributes the time to each PEIM and driver, and
+                 compares both against the budget PCDs.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the phase and module times to the debug log.
+                       Installs the TEST_POINT_BOOT_PERFORMANCE configuration table.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointReadyToBootBootPerformanceBudget (
+  VOID
+  );
+
 /**
   This service verifies SMI handler profiling.
 
@@ -770,6 +806,25 @@ TestPointSmmExitBootServices (
 #define   TEST_POINT_BYTE8_READY_TO_BOOT_HSTI_TABLE_FUNCTIONAL_ERROR_CODE                        L"0x08010000"
 #define   TEST_POINT_BYTE8_READY_TO_BOOT_HSTI_TABLE_FUNCTIONAL_ERROR_STRING                      L"No HSTI\r\n"
 
+// Byte 9 - Performance
+#define TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_PHASE_BUDGET                                    BIT0
+#define TEST_POINT_BYTE9_READY_TO_BOOT_MODULE_BUDGET                                        BIT1
+#define   TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_PHASE_BUDGET_ERROR_CODE                            L"0x09000000"
+#define   TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_PHASE_BUDGET_ERROR_STRING                          L"Boot phase over budget\r\n"
+#define   TEST_POINT_BYTE9_READY_TO_BOOT_MODULE_BUDGET_ERROR_CODE                                L"0x09010000"
+#define   TEST_POINT_BYTE9_READY_TO_BOOT_MODULE_BUDGET_ERROR_STRING                              L"Module over budget\r\n"
+
+//
+// Boot phases measured by TestPointReadyToBootBootPerformanceBudget().
+//
+#define TEST_POINT_BOOT_PHASE_PRE_MEM        0
+#define TEST_POINT_BOOT_PHASE_POST_MEM       1
+#define TEST_POINT_BOOT_PHASE_END_OF_DXE     2
+#define TEST_POINT_BOOT_PHASE_READY_TO_BOOT  3
+#define TEST_POINT_BOOT_PHASE_MAX            4
+
+#define TEST_POINT_BOOT_PERFORMANCE_VERSION  1
+
 #pragma pack (1)
 
 typedef struct {
@@ -782,6 +837,34 @@ typedef struct {
   CHAR16  End;
 } ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT;
 
+//
+// All times are in nanoseconds, budgets in microseconds. A phase with End 0 was not
+// measured, a budget of 0 means no budget.
+//
+typedef struct {
+  UINT64  Start;
+  UINT64  End;
+  UINT32  Budget;
+  UINT32  Reserved;
+} TEST_POINT_BOOT_PHASE_TIME;
+
+typedef struct {
+  EFI_GUID  FileName;
+  UINT64    Time;
+} TEST_POINT_MODULE_TIME;
+
+//
+// Configuration table gTestPointBootPerformanceGuid.
+//
+typedef struct {
+  UINT32                      Version;
+  UINT32                      ModuleCount;
+  UINT32                      ModuleBudget;
+  UINT32                      Reserved;
+  TEST_POINT_BOOT_PHASE_TIME  Phase[TEST_POINT_BOOT_PHASE_MAX];
+//TEST_POINT_MODULE_TIME      Module[ModuleCount];  // Sorted by time, longest first
+} TEST_POINT_BOOT_PERFORMANCE;
+
 #pragma pack ()
 
 #endif
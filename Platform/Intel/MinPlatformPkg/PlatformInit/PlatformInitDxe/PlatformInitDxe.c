@@ -74,6 +74,8 @@ OnEndOfDxe (
 {
   gBS->CloseEvent (Event);
 
+  TestPointEndOfDxeBootPerformance ();
+
   TestPointEndOfDxeNoThirdPartyPciOptionRom ();
 
   TestPointEndOfDxeDmaAcpiTableFunctional ();
@@ -138,6 +140,11 @@ OnReadyToBootLater (
 
   gBS->CloseEvent (Event);
 
+  //
+  // Check the boot performance first, before the other test points add to the Ready To Boot time.
+  //
+  TestPointReadyToBootBootPerformanceBudget ();
+
   TestPointReadyToBootMemoryTypeInformationFunctional ();
   TestPointReadyToBootUefiMemoryAttributeTableFunctional ();
   TestPointReadyToBootUefiBootVariableFunctional ();
@@ -0,0 +1,444 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <PiDxe.h>
+#include <Library/TestPointCheckLib.h>
+#include <Library/TestPointLib.h>
+#include <Library/DebugLib.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Library/PerformanceLib.h>
+#include <IndustryStandard/Acpi.h>
+#include <Guid/FirmwarePerformance.h>
+#include <Guid/ExtendedFirmwarePerformance.h>
+
+//
+// Number of the longest modules dumped even when they are within the budget.
+//
+#define TEST_POINT_MODULE_DUMP_COUNT  16
+
+VOID *
+TestPointGetAcpi (
+  IN UINT32  Signature
+  );
+
+CHAR8 *mBootPhaseName[TEST_POINT_BOOT_PHASE_MAX] = {
+  "PreMem",
+  "PostMem",
+  "EndOfDxe",
+  "ReadyToBoot",
+};
+
+GLOBAL_REMOVE_IF_UNREFERENCED UINT64  mTestPointEndOfDxeTime;
+
+/**
+  Record the End Of DXE timestamp, in the FPDT timebase.
+**/
+VOID
+TestPointRecordEndOfDxeTime (
+  VOID
+  )
+{
+  mTestPointEndOfDxeTime = GetTimeInNanoSecond (GetPerformanceCounter ());
+}
+
+/**
+  Return the string of an FPDT extended record.
+
+  @param[in] RecordPtr   The FPDT record.
+
+  @return The ASCII string of the record, NULL if the record type has none.
+**/
+CHAR8 *
+GetFpdtRecordString (
+  IN FPDT_RECORD_PTR  RecordPtr
+  )
+{
+  switch (RecordPtr.RecordHeader->Type) {
+  case FPDT_DYNAMIC_STRING_EVENT_TYPE:
+    return RecordPtr.DynamicStringEvent->String;
+  case FPDT_DUAL_GUID_STRING_EVENT_TYPE:
+    return RecordPtr.DualGuidStringEvent->String;
+  case FPDT_GUID_QWORD_STRING_EVENT_TYPE:
+    return RecordPtr.GuidQwordStringEvent->String;
+  default:
+    return NULL;
+  }
+}
+
+/**
+  Get the extended records of the FPDT boot performance table.
+
+  @param[out] RecordStart   The first record.
+  @param[out] RecordEnd     The end of the records.
+
+  @retval EFI_SUCCESS       The records are found.
+  @retval EFI_NOT_FOUND     There is no FPDT or boot performance table.
+**/
+EFI_STATUS
+GetBootPerformanceRecords (
+  OUT UINT8  **RecordStart,
+  OUT UINT8  **RecordEnd
+  )
+{
+  FIRMWARE_PERFORMANCE_TABLE  *Fpdt;
+  BOOT_PERFORMANCE_TABLE      *BootTable;
+
+  Fpdt = TestPointGetAcpi (EFI_ACPI_5_0_FIRMWARE_PERFORMANCE_DATA_TABLE_SIGNATURE);
+  if (Fpdt == NULL || Fpdt->BootPointerRecord.BootPerformanceTablePointer == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  BootTable = (BOOT_PERFORMANCE_TABLE *)(UINTN)Fpdt->BootPointerRecord.BootPerformanceTablePointer;
+  if (BootTable->Header.Signature != EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_SIGNATURE ||
+      BootTable->Header.Length < sizeof(BOOT_PERFORMANCE_TABLE)) {
+    return EFI_NOT_FOUND;
+  }
+
+  *RecordStart = (UINT8 *)BootTable + sizeof(BOOT_PERFORMANCE_TABLE);
+  *RecordEnd   = (UINT8 *)BootTable + BootTable->Header.Length;
+  return EFI_SUCCESS;
+}
+
+/**
+  Find the phase boundaries in the FPDT records.
+
+  PEI core logs PreMem begin/end and PostMem begin around the memory installation,
+  DxeIpl logs PostMem end, and DXE core logs the end of PEI and the begin of DXE.
+  End Of DXE has no record of its own and comes from TestPointRecordEndOfDxeTime().
+
+  @param[in]  RecordStart   The first record.
+  @param[in]  RecordEnd     The end of the records.
+  @param[out] Phase         The phase times.
+**/
+VOID
+GetBootPhaseTime (
+  IN  UINT8                       *RecordStart,
+  IN  UINT8                       *RecordEnd,
+  OUT TEST_POINT_BOOT_PHASE_TIME  *Phase
+  )
+{
+  FPDT_RECORD_PTR  RecordPtr;
+  UINT8            *Record;
+  CHAR8            *String;
+  UINT64           Timestamp;
+  UINT64           PreMemStart;
+  UINT64           PreMemEnd;
+  UINT64           PostMemStart;
+  UINT64           PostMemEnd;
+  UINT64           PeiEnd;
+  UINT64           DxeStart;
+  BOOLEAN          PreMemFound;
+
+  PreMemStart  = 0;
+  PreMemEnd    = 0;
+  PostMemStart = 0;
+  PostMemEnd   = 0;
+  PeiEnd       = 0;
+  DxeStart     = 0;
+  PreMemFound  = FALSE;
+
+  for (Record = RecordStart; Record + sizeof(EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER) <= RecordEnd; Record += RecordPtr.RecordHeader->Length) {
+    RecordPtr.RecordHeader = (EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *)Record;
+    if (RecordPtr.RecordHeader->Length == 0) {
+      break;
+    }
+    String = GetFpdtRecordString (RecordPtr);
+    if (String == NULL) {
+      continue;
+    }
+
+    Timestamp = RecordPtr.DynamicStringEvent->Timestamp;
+    switch (RecordPtr.DynamicStringEvent->ProgressID) {
+    case PERF_INMODULE_START_ID:
+      if (AsciiStrCmp (String, "PreMem") == 0) {
+        PreMemStart = Timestamp;
+        PreMemFound = TRUE;
+      } else if (AsciiStrCmp (String, "PostMem") == 0) {
+        PostMemStart = Timestamp;
+      }
+      break;
+    case PERF_INMODULE_END_ID:
+      if (AsciiStrCmp (String, "PreMem") == 0) {
+        PreMemEnd = Timestamp;
+      } else if (AsciiStrCmp (String, "PostMem") == 0) {
+        PostMemEnd = Timestamp;
+      }
+      break;
+    case PERF_CROSSMODULE_START_ID:
+      if (AsciiStrCmp (String, "DXE") == 0) {
+        DxeStart = Timestamp;
+      }
+      break;
+    case PERF_CROSSMODULE_END_ID:
+      if (AsciiStrCmp (String, "PEI") == 0) {
+        PeiEnd = Timestamp;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  if (PreMemEnd == 0) {
+    PreMemEnd = PostMemStart;
+  }
+  if (PostMemStart == 0) {
+    PostMemStart = PreMemEnd;
+  }
+  if (PostMemEnd == 0) {
+    PostMemEnd = (PeiEnd != 0) ? PeiEnd : DxeStart;
+  }
+  if (DxeStart == 0) {
+    DxeStart = PostMemEnd;
+  }
+
+  if (PreMemFound && PreMemEnd >= PreMemStart) {
+    Phase[TEST_POINT_BOOT_PHASE_PRE_MEM].Start = PreMemStart;
+    Phase[TEST_POINT_BOOT_PHASE_PRE_MEM].End   = PreMemEnd;
+  }
+  if (PostMemStart != 0 && PostMemEnd >= PostMemStart) {
+    Phase[TEST_POINT_BOOT_PHASE_POST_MEM].Start = PostMemStart;
+    Phase[TEST_POINT_BOOT_PHASE_POST_MEM].End   = PostMemEnd;
+  }
+  if (DxeStart != 0 && mTestPointEndOfDxeTime >= DxeStart) {
+    Phase[TEST_POINT_BOOT_PHASE_END_OF_DXE].Start = DxeStart;
+    Phase[TEST_POINT_BOOT_PHASE_END_OF_DXE].End   = mTestPointEndOfDxeTime;
+  }
+  if (mTestPointEndOfDxeTime != 0) {
+    Phase[TEST_POINT_BOOT_PHASE_READY_TO_BOOT].Start = mTestPointEndOfDxeTime;
+    Phase[TEST_POINT_BOOT_PHASE_READY_TO_BOOT].End   = GetTimeInNanoSecond (GetPerformanceCounter ());
+  }
+
+  Phase[TEST_POINT_BOOT_PHASE_PRE_MEM].Budget       = PcdGet32 (PcdTestPointPerformancePreMemBudget);
+  Phase[TEST_POINT_BOOT_PHASE_POST_MEM].Budget      = PcdGet32 (PcdTestPointPerformancePostMemBudget);
+  Phase[TEST_POINT_BOOT_PHASE_END_OF_DXE].Budget    = PcdGet32 (PcdTestPointPerformanceEndOfDxeBudget);
+  Phase[TEST_POINT_BOOT_PHASE_READY_TO_BOOT].Budget = PcdGet32 (PcdTestPointPerformanceReadyToBootBudget);
+}
+
+/**
+  Attribute the time of the FPDT records to modules.
+
+  Entry points of PEIMs and drivers and Driver Binding Start are paired by the module
+  GUID. Nested calls are included in the time of the outer module.
+
+  @param[in]  RecordStart   The first record.
+  @param[in]  RecordEnd     The end of the records.
+  @param[out] Module        The module table, with one entry per record at most.
+  @param[in]  ModuleStart   Scratch buffer for the pending start, same size as Module.
+
+  @return The number of modules, sorted by time with the longest first.
+**/
+UINTN
+GetModuleTime (
+  IN  UINT8                   *RecordStart,
+  IN  UINT8                   *RecordEnd,
+  OUT TEST_POINT_MODULE_TIME  *Module,
+  IN  UINT64                  *ModuleStart
+  )
+{
+  FPDT_RECORD_PTR         RecordPtr;
+  UINT8                   *Record;
+  EFI_GUID                *Guid;
+  UINT16                  ProgressId;
+  UINTN                   ModuleCount;
+  UINTN                   Index;
+  UINTN                   SortIndex;
+  TEST_POINT_MODULE_TIME  Entry;
+
+  ModuleCount = 0;
+  for (Record = RecordStart; Record + sizeof(EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER) <= RecordEnd; Record += RecordPtr.RecordHeader->Length) {
+    RecordPtr.RecordHeader = (EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *)Record;
+    if (RecordPtr.RecordHeader->Length == 0) {
+      break;
+    }
+    if (RecordPtr.RecordHeader->Type < FPDT_GUID_EVENT_TYPE ||
+        RecordPtr.RecordHeader->Type > FPDT_GUID_QWORD_STRING_EVENT_TYPE) {
+      continue;
+    }
+
+    ProgressId = RecordPtr.GuidEvent->ProgressID;
+    if (ProgressId != MODULE_START_ID && ProgressId != MODULE_END_ID &&
+        ProgressId != MODULE_DB_START_ID && ProgressId != MODULE_DB_END_ID) {
+      continue;
+    }
+
+    if (RecordPtr.RecordHeader->Type == FPDT_DUAL_GUID_STRING_EVENT_TYPE) {
+      Guid = &RecordPtr.DualGuidStringEvent->Guid1;
+    } else {
+      Guid = &RecordPtr.GuidEvent->Guid;
+    }
+
+    for (Index = 0; Index < ModuleCount; Index++) {
+      if (CompareGuid (&Module[Index].FileName, Guid)) {
+        break;
+      }
+    }
+    if (Index == ModuleCount) {
+      if (ProgressId == MODULE_END_ID || ProgressId == MODULE_DB_END_ID) {
+        continue;
+      }
+      CopyGuid (&Module[Index].FileName, Guid);
+      Module[Index].Time  = 0;
+      ModuleStart[Index]  = MAX_UINT64;
+      ModuleCount++;
+    }
+
+    if (ProgressId == MODULE_START_ID || ProgressId == MODULE_DB_START_ID) {
+      if (ModuleStart[Index] == MAX_UINT64) {
+        ModuleStart[Index] = RecordPtr.GuidEvent->Timestamp;
+      }
+    } else if (ModuleStart[Index] != MAX_UINT64) {
+      if (RecordPtr.GuidEvent->Timestamp > ModuleStart[Index]) {
+        Module[Index].Time += RecordPtr.GuidEvent->Timestamp - ModuleStart[Index];
+      }
+      ModuleStart[Index] = MAX_UINT64;
+    }
+  }
+
+  for (Index = 1; Index < ModuleCount; Index++) {
+    CopyMem (&Entry, &Module[Index], sizeof(Entry));
+    for (SortIndex = Index; SortIndex > 0 && Module[SortIndex - 1].Time < Entry.Time; SortIndex--) {
+      CopyMem (&Module[SortIndex], &Module[SortIndex - 1], sizeof(Entry));
+    }
+    CopyMem (&Module[SortIndex], &Entry, sizeof(Entry));
+  }
+
+  return ModuleCount;
+}
+
+EFI_STATUS
+TestPointCheckBootPerformance (
+  OUT BOOLEAN  *PhaseResult,
+  OUT BOOLEAN  *ModuleResult
+  )
+{
+  EFI_STATUS                   Status;
+  UINT8                        *RecordStart;
+  UINT8                        *RecordEnd;
+  UINTN                        RecordCount;
+  UINT8                        *Record;
+  UINTN                        ModuleCount;
+  UINT64                       *ModuleStart;
+  TEST_POINT_BOOT_PERFORMANCE  *Performance;
+  TEST_POINT_MODULE_TIME       *Module;
+  TEST_POINT_BOOT_PHASE_TIME   *Phase;
+  UINT64                       Time;
+  UINTN                        Index;
+
+  DEBUG ((DEBUG_INFO, "==== TestPointCheckBootPerformance - Enter\n"));
+
+  *PhaseResult  = TRUE;
+  *ModuleResult = TRUE;
+
+  Status = GetBootPerformanceRecords (&RecordStart, &RecordEnd);
+  if (EFI_ERROR(Status)) {
+    DEBUG ((DEBUG_ERROR, "No FPDT boot performance table\n"));
+    *PhaseResult  = FALSE;
+    *ModuleResult = FALSE;
+    goto Done;
+  }
+
+  RecordCount = 0;
+  for (Record = RecordStart; Record + sizeof(EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER) <= RecordEnd; Record += ((EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *)Record)->Length) {
+    if (((EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *)Record)->Length == 0) {
+      break;
+    }
+    RecordCount++;
+  }
+
+  Performance = AllocateZeroPool (sizeof(TEST_POINT_BOOT_PERFORMANCE) + RecordCount * sizeof(TEST_POINT_MODULE_TIME));
+  ModuleStart = AllocatePool (RecordCount * sizeof(UINT64));
+  if (Performance == NULL || ModuleStart == NULL) {
+    if (Performance != NULL) {
+      FreePool (Performance);
+    }
+    if (ModuleStart != NULL) {
+      FreePool (ModuleStart);
+    }
+    *PhaseResult  = FALSE;
+    *ModuleResult = FALSE;
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Phase  = Performance->Phase;
+  Module = (TEST_POINT_MODULE_TIME *)(Performance + 1);
+  GetBootPhaseTime (RecordStart, RecordEnd, Phase);
+  ModuleCount = GetModuleTime (RecordStart, RecordEnd, Module, ModuleStart);
+  FreePool (ModuleStart);
+
+  Performance->Version      = TEST_POINT_BOOT_PERFORMANCE_VERSION;
+  Performance->ModuleCount  = (UINT32)ModuleCount;
+  Performance->ModuleBudget = PcdGet32 (PcdTestPointPerformanceModuleBudget);
+
+  DEBUG ((DEBUG_INFO, "Boot Phase      Time(us)    Budget(us)\n"));
+  for (Index = 0; Index < TEST_POINT_BOOT_PHASE_MAX; Index++) {
+    if (Phase[Index].End == 0) {
+      DEBUG ((DEBUG_INFO, "  %-12s  not measured\n", mBootPhaseName[Index]));
+      if (Phase[Index].Budget != 0) {
+        *PhaseResult = FALSE;
+      }
+      continue;
+    }
+    Time = DivU64x32 (Phase[Index].End - Phase[Index].Start, 1000);
+    DEBUG ((DEBUG_INFO, "  %-12s  %10ld  %10d", mBootPhaseName[Index], Time, Phase[Index].Budget));
+    if (Phase[Index].Budget != 0 && Time > Phase[Index].Budget) {
+      DEBUG ((DEBUG_INFO, "  <== over budget"));
+      *PhaseResult = FALSE;
+    }
+    DEBUG ((DEBUG_INFO, "\n"));
+  }
+
+  DEBUG ((DEBUG_INFO, "Module                                  Time(us)\n"));
+  for (Index = 0; Index < ModuleCount; Index++) {
+    Time = DivU64x32 (Module[Index].Time, 1000);
+    if (Performance->ModuleBudget != 0 && Time > Performance->ModuleBudget) {
+      DEBUG ((DEBUG_INFO, "  %g  %10ld  <== over budget %d\n", &Module[Index].FileName, Time, Performance->ModuleBudget));
+      *ModuleResult = FALSE;
+    } else if (Index < TEST_POINT_MODULE_DUMP_COUNT) {
+      DEBUG ((DEBUG_INFO, "  %g  %10ld\n", &Module[Index].FileName, Time));
+    } else {
+      break;
+    }
+  }
+
+  Status = gBS->InstallConfigurationTable (&gTestPointBootPerformanceGuid, Performance);
+  if (EFI_ERROR(Status)) {
+    FreePool (Performance);
+  }
+  Status = EFI_SUCCESS;
+
+Done:
+  if (!*PhaseResult) {
+    TestPointLibAppendErrorString (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_PHASE_BUDGET_ERROR_CODE \
+        TEST_POINT_READY_TO_BOOT \
+        TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_PHASE_BUDGET_ERROR_STRING
+      );
+  }
+  if (!*ModuleResult) {
+    TestPointLibAppendErrorString (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      TEST_POINT_BYTE9_READY_TO_BOOT_MODULE_BUDGET_ERROR_CODE \
+        TEST_POINT_READY_TO_BOOT \
+        TEST_POINT_BYTE9_READY_TO_BOOT_MODULE_BUDGET_ERROR_STRING
+      );
+  }
+  DEBUG ((DEBUG_INFO, "==== TestPointCheckBootPerformance - Exit\n"));
+
+  return Status;
+}
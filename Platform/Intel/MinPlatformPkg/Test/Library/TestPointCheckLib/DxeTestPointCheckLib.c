@@ -153,6 +153,17 @@ TestPointGetAcpi (
   IN UINT32  Signature
   );
 
+VOID
+TestPointRecordEndOfDxeTime (
+  VOID
+  );
+
+EFI_STATUS
+TestPointCheckBootPerformance (
+  OUT BOOLEAN  *PhaseResult,
+  OUT BOOLEAN  *ModuleResult
+  );
+
 GLOBAL_REMOVE_IF_UNREFERENCED ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT  mTestPointStruct = {
   PLATFORM_TEST_POINT_VERSION,
   PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
@@ -1241,6 +1252,82 @@ TestPointReadyToBootTcgMorEnabled (
   return EFI_SUCCESS;
 }
 
+/**
+  This service records the end of DXE for the boot performance budget check.
+
+  Test subject: Boot performance.
+  Test overview: Takes the End Of DXE timestamp, which has no FPDT record of its own.
+  Reporting mechanism: None. The result is checked at Ready To Boot.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfDxeBootPerformance (
+  VOID
+  )
+{
+  if ((mFeatureImplemented[9] & (TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_PHASE_BUDGET | TEST_POINT_BYTE9_READY_TO_BOOT_MODULE_BUDGET)) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  TestPointRecordEndOfDxeTime ();
+  return EFI_SUCCESS;
+}
+
+/**
+  This service verifies the boot phases and modules stay within the platform time budgets.
+
+  Test subject: Boot performance.
+  Test overview: Splits the FPDT boot records into the PreMem, PostMem, End Of DXE and
+                 Ready To Boot phases, attributes the time to each PEIM and driver, and
+                 compares both against the budget PCDs.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the phase and module times to the debug log.
+                       Installs the TEST_POINT_BOOT_PERFORMANCE configuration table.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointReadyToBootBootPerformanceBudget (
+  VOID
+  )
+{
+  BOOLEAN  PhaseResult;
+  BOOLEAN  ModuleResult;
+
+  if ((mFeatureImplemented[9] & (TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_PHASE_BUDGET | TEST_POINT_BYTE9_READY_TO_BOOT_MODULE_BUDGET)) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointReadyToBootBootPerformanceBudget - Enter\n"));
+
+  TestPointCheckBootPerformance (&PhaseResult, &ModuleResult);
+
+  if (PhaseResult && (mFeatureImplemented[9] & TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_PHASE_BUDGET) != 0) {
+    TestPointLibSetFeaturesVerified (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      9,
+      TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_PHASE_BUDGET
+      );
+  }
+  if (ModuleResult && (mFeatureImplemented[9] & TEST_POINT_BYTE9_READY_TO_BOOT_MODULE_BUDGET) != 0) {
+    TestPointLibSetFeaturesVerified (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      9,
+      TEST_POINT_BYTE9_READY_TO_BOOT_MODULE_BUDGET
+      );
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointReadyToBootBootPerformanceBudget - Exit\n"));
+  return EFI_SUCCESS;
+}
+
 /**
   This service verifies the system state after Exit Boot Services is invoked.
 
@@ -595,6 +595,48 @@ TestPointReadyToBootTcgMorEnabled (
   return EFI_SUCCESS;
 }
 
+/**
+  This service records the end of DXE for the boot performance budget check.
+
+  Test subject: Boot performance.
+  Test overview: Takes the End Of DXE timestamp, which has no FPDT record of its own.
+  Reporting mechanism: None. The result is checked at Ready To Boot.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfDxeBootPerformance (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  This service verifies the boot phases and modules stay within the platform time budgets.
+
+  Test subject: Boot performance.
+  Test overview: Splits the FPDT boot records into the PreMem, PostMem, End Of DXE and
+                 Ready To Boot phases, attributes the time to each PEIM and driver, and
+                 compares both against the budget PCDs.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps the phase and module times to the debug log.
+                       Installs the TEST_POINT_BOOT_PERFORMANCE configuration table.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointReadyToBootBootPerformanceBudget (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
 /**
   This service verifies SMI handler profiling.
 
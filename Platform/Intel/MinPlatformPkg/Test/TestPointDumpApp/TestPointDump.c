@@ -13,8 +13,16 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DebugLib.h>
 #include <Library/UefiLib.h>
 #include <Library/TestPointLib.h>
+#include <Library/TestPointCheckLib.h>
 #include <Protocol/AdapterInformation.h>
 
+CHAR16 *mBootPhaseName[TEST_POINT_BOOT_PHASE_MAX] = {
+  L"PreMem",
+  L"PostMem",
+  L"EndOfDxe",
+  L"ReadyToBoot",
+};
+
 VOID
 DumpTestPoint (
   IN VOID                     *TestPointData
@@ -159,6 +167,62 @@ DumpTestPointDataDxe (
   FreePool (Handles);
 }
 
+VOID
+DumpBootPerformance (
+  VOID
+  )
+{
+  EFI_STATUS                   Status;
+  TEST_POINT_BOOT_PERFORMANCE  *Performance;
+  TEST_POINT_BOOT_PHASE_TIME   *Phase;
+  TEST_POINT_MODULE_TIME       *Module;
+  UINT64                       Time;
+  UINTN                        Index;
+
+  Status = EfiGetSystemConfigurationTable (&gTestPointBootPerformanceGuid, (VOID **)&Performance);
+  if (EFI_ERROR (Status) || Performance->Version != TEST_POINT_BOOT_PERFORMANCE_VERSION) {
+    return ;
+  }
+
+  Print (L"BootPerformance\n");
+  Print (L"  Phase         Time(us)    Budget(us)\n");
+  for (Index = 0; Index < TEST_POINT_BOOT_PHASE_MAX; Index++) {
+    Phase = &Performance->Phase[Index];
+    if (Phase->End == 0) {
+      Print (L"  %-12s  not measured\n", mBootPhaseName[Index]);
+      continue;
+    }
+    Time = DivU64x32 (Phase->End - Phase->Start, 1000);
+    if (Phase->Budget == 0) {
+      Print (L"  %-12s  %10ld           -\n", mBootPhaseName[Index], Time);
+    } else {
+      Print (
+        L"  %-12s  %10ld  %10d  %s\n",
+        mBootPhaseName[Index],
+        Time,
+        Phase->Budget,
+        (Time > Phase->Budget) ? L"OVER" : L"OK"
+        );
+    }
+  }
+
+  Print (L"  Module budget (us)          - %d\n", Performance->ModuleBudget);
+  Print (L"  Module                                  Time(us)\n");
+  Module = (TEST_POINT_MODULE_TIME *)(Performance + 1);
+  for (Index = 0; Index < Performance->ModuleCount; Index++) {
+    Time = DivU64x32 (Module[Index].Time, 1000);
+    if (Time == 0) {
+      break;
+    }
+    Print (
+      L"  %g  %10ld%s\n",
+      &Module[Index].FileName,
+      Time,
+      (Performance->ModuleBudget != 0 && Time > Performance->ModuleBudget) ? L"  OVER" : L""
+      );
+  }
+}
+
 EFI_STATUS
 EFIAPI
 TestPointDumpAppEntrypoint (
@@ -167,6 +231,7 @@ TestPointDumpAppEntrypoint (
   )
 {
   DumpTestPointDataDxe (0, NULL);
+  DumpBootPerformance ();
 
   return EFI_SUCCESS;
 }
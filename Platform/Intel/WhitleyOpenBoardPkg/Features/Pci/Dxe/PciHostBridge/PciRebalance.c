@@ -116,318 +116,6 @@ LastStackOfSocket (
 }
 
 
-/**
-  Determine the last stack for a given socket with resources
-
-  @param SocketResources   - CPU_RESOURCE structure pointer that stores all resources need per stack
-  @param Socket            - Index of the Socket
-  @param ResourceType      - Type of resource that requires alignment
-  @param LastStack         - Pointer that will store the value of the last stack with resources allocated to it
-  @param ResourceSize      - Pointer that will store the sum of the requested resource type
-
-  @return The last stack with resources allocated to it and the
-          total amount of resoures requested of the type
-          requested.
-*/
-VOID
-LastStackWithResources (
-  IN CPU_RESOURCE       *SocketResources,
-  IN UINT8              Socket,
-  IN PCI_RESOURCE_TYPE  ResourceType,
-  OUT UINT8             *LastStack,
-  OUT UINT64            *ResourceSize
-  )
-{
-  UINT8   Stack;
-
-  *LastStack    = 0;
-  *ResourceSize = 0;
-
-  for (Stack = 0; Stack < MAX_IIO_STACK; Stack++) {
-    if (!(mIioUds->IioUdsPtr->PlatformData.CpuQpiInfo[Socket].stackPresentBitmap & (1 << Stack))) {
-      continue;
-    }
-
-    switch (ResourceType) {
-      case TypeIo:
-        if (SocketResources->StackRes[Stack].NumIoPortsDesired != 0) {
-          *ResourceSize += SocketResources->StackRes[Stack].NumIoPortsDesired + 1;
-          *LastStack = Stack;
-        }
-        break;
-      case TypeMem32:
-        if (SocketResources->StackRes[Stack].MmiolLength != 0) {
-          *ResourceSize += SocketResources->StackRes[Stack].MmiolLength + 1;
-          *LastStack = Stack;
-        }
-        break;
-      case TypeMem64:
-        if (SocketResources->StackRes[Stack].MmiohLength != 0) {
-          *ResourceSize += SocketResources->StackRes[Stack].MmiohLength + 1;
-          *LastStack = Stack;
-        }
-        break;
-      default:
-        break;
-    }
-  }
-}
-
-
-/**
-  Visit all stacks in this socket and recalculate the resource ranges per stack based on resource
-  needs from PCI/PCIe device/functions.
-
-  @param SocketResources   -  CPU_RESOURCE structure pointer that stores all resources need per stack
-  @param Socket            -  Index of the Socket
-  @param ResourceType      -  type of resource that requires alignment
-
-  @retval EFI_SUCCESS            -  Succeed.
-  @retval EFI_OUT_OF_RESOURCES   -  Not enough resources to be adjusted within the socket.
-**/
-EFI_STATUS
-AdjustResources (
-  CPU_RESOURCE *SocketResources,
-  UINT8         Socket,
-  UINT8         ResourceType
-  )
-{
-  UINT8       Stack;
-  UINT64      NewLength;
-  CONST UINT8 LastStack = LastStackOfSocket (Socket);
-  UINT64      PreviousLimit;
-  BOOLEAN     FirstStack = TRUE;
-
-  switch (ResourceType) {
-    case TypeIo:
-      // Return if IoResourceNeeds is not zero which indicates a socket adjustment is needed
-      if(SocketResources->IoResourceNeeds != 0){
-          return EFI_OUT_OF_RESOURCES;
-      }
-
-      for (Stack = 0; Stack < MAX_IIO_STACK; Stack++) {
-
-        if (!(mIioUds->IioUdsPtr->PlatformData.CpuQpiInfo[Socket].stackPresentBitmap & (1 << Stack))){
-          continue;
-        }
-        //
-        // For the first enabled stack, use the base I/O address for the socket, otherwise
-        // calculate the new base based off the last enabled stack
-        //
-        if (FirstStack) {
-          // stackPresentBitmap doesn't cover if a valid stack was disable due to resource adjustments.
-          // Start with valid resources for current socket
-          SocketResources->StackRes[Stack].IoBase = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].PciResourceIoBase;
-          FirstStack = FALSE;
-        } else {
-          // Check to see if the previous stack is disabled by checking for equal base and limit
-          if (SocketResources->StackRes[Stack-1].IoBase == SocketResources->StackRes[Stack-1].IoLimit) {
-            if (PreviousLimit % 2 == 1) {
-              PreviousLimit += 1;
-            }
-            SocketResources->StackRes[Stack].IoBase = (UINT16) PreviousLimit;
-          } else {
-            SocketResources->StackRes[Stack].IoBase = (UINT16) PreviousLimit + 1;
-          }
-        }
-
-        NewLength = SocketResources->StackRes[Stack].NumIoPortsDesired;
-
-        //
-        //assign the left space to the last IIO stack. Reserved for across socket resource adjustment.
-        //make adjustments if NewLength is zero
-        //
-        if (Stack == LastStack) {
-          if (NewLength != 0) {
-            if (SocketResources->IoResourcesLeft != 0) {
-              NewLength += SocketResources->IoResourcesLeft + 1;
-            }
-          } else {
-            NewLength = SocketResources->IoResourcesLeft;
-          }
-        }
-
-        SocketResources->StackRes[Stack].NeedIoUpdate = TRUE;
-        SocketResources->StackRes[Stack].IoLimit = (UINT16)(SocketResources->StackRes[Stack].IoBase + NewLength);
-        PreviousLimit = SocketResources->StackRes[Stack].IoLimit;
-        DEBUG((DEBUG_INFO, "SocketResources[%x].StackRes[%x].IoBase =%x   newLength = %x\n",Socket,Stack,SocketResources->StackRes[Stack].IoBase,NewLength));
-        DEBUG((DEBUG_INFO, "SocketResources[%x].StackRes[%x].IoLimit =%x\n",Socket,Stack,SocketResources->StackRes[Stack].IoLimit));
-      }
-      break;
-
-    case TypeMem32:
-      //
-      // Return if MmiolResourceNeeds is not zero which indicates a socket adjustment is needed
-      //
-        if (SocketResources->MmiolResourceNeeds != 0) {
-          return EFI_OUT_OF_RESOURCES;
-        }
-        //
-        // Visit all Stacks in this Socket and recalculate the New Mem32 Ranges per Stack
-        //
-        for (Stack = 0; Stack < MAX_IIO_STACK; Stack++){
-
-          if (!(mIioUds->IioUdsPtr->PlatformData.CpuQpiInfo[Socket].stackPresentBitmap & (1 << Stack))) {
-            continue;
-          }
-          //
-          // For the first enabled stack, use the base low mmio address for the socket, otherwize
-          // calculate the new base based off the last enabled stack
-          //
-          if (FirstStack) {
-            // stackPresentBitmap doesn't cover if a valid stack was disable due to resource adjustments.
-            // Start with valid resources for current socket
-            SocketResources->StackRes[Stack].MmiolBase = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio32Base;
-            FirstStack = FALSE;
-          } else {
-            // Check to see if the previous stack is disabled by checking for equal base and limit
-            if (SocketResources->StackRes[Stack-1].MmiolBase == SocketResources->StackRes[Stack-1].MmiolLimit) {
-              if (PreviousLimit % 2 == 1) {
-                PreviousLimit += 1;
-              }
-              SocketResources->StackRes[Stack].MmiolBase = (UINT32) PreviousLimit;
-            } else {
-              SocketResources->StackRes[Stack].MmiolBase = (UINT32) PreviousLimit + 1;
-            }
-          }
-          //
-          // Verify if this Stack is the one that requires an update and calculate the new Limit
-          // otherwise assign the new limit based on the Chunk and Extra Chunk calculation and assign the Newlength
-          //
-          NewLength =  SocketResources->StackRes[Stack].MmiolLength;
-          //
-          //assign the left space to the last IIO stack. Reserved for across socket resource adjustment.
-          //make adjustments if NewLength is zero
-          //
-          if (Stack == LastStack) {
-            if (NewLength != 0) {
-              if (SocketResources->MmiolResourcesLeft){
-                NewLength += SocketResources->MmiolResourcesLeft + 1;
-              }
-            } else {
-              NewLength = SocketResources->MmiolResourcesLeft;
-            }
-          }
-
-          SocketResources->StackRes[Stack].MmiolUpdate = 1;
-          SocketResources->StackRes[Stack].MmiolLimit =  (UINT32)(SocketResources->StackRes[Stack].MmiolBase + NewLength);
-          PreviousLimit = SocketResources->StackRes[Stack].MmiolLimit;
-          DEBUG((DEBUG_INFO, "SocketResources[%x].StackRes[%x].MmiolBase =%x   newLength = %x\n",Socket,Stack,SocketResources->StackRes[Stack].MmiolBase,NewLength));
-          DEBUG((DEBUG_INFO, "SocketResources[%x].StackRes[%x].MmiolLimit =%x\n",Socket,Stack,SocketResources->StackRes[Stack].MmiolLimit));
-        }
-      break;
-
-    case TypeMem64:
-      // Return if MmiohResourceNeeds is not zero which indicates a socket adjustment is needed
-      if (SocketResources->MmiohResourceNeeds != 0){
-        return EFI_OUT_OF_RESOURCES;
-      }
-      //
-      // Visit all Stacks in this Socket and recalculate the New Mem64 Ranges per Stack
-      //
-      for (Stack = 0; Stack < MAX_IIO_STACK; Stack++) {
-
-        if(!(mIioUds->IioUdsPtr->PlatformData.CpuQpiInfo[Socket].stackPresentBitmap & (1 << Stack))){
-          continue;
-        }
-        //
-        // For the first enabled stack, use the base high mmio address for the socket, otherwise
-        // calculate the new base based off the last enabled stack
-        //
-        if (FirstStack) {
-          // stackPresentBitmap doesn't cover if a valid stack was disable due to resource adjustments.
-          // Start with valid resources for current socket
-          SocketResources->StackRes[Stack].MmiohBase = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio64Base;
-          FirstStack = FALSE;
-        } else {
-           // Check to see if the previous stack is disabled by checking for equal base and limit
-          if (SocketResources->StackRes[Stack-1].MmiohBase == SocketResources->StackRes[Stack-1].MmiohLimit) {
-            if (PreviousLimit % 2 == 1) {
-              PreviousLimit += 1;
-            }
-            SocketResources->StackRes[Stack].MmiohBase = PreviousLimit;
-          } else {
-            SocketResources->StackRes[Stack].MmiohBase = PreviousLimit + 1;
-          }
-        }
-
-        //
-        // Verify if this Stack is the one that requires an update and calculate the new Limit
-        // otherwise assign the new limit based on the Chunk and Extra Chunk calculation and assign the Newlength
-        //
-
-        NewLength =  SocketResources->StackRes[Stack].MmiohLength;
-
-        //
-        //assign the left space to the last IIO stack. Reserved for across socket resource adjustment.
-        //make adjustments if NewLength is zero
-        //
-        if (Stack == LastStack) {
-          if (NewLength != 0) {
-            if (SocketResources->MmiohResourcesLeft) {
-              NewLength += SocketResources->MmiohResourcesLeft + 1;
-            }
-          } else {
-              NewLength = SocketResources->MmiohResourcesLeft;
-          }
-        }
-
-        SocketResources->StackRes[Stack].MmiohUpdate = 1;
-        SocketResources->StackRes[Stack].MmiohLimit =  (SocketResources->StackRes[Stack].MmiohBase + NewLength);
-        PreviousLimit = SocketResources->StackRes[Stack].MmiohLimit;
-        DEBUG((DEBUG_INFO, "SocketResources[%x].StackRes[%x].MmiohBase =%lx   newLength = %lx\n",Socket,Stack,SocketResources->StackRes[Stack].MmiohBase,NewLength));
-        DEBUG((DEBUG_INFO, "SocketResources[%x].StackRes[%x].MmiohLimit =%lx\n",Socket,Stack,SocketResources->StackRes[Stack].MmiohLimit));
-
-      } // for Stack
-      break;
-    default:
-        DEBUG((DEBUG_ERROR, "[PCI] ERROR: Resource Type Unknown = %x\n", ResourceType));
-      break;
-  }// switch
-
-  return EFI_SUCCESS;
-}
-
-
-/**
-  Adjust resource ratio assignment among sockets to fit the resource needs from PCI devices.
-
-  @param SocketResources   -  CPU_RESOURCE structure pointer that stores all resources need per socket
-  @param ResourceType      -  type of resource that requires alignment
-  @param ValidSockets       -  Number of Valid Sockets, need it to calculate how resources need to be splitted
-
-  @retval EFI_SUCCESS            -  Succeed.
-  @retval EFI_OUT_OF_RESOURCES   -  Not enough resources to be adjusted within the socket.
-**/
-EFI_STATUS
-AdjustSocketResources (
-  CPU_RESOURCE *SocketResources,
-  UINT8         ResourceType,
-  UINT8         ValidSockets
-  )
-{
-  EFI_STATUS    Status;
-
-  switch(ResourceType){
-    case TypeIo:
-      Status = AdjustSocketIo (SocketResources, ResourceType, ValidSockets);
-      break;
-    case TypeMem32:
-      Status = AdjustSocketMmioL (SocketResources, ResourceType, ValidSockets);
-      break;
-    case TypeMem64:
-      Status = AdjustSocketMmioH (SocketResources, ResourceType, ValidSockets);
-      break;
-    default:
-      DEBUG((DEBUG_ERROR, "[PCI] ERROR: Resource Type Unknown = %x\n", ResourceType));
-      Status = EFI_INVALID_PARAMETER;
-      break;
-  } // switch
-
-  return Status;
-}
-
-
 /**
   Compare current system resource map with rebalance request NVRAM variable to see if stored settings were applied.
 
@@ -653,35 +341,24 @@ AdjustResourceAmongRootBridges (
   PCI_ROOT_BRIDGE_INSTANCE               *RootBridgeInstance;
   LIST_ENTRY                             *List;
   CPU_RESOURCE                           SocketResources[MAX_SOCKET];
-  UINT64                                 SocketIoLength;
-  UINT64                                 SocketMem32Length;
-  UINT64                                 SocketMem64Length;
-  UINT64                                 SocketIoBase;
-  UINT64                                 SocketMem32Base;
-  UINT64                                 SocketMem64Base;
   UINT64                                 RsvLenAtBegin;
   UINT64                                 RsvLenAtEnd;
+  UINT64                                 StackBase;
   UINT64                                 StackLength;
   UINT64                                 NewLength;
   UINT64                                 Alignment;
-  UINT64                                 Remainder;
   UINT8                                  Socket;
-  UINT8                                  ValidSockets;
   BOOLEAN                                ChangedType[TypeMax];
-  BOOLEAN                                ChangedTypeOOR[TypeMax]; // Change type for out of resources
   UINT8                                  TypeIndex;
   UINT8                                  ChangedBitMap;
   EFI_STATUS                             Status;
   UINTN                                  VarSize;
   SYSTEM_PCI_BASE_LIMITS                 SocketPciResourceData;
   UINT8                                  Stack;
-  UINT8                                  LastStack;
   UINT16                                 IoGranularity;
   UINT32                                 MmiolGranularity;
   UINT64                                 MmiohGranularity;
-  BOOLEAN                                OutOfResources;
   UINT32                                 UboxMmioSize;
-  BOOLEAN                                IsVirtualRootBridge;
   PCI_BASE_LIMITS                        *CurStackLimits;
   PCI_BASE_LIMITS                        *UboxStackLimits;
   PCI_BASE_LIMITS                        *CurSocketLimits;
@@ -690,10 +367,7 @@ AdjustResourceAmongRootBridges (
 
   *Result = SocketResourceRatioNotChanged;
   SetMem (ChangedType, TypeMax, FALSE);
-  SetMem (ChangedTypeOOR, TypeMax, FALSE);
   ChangedBitMap = 0;
-  OutOfResources = FALSE;
-  IsVirtualRootBridge = FALSE;
 
   IoGranularity = mIioUds->IioUdsPtr->PlatformData.IoGranularity;
   MmiolGranularity = mIioUds->IioUdsPtr->PlatformData.MmiolGranularity;
@@ -744,54 +418,15 @@ AdjustResourceAmongRootBridges (
   }
   UboxMmioSize = mIioUds->IioUdsPtr->PlatformData.UboxMmioSize;
   PlatGlobalMmiolBase = mIioUds->IioUdsPtr->PlatformData.PlatGlobalMmio32Base;
-  ValidSockets = 0;
+  //
+  // Collect the resource requests of all stacks. A resource type needs a new layout if any stack
+  // cannot fit its request, padded for alignment at the base it has now, into its current aperture.
+  //
   for (List = HostBridgeInstance->RootBridges.ForwardLink, Socket = 0; Socket < MAX_SOCKET; Socket ++) {
 
     if (!mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Valid) {
       continue;
     }
-    ValidSockets++;
-    //
-    // Calculate the length of resources available per socket
-    //
-    if (mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].PciResourceIoBase >=
-        mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].PciResourceIoLimit) {
-      SocketIoBase = 0;
-      SocketIoLength = 0;
-    } else {
-      SocketIoBase = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].PciResourceIoBase;
-      SocketIoLength = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].PciResourceIoLimit -
-                       mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].PciResourceIoBase;
-    }
-    if (mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio32Base >=
-                                                   mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio32Limit) {
-      SocketMem32Base = 0;
-      SocketMem32Length = 0;
-    } else {
-      SocketMem32Base = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio32Base;
-      SocketMem32Length = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio32Limit  -
-                                                      mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio32Base;
-      // Reserve 8M for ubox mmio
-      SocketMem32Length = SocketMem32Length - UboxMmioSize;
-    }
-
-    if (mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio64Base >=
-                                                   mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio64Limit) {
-      SocketMem64Base = 0;
-      SocketMem64Length = 0;
-    } else{
-      SocketMem64Base = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio64Base;
-      SocketMem64Length = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio64Limit -
-                                                      mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Mmio64Base;
-    }
-
-    // Get all the resources that are in this socket
-    SocketResources[Socket].IoResourcesLeft = (UINT16)SocketIoLength;
-    SocketResources[Socket].MmiolResourcesLeft = (UINT32)SocketMem32Length;
-    SocketResources[Socket].MmiohResourcesLeft = (UINT64)SocketMem64Length;
-
-    LastStack = LastStackOfSocket (Socket);
-
     for (Stack = 0; Stack < MAX_IIO_STACK; Stack++) {
       if (!(mIioUds->IioUdsPtr->PlatformData.CpuQpiInfo[Socket].stackPresentBitmap & (1 << Stack))) {
         continue;
@@ -803,79 +438,34 @@ AdjustResourceAmongRootBridges (
       Alignment = RootBridgeInstance->ResAllocNode[TypeIo].Alignment + 1;
       NewLength = RootBridgeInstance->ResAllocNode[TypeIo].Length;
 
-      if (IsVirtualRootBridge) {
-        NewLength += NewLength;
-      }
       // IoTrap allocates 256 byte range from GCD for common pool usage
       // For device to fit move to the next available alignment
       if ((Socket == 0) && (Stack == 0)) {
         NewLength += Alignment;
       }
+      SocketResources[Socket].StackRes[Stack].IoRequest = NewLength;
+      SocketResources[Socket].StackRes[Stack].IoAlignment = Alignment;
 
       if (NewLength != 0) {
         //
-        // At least 2KB align per KTI requirement. Add the length requested with given alignment.
-        // If the sum is not 2KB aligned add on the remainder that would make it align.
-        // Bump up to 4KB for root bridge requirements
-        // Have to make sure Alignment is handled for direct address allocation
-        //
-        Remainder = SocketIoBase & (Alignment - 1);
-        if (Remainder != 0) {
-          NewLength += Alignment - Remainder;
-        }
-        if (NewLength % (IoGranularity * 2)) {
-          Remainder = (IoGranularity * 2) - (NewLength % (IoGranularity * 2));
-          NewLength += Remainder;
-        }
-        //
-        // Store length as length - 1 for handling
-        //
-        NewLength -= 1;
-
         // Zero StackLength if its disable or negative
-        if (mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].PciResourceIoBase >=
-            mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].PciResourceIoLimit) {
+        //
+        StackBase = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].PciResourceIoBase;
+        if (StackBase >= mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].PciResourceIoLimit) {
           StackLength = 0;
         } else {
           StackLength = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].PciResourceIoLimit -
-                        mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].PciResourceIoBase;
-        }
-        SocketResources[Socket].StackRes[Stack].NumIoPortsDesired = (UINT16)NewLength;
-        // Check if new length can fit in the socket or stack
-        if (SocketResources[Socket].IoResourcesLeft > (UINT16)NewLength) {
-            SocketResources[Socket].IoResourcesLeft -=  (UINT16)NewLength + 1;
-        } else if (SocketResources[Socket].IoResourcesLeft == (UINT16)NewLength) {
-            SocketResources[Socket].IoResourcesLeft -=  (UINT16)NewLength;
-        } else {
-          // If there are resources left consume them
-          if (SocketResources[Socket].IoResourcesLeft != 0) {
-            NewLength = NewLength - SocketResources[Socket].IoResourcesLeft - 1;
-            SocketResources[Socket].IoResourcesLeft =  0;
-          }
-
-          SocketResources[Socket].IoResourceNeeds += (UINT16)NewLength + 1;
-          OutOfResources = TRUE;
-          ChangedTypeOOR[TypeIo] = TRUE;
+                        StackBase + 1;
         }
-        SocketResources[Socket].StackRes[Stack].IoAlignment = Alignment;
+        //
+        // At least 2KB align per KTI requirement
+        //
+        NewLength = StackApertureLength (NewLength, Alignment, StackBase, IoGranularity * 2);
         if (NewLength > StackLength) {
-          SocketResources[Socket].StackRes[Stack].NeedIoUpdate = TRUE;
-
-          //IoResourcesLeft is UINT16 type, not 2's-complement value.
-          if (SocketResources[Socket].IoResourcesLeft > SocketIoLength) {
-            DEBUG ((DEBUG_ERROR, "[PCI] Out of Resources for Socket = %x  Stack = %x Type = %x\n",
-                   Socket, Stack, TypeIo));
-            SocketResources[Socket].IoResourcesLeft = 0;
-          }
+          DEBUG ((DEBUG_INFO, "[PCI] Out of Resources for Socket = %x  Stack = %x Type = %x (need 0x%lX, have 0x%lX)\n",
+                 Socket, Stack, TypeIo, NewLength, StackLength));
           ChangedType[TypeIo] = TRUE;
         }
-        SocketIoBase += SocketResources[Socket].StackRes[Stack].NumIoPortsDesired + 1;
-        DEBUG ((DEBUG_INFO, "SocketResources[%x].IoResourceLeft = %x\n",
-               Socket, SocketResources[Socket].IoResourcesLeft));
-        DEBUG ((DEBUG_INFO, "SocketResources[%x].StackRes[%x].IoAlignment = %x\n",
-               Socket, Stack, SocketResources[Socket].StackRes[Stack].IoAlignment));
-      } else {
-        SocketResources[Socket].StackRes[Stack].NumIoPortsDesired = 0;
       }
       //
       // Check Mmem32 resource. This Host bridge does not support separated MEM / PMEM requests,
@@ -912,9 +502,6 @@ AdjustResourceAmongRootBridges (
         }
       }
 
-      if (IsVirtualRootBridge) {
-        NewLength += NewLength;
-      }
       // PCH Allocates reserved MMIO for Sx SMI handler use
       // For device to fit move to the next available alignment
       if ((Socket == 0) && (Stack == 0)) {
@@ -927,86 +514,29 @@ AdjustResourceAmongRootBridges (
       if (NewLength < mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio32MinSize) {
         NewLength = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio32MinSize;
       }
+      SocketResources[Socket].StackRes[Stack].MmiolRequest = NewLength;
+      SocketResources[Socket].StackRes[Stack].MmiolAlignment = Alignment;
 
       if (NewLength != 0) {
         //
-        // At least 4MB align per KTI requirement. Add the length requested with given alignment.
-        // If the sum is not 4MB aligned add on the remainder that would make it align.
-        // Have to make sure Alignment is handled for direct address allocation
-        //
-        Remainder = SocketMem32Base & (Alignment - 1);
-        if (Remainder != 0) {
-          NewLength += Alignment - Remainder;
-        }
-        if (NewLength % MmiolGranularity) {
-
-          Remainder = MmiolGranularity - (NewLength % MmiolGranularity);
-          NewLength += Remainder;
-        }
-
-        if (Stack == LastStack) {
-          //
-          // Ubox address must be 8MB aligned for the base address on most processors; skip check
-          // if uboxMmioSize is 0 (avoid divide by zero exception).
-          // At this point the requested resource has already been calculated to be satisfied.
-          // Add granularity padding if necessary to satisfy Ubox requirement.
-          //
-          if (UboxMmioSize != 0 && (SocketMem32Base + NewLength) % UboxMmioSize) {
-            Remainder = UboxMmioSize - (NewLength % UboxMmioSize);
-            NewLength += Remainder;
-          }
-        }
-        //
-        // Store length as length - 1 for handling
-        //
-        NewLength -= 1;
-
         // Zero StackLength if its disable or negative
-        if (mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio32Base >=
-                                   mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio32Limit) {
+        //
+        StackBase = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio32Base;
+        if (StackBase >= mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio32Limit) {
           StackLength = 0;
         } else {
           StackLength = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio32Limit -
-                                      mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio32Base;
+                        StackBase + 1;
         }
-        SocketResources[Socket].StackRes[Stack].MmiolLength = (UINT32)NewLength;
-
-        // Check if new length can fit in the socket or stack
-        if (SocketResources[Socket].MmiolResourcesLeft > (UINT32)NewLength) {
-            SocketResources[Socket].MmiolResourcesLeft -=  (UINT32)NewLength + 1;
-        } else if (SocketResources[Socket].MmiolResourcesLeft == (UINT32)NewLength) {
-            SocketResources[Socket].MmiolResourcesLeft -=  (UINT32)NewLength;
-        } else {
-            // If there are resources left consume them
-            if (SocketResources[Socket].MmiolResourcesLeft) {
-                NewLength = NewLength - SocketResources[Socket].MmiolResourcesLeft - 1;
-                SocketResources[Socket].MmiolResourcesLeft =  0;
-            }
-
-            SocketResources[Socket].MmiolResourceNeeds += (UINT32)NewLength + 1;
-            OutOfResources = TRUE;
-            ChangedTypeOOR[TypeMem32] = TRUE;
-        }
-        SocketResources[Socket].StackRes[Stack].MmiolAlignment = Alignment;
-
+        //
+        // At least 4MB align per KTI requirement
+        //
+        NewLength = StackApertureLength (NewLength, Alignment, StackBase, MmiolGranularity);
         if (NewLength > StackLength) {
-          SocketResources[Socket].StackRes[Stack].MmiolUpdate = 1;
-
-          //MmiolResourcesLeft is UINT32 type, not 2's-complement value.
-          if (SocketResources[Socket].MmiolResourcesLeft > SocketMem32Length) {
-            DEBUG ((DEBUG_ERROR, "Out of Resources for Socket = %x  Stack = %x Type = %x\n",
-                   Socket, Stack, TypeMem32));
-            SocketResources[Socket].MmiolResourcesLeft = 0;
-          }
+          DEBUG ((DEBUG_INFO, "[PCI] Out of Resources for Socket = %x  Stack = %x Type = %x (need 0x%lX, have 0x%lX)\n",
+                 Socket, Stack, TypeMem32, NewLength, StackLength));
           ChangedType[TypeMem32] = TRUE;
         }
-        SocketMem32Base += SocketResources[Socket].StackRes[Stack].MmiolLength + 1;
-        DEBUG ((DEBUG_INFO, "SocketResources[%x].MmiolResourceLeft = %x\n",
-               Socket, SocketResources[Socket].MmiolResourcesLeft));
-        DEBUG ((DEBUG_INFO, "SocketResources[%x].StackRes[%x].MmiolAlignment = %x\n",
-               Socket, Stack, SocketResources[Socket].StackRes[Stack].MmiolAlignment));
-      } else {
-        SocketResources[Socket].StackRes[Stack].MmiolLength = 0;
       }
       //
       // Check Mem64 resource. This Host bridge does not support separated MEM / PMEM requests, so only count MEM requests here.
@@ -1028,145 +558,52 @@ AdjustResourceAmongRootBridges (
       if (Alignment < RsvLenAtEnd) {
         Alignment = RsvLenAtEnd;
       }
-      if (IsVirtualRootBridge) {
-        NewLength += NewLength;
-      }
+      SocketResources[Socket].StackRes[Stack].MmiohRequest = NewLength;
+      SocketResources[Socket].StackRes[Stack].MmiohAlignment = Alignment;
 
       if (NewLength != 0) {
         //
-        // At least 1GB align per KTI requirement. Add the length requested with given alignment.
-        // If the sum is not 1GB aligned add on the remainder that would make it align.
-        // Have to make sure Alignment is handled for direct address allocation
-        //
-        Remainder = SocketMem64Base & (Alignment - 1);
-        if (Remainder != 0) {
-          NewLength += Alignment - Remainder;
-        }
-        if (NewLength % MmiohGranularity) {
-          Remainder = MmiohGranularity - (NewLength % MmiohGranularity);
-          NewLength += Remainder;
-        }
-
-        NewLength = ALIGN_VALUE (NewLength, Alignment);
-
-        //
-        // Store length as length - 1 for handling
-        //
-        NewLength -= 1;
-
         // Zero StackLength if it's disable or negative
-        if (mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio64Base >=
-                                   mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio64Limit) {
+        //
+        StackBase = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio64Base;
+        if (StackBase >= mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio64Limit) {
           StackLength = 0;
         } else {
           StackLength = mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio64Limit -
-                                      mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].StackRes[Stack].Mmio64Base;
-        }
-        SocketResources[Socket].StackRes[Stack].MmiohLength = NewLength;
-
-        // Check if new length can fit in the socket or stack
-        if (SocketResources[Socket].MmiohResourcesLeft > NewLength) {
-          SocketResources[Socket].MmiohResourcesLeft -=  NewLength + 1;
-        } else if (SocketResources[Socket].MmiohResourcesLeft == NewLength) {
-          SocketResources[Socket].MmiohResourcesLeft -=  NewLength;
-        } else {
-          // If there are resources left consume them
-          if (SocketResources[Socket].MmiohResourcesLeft != 0) {
-            NewLength = NewLength - SocketResources[Socket].MmiohResourcesLeft - 1;
-            SocketResources[Socket].MmiohResourcesLeft =  0;
-          }
-
-          SocketResources[Socket].MmiohResourceNeeds += NewLength + 1;
-          OutOfResources = TRUE;
-          ChangedTypeOOR[TypeMem64] = TRUE;
+                        StackBase + 1;
         }
-        SocketResources[Socket].StackRes[Stack].MmiohAlignment = Alignment;
-
+        //
+        // At least 1GB align per KTI requirement
+        //
+        NewLength = StackApertureLength (NewLength, Alignment, StackBase, MmiohGranularity);
+        NewLength = ALIGN_VALUE (NewLength, Alignment);
         if (NewLength > StackLength) {
-          SocketResources[Socket].StackRes[Stack].MmiohUpdate = 1;
-
-          //MmiohResourcesLeft is UINT64 type, not 2's-complement value.
-          if (SocketResources[Socket].MmiohResourcesLeft > SocketMem64Length) {
-            DEBUG ((DEBUG_ERROR, "Out of Resources for Socket = %x  Stack = %x Type = %x\n",
-                   Socket, Stack, TypeMem64));
-            SocketResources[Socket].MmiohResourcesLeft = 0;
-          }
+          DEBUG ((DEBUG_INFO, "[PCI] Out of Resources for Socket = %x  Stack = %x Type = %x (need 0x%lX, have 0x%lX)\n",
+                 Socket, Stack, TypeMem64, NewLength, StackLength));
           ChangedType[TypeMem64] = TRUE;
         }
-        SocketMem64Base += SocketResources[Socket].StackRes[Stack].MmiohLength + 1;
-        DEBUG ((DEBUG_INFO, "SocketResources[%x].MmiohResourceLeft = %lx\n",
-               Socket, SocketResources[Socket].MmiohResourcesLeft));
-        DEBUG ((DEBUG_INFO, "SocketResources[%x].StackRes[%x].MmiohAlignment = %lx\n",
-               Socket, Stack, SocketResources[Socket].StackRes[Stack].MmiohAlignment));
-      } else {
-        SocketResources[Socket].StackRes[Stack].MmiohLength = 0;
       }
 
       List = List->ForwardLink;
 
     } // for Stack
-
-    // Check and update all resource types in socket that needs adjustment
-    for (TypeIndex = 0; TypeIndex < TypeMax; TypeIndex++) {
-
-      if (ChangedType[TypeIndex]) {
-
-        DEBUG ((DEBUG_INFO, "[%d] Adjust stack %s resources...\n", Socket, mPciResourceTypeStr[TypeIndex]));
-        Status = AdjustResources (&SocketResources[Socket], Socket, TypeIndex);
-        ChangedType[TypeIndex] = FALSE;
-        if (Status == EFI_SUCCESS) {
-          ChangedBitMap |= (1 << TypeIndex);
-        } else {
-          ChangedBitMap &= ~(1 << TypeIndex);
-        }
-      }
-    }
-    //
-    // Account for Ubox resources to accurately calculate new alignments for the next socket
-    //
-    SocketMem32Base += UboxMmioSize;
   } // for Socket ..
 
   ASSERT (List == &HostBridgeInstance->RootBridges);
 
   //
-  // If a socket is out of resources, try to adjusting sockets for more room.
+  // Lay out every resource type that does not fit over the whole system in one pass.
+  // Apertures are sized against the bases they finally get, so the request written to NVRAM
+  // fits on the next boot and does not trigger another rebalance.
   //
-  if (OutOfResources && (MAX_SOCKET > 1) && (ValidSockets > 1)) {
-
-    for (TypeIndex = 0; TypeIndex < TypeMax; TypeIndex++) {
+  for (TypeIndex = 0; TypeIndex < TypeMax; TypeIndex++) {
 
-      if (ChangedTypeOOR[TypeIndex]) {
+    if (ChangedType[TypeIndex]) {
 
-        DEBUG ((DEBUG_INFO, "Adjust socket %s resources...\n", mPciResourceTypeStr[TypeIndex]));
-        Status = AdjustSocketResources (SocketResources, TypeIndex, ValidSockets);
-        if (Status == EFI_SUCCESS) {
-          ChangedBitMap |= (1 << TypeIndex);
-        } else {
-          ChangedBitMap &= ~(1 << TypeIndex);
-        }
-      }
-    }
-  } else if (OutOfResources) {
-    if (ChangedTypeOOR[TypeMem64]) {
-      //
-      // Allow mmioh to be adjusted to access max available physical address range.
-      //
-      Status = AdjustSocketResources (SocketResources, TypeMem64, ValidSockets);
+      DEBUG ((DEBUG_INFO, "[PCI] Rebalance system %s resources...\n", mPciResourceTypeStr[TypeIndex]));
+      Status = SolveSystemResources (SocketResources, TypeIndex);
       if (Status == EFI_SUCCESS) {
         ChangedBitMap |= (1 << TypeIndex);
-      } else {
-        ChangedBitMap &= ~(1 << TypeIndex);
-      }
-    }
-    if (ChangedTypeOOR[TypeIo] || ChangedTypeOOR[TypeMem32]) {
-      DEBUG ((DEBUG_ERROR, "Clearing %s request\n", mPciResourceTypeStr[TypeIo]));
-      DEBUG ((DEBUG_ERROR, "Clearing %s request\n", mPciResourceTypeStr[TypeMem32]));
-      for (Socket = 0; Socket < MAX_SOCKET; Socket++) {
-        for (Stack = 0; Stack < MAX_IIO_STACK; Stack++) {
-          SocketResources[Socket].StackRes[Stack].NeedIoUpdate = 0;
-          SocketResources[Socket].StackRes[Stack].MmiolUpdate = 0;
-        }
       }
     }
   }
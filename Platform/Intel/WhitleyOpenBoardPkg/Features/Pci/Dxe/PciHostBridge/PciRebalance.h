@@ -26,17 +26,17 @@ typedef enum {
 typedef struct {
   UINT16        IoBase;       // IO base of each stack
   UINT16        IoLimit;      // IO limit for each stack
-  UINT16        NumIoPortsDesired;
+  UINT64        IoRequest;    // IO length requested by the stack, not padded for alignment
   UINT64        IoAlignment;
   BOOLEAN       NeedIoUpdate; // Resource allocation required.
   UINT32        MmiolBase;    // Mmiol base of each stack
   UINT32        MmiolLimit;   // Mmiol limit of each stack
-  UINT32        MmiolLength;
+  UINT64        MmiolRequest; // Mmiol length requested by the stack, not padded for alignment
   UINT64        MmiolAlignment;
   UINT8         MmiolUpdate;  // Resource allocation required.
   UINT64        MmiohBase;    // Mmioh base of each stack
   UINT64        MmiohLimit;   // Mmioh limit of each stack
-  UINT64        MmiohLength;
+  UINT64        MmiohRequest; // Mmioh length requested by the stack, not padded for alignment
   UINT64        MmiohAlignment;
   UINT8         MmiohUpdate;  // Resource allocation required.
 } STACK_RESOURCE;
@@ -44,16 +44,10 @@ typedef struct {
 typedef struct{
   UINT16      IoBase;              // Io base of each socket
   UINT16      IoLimit;             // Io limit for each socket
-  UINT16      IoResourcesLeft;     // Io resources left over in socket
-  UINT16      IoResourceNeeds;     // Io resources lacking in socket
   UINT32      MmiolBase;           // Mmiol base of each socket
   UINT32      MmiolLimit;          // Mmiol limit of each socket
-  UINT32      MmiolResourcesLeft;  // Mmiol resources left over in socket
-  UINT32      MmiolResourceNeeds;  // Mmiol resources lacking in socket
   UINT64      MmiohBase;           // Mmioh base of each socket
   UINT64      MmiohLimit;          // Mmioh limit of each socket
-  UINT64      MmiohResourcesLeft;  // Mmioh resources left over in socket
-  UINT64      MmiohResourceNeeds;  // Mmioh resources lacking in socket
   STACK_RESOURCE  StackRes[MAX_LOGIC_IIO_STACK];
 } CPU_RESOURCE;
 
@@ -82,25 +76,39 @@ AdjustResourceAmongRootBridges (
   OUT SOCKET_RESOURCE_ADJUSTMENT_RESULT *Result
   );
 
-EFI_STATUS
-AdjustSocketIo (
-  IN OUT CPU_RESOURCE *SocketResources,
-  IN     UINT8         ResourceType,
-  IN     UINT8         ValidSockets
-  );
+/**
+  Calculate the aperture a stack needs for its request when placed at the given base.
 
-EFI_STATUS
-AdjustSocketMmioH (
-  IN OUT CPU_RESOURCE *SocketResources,
-  IN     UINT8         ResourceType,
-  IN     UINT8         ValidSockets
+  @param[in] Request      - Length requested for the stack, 0 if nothing is requested
+  @param[in] Alignment    - Alignment of the request
+  @param[in] Base         - Base the stack aperture starts at
+  @param[in] Granularity  - Granularity of the stack aperture
+
+  @return Length of the aperture, 0 if the stack requests nothing.
+**/
+UINT64
+StackApertureLength (
+  IN UINT64 Request,
+  IN UINT64 Alignment,
+  IN UINT64 Base,
+  IN UINT64 Granularity
   );
 
+/**
+  Compute new apertures of all sockets and stacks for one resource type in a single pass.
+
+  @param[in,out] SocketResources - CPU_RESOURCE array holding the requests per stack,
+                                   receives the new apertures on success
+  @param[in]     ResourceType    - Resource type to solve, TypeIo, TypeMem32 or TypeMem64
+
+  @retval EFI_SUCCESS            - New apertures computed and marked for update.
+  @retval EFI_OUT_OF_RESOURCES   - The requests do not fit into the system range.
+  @retval EFI_INVALID_PARAMETER  - Unsupported resource type.
+**/
 EFI_STATUS
-AdjustSocketMmioL (
-  IN OUT CPU_RESOURCE *SocketResources,
-  IN     UINT8         ResourceType,
-  IN     UINT8         ValidSockets
+SolveSystemResources (
+  IN OUT CPU_RESOURCE      *SocketResources,
+  IN     PCI_RESOURCE_TYPE  ResourceType
   );
 
 /**
@@ -115,28 +123,6 @@ LastStackOfSocket (
   IN UINT8 Socket
   );
 
-/**
-  Determine the last stack for a given socket with resources
-
-  @param SocketResources   - CPU_RESOURCE structure pointer that stores all resources need per stack
-  @param Socket            - Index of the Socket
-  @param ResourceType      - Type of resource that requires alignment
-  @param LastStack         - Pointer that will store the value of the last stack with resources allocated to it
-  @param ResourceSize      - Pointer that will store the sum of the requested resource type
-
-  @return The last stack with resources allocated to it and the
-          total amount of resoures requested of the type
-          requested.
-*/
-VOID
-LastStackWithResources (
-  IN     CPU_RESOURCE      *SocketResources,
-  IN     UINT8              Socket,
-  IN     PCI_RESOURCE_TYPE  ResourceType,
-     OUT UINT8             *LastStack,
-     OUT UINT64            *ResourceSize
-  );
-
 /**
  Find socket and stack index for given PCI Root Bridge protocol pointer.
 
@@ -0,0 +1,341 @@
+/** @file
+  Single pass resource solver for PCI resource rebalance.
+
+  The solver lays out one resource type over all sockets and stacks of the
+  system in one go, from the requests collected from the root bridges.
+  Every stack is placed right after the previous one and its aperture is
+  sized against the base it really gets, so the alignment padding stays
+  correct when the rebalance moves sockets around.
+
+  @copyright
+  Copyright 1999 - 2021 Intel Corporation. <BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Guid/SocketPciResourceData.h>
+#include <Guid/SocketIioVariable.h>
+#include <Protocol/IioUds.h>
+
+#include "PciHostBridge.h"
+#include "PciRootBridge.h"
+#include "PciRebalance.h"
+
+
+extern EFI_IIO_UDS_PROTOCOL *mIioUds;
+extern CHAR16               *mPciResourceTypeStr[];
+
+
+/**
+  Calculate the aperture a stack needs for its request when placed at the given base.
+
+  @param[in] Request      - Length requested for the stack, 0 if nothing is requested
+  @param[in] Alignment    - Alignment of the request
+  @param[in] Base         - Base the stack aperture starts at
+  @param[in] Granularity  - Granularity of the stack aperture
+
+  @return Length of the aperture, 0 if the stack requests nothing.
+**/
+UINT64
+StackApertureLength (
+  IN UINT64 Request,
+  IN UINT64 Alignment,
+  IN UINT64 Base,
+  IN UINT64 Granularity
+  )
+{
+  UINT64 Length;
+  UINT64 Remainder;
+
+  if (Request == 0) {
+    return 0;
+  }
+
+  Length = Request;
+  if (Alignment > 1) {
+    Remainder = Base & (Alignment - 1);
+    if (Remainder != 0) {
+      Length += Alignment - Remainder;
+    }
+  }
+  if (Granularity != 0 && (Length % Granularity) != 0) {
+    Length += Granularity - (Length % Granularity);
+  }
+
+  return Length;
+}
+
+
+/**
+  Get the request of one stack for the given resource type.
+
+  @param[in]  StackRes      - Stack resources
+  @param[in]  ResourceType  - Resource type
+  @param[out] Request       - Length requested for the stack
+  @param[out] Alignment     - Alignment of the request
+**/
+STATIC VOID
+GetStackRequest (
+  IN     STACK_RESOURCE    *StackRes,
+  IN     PCI_RESOURCE_TYPE  ResourceType,
+     OUT UINT64            *Request,
+     OUT UINT64            *Alignment
+  )
+{
+  switch (ResourceType) {
+    case TypeIo:
+      *Request   = StackRes->IoRequest;
+      *Alignment = StackRes->IoAlignment;
+      break;
+    case TypeMem32:
+      *Request   = StackRes->MmiolRequest;
+      *Alignment = StackRes->MmiolAlignment;
+      break;
+    case TypeMem64:
+      *Request   = StackRes->MmiohRequest;
+      *Alignment = StackRes->MmiohAlignment;
+      break;
+    default:
+      *Request   = 0;
+      *Alignment = 0;
+      break;
+  }
+}
+
+
+/**
+  Set the aperture of one stack for the given resource type and mark it for update.
+  A stack with zero length gets base equal to limit, which disables it.
+
+  @param[in,out] StackRes      - Stack resources
+  @param[in]     ResourceType  - Resource type
+  @param[in]     Base          - Base of the aperture
+  @param[in]     Length        - Length of the aperture
+**/
+STATIC VOID
+SetStackAperture (
+  IN OUT STACK_RESOURCE    *StackRes,
+  IN     PCI_RESOURCE_TYPE  ResourceType,
+  IN     UINT64             Base,
+  IN     UINT64             Length
+  )
+{
+  UINT64 Limit;
+
+  Limit = (Length == 0) ? Base : Base + Length - 1;
+
+  switch (ResourceType) {
+    case TypeIo:
+      StackRes->IoBase       = (UINT16) Base;
+      StackRes->IoLimit      = (UINT16) Limit;
+      StackRes->NeedIoUpdate = TRUE;
+      break;
+    case TypeMem32:
+      StackRes->MmiolBase    = (UINT32) Base;
+      StackRes->MmiolLimit   = (UINT32) Limit;
+      StackRes->MmiolUpdate  = 1;
+      break;
+    case TypeMem64:
+      StackRes->MmiohBase    = Base;
+      StackRes->MmiohLimit   = Limit;
+      StackRes->MmiohUpdate  = 1;
+      break;
+    default:
+      break;
+  }
+}
+
+
+/**
+  Compute new apertures of all sockets and stacks for one resource type in a single pass.
+
+  Stacks are placed contiguously in socket and stack order starting at the system base.
+  For low MMIO the Ubox range follows the stacks of every socket, aligned to its size.
+  Space left at the end is given to the last stack of the last socket, like the socket
+  ranges created by KTI leave it to the last stack.
+
+  @param[in,out] SocketResources - CPU_RESOURCE array holding the requests per stack,
+                                   receives the new apertures on success
+  @param[in]     ResourceType    - Resource type to solve, TypeIo, TypeMem32 or TypeMem64
+
+  @retval EFI_SUCCESS            - New apertures computed and marked for update.
+  @retval EFI_OUT_OF_RESOURCES   - The requests do not fit into the system range,
+                                   no aperture of this type is marked for update.
+  @retval EFI_INVALID_PARAMETER  - Unsupported resource type.
+**/
+EFI_STATUS
+SolveSystemResources (
+  IN OUT CPU_RESOURCE      *SocketResources,
+  IN     PCI_RESOURCE_TYPE  ResourceType
+  )
+{
+  UINT64          SystemBase;
+  UINT64          SystemLimit;
+  UINT64          SlackLimit;
+  UINT64          Granularity;
+  UINT64          SocketTail;
+  UINT64          Base;
+  UINT64          Length;
+  UINT64          Request;
+  UINT64          Alignment;
+  UINT64          Slack;
+  UINT64          MaxMmioh;
+  UINT8           Socket;
+  UINT8           Stack;
+  STACK_RESOURCE  *StackRes;
+  STACK_RESOURCE  *LastStackRes;
+  UINT64          LastStackBase;
+  UINT64          LastStackLength;
+
+  SocketTail = 0;
+  switch (ResourceType) {
+    case TypeIo:
+      SystemBase  = mIioUds->IioUdsPtr->PlatformData.IIO_resource[0].PciResourceIoBase;
+      SystemLimit = mIioUds->IioUdsPtr->PlatformData.PlatGlobalIoLimit;
+      SlackLimit  = SystemLimit;
+      //
+      // At least 2KB align per KTI requirement
+      //
+      Granularity = mIioUds->IioUdsPtr->PlatformData.IoGranularity * 2;
+      break;
+
+    case TypeMem32:
+      SystemBase  = mIioUds->IioUdsPtr->PlatformData.PlatGlobalMmio32Base;
+      SystemLimit = mIioUds->IioUdsPtr->PlatformData.PlatGlobalMmio32Limit;
+      SlackLimit  = SystemLimit;
+      Granularity = mIioUds->IioUdsPtr->PlatformData.MmiolGranularity;
+      SocketTail  = mIioUds->IioUdsPtr->PlatformData.UboxMmioSize;
+      break;
+
+    case TypeMem64:
+      SystemBase  = mIioUds->IioUdsPtr->PlatformData.PlatGlobalMmio64Base;
+      Granularity = (UINT64) mIioUds->IioUdsPtr->PlatformData.MmiohGranularity.lo;
+      Granularity |= ((UINT64) mIioUds->IioUdsPtr->PlatformData.MmiohGranularity.hi) << 32;
+      //
+      // Maximum chunk accessible in the system based on the given granularity (14nm),
+      // or the whole physical address space (10nm).
+      //
+      if (mIioUds->IioUdsPtr->PlatformData.UboxMmioSize == 0) {
+        MaxMmioh = SystemBase + Granularity * 32;
+      } else {
+        MaxMmioh = LShiftU64 (1, mIioUds->IioUdsPtr->PlatformData.MaxAddressBits);
+      }
+      SystemLimit = MAX (MaxMmioh - 1, mIioUds->IioUdsPtr->PlatformData.PlatGlobalMmio64Limit);
+      //
+      // Only the range given to the system originally is handed out as spare.
+      //
+      SlackLimit  = mIioUds->IioUdsPtr->PlatformData.PlatGlobalMmio64Limit;
+      break;
+
+    default:
+      DEBUG ((DEBUG_ERROR, "[PCI] ERROR: Resource Type Unknown = %x\n", ResourceType));
+      return EFI_INVALID_PARAMETER;
+  }
+
+  DEBUG ((DEBUG_INFO, "[PCI] Solving %s layout in 0x%llX..0x%llX [%llX]\n",
+          mPciResourceTypeStr[ResourceType], SystemBase, SystemLimit, Granularity));
+
+  Base            = SystemBase;
+  LastStackRes    = NULL;
+  LastStackBase   = 0;
+  LastStackLength = 0;
+
+  for (Socket = 0; Socket < MAX_SOCKET; Socket++) {
+
+    if (!mIioUds->IioUdsPtr->PlatformData.IIO_resource[Socket].Valid) {
+      continue;
+    }
+
+    StackRes = NULL;
+    for (Stack = 0; Stack < MAX_IIO_STACK; Stack++) {
+
+      if (!(mIioUds->IioUdsPtr->PlatformData.CpuQpiInfo[Socket].stackPresentBitmap & (1 << Stack))) {
+        continue;
+      }
+      StackRes = &SocketResources[Socket].StackRes[Stack];
+      GetStackRequest (StackRes, ResourceType, &Request, &Alignment);
+
+      Length = StackApertureLength (Request, Alignment, Base, Granularity);
+      if (ResourceType == TypeMem64) {
+        Length = ALIGN_VALUE (Length, Alignment);
+      }
+
+      SetStackAperture (StackRes, ResourceType, Base, Length);
+      PCIDEBUG ("[%d.%d] %s request 0x%llX align 0x%llX -> 0x%llX..+0x%llX\n", Socket, Stack,
+                mPciResourceTypeStr[ResourceType], Request, Alignment, Base, Length);
+
+      LastStackBase   = Base;
+      LastStackLength = Length;
+      Base += Length;
+    }
+
+    if (StackRes == NULL) {
+      continue;
+    }
+    LastStackRes = StackRes;
+
+    if (SocketTail != 0) {
+      //
+      // Ubox range follows the last stack of the socket and must be aligned to its size.
+      // Pad the last stack so there is no hole between the stacks and the Ubox.
+      //
+      if ((Base % SocketTail) != 0) {
+        LastStackLength += SocketTail - (Base % SocketTail);
+        Base = LastStackBase + LastStackLength;
+        SetStackAperture (LastStackRes, ResourceType, LastStackBase, LastStackLength);
+      }
+      Base += SocketTail;
+    }
+  }
+
+  if (LastStackRes == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  DEBUG ((DEBUG_INFO, "[PCI] Total request %s range = 0x%llX, system range = 0x%llX\n",
+          mPciResourceTypeStr[ResourceType], Base - SystemBase, SystemLimit - SystemBase + 1));
+  if (Base - 1 > SystemLimit) {
+    //
+    // Not enough system resources to support the request.
+    // Remove all request to update NVRAM variable for this resource type.
+    //
+    for (Socket = 0; Socket < MAX_SOCKET; Socket++) {
+      for (Stack = 0; Stack < MAX_IIO_STACK; Stack++) {
+        switch (ResourceType) {
+          case TypeIo:
+            SocketResources[Socket].StackRes[Stack].NeedIoUpdate = FALSE;
+            break;
+          case TypeMem32:
+            SocketResources[Socket].StackRes[Stack].MmiolUpdate = 0;
+            break;
+          default:
+            SocketResources[Socket].StackRes[Stack].MmiohUpdate = 0;
+            break;
+        }
+      }
+    }
+    DEBUG ((DEBUG_ERROR, "[PCI] ERROR: Out of adjustable %s resources\n", mPciResourceTypeStr[ResourceType]));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Give away leftover resources to the last stack. For low MMIO it sits before the Ubox
+  // of the last socket, so keep the Ubox alignment.
+  //
+  if (SlackLimit >= Base) {
+    Slack = SlackLimit - Base + 1;
+    if (SocketTail != 0) {
+      Slack -= Slack % SocketTail;
+    } else if (Granularity != 0) {
+      Slack -= Slack % Granularity;
+    }
+    if (Slack != 0) {
+      LastStackLength += Slack;
+      SetStackAperture (LastStackRes, ResourceType, LastStackBase, LastStackLength);
+      DEBUG ((DEBUG_INFO, "[PCI] Spare %s range 0x%llX given to the last stack\n",
+              mPciResourceTypeStr[ResourceType], Slack));
+    }
+  }
+
+  return EFI_SUCCESS;
+}
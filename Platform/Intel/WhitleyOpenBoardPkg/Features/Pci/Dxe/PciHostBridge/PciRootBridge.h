@@ -25,6 +25,7 @@
 #include <Library/DxeServicesTableLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/BaseLib.h>
+#include <Library/IoLib.h>
 #include <Library/PciSegmentLib.h>
 #include <Library/UefiLib.h>
 #include <Library/TimerLib.h>
@@ -426,6 +426,182 @@ RootBridgeIoPollIo (
   return EFI_TIMEOUT;
 }
 
+/**
+  Check a memory request against the apertures of the root bridge.
+
+  The whole range touched by the request is checked once, so the transfer
+  itself can run without any per element validation.
+
+  @param[in]  RootBridge  Root bridge instance.
+  @param[in]  Width       Signifies the width of the memory operations.
+  @param[in]  Address     The base address of the memory operations.
+  @param[in]  Count       The number of memory operations to perform.
+
+  @retval EFI_SUCCESS            The request is within the root bridge apertures.
+  @retval EFI_INVALID_PARAMETER  Width is invalid or the request exceeds the apertures.
+  @retval EFI_UNSUPPORTED        Address is not aligned to the width of the operations.
+**/
+STATIC
+EFI_STATUS
+RootBridgeIoCheckMemParameter (
+  IN PCI_ROOT_BRIDGE_INSTANCE               *RootBridge,
+  IN EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN UINT64                                 Address,
+  IN UINTN                                  Count
+  )
+{
+  UINT64  Limit;
+  UINT64  Room;
+  UINT64  Stride;
+  UINT64  Elements;
+
+  if (Width < 0 || Width >= EfiPciWidthMaximum) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Stride = LShiftU64 (1, Width & 0x03);
+  if ((Address & (Stride - 1)) != 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Check memory access limit
+  //
+  if (RootBridge->Aperture.Mem64Limit > RootBridge->Aperture.Mem64Base) {
+    Limit = RootBridge->Aperture.Mem64Limit;
+  } else {
+    Limit = RootBridge->Aperture.Mem32Limit;
+  }
+  if (Address > Limit) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (Count == 0) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // FIFO operations access the same element Count times, all other operations
+  // access Count consecutive elements.
+  //
+  Elements = (Width >= EfiPciWidthFifoUint8 && Width <= EfiPciWidthFifoUint64) ? 1 : Count;
+  Room = Limit - Address;
+  if (Room < Stride - 1 || Elements - 1 > DivU64x32 (Room - (Stride - 1), (UINT32) Stride)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Read from memory mapped I/O space for an already validated request.
+
+  @param[in]   Width     Signifies the width of the memory operations.
+  @param[in]   Address   The base address of the memory operations.
+  @param[in]   Count     The number of memory operations to perform.
+  @param[out]  Buffer    The destination buffer to store the results.
+**/
+STATIC
+VOID
+RootBridgeIoMmioRead (
+  IN     EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN     UINT64                                 Address,
+  IN     UINTN                                  Count,
+  OUT    VOID                                   *Buffer
+  )
+{
+  UINTN   InStride;
+  UINTN   OutStride;
+  UINT8   *Uint8Buffer;
+
+  InStride  = (UINTN) 1 << (Width & 0x03);
+  OutStride = InStride;
+  if (Width >= EfiPciWidthFifoUint8 && Width <= EfiPciWidthFifoUint64) {
+    InStride = 0;
+  }
+  if (Width >= EfiPciWidthFillUint8 && Width <= EfiPciWidthFillUint64) {
+    OutStride = 0;
+  }
+
+  Uint8Buffer = Buffer;
+  switch (Width & 0x03) {
+    case EfiPciWidthUint8:
+      for (; Count > 0; Count--, Address += InStride, Uint8Buffer += OutStride) {
+        *Uint8Buffer = MmioRead8 ((UINTN) Address);
+      }
+      break;
+    case EfiPciWidthUint16:
+      for (; Count > 0; Count--, Address += InStride, Uint8Buffer += OutStride) {
+        WriteUnaligned16 ((UINT16 *) Uint8Buffer, MmioRead16 ((UINTN) Address));
+      }
+      break;
+    case EfiPciWidthUint32:
+      for (; Count > 0; Count--, Address += InStride, Uint8Buffer += OutStride) {
+        WriteUnaligned32 ((UINT32 *) Uint8Buffer, MmioRead32 ((UINTN) Address));
+      }
+      break;
+    default:
+      for (; Count > 0; Count--, Address += InStride, Uint8Buffer += OutStride) {
+        WriteUnaligned64 ((UINT64 *) Uint8Buffer, MmioRead64 ((UINTN) Address));
+      }
+      break;
+  }
+}
+
+/**
+  Write to memory mapped I/O space for an already validated request.
+
+  @param[in]   Width     Signifies the width of the memory operations.
+  @param[in]   Address   The base address of the memory operations.
+  @param[in]   Count     The number of memory operations to perform.
+  @param[in]   Buffer    The source buffer to write data from.
+**/
+STATIC
+VOID
+RootBridgeIoMmioWrite (
+  IN     EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN     UINT64                                 Address,
+  IN     UINTN                                  Count,
+  IN     VOID                                   *Buffer
+  )
+{
+  UINTN   InStride;
+  UINTN   OutStride;
+  UINT8   *Uint8Buffer;
+
+  InStride  = (UINTN) 1 << (Width & 0x03);
+  OutStride = InStride;
+  if (Width >= EfiPciWidthFifoUint8 && Width <= EfiPciWidthFifoUint64) {
+    InStride = 0;
+  }
+  if (Width >= EfiPciWidthFillUint8 && Width <= EfiPciWidthFillUint64) {
+    OutStride = 0;
+  }
+
+  Uint8Buffer = Buffer;
+  switch (Width & 0x03) {
+    case EfiPciWidthUint8:
+      for (; Count > 0; Count--, Address += InStride, Uint8Buffer += OutStride) {
+        MmioWrite8 ((UINTN) Address, *Uint8Buffer);
+      }
+      break;
+    case EfiPciWidthUint16:
+      for (; Count > 0; Count--, Address += InStride, Uint8Buffer += OutStride) {
+        MmioWrite16 ((UINTN) Address, ReadUnaligned16 ((UINT16 *) Uint8Buffer));
+      }
+      break;
+    case EfiPciWidthUint32:
+      for (; Count > 0; Count--, Address += InStride, Uint8Buffer += OutStride) {
+        MmioWrite32 ((UINTN) Address, ReadUnaligned32 ((UINT32 *) Uint8Buffer));
+      }
+      break;
+    default:
+      for (; Count > 0; Count--, Address += InStride, Uint8Buffer += OutStride) {
+        MmioWrite64 ((UINTN) Address, ReadUnaligned64 ((UINT64 *) Uint8Buffer));
+      }
+      break;
+  }
+}
+
 /**
   Enables a PCI driver to access PCI controller registers in the PCI root
   bridge memory space.
@@ -463,36 +639,22 @@ RootBridgeIoMemRead (
   OUT    VOID                                   *Buffer
   )
 {
+  EFI_STATUS                Status;
   PCI_ROOT_BRIDGE_INSTANCE  *RootBridge;
-  if (Buffer == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
 
-  if (Width < 0 ||Width >= EfiPciWidthMaximum  ) {
+  if (Buffer == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
   RootBridge = ROOT_BRIDGE_FROM_THIS (This);
-  //
-  // Check memory access limit
-  //
-  if (RootBridge->Aperture.Mem64Limit > RootBridge->Aperture.Mem64Base) {
-      if (Address > RootBridge->Aperture.Mem64Limit) {
-        return EFI_INVALID_PARAMETER;
-      }
-  } else {
-      if (Address > RootBridge->Aperture.Mem32Limit) {
-        return EFI_INVALID_PARAMETER;
-      }
+
+  Status = RootBridgeIoCheckMemParameter (RootBridge, Width, Address, Count);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
-  return mCpuIo->Mem.Read (
-                      mCpuIo,
-                      (EFI_CPU_IO_PROTOCOL_WIDTH) Width,
-                      Address,
-                      Count,
-                      Buffer
-                      );
+  RootBridgeIoMmioRead (Width, Address, Count, Buffer);
+  return EFI_SUCCESS;
 }
 
 /**
@@ -532,37 +694,22 @@ RootBridgeIoMemWrite (
   IN     VOID                                   *Buffer
   )
 {
+  EFI_STATUS                Status;
   PCI_ROOT_BRIDGE_INSTANCE  *RootBridge;
 
   if (Buffer == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  if (Width < 0 || Width >= EfiPciWidthMaximum ) {
-    return EFI_INVALID_PARAMETER;
-  }
-
   RootBridge = ROOT_BRIDGE_FROM_THIS (This);
 
-  //
-  // Check memory access limit
-  //
-  if (RootBridge->Aperture.Mem64Limit > RootBridge->Aperture.Mem64Base) {
-      if (Address > RootBridge->Aperture.Mem64Limit) {
-        return EFI_INVALID_PARAMETER;
-      }
-  } else {
-      if (Address > RootBridge->Aperture.Mem32Limit) {
-        return EFI_INVALID_PARAMETER;
-      }
+  Status = RootBridgeIoCheckMemParameter (RootBridge, Width, Address, Count);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
-  return mCpuIo->Mem.Write (
-                      mCpuIo,
-                      (EFI_CPU_IO_PROTOCOL_WIDTH) Width,
-                      Address,
-                      Count,
-                      Buffer
-                      );
+
+  RootBridgeIoMmioWrite (Width, Address, Count, Buffer);
+  return EFI_SUCCESS;
 }
 
 /**
@@ -746,11 +893,10 @@ RootBridgeIoCopyMem (
   IN UINTN                                        Count
   )
 {
-  EFI_STATUS  Status;
-  BOOLEAN     Forward;
-  UINTN       Stride;
-  UINTN       Index;
-  UINT64      Result;
+  EFI_STATUS                Status;
+  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge;
+  UINTN                     Stride;
+  UINT64                    Step;
 
   if ((UINT32) Width > EfiPciWidthUint64) {
     return EFI_INVALID_PARAMETER;
@@ -760,44 +906,68 @@ RootBridgeIoCopyMem (
     return EFI_SUCCESS;
   }
 
+  //
+  // Validate both regions once instead of on every element.
+  //
+  RootBridge = ROOT_BRIDGE_FROM_THIS (This);
+  Status = RootBridgeIoCheckMemParameter (RootBridge, Width, SrcAddress, Count);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  Status = RootBridgeIoCheckMemParameter (RootBridge, Width, DestAddress, Count);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  if (Count == 0) {
+    return EFI_SUCCESS;
+  }
+
   Stride = (UINTN)1 << Width;
 
-  Forward = TRUE;
+  //
+  // Move the data in 64-bit accesses when both regions and the length are 8 byte
+  // aligned. Both addresses then differ by a multiple of 8, so copying in the
+  // right direction stays correct for overlapping regions too.
+  //
+  if (Width < EfiPciWidthUint64 &&
+      ((DestAddress | SrcAddress | (Count * Stride)) & (sizeof (UINT64) - 1)) == 0) {
+    Count  = Count * Stride / sizeof (UINT64);
+    Width  = EfiPciWidthUint64;
+    Stride = sizeof (UINT64);
+  }
+
+  Step = Stride;
   if ((DestAddress > SrcAddress) &&
       (DestAddress < (SrcAddress + Count * Stride))) {
-    Forward = FALSE;
+    //
+    // The regions overlap with the destination above the source, copy backward.
+    //
+    Step = (UINT64) 0 - Stride;
     SrcAddress = SrcAddress + (Count - 1) * Stride;
     DestAddress = DestAddress + (Count - 1) * Stride;
   }
 
-  for (Index = 0; Index < Count; Index++) {
-    Status = RootBridgeIoMemRead (
-               This,
-               Width,
-               SrcAddress,
-               1,
-               &Result
-               );
-    if (EFI_ERROR (Status)) {
-      return Status;
-    }
-    Status = RootBridgeIoMemWrite (
-               This,
-               Width,
-               DestAddress,
-               1,
-               &Result
-               );
-    if (EFI_ERROR (Status)) {
-      return Status;
-    }
-    if (Forward) {
-      SrcAddress += Stride;
-      DestAddress += Stride;
-    } else {
-      SrcAddress -= Stride;
-      DestAddress -= Stride;
-    }
+  switch (Width) {
+    case EfiPciWidthUint8:
+      for (; Count > 0; Count--, SrcAddress += Step, DestAddress += Step) {
+        MmioWrite8 ((UINTN) DestAddress, MmioRead8 ((UINTN) SrcAddress));
+      }
+      break;
+    case EfiPciWidthUint16:
+      for (; Count > 0; Count--, SrcAddress += Step, DestAddress += Step) {
+        MmioWrite16 ((UINTN) DestAddress, MmioRead16 ((UINTN) SrcAddress));
+      }
+      break;
+    case EfiPciWidthUint32:
+      for (; Count > 0; Count--, SrcAddress += Step, DestAddress += Step) {
+        MmioWrite32 ((UINTN) DestAddress, MmioRead32 ((UINTN) SrcAddress));
+      }
+      break;
+    default:
+      for (; Count > 0; Count--, SrcAddress += Step, DestAddress += Step) {
+        MmioWrite64 ((UINTN) DestAddress, MmioRead64 ((UINTN) SrcAddress));
+      }
+      break;
   }
   return EFI_SUCCESS;
 }
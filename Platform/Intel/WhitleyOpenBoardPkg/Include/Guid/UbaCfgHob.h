@@ -1,6 +1,23 @@
 /** @file
   uba config database head file
 
+  The configuration database is a single flat buffer. Every reference inside
+  it is an offset from the start of the buffer, so it can be moved from
+  temporary RAM to permanent memory, copied into a HOB and adopted by DXE
+  without any pointer fixup.
+
+    +--------------------------+  0
+    | UBA_CONFIG_DB_HEADER     |
+    +--------------------------+  IndexOffset
+    | UINT32 Index[IndexSlots] |  open addressed GUID hash, entry number + 1
+    +--------------------------+  EntryOffset
+    | UBA_CONFIG_DB_ENTRY      |
+    |   [EntryCapacity]        |
+    +--------------------------+  DataOffset
+    | Config data, 8 byte      |
+    | aligned, DataUsed bytes  |
+    +--------------------------+  TotalSize
+
   @copyright
   Copyright 2012 - 2021 Intel Corporation. <BR>
 
@@ -12,63 +29,53 @@
 
 
 #define UBA_CONFIG_HOB_SIGNATURE    SIGNATURE_32('U', 'B', 'A', 'H')
-#define UBA_CONFIG_HOB_VERSION      0x01
+#define UBA_CONFIG_HOB_VERSION      0x02
 
 #define UBA_BOARD_SIGNATURE         SIGNATURE_32('S', 'K', 'U', 'D')
 #define UBA_BOARD_VERSION           0x01
 
+//
+// The database is created with PcdUbaConfigDbEntries entries and PcdUbaConfigDbDataSize
+// bytes of data. The entry table and the hash index double whenever the entry table is
+// full. The index always keeps at least half of its slots empty so a probe sequence
+// ends quickly.
+//
+#define UBA_CONFIG_DB_DATA_ALIGNMENT      8
+#define UBA_CONFIG_DB_SLOT_EMPTY          0
+
 //
 // Interface data between PEI & DXE
 // Should keep same align
 //
 #pragma pack (1)
 
-typedef struct _UBA_CONFIG_HOB_FIELD {
-  UINT32                  Signature;
-  UINT32                  Version;
+typedef struct _UBA_CONFIG_DB_ENTRY {
   EFI_GUID                ResId;
-  UINT64                  DataOffset;
+  UINT32                  DataOffset;       // Relative to UBA_CONFIG_DB_HEADER.DataOffset
   UINT32                  Size;
-} UBA_CONFIG_HOB_FIELD;
+} UBA_CONFIG_DB_ENTRY;
 
-typedef struct _UBA_CONFIG_HOB_HEADER {
+typedef struct _UBA_CONFIG_DB_HEADER {
   UINT32                  Signature;
   UINT32                  Version;
-  EFI_GUID                DataGuid;
-  UINT32                  HobLength;
+  UINT32                  TotalSize;        // Size of the whole buffer
   UINT32                  BoardId;
   EFI_GUID                BoardGuid;
   CHAR8                   BoardName[16];
   UINT32                  DataCount;
-  UBA_CONFIG_HOB_FIELD    HobField[1];
-} UBA_CONFIG_HOB_HEADER;
-
-
-typedef struct _UBA_BOARD_NODE {
-  UINT32                  Signature;
-  UINT32                  Version;
-  LIST_ENTRY              DataLinkHead;
-
-  UINT32                  BoardId;
-  EFI_GUID                BoardGuid;
-  CHAR8                   BoardName[16];
-  UINT32                  DataCount;
-} UBA_BOARD_NODE;
-
-typedef struct _UBA_CONFIG_NODE {
-  UINT32                  Signature;
-  UINT32                  Version;
-  LIST_ENTRY              DataLink;
-
-  EFI_HANDLE              Handle;
-  EFI_GUID                ResId;
-  UINT32                  Size;
-  VOID                    *Data;
-} UBA_CONFIG_NODE;
+  UINT32                  EntryCapacity;
+  UINT32                  IndexSlots;       // Power of 2, twice EntryCapacity
+  UINT32                  IndexOffset;
+  UINT32                  EntryOffset;
+  UINT32                  DataOffset;
+  UINT32                  DataUsed;
+  UINT32                  Reserved;
+} UBA_CONFIG_DB_HEADER;
 
 #pragma pack ()
 
-#define BOARD_NODE_INSTANCE_FROM_THIS(p)       CR(p, UBA_BOARD_NODE, DataLinkHead, UBA_BOARD_SIGNATURE)
-#define CONFIG_NODE_INSTANCE_FROM_THIS(p)      CR(p, UBA_CONFIG_NODE, DataLink, UBA_BOARD_SIGNATURE)
+#define UBA_CONFIG_DB_INDEX(Db)     ((UINT32 *) ((UINT8 *) (Db) + (Db)->IndexOffset))
+#define UBA_CONFIG_DB_ENTRIES(Db)   ((UBA_CONFIG_DB_ENTRY *) ((UINT8 *) (Db) + (Db)->EntryOffset))
+#define UBA_CONFIG_DB_DATA(Db, e)   ((VOID *) ((UINT8 *) (Db) + (Db)->DataOffset + (e)->DataOffset))
 
 #endif // _UBA_CONFIG_DATABASE_HOB_H_
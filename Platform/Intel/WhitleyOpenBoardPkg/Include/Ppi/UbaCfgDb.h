@@ -16,7 +16,7 @@
 
 typedef struct _UBA_CONFIG_DATABASE_PPI UBA_CONFIG_DATABASE_PPI;
 
-#define UBA_CONFIG_PPI_VERSION    01
+#define UBA_CONFIG_PPI_VERSION    02
 #define UBA_CONFIG_PPI_SIGNATURE  SIGNATURE_32('U', 'S', 'K', 'U')
 
 //
@@ -124,6 +124,33 @@ EFI_STATUS
   IN  OUT UINTN                       *DataSize
   );
 
+/**
+  Get a pointer to configuration data inside uba configuration database,
+  without copying it.
+
+  The data must be treated as read only. The pointer stays valid until the
+  next AddData call, and must not be kept across permanent memory
+  installation, as the database may be moved then.
+
+  @param This                   uba Ppi instance.
+  @param ResId                  The configuration data resource id.
+  @param Data                   Return the pointer to the configuration data.
+  @param DataSize               Return the size of the configuration data, optional.
+
+  @retval EFI_INVALID_PARAMETER Required parameters not correct.
+  @retval EFI_NOT_FOUND         Platform or data not found.
+  @retval EFI_SUCCESS           Operation success.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *PEI_UBA_CONFIG_GET_DATA_POINTER) (
+  IN  UBA_CONFIG_DATABASE_PPI         *This,
+  IN  EFI_GUID                        *ResId,
+  OUT VOID                            **Data,
+  OUT UINTN                           *DataSize     OPTIONAL
+  );
+
 
 //
 // Multi Sku config database PPI
@@ -137,6 +164,7 @@ struct _UBA_CONFIG_DATABASE_PPI {
 
   PEI_UBA_CONFIG_ADD_DATA            AddData;
   PEI_UBA_CONFIG_GET_DATA            GetData;
+  PEI_UBA_CONFIG_GET_DATA_POINTER    GetDataPointer;
 };
 
 extern EFI_GUID gUbaConfigDatabasePpiGuid;
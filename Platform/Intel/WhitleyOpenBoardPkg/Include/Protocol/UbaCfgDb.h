@@ -18,7 +18,7 @@
 typedef struct _UBA_CONFIG_DATABASE_PROTOCOL UBA_CONFIG_DATABASE_PROTOCOL;
 
 #define UBA_CONFIG_PROTOCOL_SIGNATURE  SIGNATURE_32('M', 'S', 'K', 'P')
-#define UBA_CONFIG_PROTOCOL_VERSION    0x01
+#define UBA_CONFIG_PROTOCOL_VERSION    0x02
 
 /**
   Get platform's GUID and user friendly name by PlatformType.
@@ -96,6 +96,32 @@ EFI_STATUS
   OUT UINTN                                 *DataSize
   );
 
+/**
+  Get a pointer to configuration data inside uba configuration database,
+  without copying it.
+
+  The data must be treated as read only. The pointer stays valid until the
+  next AddData call.
+
+  @param This                   uba Protocol instance.
+  @param ResId                  The configuration data resource id.
+  @param Data                   Return the pointer to the configuration data.
+  @param DataSize               Return the size of the configuration data, optional.
+
+  @retval EFI_INVALID_PARAMETER Required parameters not correct.
+  @retval EFI_NOT_FOUND         Platform or data not found.
+  @retval EFI_SUCCESS           Operation success.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *UBA_CONFIG_GET_DATA_POINTER) (
+  IN  UBA_CONFIG_DATABASE_PROTOCOL          *This,
+  IN  EFI_GUID                              *ResId,
+  OUT VOID                                  **Data,
+  OUT UINTN                                 *DataSize     OPTIONAL
+  );
+
 
 //
 // UbaConfigDatabaseProtocol
@@ -107,6 +133,7 @@ struct _UBA_CONFIG_DATABASE_PROTOCOL {
   UBA_CONFIG_GET_PLATFORM               GetSku;
   UBA_CONFIG_ADD_DATA                   AddData;
   UBA_CONFIG_GET_DATA                   GetData;
+  UBA_CONFIG_GET_DATA_POINTER           GetDataPointer;
 };
 
 extern EFI_GUID gUbaConfigDatabaseProtocolGuid;
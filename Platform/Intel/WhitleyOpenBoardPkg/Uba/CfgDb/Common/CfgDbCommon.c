@@ -0,0 +1,224 @@
+/** @file
+  UbaConfigDatabase functions shared by the Peim and the Dxe driver.
+
+  @copyright
+  Copyright 2013 - 2021 Intel Corporation. <BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "CfgDbCommon.h"
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+/**
+  Internal function for hashing a resource ID into the database index.
+
+  @param ResId                  The resource ID.
+
+  @return The hash value, the caller masks it with the index size.
+**/
+STATIC
+UINT32
+InternalHashResId (
+  IN  EFI_GUID                      *ResId
+  )
+{
+  UINT32                          Hash;
+
+  Hash = ReadUnaligned32 ((UINT32 *) ResId) ^
+         ReadUnaligned32 ((UINT32 *) ResId + 1) ^
+         ReadUnaligned32 ((UINT32 *) ResId + 2) ^
+         ReadUnaligned32 ((UINT32 *) ResId + 3);
+
+  //
+  // Fold the upper bits down, only the low bits select the slot.
+  //
+  Hash ^= Hash >> 16;
+  Hash *= 0x45D9F3B;
+  Hash ^= Hash >> 16;
+
+  return Hash;
+}
+
+/**
+  Internal function for adding an entry to the database hash index.
+
+  The index always has more free slots than entries, so the probe terminates.
+
+  @param Database               The configuration database.
+  @param EntryNumber            The entry to add.
+**/
+VOID
+InternalIndexEntry (
+  IN  UBA_CONFIG_DB_HEADER          *Database,
+  IN  UINT32                        EntryNumber
+  )
+{
+  UINT32                          *Index;
+  UINT32                          Mask;
+  UINT32                          Slot;
+
+  Index = UBA_CONFIG_DB_INDEX (Database);
+  Mask  = Database->IndexSlots - 1;
+  Slot  = InternalHashResId (&UBA_CONFIG_DB_ENTRIES (Database)[EntryNumber].ResId) & Mask;
+
+  while (Index[Slot] != UBA_CONFIG_DB_SLOT_EMPTY) {
+    Slot = (Slot + 1) & Mask;
+  }
+
+  Index[Slot] = EntryNumber + 1;
+}
+
+/**
+  Internal function for finding configuration data in the database.
+
+  If the same resource ID was added more than once, the first one is returned.
+
+  @param Database               The configuration database.
+  @param ResId                  The resource ID.
+
+  @return The database entry, NULL if not found.
+**/
+UBA_CONFIG_DB_ENTRY *
+InternalFindEntry (
+  IN  UBA_CONFIG_DB_HEADER          *Database,
+  IN  EFI_GUID                      *ResId
+  )
+{
+  UINT32                          *Index;
+  UBA_CONFIG_DB_ENTRY             *Entries;
+  UINT32                          Mask;
+  UINT32                          Slot;
+
+  Index   = UBA_CONFIG_DB_INDEX (Database);
+  Entries = UBA_CONFIG_DB_ENTRIES (Database);
+  Mask    = Database->IndexSlots - 1;
+  Slot    = InternalHashResId (ResId) & Mask;
+
+  while (Index[Slot] != UBA_CONFIG_DB_SLOT_EMPTY) {
+    if (CompareGuid (ResId, &Entries[Index[Slot] - 1].ResId)) {
+      return &Entries[Index[Slot] - 1];
+    }
+    Slot = (Slot + 1) & Mask;
+  }
+
+  return NULL;
+}
+
+/**
+  Internal function for allocating an empty configuration database.
+
+  @param EntryCapacity          Number of entries, must be a power of 2.
+  @param DataCapacity           Size of the data area.
+
+  @return The configuration database, NULL if no enough resource.
+**/
+UBA_CONFIG_DB_HEADER *
+InternalCreateDatabase (
+  IN  UINT32                        EntryCapacity,
+  IN  UINT32                        DataCapacity
+  )
+{
+  UBA_CONFIG_DB_HEADER            *Database;
+  UINT32                          IndexSlots;
+  UINT32                          IndexOffset;
+  UINT32                          EntryOffset;
+  UINT32                          DataOffset;
+
+  ASSERT ((EntryCapacity != 0) && ((EntryCapacity & (EntryCapacity - 1)) == 0));
+
+  IndexSlots  = EntryCapacity * 2;
+  IndexOffset = (UINT32) ALIGN_VALUE (sizeof (UBA_CONFIG_DB_HEADER), UBA_CONFIG_DB_DATA_ALIGNMENT);
+  EntryOffset = (UINT32) ALIGN_VALUE (IndexOffset + IndexSlots * sizeof (UINT32), UBA_CONFIG_DB_DATA_ALIGNMENT);
+  DataOffset  = (UINT32) ALIGN_VALUE (EntryOffset + EntryCapacity * sizeof (UBA_CONFIG_DB_ENTRY), UBA_CONFIG_DB_DATA_ALIGNMENT);
+
+  Database = AllocateZeroPool (DataOffset + DataCapacity);
+  if (Database == NULL) {
+    return NULL;
+  }
+
+  Database->Signature     = UBA_CONFIG_HOB_SIGNATURE;
+  Database->Version       = UBA_CONFIG_HOB_VERSION;
+  Database->TotalSize     = DataOffset + DataCapacity;
+  Database->EntryCapacity = EntryCapacity;
+  Database->IndexSlots    = IndexSlots;
+  Database->IndexOffset   = IndexOffset;
+  Database->EntryOffset   = EntryOffset;
+  Database->DataOffset    = DataOffset;
+
+  return Database;
+}
+
+/**
+  Internal function for moving the configuration database to a bigger buffer.
+
+  The entry table doubles when it is full, the data area doubles until the new
+  data fits. The old buffer is freed, the caller records the new one.
+
+  @param Database               The configuration database.
+  @param DataSize               Aligned size of the data to be added.
+
+  @return The new configuration database, NULL if no enough resource.
+**/
+UBA_CONFIG_DB_HEADER *
+InternalGrowDatabase (
+  IN  UBA_CONFIG_DB_HEADER          *Database,
+  IN  UINT32                        DataSize
+  )
+{
+  UBA_CONFIG_DB_HEADER            *NewDatabase;
+  UINT32                          EntryCapacity;
+  UINT32                          DataCapacity;
+  UINT32                          DataNeeded;
+  UINT32                          Index;
+
+  EntryCapacity = Database->EntryCapacity;
+  if (Database->DataCount == EntryCapacity) {
+    EntryCapacity *= 2;
+  }
+
+  //
+  // Only ever double, so a run of additions reallocates a logarithmic number of times.
+  //
+  DataCapacity = MAX (Database->TotalSize - Database->DataOffset, UBA_CONFIG_DB_DATA_ALIGNMENT);
+  DataNeeded   = Database->DataUsed + DataSize;
+  while (DataCapacity < DataNeeded) {
+    DataCapacity *= 2;
+  }
+
+  NewDatabase = InternalCreateDatabase (EntryCapacity, DataCapacity);
+  if (NewDatabase == NULL) {
+    return NULL;
+  }
+
+  NewDatabase->BoardId   = Database->BoardId;
+  NewDatabase->DataCount = Database->DataCount;
+  NewDatabase->DataUsed  = Database->DataUsed;
+  CopyGuid (&NewDatabase->BoardGuid, &Database->BoardGuid);
+  CopyMem (NewDatabase->BoardName, Database->BoardName, sizeof (NewDatabase->BoardName));
+
+  //
+  // Data offsets are relative to the data area, only the index has to be rebuilt.
+  //
+  CopyMem (
+    UBA_CONFIG_DB_ENTRIES (NewDatabase),
+    UBA_CONFIG_DB_ENTRIES (Database),
+    Database->DataCount * sizeof (UBA_CONFIG_DB_ENTRY)
+    );
+  CopyMem (
+    (UINT8 *) NewDatabase + NewDatabase->DataOffset,
+    (UINT8 *) Database + Database->DataOffset,
+    Database->DataUsed
+    );
+  for (Index = 0; Index < NewDatabase->DataCount; Index++) {
+    InternalIndexEntry (NewDatabase, Index);
+  }
+
+  FreePool (Database);
+
+  return NewDatabase;
+}
@@ -0,0 +1,77 @@
+/** @file
+  UbaConfigDatabase functions shared by the Peim and the Dxe driver.
+
+  @copyright
+  Copyright 2013 - 2021 Intel Corporation. <BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef _UBA_CONFIG_DATABASE_COMMON_H_
+#define _UBA_CONFIG_DATABASE_COMMON_H_
+
+#include <Uefi/UefiBaseType.h>
+#include <Guid/UbaCfgHob.h>
+
+/**
+  Internal function for adding an entry to the database hash index.
+
+  The index always has more free slots than entries, so the probe terminates.
+
+  @param Database               The configuration database.
+  @param EntryNumber            The entry to add.
+**/
+VOID
+InternalIndexEntry (
+  IN  UBA_CONFIG_DB_HEADER          *Database,
+  IN  UINT32                        EntryNumber
+  );
+
+/**
+  Internal function for finding configuration data in the database.
+
+  If the same resource ID was added more than once, the first one is returned.
+
+  @param Database               The configuration database.
+  @param ResId                  The resource ID.
+
+  @return The database entry, NULL if not found.
+**/
+UBA_CONFIG_DB_ENTRY *
+InternalFindEntry (
+  IN  UBA_CONFIG_DB_HEADER          *Database,
+  IN  EFI_GUID                      *ResId
+  );
+
+/**
+  Internal function for allocating an empty configuration database.
+
+  @param EntryCapacity          Number of entries, must be a power of 2.
+  @param DataCapacity           Size of the data area.
+
+  @return The configuration database, NULL if no enough resource.
+**/
+UBA_CONFIG_DB_HEADER *
+InternalCreateDatabase (
+  IN  UINT32                        EntryCapacity,
+  IN  UINT32                        DataCapacity
+  );
+
+/**
+  Internal function for moving the configuration database to a bigger buffer.
+
+  The entry table doubles when it is full, the data area doubles until the new
+  data fits. The old buffer is freed, the caller records the new one.
+
+  @param Database               The configuration database.
+  @param DataSize               Aligned size of the data to be added.
+
+  @return The new configuration database, NULL if no enough resource.
+**/
+UBA_CONFIG_DB_HEADER *
+InternalGrowDatabase (
+  IN  UBA_CONFIG_DB_HEADER          *Database,
+  IN  UINT32                        DataSize
+  );
+
+#endif // _UBA_CONFIG_DATABASE_COMMON_H_
@@ -8,6 +8,7 @@
 **/
 
 #include "CfgDbDxe.h"
+#include "../Common/CfgDbCommon.h"
 
 #include <PiDxe.h>  // For Hob
 
@@ -19,90 +20,6 @@
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/UefiBootServicesTableLib.h>
 
-/**
-  Internal function for getting the platform record node in the database.
-
-  @param This                   uba Protocol instance.
-  @param SkuNode                The pointer to pointer of Platform record node.
-
-  @retval EFI_NOT_FOUND         Platform record not found.
-  @retval EFI_SUCCESS           Platform found.
-**/
-EFI_STATUS
-InternalGetSkuNode (
-  IN  UBA_CONFIG_DATABASE_PROTOCOL  *This,
-  OUT UBA_BOARD_NODE                **SkuNode
-  )
-{
-  UBA_DXE_PRIVATE_DATA              *UbaDxePrivate;
-  UbaDxePrivate = NULL;
-
-  UbaDxePrivate = PRIVATE_DATA_FROM_PROTOCOL (This);
-  *SkuNode = UbaDxePrivate->CurrentSku;
-
-  return EFI_SUCCESS;
-}
-
-/**
-  Internal function for init the platform record to database.
-  Create the connections between UBA_BOARD_NODE and UBA_DXE_PRIVATE_DATA
-
-  @param This                   UBA Protocol instance.
-  @param BoardId                The platform type.
-  @param BoardGuid              The platform GUID.
-  @param BoardName              The platform user friendly name.
-  @param SkuNode                The pointer to pointer of Platform record node.
-
-  @retval EFI_ALREADY_STARTED   Platform record already exist.
-  @retval EFI_OUT_OF_RESOURCES  No enough resource.
-  @retval EFI_SUCCESS           Operation success.
-**/
-EFI_STATUS
-InternalInitSkuDxe (
-  IN  UBA_CONFIG_DATABASE_PROTOCOL        *This,
-  IN  UINT32                              BoardId,
-  IN  EFI_GUID                            *BoardGuid,     OPTIONAL
-  IN  CHAR8                               *BoardName,     OPTIONAL
-  OUT UBA_BOARD_NODE                      **SkuNode       OPTIONAL
-  )
-{
-  UBA_DXE_PRIVATE_DATA            *UbaDxePrivate;
-  UBA_BOARD_NODE                  *NewSkuNode;
-  UbaDxePrivate = NULL;
-  NewSkuNode = NULL;
-
-  UbaDxePrivate = PRIVATE_DATA_FROM_PROTOCOL (This);
-
-  NewSkuNode = AllocateZeroPool (sizeof (UBA_BOARD_NODE));
-  if (NewSkuNode == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  NewSkuNode->Signature     = UBA_BOARD_SIGNATURE;
-  NewSkuNode->Version       = UBA_BOARD_VERSION;
-  NewSkuNode->BoardId       = BoardId;
-
-  if (BoardName != NULL) {
-    AsciiStrnCpyS (NewSkuNode->BoardName, AsciiStrSize (BoardName) / sizeof (CHAR8), BoardName, sizeof (NewSkuNode->BoardName) - 1);
-  }
-
-  if (BoardGuid != NULL) {
-    CopyMem (&NewSkuNode->BoardGuid, BoardGuid, sizeof (EFI_GUID));
-  }
-
-  // Initialize the list head for Datalink.
-  InitializeListHead (&NewSkuNode->DataLinkHead);
-
-  if (SkuNode != NULL) {
-    // Output the point of sku node.
-    *SkuNode = NewSkuNode;
-    // Pass the point to CurrentSku in UbaDxePrivate.
-    UbaDxePrivate->CurrentSku = NewSkuNode;
-  }
-
-  return EFI_SUCCESS;
-}
-
 /**
   Internal function for adding new configuration data record to database.
 
@@ -113,6 +30,7 @@ InternalInitSkuDxe (
 
   @retval EFI_INVALID_PARAMETER Parameter invalid.
   @retval EFI_OUT_OF_RESOURCES  No enough resource.
+  @retval EFI_NOT_FOUND         Platform not found.
   @retval EFI_SUCCESS           Operation success.
 **/
 EFI_STATUS
@@ -126,11 +44,9 @@ InternalAddNewConfigData (
   EFI_STATUS                      Status;
   EFI_HANDLE                      Handle;
   UBA_DXE_PRIVATE_DATA            *UbaDxePrivate;
-  UBA_CONFIG_NODE                 *NewDataNode;
-  UBA_BOARD_NODE                  *SkuNode;
-  UbaDxePrivate = NULL;
-  NewDataNode   = NULL;
-  SkuNode       = NULL;
+  UBA_CONFIG_DB_HEADER            *Database;
+  UBA_CONFIG_DB_ENTRY             *Entry;
+  UINT32                          AlignedSize;
 
   if ((ResId == NULL) || (Data == NULL) || (DataSize <= 0)) {
     return EFI_INVALID_PARAMETER;
@@ -138,28 +54,30 @@ InternalAddNewConfigData (
 
   UbaDxePrivate = PRIVATE_DATA_FROM_PROTOCOL (This);
 
-  Status = InternalGetSkuNode (This, &SkuNode);
-  if (EFI_ERROR (Status)) {
-    return Status;
+  Database = UbaDxePrivate->Database;
+  if (Database == NULL) {
+    return EFI_NOT_FOUND;
   }
 
-  NewDataNode = AllocateZeroPool (sizeof (UBA_CONFIG_NODE));
-  if (NewDataNode == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  AlignedSize = ALIGN_VALUE ((UINT32) DataSize, UBA_CONFIG_DB_DATA_ALIGNMENT);
+  if ((Database->DataCount == Database->EntryCapacity) ||
+      (Database->DataUsed + AlignedSize > Database->TotalSize - Database->DataOffset)) {
+    Database = InternalGrowDatabase (Database, AlignedSize);
+    if (Database == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    UbaDxePrivate->Database = Database;
   }
 
-  NewDataNode->Signature      = UBA_BOARD_SIGNATURE;
-  NewDataNode->Version        = UBA_BOARD_VERSION;
-  NewDataNode->Handle         = (EFI_HANDLE) (UINTN) UbaDxePrivate->HandleCount;
-  NewDataNode->Data           = AllocateCopyPool (DataSize, Data);
-  NewDataNode->Size           = (UINT32) DataSize;
-
-  CopyMem (&NewDataNode->ResId, ResId, sizeof (EFI_GUID));
+  Entry = &UBA_CONFIG_DB_ENTRIES (Database)[Database->DataCount];
+  CopyGuid (&Entry->ResId, ResId);
+  Entry->DataOffset = Database->DataUsed;
+  Entry->Size       = (UINT32) DataSize;
+  CopyMem (UBA_CONFIG_DB_DATA (Database, Entry), Data, DataSize);
 
-  InsertTailList (&SkuNode->DataLinkHead, &NewDataNode->DataLink);
-  SkuNode->DataCount ++;
-  UbaDxePrivate->ConfigDataCount ++;
-  UbaDxePrivate->HandleCount ++;
+  InternalIndexEntry (Database, Database->DataCount);
+  Database->DataCount ++;
+  Database->DataUsed += AlignedSize;
 
   //
   // This Protocol just install for Protocol notify
@@ -168,7 +86,7 @@ InternalAddNewConfigData (
   Handle = NULL;
   Status = gBS->InstallProtocolInterface (
                   &Handle,
-                  &NewDataNode->ResId,
+                  ResId,
                   EFI_NATIVE_INTERFACE,
                   &UbaDxePrivate->UbaCfgDbProtocol
                   );
@@ -183,8 +101,7 @@ InternalAddNewConfigData (
 /**
   Internal function for Getting configuration data from database.
 
-  @param This                   uba Protocol instance.
-  @param SkuNode                The platform node record.
+  @param Database               The configuration database.
   @param ResId                  The resource ID.
   @param Data                   Data pointer.
   @param DataSize               Data size pointer.
@@ -196,57 +113,38 @@ InternalAddNewConfigData (
 **/
 EFI_STATUS
 InternalGetConfigData (
-  IN  UBA_CONFIG_DATABASE_PROTOCOL        *This,
-  IN  UBA_BOARD_NODE                      *SkuNode,
+  IN  UBA_CONFIG_DB_HEADER                *Database,
   IN  EFI_GUID                            *ResId,
   OUT VOID                                *Data,      OPTIONAL
   OUT UINTN                               *DataSize   OPTIONAL
   )
 {
-  LIST_ENTRY                            *ListHead;
-  LIST_ENTRY                            *Link;
-  UBA_CONFIG_NODE                       *DataNode;
-  ListHead = NULL;
-  Link     = NULL;
-  DataNode = NULL;
-
-  if ((SkuNode == NULL) || (ResId == NULL)) {
+  UBA_CONFIG_DB_ENTRY                   *Entry;
+
+  if ((Database == NULL) || (ResId == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
-  ListHead = &SkuNode->DataLinkHead;
-  if (IsListEmpty (ListHead)) {
+  Entry = InternalFindEntry (Database, ResId);
+  if (Entry == NULL) {
     return EFI_NOT_FOUND;
   }
 
-  for (Link = GetFirstNode (ListHead); !IsNull (ListHead, Link); Link = GetNextNode (ListHead, Link)) {
+  if (DataSize != NULL) {
 
-    DataNode = CONFIG_NODE_INSTANCE_FROM_THIS (Link);
-    ASSERT (DataNode != NULL);
-    if (DataNode == NULL) {
-      return EFI_UNSUPPORTED;
+    if (*DataSize < Entry->Size) {
+      *DataSize = Entry->Size;
+      return EFI_BUFFER_TOO_SMALL;
     }
-    if (CompareGuid (ResId, &DataNode->ResId)) {
-
-      if (DataSize != NULL) {
-
-        if (*DataSize < DataNode->Size) {
-          *DataSize = DataNode->Size;
-          return EFI_BUFFER_TOO_SMALL;
-        }
-
-        *DataSize = DataNode->Size;
 
-        if (Data != NULL) {
-          CopyMem (Data, DataNode->Data, DataNode->Size);
-        }
-      }
+    *DataSize = Entry->Size;
 
-      return EFI_SUCCESS;
+    if (Data != NULL) {
+      CopyMem (Data, UBA_CONFIG_DB_DATA (Database, Entry), Entry->Size);
     }
   }
 
-  return EFI_NOT_FOUND;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -276,28 +174,25 @@ DxeUbaGetPlatformSku (
   OUT CHAR8                               *BoardName   OPTIONAL
   )
 {
-  EFI_STATUS                 Status;
-  UBA_BOARD_NODE             *SkuNode;
-  SkuNode = NULL;
+  UBA_CONFIG_DB_HEADER       *Database;
 
-  Status = InternalGetSkuNode (This, &SkuNode);
-
-  if (!EFI_ERROR (Status)) {
-    if (BoardId != NULL) {
-      *BoardId = SkuNode->BoardId;
-    }
-    if (BoardName != NULL) {
-      AsciiStrCpyS (BoardName, AsciiStrSize (SkuNode->BoardName) / sizeof (CHAR8) , SkuNode->BoardName);
-    }
+  Database = PRIVATE_DATA_FROM_PROTOCOL (This)->Database;
+  if (Database == NULL) {
+    return EFI_NOT_FOUND;
+  }
 
-    if (BoardGuid != NULL) {
-      CopyMem (BoardGuid, &SkuNode->BoardGuid, sizeof (EFI_GUID));
-    }
+  if (BoardId != NULL) {
+    *BoardId = Database->BoardId;
+  }
+  if (BoardName != NULL) {
+    AsciiStrCpyS (BoardName, AsciiStrSize (Database->BoardName) / sizeof (CHAR8) , Database->BoardName);
+  }
 
-    return EFI_SUCCESS;
+  if (BoardGuid != NULL) {
+    CopyGuid (BoardGuid, &Database->BoardGuid);
   }
 
-  return Status;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -322,18 +217,7 @@ DxeUbaAddData (
   IN  UINTN                               DataSize
   )
 {
-  EFI_STATUS                 Status;
-  UBA_BOARD_NODE             *SkuNode;
-  SkuNode = NULL;
-
-  Status = InternalGetSkuNode (This, &SkuNode);
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
-
-  Status = InternalAddNewConfigData (This, ResId, Data, DataSize);
-
-  return Status;
+  return InternalAddNewConfigData (This, ResId, Data, DataSize);
 }
 
 /**
@@ -360,19 +244,18 @@ DxeUbaGetData (
   )
 {
   EFI_STATUS                      Status;
-  UBA_BOARD_NODE                  *SkuNode;
-  SkuNode = NULL;
+  UBA_CONFIG_DB_HEADER            *Database;
 
   if ((ResId == NULL) || (Data == NULL) || (DataSize == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
-  Status = InternalGetSkuNode (This, &SkuNode);
-  if (EFI_ERROR (Status)) {
-    return Status;
+  Database = PRIVATE_DATA_FROM_PROTOCOL (This)->Database;
+  if (Database == NULL) {
+    return EFI_NOT_FOUND;
   }
 
-  Status = InternalGetConfigData (This, SkuNode, ResId, Data, DataSize);
+  Status = InternalGetConfigData (Database, ResId, Data, DataSize);
   if (!EFI_ERROR (Status)) {
     return EFI_SUCCESS;
   }
@@ -381,30 +264,76 @@ DxeUbaGetData (
 }
 
 /**
-  Internal function for getting current platform's configuration data from HOB, which passed by PEIM.
+  Get a pointer to configuration data inside uba configuration database.
 
   @param This                   uba Protocol instance.
+  @param ResId                  The configuration data resource id.
+  @param Data                   Return the pointer to the configuration data.
+  @param DataSize               Return the size of the configuration data, optional.
 
   @retval EFI_INVALID_PARAMETER Required parameters not correct.
-  @retval EFI_OUT_OF_RESOURCES  Resource not enough.
   @retval EFI_NOT_FOUND         Platform or data not found.
   @retval EFI_SUCCESS           Operation success.
 **/
 EFI_STATUS
+EFIAPI
+DxeUbaGetDataPointer (
+  IN  UBA_CONFIG_DATABASE_PROTOCOL        *This,
+  IN  EFI_GUID                            *ResId,
+  OUT VOID                                **Data,
+  OUT UINTN                               *DataSize     OPTIONAL
+  )
+{
+  UBA_CONFIG_DB_HEADER            *Database;
+  UBA_CONFIG_DB_ENTRY             *Entry;
+
+  if ((ResId == NULL) || (Data == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Database = PRIVATE_DATA_FROM_PROTOCOL (This)->Database;
+  if (Database == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Entry = InternalFindEntry (Database, ResId);
+  if (Entry == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  *Data = UBA_CONFIG_DB_DATA (Database, Entry);
+  if (DataSize != NULL) {
+    *DataSize = Entry->Size;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Internal function for getting current platform's configuration data from HOB, which passed by PEIM.
+
+  The HOB carries the configuration database built in PEI, it is adopted as it is
+  and a notify protocol is installed for each configuration data in it.
+
+  @param This                   uba Protocol instance.
+
+  @retval EFI_UNSUPPORTED       The HOB is not found or not recognized.
+  @retval EFI_OUT_OF_RESOURCES  Resource not enough.
+  @retval EFI_SUCCESS           Operation success.
+**/
+EFI_STATUS
 InternalGetConfigDataFromHob (
   IN  UBA_CONFIG_DATABASE_PROTOCOL  *This
   )
 {
   EFI_STATUS                            Status;
   EFI_PEI_HOB_POINTERS                  Hob;
-  UINT8                                 *HobDataStart;
-  UBA_CONFIG_HOB_HEADER                 *HobHeader;
-  UBA_CONFIG_HOB_FIELD                  *HobDataFieldStart;
+  UBA_DXE_PRIVATE_DATA                  *UbaDxePrivate;
+  UBA_CONFIG_DB_HEADER                  *HobDatabase;
+  UBA_CONFIG_DB_HEADER                  *Database;
+  UBA_CONFIG_DB_ENTRY                   *Entries;
+  EFI_HANDLE                            Handle;
   UINTN                                 Index;
-  UBA_BOARD_NODE                        *SkuNode;
-  HobHeader = NULL;
-  HobDataFieldStart = NULL;
-  SkuNode = NULL;
 
   Hob.Raw = GetFirstGuidHob (&gUbaCurrentConfigHobGuid);
   ASSERT (Hob.Raw != NULL);
@@ -414,25 +343,32 @@ InternalGetConfigDataFromHob (
 
   DEBUG ((DEBUG_INFO, "UbaConfigDatabasedxeEntry: get first hob!\n"));
 
-  HobDataStart = GET_GUID_HOB_DATA (Hob);
-
-  HobHeader          = (UBA_CONFIG_HOB_HEADER *) HobDataStart;
-  HobDataFieldStart  = HobHeader->HobField;
+  HobDatabase = (UBA_CONFIG_DB_HEADER *) GET_GUID_HOB_DATA (Hob);
+  if ((GET_GUID_HOB_DATA_SIZE (Hob) < sizeof (UBA_CONFIG_DB_HEADER)) ||
+      (HobDatabase->Signature != UBA_CONFIG_HOB_SIGNATURE) ||
+      (HobDatabase->Version != UBA_CONFIG_HOB_VERSION) ||
+      (HobDatabase->TotalSize > GET_GUID_HOB_DATA_SIZE (Hob))) {
+    ASSERT (FALSE);
+    return EFI_UNSUPPORTED;
+  }
 
-  //Call internal function for SKU init, accroding to hob data.
-  Status = InternalInitSkuDxe (This, HobHeader->BoardId, &HobHeader->BoardGuid, HobHeader->BoardName, &SkuNode);
-  if (EFI_ERROR (Status)) {
-    return Status;
+  Database = AllocateCopyPool (HobDatabase->TotalSize, HobDatabase);
+  if (Database == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  // Obtain all data stored in the hob from PEI phase.
-  for (Index = 0; Index < HobHeader->DataCount; Index ++) {
-    Status = This->AddData (
-                     This,
-                     &HobDataFieldStart[Index].ResId,
-                     (VOID *) ((UINTN) HobDataFieldStart[Index].DataOffset + (UINTN) HobHeader),
-                     HobDataFieldStart[Index].Size
-                     );
+  UbaDxePrivate = PRIVATE_DATA_FROM_PROTOCOL (This);
+  UbaDxePrivate->Database = Database;
+
+  Entries = UBA_CONFIG_DB_ENTRIES (Database);
+  for (Index = 0; Index < Database->DataCount; Index ++) {
+    Handle = NULL;
+    Status = gBS->InstallProtocolInterface (
+                    &Handle,
+                    &Entries[Index].ResId,
+                    EFI_NATIVE_INTERFACE,
+                    This
+                    );
     ASSERT_EFI_ERROR (Status);
     if (Status != EFI_SUCCESS) {
       return Status;
@@ -475,8 +411,7 @@ UbaConfigDatabaseEntry (
   UbaDxePrivate->Signature  = UBA_BOARD_SIGNATURE;
   UbaDxePrivate->Version    = UBA_BOARD_VERSION;
 
-  UbaDxePrivate->ConfigDataCount           = 0;
-  UbaDxePrivate->HandleCount               = 0;
+  UbaDxePrivate->Database                  = NULL;
 
   UbaDxePrivate->UbaCfgDbProtocol.Signature      = UBA_CONFIG_PROTOCOL_SIGNATURE;
   UbaDxePrivate->UbaCfgDbProtocol.Version        = UBA_CONFIG_PROTOCOL_VERSION;
@@ -484,6 +419,7 @@ UbaConfigDatabaseEntry (
   UbaDxePrivate->UbaCfgDbProtocol.GetSku         = DxeUbaGetPlatformSku;
   UbaDxePrivate->UbaCfgDbProtocol.AddData        = DxeUbaAddData;
   UbaDxePrivate->UbaCfgDbProtocol.GetData        = DxeUbaGetData;
+  UbaDxePrivate->UbaCfgDbProtocol.GetDataPointer = DxeUbaGetDataPointer;
 
   //
   // Just produce our Protocol
@@ -500,7 +436,7 @@ UbaConfigDatabaseEntry (
   }
 
   DEBUG ((DEBUG_INFO, "UbaConfigDatabasedxeEntry: before get data from hob!\n"));
-  // Init sku dxe and get configuration data from hob passed by PEIM.
+  // Get the configuration database passed by PEIM.
   Status = InternalGetConfigDataFromHob (&UbaDxePrivate->UbaCfgDbProtocol);
   ASSERT_EFI_ERROR (Status);
 
@@ -19,9 +19,7 @@ typedef struct _UBA_DXE_PRIVATE_DATA {
   UINT32                          Signature;
   UINT32                          Version;
 
-  UINTN                           ConfigDataCount;              //for AllConfigDataSize
-  UINTN                           HandleCount;
-  UBA_BOARD_NODE                  *CurrentSku;
+  UBA_CONFIG_DB_HEADER            *Database;
 
   UBA_CONFIG_DATABASE_PROTOCOL   UbaCfgDbProtocol;
 } UBA_DXE_PRIVATE_DATA;
@@ -8,6 +8,7 @@
 **/
 
 #include "CfgDbPei.h"
+#include "../Common/CfgDbCommon.h"
 
 #include <Ppi/EndOfPeiPhase.h>
 
@@ -19,42 +20,51 @@
 #include <Library/PeimEntryPoint.h>
 #include <Library/PeiServicesLib.h>
 #include <Library/PeiServicesTablePointerLib.h>
+#include <Library/PcdLib.h>
 
 /**
-  Internal function for getting the platform record node in the database.
+  Internal function for getting the configuration database of the current platform.
 
-  @param This                   uba Ppi instance.
-  @param SkuNode                The pointer to pointer of Platform record node.
+  @param UbaPeimPrivate         uba Ppi private data.
 
-  @retval EFI_NOT_FOUND         Platform record not found.
-  @retval EFI_SUCCESS           Platform found.
+  @return The configuration database, NULL if the platform is not initialized yet.
 **/
-EFI_STATUS
-InternalGetSkuNode (
-  IN  UBA_CONFIG_DATABASE_PPI       *This,
-  OUT UBA_BOARD_NODE                **SkuNode
+UBA_CONFIG_DB_HEADER *
+InternalGetDatabase (
+  IN  UBA_PEIM_PRIVATE_DATA         *UbaPeimPrivate
   )
 {
-  UBA_PEIM_PRIVATE_DATA           *UbaPeimPrivate;
-  UbaPeimPrivate = NULL;
+  if (UbaPeimPrivate->DatabaseOffset == 0) {
+    return NULL;
+  }
 
-  UbaPeimPrivate = PRIVATE_DATA_FROM_PPI (This);
-  *SkuNode = UbaPeimPrivate->CurrentSku;
+  return (UBA_CONFIG_DB_HEADER *) ((UINT8 *) UbaPeimPrivate + UbaPeimPrivate->DatabaseOffset);
+}
 
-  return EFI_SUCCESS;
+/**
+  Internal function for recording the configuration database of the current platform.
+
+  @param UbaPeimPrivate         uba Ppi private data.
+  @param Database               The configuration database.
+**/
+VOID
+InternalSetDatabase (
+  IN  UBA_PEIM_PRIVATE_DATA         *UbaPeimPrivate,
+  IN  UBA_CONFIG_DB_HEADER          *Database
+  )
+{
+  UbaPeimPrivate->DatabaseOffset = (INTN) ((UINTN) Database - (UINTN) UbaPeimPrivate);
 }
 
 /**
   Internal function for init the platform record to database.
-  Create the connections between UBA_BOARD_NODE and UBA_PEIM_PRIVATE_DATA
+  Create an empty configuration database for the platform.
 
   @param This                   uba Ppi instance.
   @param BoardId                The platform type.
   @param BoardGuid              The platform GUID.
   @param BoardName              The platform user friendly name.
-  @param SkuNode                The pointer to pointer of Platform record node.
 
-  @retval EFI_ALREADY_STARTED   Platform record already exist.
   @retval EFI_OUT_OF_RESOURCES  No enough resource.
   @retval EFI_SUCCESS           Operation success.
 **/
@@ -63,41 +73,40 @@ InternalInitSku (
   IN  UBA_CONFIG_DATABASE_PPI             *This,
   IN  UINT32                              BoardId,
   IN  EFI_GUID                            *BoardGuid,     OPTIONAL
-  IN  CHAR8                               *BoardName,     OPTIONAL
-  OUT UBA_BOARD_NODE                      **SkuNode       OPTIONAL
+  IN  CHAR8                               *BoardName      OPTIONAL
   )
 {
   UBA_PEIM_PRIVATE_DATA           *UbaPeimPrivate;
-  UBA_BOARD_NODE                  *NewSkuNode;
-  UbaPeimPrivate = NULL;
-  NewSkuNode = NULL;
+  UBA_CONFIG_DB_HEADER            *Database;
+  UBA_CONFIG_DB_HEADER            *OldDatabase;
 
   UbaPeimPrivate = PRIVATE_DATA_FROM_PPI (This);
 
-  NewSkuNode = AllocateZeroPool (sizeof (UBA_BOARD_NODE));
-  if (NewSkuNode == NULL) {
+  //
+  // The PEI heap cannot free, so the database is sized up front to avoid growing it.
+  //
+  Database = InternalCreateDatabase (
+               PcdGet32 (PcdUbaConfigDbEntries),
+               PcdGet32 (PcdUbaConfigDbDataSize)
+               );
+  if (Database == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  NewSkuNode->Signature     = UBA_BOARD_SIGNATURE;
-  NewSkuNode->Version       = UBA_BOARD_VERSION;
-  NewSkuNode->BoardId       = BoardId;
+  Database->BoardId = BoardId;
 
   if (BoardName != NULL) {
-    AsciiStrnCpyS (NewSkuNode->BoardName, sizeof (NewSkuNode->BoardName), BoardName, sizeof (NewSkuNode->BoardName) - 1);
+    AsciiStrnCpyS (Database->BoardName, sizeof (Database->BoardName), BoardName, sizeof (Database->BoardName) - 1);
   }
 
   if (BoardGuid != NULL) {
-    CopyMem (&NewSkuNode->BoardGuid, BoardGuid, sizeof (EFI_GUID));
+    CopyGuid (&Database->BoardGuid, BoardGuid);
   }
 
-  //Initialize the list head for Datalink.
-  InitializeListHead (&NewSkuNode->DataLinkHead);
-
-
-  if (SkuNode != NULL) {
-    *SkuNode = NewSkuNode;
-    UbaPeimPrivate->CurrentSku = NewSkuNode;
+  OldDatabase = InternalGetDatabase (UbaPeimPrivate);
+  InternalSetDatabase (UbaPeimPrivate, Database);
+  if (OldDatabase != NULL) {
+    FreePool (OldDatabase);
   }
 
   return EFI_SUCCESS;
@@ -113,6 +122,7 @@ InternalInitSku (
 
   @retval EFI_INVALID_PARAMETER Parameter invalid.
   @retval EFI_OUT_OF_RESOURCES  No enough resource.
+  @retval EFI_NOT_FOUND         Platform not found.
   @retval EFI_SUCCESS           Operation success.
 **/
 EFI_STATUS
@@ -125,13 +135,10 @@ InternalAddNewConfigData (
 {
   EFI_STATUS                      Status;
   UBA_PEIM_PRIVATE_DATA           *UbaPeimPrivate;
-  UBA_CONFIG_NODE                 *NewDataNode;
-  UBA_BOARD_NODE                  *SkuNode;
-  EFI_PEI_PPI_DESCRIPTOR          *ConfigDataPpi;
-  UbaPeimPrivate = NULL;
-  NewDataNode = NULL;
-  SkuNode = NULL;
-  ConfigDataPpi = NULL;
+  UBA_CONFIG_DB_HEADER            *Database;
+  UBA_CONFIG_DB_ENTRY             *Entry;
+  UBA_CONFIG_DATA_PPI_DESCRIPTOR  *ConfigDataPpi;
+  UINT32                          AlignedSize;
 
   if ((ResId == NULL) || (Data == NULL) || (DataSize <= 0)) {
     return EFI_INVALID_PARAMETER;
@@ -139,43 +146,47 @@ InternalAddNewConfigData (
 
   UbaPeimPrivate = PRIVATE_DATA_FROM_PPI (This);
 
-  Status = InternalGetSkuNode (This, &SkuNode);
-  if (EFI_ERROR (Status)) {
-    return Status;
+  Database = InternalGetDatabase (UbaPeimPrivate);
+  if (Database == NULL) {
+    return EFI_NOT_FOUND;
   }
 
-  NewDataNode = AllocateZeroPool (sizeof (UBA_CONFIG_NODE));
-  if (NewDataNode == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  AlignedSize = ALIGN_VALUE ((UINT32) DataSize, UBA_CONFIG_DB_DATA_ALIGNMENT);
+  if ((Database->DataCount == Database->EntryCapacity) ||
+      (Database->DataUsed + AlignedSize > Database->TotalSize - Database->DataOffset)) {
+    DEBUG ((DEBUG_WARN, "UBA config database is full, raise PcdUbaConfigDbEntries or PcdUbaConfigDbDataSize\n"));
+    Database = InternalGrowDatabase (Database, AlignedSize);
+    if (Database == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    InternalSetDatabase (UbaPeimPrivate, Database);
   }
 
-  NewDataNode->Signature      = UBA_BOARD_SIGNATURE;
-  NewDataNode->Version        = UBA_BOARD_VERSION;
-  NewDataNode->Handle         = (EFI_HANDLE) (UINTN) UbaPeimPrivate->HandleCount;
-  NewDataNode->Data           = AllocateCopyPool (DataSize, Data);
-  NewDataNode->Size           = (UINT32) DataSize;
-
-  CopyMem (&NewDataNode->ResId, ResId, sizeof (EFI_GUID));
+  Entry = &UBA_CONFIG_DB_ENTRIES (Database)[Database->DataCount];
+  CopyGuid (&Entry->ResId, ResId);
+  Entry->DataOffset = Database->DataUsed;
+  Entry->Size       = (UINT32) DataSize;
+  CopyMem (UBA_CONFIG_DB_DATA (Database, Entry), Data, DataSize);
 
-  InsertTailList (&SkuNode->DataLinkHead, &NewDataNode->DataLink);
-  SkuNode->DataCount ++;
-  UbaPeimPrivate->ConfigDataCount ++;
-  UbaPeimPrivate->HandleCount ++;
+  InternalIndexEntry (Database, Database->DataCount);
+  Database->DataCount ++;
+  Database->DataUsed += AlignedSize;
 
   //
   // This PPI just install for NotifyPpi
   // The PPI instance UbaCfgDbPpi should not used
   //
-  ConfigDataPpi = AllocateZeroPool (sizeof (EFI_PEI_PPI_DESCRIPTOR));
+  ConfigDataPpi = AllocateZeroPool (sizeof (UBA_CONFIG_DATA_PPI_DESCRIPTOR));
   if (ConfigDataPpi == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  ConfigDataPpi->Flags = EFI_PEI_PPI_DESCRIPTOR_PPI | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST;
-  ConfigDataPpi->Guid  = &NewDataNode->ResId;
-  ConfigDataPpi->Ppi   = &UbaPeimPrivate->UbaCfgDbPpi;
+  CopyGuid (&ConfigDataPpi->ResId, ResId);
+  ConfigDataPpi->Descriptor.Flags = EFI_PEI_PPI_DESCRIPTOR_PPI | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST;
+  ConfigDataPpi->Descriptor.Guid  = &ConfigDataPpi->ResId;
+  ConfigDataPpi->Descriptor.Ppi   = &UbaPeimPrivate->UbaCfgDbPpi;
 
-  Status = PeiServicesInstallPpi (ConfigDataPpi);
+  Status = PeiServicesInstallPpi (&ConfigDataPpi->Descriptor);
   ASSERT_EFI_ERROR (Status);
   if (Status != EFI_SUCCESS) {
     return Status;
@@ -187,8 +198,7 @@ InternalAddNewConfigData (
 /**
   Internal function for Getting configuration data from database.
 
-  @param This                   uba Ppi instance.
-  @param SkuNode                The platform node record.
+  @param Database               The configuration database.
   @param ResId                  The resource ID.
   @param Data                   Data pointer.
   @param DataSize               Data size pointer.
@@ -200,204 +210,40 @@ InternalAddNewConfigData (
 **/
 EFI_STATUS
 InternalGetConfigData (
-  IN  UBA_CONFIG_DATABASE_PPI             *This,
-  IN  UBA_BOARD_NODE                      *SkuNode,
+  IN  UBA_CONFIG_DB_HEADER                *Database,
   IN  EFI_GUID                            *ResId,
   OUT VOID                                *Data,      OPTIONAL
   OUT UINTN                               *DataSize   OPTIONAL
   )
 {
-  LIST_ENTRY                            *ListHead;
-  LIST_ENTRY                            *Link;
-  UBA_CONFIG_NODE                       *DataNode;
-  ListHead = NULL;
-  Link = NULL;
-  DataNode = NULL;
-
-  if ((SkuNode == NULL) || (ResId == NULL)) {
+  UBA_CONFIG_DB_ENTRY                   *Entry;
+
+  if ((Database == NULL) || (ResId == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
-  ListHead = &SkuNode->DataLinkHead;
-  if (IsListEmpty (ListHead)) {
+  Entry = InternalFindEntry (Database, ResId);
+  if (Entry == NULL) {
     return EFI_NOT_FOUND;
   }
 
-  for (Link = GetFirstNode (ListHead); !IsNull (ListHead, Link); Link = GetNextNode (ListHead, Link)) {
+  if (DataSize != NULL) {
 
-    DataNode = CONFIG_NODE_INSTANCE_FROM_THIS (Link);
-    ASSERT (DataNode != NULL);
-    if (DataNode == NULL) {
-      return EFI_UNSUPPORTED;
+    if (*DataSize < Entry->Size) {
+      *DataSize = Entry->Size;
+      return EFI_BUFFER_TOO_SMALL;
     }
 
-    if (CompareGuid (ResId, &DataNode->ResId)) {
+    *DataSize = Entry->Size;
 
-      if (DataSize != NULL) {
-
-        if (*DataSize < DataNode->Size) {
-          *DataSize = DataNode->Size;
-          return EFI_BUFFER_TOO_SMALL;
-        }
-
-        *DataSize = DataNode->Size;
-
-        if (Data != NULL) {
-          CopyMem (Data, DataNode->Data, DataNode->Size);
-        }
-      }
-
-      return EFI_SUCCESS;
+    if (Data != NULL) {
+      CopyMem (Data, UBA_CONFIG_DB_DATA (Database, Entry), Entry->Size);
     }
   }
 
-  return EFI_NOT_FOUND;
-}
-
-/**
-  Covert the LIST_ENTRY pointer from CAR to RAM after memory init.
-
-  @param Link                   The LIST_ENTRY pointer want to convert.
-  @param PtrPositive            The pointer need positive fix.
-  @param PtrDelta               The pointer delta value after memory init.
-
-  @retval EFI_SUCCESS           Operation success.
-**/
-EFI_STATUS
-PeiConvertListPointer (
-  IN  LIST_ENTRY                          *Link,
-  IN  BOOLEAN                             PtrPositive,
-  IN  UINTN                               PtrDelta
-  )
-{
-  if (PtrPositive) {
-    Link->ForwardLink = (LIST_ENTRY *) ((UINTN) Link->ForwardLink + PtrDelta);
-    Link->BackLink    = (LIST_ENTRY *) ((UINTN) Link->BackLink + PtrDelta);
-  } else {
-    Link->ForwardLink = (LIST_ENTRY *) ((UINTN) Link->ForwardLink - PtrDelta);
-    Link->BackLink    = (LIST_ENTRY *) ((UINTN) Link->BackLink - PtrDelta);
-  }
-
-  return EFI_SUCCESS;
-}
-
-/**
-  Covert general pointer from CAR to RAM after memory init.
-
-  @param Ptr                    The VOID pointer want to convert.
-  @param PtrPositive            The pointer need positive fix.
-  @param PtrDelta               The pointer delta value after memory init.
-
-  @retval EFI_SUCCESS           Operation success.
-**/
-EFI_STATUS
-PeiConvertVoidPointer (
-  IN  VOID                                **Ptr,
-  IN  BOOLEAN                             PtrPositive,
-  IN  UINTN                               PtrDelta
-  )
-{
-  if (PtrPositive) {
-    *Ptr = (VOID *) ((UINTN)*Ptr + PtrDelta);
-  } else {
-    *Ptr = (VOID *) ((UINTN)*Ptr - PtrDelta);
-  }
-
   return EFI_SUCCESS;
 }
 
-/**
-  Covert all pointers from CAR to RAM after memory init.
-
-  @param This                   The uba Ppi pointer.
-  @param PtrPositive            The pointer need positive fix.
-  @param PtrDelta               The pointer delta value after memory init.
-
-  @retval EFI_SUCCESS           Operation success.
-**/
-EFI_STATUS
-PeiConvertDataPointer (
-  IN  UBA_CONFIG_DATABASE_PPI             *This,
-  IN  BOOLEAN                             PtrPositive,
-  IN  UINTN                               PtrDelta
-  )
-{
-  UBA_PEIM_PRIVATE_DATA                 *UbaPeimPrivate;
-  UBA_BOARD_NODE                        *SkuNode;
-  UBA_CONFIG_NODE                       *DataNode;
-  LIST_ENTRY                            *DataListHead;
-  LIST_ENTRY                            *DataLink;
-  UbaPeimPrivate = NULL;
-  SkuNode = NULL;
-  DataNode = NULL;
-  DataListHead = NULL;
-  DataLink = NULL;
-
-  UbaPeimPrivate = PRIVATE_DATA_FROM_PPI (This);
-  if (UbaPeimPrivate->ThisAddress == (UINTN) This) {
-    return EFI_SUCCESS;
-  }
-
-  PeiConvertVoidPointer ((VOID**) &UbaPeimPrivate->CurrentSku, PtrPositive, PtrDelta);
-
-  SkuNode       = UbaPeimPrivate->CurrentSku;
-  DataListHead  = &SkuNode->DataLinkHead;
-
-  PeiConvertListPointer (DataListHead, PtrPositive, PtrDelta);
-
-  DataLink = DataListHead->ForwardLink;
-  while (DataListHead != DataLink) {
-
-    PeiConvertListPointer (DataLink, PtrPositive, PtrDelta);
-    DataNode = CONFIG_NODE_INSTANCE_FROM_THIS (DataLink);
-    PeiConvertVoidPointer (&DataNode->Data, PtrPositive, PtrDelta);
-
-    DataLink = DataLink->ForwardLink;
-  }
-
-  UbaPeimPrivate->ThisAddress = (UINTN) This;
-
-  return EFI_SUCCESS;
-}
-
-/**
-  Check whether the This pointer have been relocated after memory init,
-  if true, we need also relocate our own pointers in the heap, because core won't
-  do it for us.
-
-  @param This                   The uba Ppi pointer.
-
-  @retval EFI_SUCCESS           Operation success.
-**/
-EFI_STATUS
-PeiCheckPointerRelocated (
-  IN  UBA_CONFIG_DATABASE_PPI       *This
-  )
-{
-  EFI_STATUS                        Status;
-  UBA_PEIM_PRIVATE_DATA             *UbaPeimPrivate;
-  BOOLEAN                           PtrPositive;
-  UINTN                             PtrDelta;
-  Status = EFI_SUCCESS;
-  UbaPeimPrivate = NULL;
-  PtrPositive = FALSE;
-  PtrDelta = 0;
-
-  UbaPeimPrivate = PRIVATE_DATA_FROM_PPI (This);
-  if (UbaPeimPrivate->ThisAddress != (UINTN) This) {
-    if ((UINTN) This > UbaPeimPrivate->ThisAddress) {
-      PtrPositive = TRUE;
-      PtrDelta    = (UINTN) This - UbaPeimPrivate->ThisAddress;
-    } else {
-      PtrPositive = FALSE;
-      PtrDelta    = UbaPeimPrivate->ThisAddress - (UINTN) This;
-    }
-    Status = PeiConvertDataPointer (This, PtrPositive, PtrDelta);
-  }
-
-  return Status;
-}
-
 /**
   Set platform's GUID and user friendly name by BoardId.
 
@@ -422,14 +268,7 @@ PeiUbaInit (
   IN  CHAR8                               *BoardName     OPTIONAL
   )
 {
-  EFI_STATUS                 Status;
-  UBA_BOARD_NODE             *SkuNode;
-  Status  = EFI_SUCCESS;
-  SkuNode = NULL;
-
-  PeiCheckPointerRelocated (This);
-  Status = InternalInitSku (This, BoardId, BoardGuid, BoardName, &SkuNode);
-  return Status;
+  return InternalInitSku (This, BoardId, BoardGuid, BoardName);
 }
 
 /**
@@ -459,30 +298,25 @@ PeiUbaGetSku (
   OUT CHAR8                               *BoardName     OPTIONAL
   )
 {
-  EFI_STATUS                 Status;
-  UBA_BOARD_NODE             *SkuNode;
-  SkuNode = NULL;
-
-  PeiCheckPointerRelocated (This);
-
-  Status = InternalGetSkuNode (This, &SkuNode);
+  UBA_CONFIG_DB_HEADER       *Database;
 
-  if (!EFI_ERROR (Status)) {
-    if (BoardId != NULL) {
-      *BoardId = SkuNode->BoardId;
-    }
-    if (BoardName != NULL) {
-      AsciiStrCpyS (BoardName, AsciiStrSize (SkuNode->BoardName) / sizeof (CHAR8), SkuNode->BoardName);
-    }
+  Database = InternalGetDatabase (PRIVATE_DATA_FROM_PPI (This));
+  if (Database == NULL) {
+    return EFI_NOT_FOUND;
+  }
 
-    if (BoardGuid != NULL) {
-      CopyMem (BoardGuid, &SkuNode->BoardGuid, sizeof (EFI_GUID));
-    }
+  if (BoardId != NULL) {
+    *BoardId = Database->BoardId;
+  }
+  if (BoardName != NULL) {
+    AsciiStrCpyS (BoardName, AsciiStrSize (Database->BoardName) / sizeof (CHAR8), Database->BoardName);
+  }
 
-    return EFI_SUCCESS;
+  if (BoardGuid != NULL) {
+    CopyGuid (BoardGuid, &Database->BoardGuid);
   }
 
-  return Status;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -507,19 +341,7 @@ PeiUbaAddData (
   IN  UINTN                               DataSize
   )
 {
-  EFI_STATUS                 Status;
-  UBA_BOARD_NODE             *SkuNode;
-  SkuNode = NULL;
-
-  PeiCheckPointerRelocated (This);
-
-  Status = InternalGetSkuNode (This, &SkuNode);
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
-
-  Status = InternalAddNewConfigData (This, ResId, Data, DataSize);
-  return Status;
+  return InternalAddNewConfigData (This, ResId, Data, DataSize);
 }
 
 /**
@@ -546,21 +368,18 @@ PeiUbaGetData (
   )
 {
   EFI_STATUS                            Status;
-  UBA_BOARD_NODE                        *SkuNode;
-  SkuNode = NULL;
+  UBA_CONFIG_DB_HEADER                  *Database;
 
   if ((ResId == NULL) || (Data == NULL) || (DataSize == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
-  PeiCheckPointerRelocated (This);
-
-  Status = InternalGetSkuNode (This, &SkuNode);
-  if (EFI_ERROR (Status)) {
-    return Status;
+  Database = InternalGetDatabase (PRIVATE_DATA_FROM_PPI (This));
+  if (Database == NULL) {
+    return EFI_NOT_FOUND;
   }
 
-  Status = InternalGetConfigData (This, SkuNode, ResId, Data, DataSize);
+  Status = InternalGetConfigData (Database, ResId, Data, DataSize);
   if (!EFI_ERROR (Status)) {
     return EFI_SUCCESS;
   }
@@ -569,104 +388,46 @@ PeiUbaGetData (
 }
 
 /**
-  Internal function for creating a HOB for platform data,
-  and copy all the platform information and configuration data to the HOB,
-  it will be passed to DXE driver.
+  Get a pointer to configuration data inside uba configuration database.
 
-  @param SkuNode                The platform node in database.
-  @param HobGuid                The Hob GUID want to build.
+  @param This                   uba Ppi instance.
+  @param ResId                  The configuration data resource id.
+  @param Data                   Return the pointer to the configuration data.
+  @param DataSize               Return the size of the configuration data, optional.
 
-  @retval EFI_OUT_OF_RESOURCES  No enough resource.
+  @retval EFI_INVALID_PARAMETER Required parameters not correct.
+  @retval EFI_NOT_FOUND         Platform or data not found.
   @retval EFI_SUCCESS           Operation success.
 **/
 EFI_STATUS
-InternalCreateHobForSkuNode (
-  IN UBA_BOARD_NODE                     *SkuNode,
-  IN EFI_GUID                           *HobGuid
+EFIAPI
+PeiUbaGetDataPointer (
+  IN  UBA_CONFIG_DATABASE_PPI             *This,
+  IN  EFI_GUID                            *ResId,
+  OUT VOID                                **Data,
+  OUT UINTN                               *DataSize     OPTIONAL
   )
 {
-  UINT8                                 *HobData;
-  UBA_CONFIG_HOB_HEADER                 *HobHeader;
-  UBA_CONFIG_HOB_FIELD                  *HobDataFieldStart;
-  UINT8                                 *ConfigDataHobPtr;
-  UINTN                                 DataLength;
-  UINTN                                 Index;
-  LIST_ENTRY                            *ListHead;
-  LIST_ENTRY                            *Link;
-  UBA_CONFIG_NODE                       *DataNode;
-  HobData = NULL;
-  HobHeader = NULL;
-  HobDataFieldStart = NULL;
-  ConfigDataHobPtr = NULL;
-  DataLength = 0;
-  ListHead = NULL;
-  Link = NULL;
-  DataNode = NULL;
-
-  if (SkuNode->DataCount != 0) {
-    DataLength = sizeof (UBA_CONFIG_HOB_HEADER) +
-      sizeof (UBA_CONFIG_HOB_FIELD) * (SkuNode->DataCount - 1);
-
-    //
-    // Get config data size
-    //
-    ListHead = &SkuNode->DataLinkHead;
-    for (Link = GetFirstNode (ListHead); !IsNull (ListHead, Link); Link = GetNextNode (ListHead, Link)) {
-      DataNode = CONFIG_NODE_INSTANCE_FROM_THIS (Link);
-      DataLength += DataNode->Size;
-    }
+  UBA_CONFIG_DB_HEADER                  *Database;
+  UBA_CONFIG_DB_ENTRY                   *Entry;
 
-    HobData = BuildGuidHob (HobGuid, DataLength);
-    ASSERT (HobData != NULL);
-    if (HobData == NULL) {
-      return EFI_OUT_OF_RESOURCES;
-    }
+  if ((ResId == NULL) || (Data == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
 
-    HobHeader         = (UBA_CONFIG_HOB_HEADER *) HobData;
-    HobDataFieldStart = HobHeader->HobField;
-    ConfigDataHobPtr  = (UINT8 *) HobDataFieldStart + (sizeof (UBA_CONFIG_HOB_FIELD) * SkuNode->DataCount);
-
-    //
-    // Copy our HOB header
-    //
-    HobHeader->Signature  = UBA_CONFIG_HOB_SIGNATURE;
-    HobHeader->Version    = UBA_CONFIG_HOB_VERSION;
-    HobHeader->HobLength  = DataLength;
-    CopyGuid (&HobHeader->DataGuid, HobGuid);
-
-    HobHeader->BoardId = SkuNode->BoardId;
-    HobHeader->DataCount = SkuNode->DataCount;
-    CopyGuid (&HobHeader->BoardGuid, &SkuNode->BoardGuid);
-    CopyMem (HobHeader->BoardName, SkuNode->BoardName, AsciiStrSize (SkuNode->BoardName));
-
-    //
-    // Copy N * (UBA_CONFIG_HOB_NODE & UBA_CONFIG_HOB_NODE->Data)
-    //
-    Index     = 0;
-    ListHead  = &SkuNode->DataLinkHead;
-    for (Link = GetFirstNode (ListHead); !IsNull (ListHead, Link); Link = GetNextNode (ListHead, Link)) {
-      DataNode = CONFIG_NODE_INSTANCE_FROM_THIS (Link);
-      ASSERT (DataNode != NULL);
-      if (DataNode == NULL) {
-        return EFI_UNSUPPORTED;
-      }
-
-      HobDataFieldStart[Index].Size       = DataNode->Size;
-      HobDataFieldStart[Index].Signature  = DataNode->Signature;
-      HobDataFieldStart[Index].Version    = DataNode->Version;
-      CopyGuid (&HobDataFieldStart[Index].ResId, &DataNode->ResId);
-
-      CopyMem (ConfigDataHobPtr, DataNode->Data, DataNode->Size);
-
-      //
-      // Fix the config data pointer after memory copy
-      // Set the pointer address into memory in HOB
-      //
-      HobDataFieldStart[Index].DataOffset = ((UINTN) ConfigDataHobPtr - (UINTN) HobHeader);
-
-      Index ++;
-      ConfigDataHobPtr += DataNode->Size;
-    }
+  Database = InternalGetDatabase (PRIVATE_DATA_FROM_PPI (This));
+  if (Database == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Entry = InternalFindEntry (Database, ResId);
+  if (Entry == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  *Data = UBA_CONFIG_DB_DATA (Database, Entry);
+  if (DataSize != NULL) {
+    *DataSize = Entry->Size;
   }
 
   return EFI_SUCCESS;
@@ -676,6 +437,9 @@ InternalCreateHobForSkuNode (
   End of PEI phase callback, we need build configuration data HOB in this callback,
   it will pass to DXE driver.
 
+  The configuration database has no pointers in it, the used part is copied into
+  the HOB as it is.
+
   @param PeiServices            The PEI service pointer.
   @param NotifyDescriptor       The notify descriptor.
   @param Ppi                    The PPI was notified.
@@ -693,10 +457,9 @@ EndOfPeiPpiNotifyCallback (
 {
   EFI_STATUS                      Status;
   UBA_CONFIG_DATABASE_PPI         *UbaConfigPpi;
-  UBA_PEIM_PRIVATE_DATA           *UbaPeimPrivate;
-  UBA_BOARD_NODE                  *SkuNode;
-  UbaPeimPrivate = NULL;
-  SkuNode = NULL;
+  UBA_CONFIG_DB_HEADER            *Database;
+  UBA_CONFIG_DB_HEADER            *HobDatabase;
+  UINT32                          UsedSize;
 
   Status = PeiServicesLocatePpi (
              &gUbaConfigDatabasePpiGuid,
@@ -709,19 +472,20 @@ EndOfPeiPpiNotifyCallback (
     return Status;
   }
 
-  PeiCheckPointerRelocated (UbaConfigPpi);
-
   //
   // Build GUID data HOB for current platform configuration data
   //
-  UbaPeimPrivate = PRIVATE_DATA_FROM_PPI (UbaConfigPpi);
-  if (UbaPeimPrivate->CurrentSku != NULL) {
-    SkuNode = UbaPeimPrivate->CurrentSku;
-    Status = InternalCreateHobForSkuNode (SkuNode, &gUbaCurrentConfigHobGuid);
-    ASSERT_EFI_ERROR (Status);
-    if (Status != EFI_SUCCESS) {
-      return Status;
+  Database = InternalGetDatabase (PRIVATE_DATA_FROM_PPI (UbaConfigPpi));
+  if (Database != NULL) {
+    UsedSize    = Database->DataOffset + Database->DataUsed;
+    HobDatabase = BuildGuidDataHob (&gUbaCurrentConfigHobGuid, Database, UsedSize);
+    ASSERT (HobDatabase != NULL);
+    if (HobDatabase == NULL) {
+      return EFI_OUT_OF_RESOURCES;
     }
+    HobDatabase->TotalSize = UsedSize;
+
+    DEBUG ((DEBUG_INFO, "UBA config database: %d entries, %d bytes\n", Database->DataCount, UsedSize));
   }
 
   //
@@ -766,9 +530,7 @@ UbaConfigDatabasePeimEntry (
   UbaPeimPrivate->Signature  = UBA_BOARD_SIGNATURE;
   UbaPeimPrivate->Version    = UBA_BOARD_VERSION;
 
-  UbaPeimPrivate->ConfigDataCount      = 0;
-  UbaPeimPrivate->HandleCount          = 0;
-  UbaPeimPrivate->ThisAddress          = (UINTN) &UbaPeimPrivate->UbaCfgDbPpi;
+  UbaPeimPrivate->DatabaseOffset       = 0;
 
   UbaPeimPrivate->UbaPeimPpiList.Flags = EFI_PEI_PPI_DESCRIPTOR_PPI | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST;
   UbaPeimPrivate->UbaPeimPpiList.Guid  = &gUbaConfigDatabasePpiGuid;
@@ -780,8 +542,9 @@ UbaConfigDatabasePeimEntry (
   UbaPeimPrivate->UbaCfgDbPpi.InitSku   = PeiUbaInit;
   UbaPeimPrivate->UbaCfgDbPpi.GetSku    = PeiUbaGetSku;
 
-  UbaPeimPrivate->UbaCfgDbPpi.AddData   = PeiUbaAddData;
-  UbaPeimPrivate->UbaCfgDbPpi.GetData   = PeiUbaGetData;
+  UbaPeimPrivate->UbaCfgDbPpi.AddData        = PeiUbaAddData;
+  UbaPeimPrivate->UbaCfgDbPpi.GetData        = PeiUbaGetData;
+  UbaPeimPrivate->UbaCfgDbPpi.GetDataPointer = PeiUbaGetDataPointer;
 
   //
   // Just produce our PPI
@@ -19,15 +19,26 @@ typedef struct _UBA_PEIM_PRIVATE_DATA {
   UINT32                          Signature;
   UINT32                          Version;
 
-  UINTN                           ConfigDataCount;      //for AllConfigDataSize
-  UINTN                           HandleCount;
-  UBA_BOARD_NODE                  *CurrentSku;
-  UINTN                           ThisAddress;
+  //
+  // Position of the configuration database relative to this structure, 0 before InitSku.
+  // Both are allocated from the PEI heap, which is migrated as a whole after memory init,
+  // so unlike a pointer the offset stays valid without any fixup.
+  //
+  INTN                            DatabaseOffset;
 
   UBA_CONFIG_DATABASE_PPI         UbaCfgDbPpi;
   EFI_PEI_PPI_DESCRIPTOR          UbaPeimPpiList;
 } UBA_PEIM_PRIVATE_DATA;
 
+//
+// PPI installed for each configuration data so board modules can be notified of it.
+// Carries its own copy of the GUID as the database may be moved when it grows.
+//
+typedef struct _UBA_CONFIG_DATA_PPI_DESCRIPTOR {
+  EFI_PEI_PPI_DESCRIPTOR          Descriptor;
+  EFI_GUID                        ResId;
+} UBA_CONFIG_DATA_PPI_DESCRIPTOR;
+
 #define PRIVATE_DATA_FROM_PPI(p)    CR(p, UBA_PEIM_PRIVATE_DATA, UbaCfgDbPpi, UBA_BOARD_SIGNATURE)
 
 #endif // _UBA_CONFIG_DATABASE_PEIM_H_
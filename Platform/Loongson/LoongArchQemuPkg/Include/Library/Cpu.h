@@ -224,6 +224,8 @@
 #define LOONGARCH_CSR_TLBRSAVE      0x8b    /* KScratch for TLB refill exception */
 #define LOONGARCH_CSR_PGD           0x1b    /* Page table base */
 
+/* Invalid all tlb entries */
+#define INVTLB_ALL                  0x0
 /* Invalid addr with global=1 or matched asid in current tlb */
 #define INVTLB_ADDR_GTRUE_OR_ASID   0x6
 
@@ -23,6 +23,23 @@
 #include "mmu.h"
 
 BOOLEAN  mMmuInited = FALSE;
+
+//
+// Once the DXE constructor has run, page-table pages are carved out of
+// PAGE_TABLE_POOL_PAGES sized chunks and recycled through a free list,
+// and TLB invalidation is deferred to the end of each
+// LoongArchSetMemoryAttributes call. Before that (SEC/PEI) module globals
+// may not be writable, so pages are allocated and invalidated one by one.
+//
+#define PAGE_TABLE_POOL_PAGES    32
+#define TLB_FLUSH_ALL_THRESHOLD  64
+
+UINTN    mPageTablePoolNext;
+UINTN    mPageTablePoolPagesLeft;
+VOID     *mPageTableFreeList;
+BOOLEAN  mTlbFlushDeferred;
+UINTN    mTlbFlushStart;
+UINTN    mTlbFlushEnd;
 /**
   Check to see if mmu successfully initializes.
 
@@ -208,6 +225,124 @@ SetPmd (
   *Pmd = (PMD) {((UINTN)Pte)};
 }
 
+/**
+  Allocates one page for use as a page directory or page table.
+
+  @param  VOID.
+
+  @retval  A pointer to the page, or NULL if out of resources.
+**/
+VOID *
+PageTableAlloc (
+  VOID
+  )
+{
+  VOID *Page;
+
+  if (!mMmuInited) {
+    return AllocatePages (1);
+  }
+
+  if (mPageTableFreeList != NULL) {
+    Page = mPageTableFreeList;
+    mPageTableFreeList = *(VOID **)Page;
+    return Page;
+  }
+
+  if (mPageTablePoolPagesLeft == 0) {
+    mPageTablePoolNext = (UINTN)AllocatePages (PAGE_TABLE_POOL_PAGES);
+    if (mPageTablePoolNext == 0) {
+      return AllocatePages (1);
+    }
+    mPageTablePoolPagesLeft = PAGE_TABLE_POOL_PAGES;
+  }
+
+  Page = (VOID *)mPageTablePoolNext;
+  mPageTablePoolNext += EFI_PAGE_SIZE;
+  mPageTablePoolPagesLeft--;
+
+  return Page;
+}
+
+/**
+  Returns a page obtained from PageTableAlloc.
+
+  @param  Page  A pointer to the page.
+
+  @retval VOID
+**/
+VOID
+PageTableFree (
+  IN VOID *Page
+  )
+{
+  if (!mMmuInited) {
+    FreePages (Page, 1);
+    return;
+  }
+
+  *(VOID **)Page = mPageTableFreeList;
+  mPageTableFreeList = Page;
+}
+
+/**
+  Invalidates the TLB entries translating the specified region, or records
+  the region to be invalidated by FlushTlbRange if invalidation is deferred.
+
+  @param  Address  The start address of the region whose mapping changed.
+  @param  Size  The size of the region.
+
+  @retval VOID
+**/
+VOID
+InvalidTlbRange (
+  IN UINTN Address,
+  IN UINTN Size
+  )
+{
+  if (!mTlbFlushDeferred) {
+    //
+    // One address is enough, invtlb matches entries of any page size.
+    //
+    LoongarchInvalidTlb (Address);
+    return;
+  }
+
+  mTlbFlushStart = MIN (mTlbFlushStart, Address);
+  mTlbFlushEnd = MAX (mTlbFlushEnd, Address + Size);
+}
+
+/**
+  Invalidates the TLB entries recorded by InvalidTlbRange, page by page
+  for small regions and all at once otherwise.
+
+  @param  VOID.
+
+  @retval VOID
+**/
+VOID
+FlushTlbRange (
+  VOID
+  )
+{
+  UINTN Address;
+
+  if (mTlbFlushStart >= mTlbFlushEnd) {
+    return;
+  }
+
+  if ((mTlbFlushEnd - mTlbFlushStart) > TLB_FLUSH_ALL_THRESHOLD * EFI_PAGE_SIZE) {
+    LoongarchInvalidTlbAll ();
+  } else {
+    for (Address = mTlbFlushStart; Address < mTlbFlushEnd; Address += EFI_PAGE_SIZE) {
+      LoongarchInvalidTlb (Address);
+    }
+  }
+
+  mTlbFlushStart = MAX_UINTN;
+  mTlbFlushEnd = 0;
+}
+
 /**
   Free up memory space occupied by page tables.
 
@@ -220,7 +355,7 @@ PteFree (
   IN PTE *Pte
   )
 {
-  FreePages ((VOID *)Pte, 1);
+  PageTableFree ((VOID *)Pte);
 }
 
 /**
@@ -235,7 +370,7 @@ PmdFree (
   IN PMD *Pmd
   )
 {
-  FreePages ((VOID *)Pmd, 1);
+  PageTableFree ((VOID *)Pmd);
 }
 
 /**
@@ -250,7 +385,7 @@ PudFree (
   IN PUD *Pud
   )
 {
-  FreePages ((VOID *)Pud, 1);
+  PageTableFree ((VOID *)Pud);
 }
 
 /**
@@ -267,7 +402,7 @@ PudAlloc (
   IN PGD *Pgd
   )
 {
-  PUD *Pud = (PUD *) AllocatePages (1);
+  PUD *Pud = (PUD *) PageTableAlloc ();
   if (!Pud) {
     return EFI_OUT_OF_RESOURCES;
   }
@@ -299,7 +434,7 @@ PmdAlloc (
 {
   PMD *Pmd;
 
-  Pmd = (PMD *) AllocatePages (1);
+  Pmd = (PMD *) PageTableAlloc ();
   if (!Pmd) {
     return EFI_OUT_OF_RESOURCES;
   }
@@ -331,7 +466,7 @@ PteAlloc (
 {
   PTE *Pte;
 
-  Pte = (PTE *) AllocatePages (1);
+  Pte = (PTE *) PageTableAlloc ();
   if (!Pte) {
     return EFI_OUT_OF_RESOURCES;
   }
@@ -516,7 +651,7 @@ MemoryMapPteRange (
 
     SetPte (Pte, PteVal);
     if (UpDate) {
-      LoongarchInvalidTlb(Address);
+      InvalidTlbRange (Address, EFI_PAGE_SIZE);
     }
   } while (Pte++, Address += EFI_PAGE_SIZE, Address != End);
 
@@ -547,6 +682,7 @@ ConvertHugePageToPage (
   UINTN HugePageStart;
   EFI_STATUS Status;
 
+  Status = EFI_SUCCESS;
   if ((pmd_none (*Pmd)) ||
       (!IS_HUGE_PAGE (Pmd->PmdVal)))
   {
@@ -557,6 +693,7 @@ ConvertHugePageToPage (
     HugePageStart = Address & PMD_MASK;
     HugePageEnd = HugePageStart + HUGE_PAGE_SIZE;
     ASSERT (HugePageEnd >= End);
+    InvalidTlbRange (HugePageStart, HUGE_PAGE_SIZE);
 
     if (Address > HugePageStart) {
       Status |= MemoryMapPteRange (Pmd, HugePageStart, Address, OldAttributes);
@@ -592,7 +729,9 @@ MemoryMapPmdRange (
   )
 {
   PMD *Pmd;
+  PMD PmdVal;
   UINTN Next;
+  EFI_STATUS Status;
 
   Pmd = PmdAllocGet (Pud, Address);
   if (!Pmd) {
@@ -602,21 +741,36 @@ MemoryMapPmdRange (
   do {
     Next = PMD_ADDRESS_END (Address, End);
     if (((Address & (~PMD_MASK)) == 0) &&
-        ((Next &  (~PMD_MASK)) == 0) &&
-        (pmd_none (*Pmd) || IS_HUGE_PAGE (Pmd->PmdVal)))
+        ((Next &  (~PMD_MASK)) == 0))
     {
       DEBUG ((DEBUG_VERBOSE,
         "%a %d Address %p  PGD_INDEX %p PUD_INDEX   %p PMD_INDEX  %p MAKE_HUGE_PTE  %p\n",
         __func__, __LINE__,  Address, PGD_INDEX (Address), PUD_INDEX (Address), PMD_INDEX (Address),
         MAKE_HUGE_PTE (Address, Attributes)));
 
+      //
+      // The whole block is being mapped with the same attributes, so use a
+      // huge page, releasing the page table if the block had been split.
+      //
+      PmdVal = *Pmd;
       SetPmd (Pmd, (PTE *)MAKE_HUGE_PTE (Address, Attributes));
+      if (!pmd_none (PmdVal)) {
+        if (!IS_HUGE_PAGE (PmdVal.PmdVal)) {
+          PteFree ((PTE *)PMD_VAL (PmdVal));
+          InvalidTlbRange (Address, HUGE_PAGE_SIZE);
+        } else if (PMD_VAL (PmdVal) != PMD_VAL (*Pmd)) {
+          InvalidTlbRange (Address, HUGE_PAGE_SIZE);
+        }
+      }
     } else {
-      ConvertHugePageToPage (Pmd, Address, Next, Attributes);
+      Status = ConvertHugePageToPage (Pmd, Address, Next, Attributes);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
     }
   } while (Pmd++, Address = Next, Address != End);
 
-  return 0;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -841,7 +995,14 @@ LoongArchSetMemoryAttributes (
   }
   Attributes = EfiAttributeToLoongArchAttribute (Attributes);
   DEBUG ((DEBUG_VERBOSE, "%a %d %p %p %p.\n", __func__, __LINE__, BaseAddress , Length, Attributes));
+  if (mMmuInited) {
+    mTlbFlushDeferred = TRUE;
+  }
   MemoryMapPageRange (BaseAddress, BaseAddress + Length, Attributes);
+  if (mTlbFlushDeferred) {
+    FlushTlbRange ();
+    mTlbFlushDeferred = FALSE;
+  }
   DEBUG ((DEBUG_VERBOSE, "%a %d end.\n", __func__, __LINE__));
 
   return EFI_SUCCESS;
@@ -882,5 +1043,8 @@ MmuInitialize (VOID)
      mMmuInited = TRUE;
    }
 
+   mTlbFlushStart = MAX_UINTN;
+   mTlbFlushEnd = 0;
+
   return EFI_SUCCESS;
 }
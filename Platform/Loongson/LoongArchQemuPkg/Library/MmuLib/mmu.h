@@ -68,6 +68,17 @@ LoongarchInvalidTlb (
   UINTN Address
   );
 
+/*
+ Invalid all TLB entries, including global ones
+
+ @retval  none
+*/
+extern
+VOID
+LoongarchInvalidTlbAll (
+  VOID
+  );
+
 /*
  Set Tlb Refill function to hardware
 
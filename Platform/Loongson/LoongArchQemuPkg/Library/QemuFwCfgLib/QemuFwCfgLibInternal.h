@@ -12,6 +12,12 @@
 #ifndef QEMU_FW_CFG_LIB_INTERNAL_H_
 #define QEMU_FW_CFG_LIB_INTERNAL_H_
 
+//
+// Offset of the DMA address register from the start of the fw_cfg MMIO
+// region (data register at 0x0, selector at 0x8).
+//
+#define FW_CFG_DMA_OFFSET  0x10
+
 /**
   Returns a boolean indicating if the firmware configuration interface is
   available for library-internal purposes.
@@ -26,6 +32,20 @@ InternalQemuFwCfgIsAvailable (
   VOID
   );
 
+/**
+  To get firmware configure DMA address.
+
+  @param VOID
+
+  @retval  firmware configure DMA address, or 0 if the DMA interface is
+           not available.
+**/
+UINTN
+EFIAPI
+QemuGetFwCfgDmaAddress (
+  VOID
+  );
+
 /**
   Returns a boolean indicating whether QEMU provides the DMA-like access method
   for fw_cfg.
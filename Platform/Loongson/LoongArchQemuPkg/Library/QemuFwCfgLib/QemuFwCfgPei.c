@@ -11,6 +11,7 @@
 
 #include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
+#include <Library/IoLib.h>
 #include <Library/QemuFwCfgLib.h>
 
 #include "QemuFwCfgLibInternal.h"
@@ -84,7 +85,7 @@ InternalQemuFwCfgDmaIsAvailable (
   VOID
   )
 {
-  return FALSE;
+  return (QemuGetFwCfgDmaAddress () != 0);
 }
 
 /**
@@ -109,9 +110,42 @@ InternalQemuFwCfgDmaBytes (
   IN     UINT32   Control
   )
 {
+  volatile FW_CFG_DMA_ACCESS  Access;
+  UINT32                      Status;
+
+  if (Size == 0) {
+    return;
+  }
+
+  ASSERT (Control == FW_CFG_DMA_CTL_WRITE || Control == FW_CFG_DMA_CTL_READ ||
+    Control == FW_CFG_DMA_CTL_SKIP);
+
+  //
+  // The access structure and the buffer are identity mapped, so their
+  // addresses can be handed to QEMU as they are. All fields are big endian.
+  //
+  Access.Control = SwapBytes32 (Control);
+  Access.Length  = SwapBytes32 (Size);
+  Access.Address = SwapBytes64 ((UINT64)(UINTN)Buffer);
+
+  //
+  // Make sure the access structure and the buffer are visible to QEMU
+  // before kicking off the transfer.
+  //
+  MemoryFence ();
+
+  MmioWrite64 (QemuGetFwCfgDmaAddress (),
+    SwapBytes64 ((UINT64)(UINTN)&Access));
+
   //
-  // We should never reach here
+  // The write above is handled synchronously by QEMU, so the transfer is
+  // normally complete by now; poll anyway as the interface allows it to
+  // be asynchronous.
   //
-  ASSERT (FALSE);
-  CpuDeadLoop ();
+  do {
+    Status = SwapBytes32 (Access.Control);
+  } while ((Status != 0) && ((Status & FW_CFG_DMA_CTL_ERROR) == 0));
+  ASSERT (Status == 0);
+
+  MemoryFence ();
 }
@@ -23,6 +23,7 @@
 
 STATIC UINTN mFwCfgSelectorAddress;
 STATIC UINTN mFwCfgDataAddress;
+STATIC UINTN mFwCfgDmaAddress;
 /**
   To get firmware configure selector address.
 
@@ -61,6 +62,26 @@ QemuGetFwCfgDataAddress (
   }
   return FwCfgDataAddress;
 }
+/**
+  To get firmware configure DMA address.
+
+  @param VOID
+
+  @retval  firmware configure DMA address, or 0 if the DMA interface is
+           not available.
+**/
+UINTN
+EFIAPI
+QemuGetFwCfgDmaAddress (
+  VOID
+  )
+{
+  UINTN FwCfgDmaAddress = mFwCfgDmaAddress;
+  if (FwCfgDmaAddress == 0) {
+    FwCfgDmaAddress = (UINTN)PcdGet64 (PcdFwCfgDmaAddress);
+  }
+  return FwCfgDmaAddress;
+}
 /**
   Selects a firmware configuration item for reading.
 
@@ -404,6 +425,8 @@ QemuFwCfgInitialize (
   UINT64            FwCfgSelectorAddress;
   UINT64            FwCfgDataAddress;
   UINT64            FwCfgDataSize;
+  UINT64            FwCfgSize;
+  UINT32            Features;
   RETURN_STATUS     PcdStatus;
 
   DeviceTreeBase = (VOID *) (UINTN)PcdGet64 (PcdDeviceTreeBase);
@@ -435,6 +458,7 @@ QemuFwCfgInitialize (
         && (Len == (2 * sizeof (UINT64))))
       {
         FwCfgDataAddress      = SwapBytes64 (RegProp[0]);
+        FwCfgSize             = SwapBytes64 (RegProp[1]);
         FwCfgDataSize         = 8;
         FwCfgSelectorAddress  = FwCfgDataAddress + FwCfgDataSize;
 
@@ -451,6 +475,25 @@ QemuFwCfgInitialize (
           FwCfgDataAddress
           );
         ASSERT_RETURN_ERROR (PcdStatus);
+
+        //
+        // The DMA address register follows the selector, and is only
+        // present if the region is large enough and QEMU advertises it.
+        //
+        if (FwCfgSize >= FW_CFG_DMA_OFFSET + sizeof (UINT64)) {
+          QemuFwCfgSelectItem (QemuFwCfgItemInterfaceVersion);
+          MmioReadBytes (sizeof (Features), &Features);
+          if ((Features & FW_CFG_F_DMA) != 0) {
+            mFwCfgDmaAddress = FwCfgDataAddress + FW_CFG_DMA_OFFSET;
+            PcdStatus = PcdSet64S (
+              PcdFwCfgDmaAddress,
+              mFwCfgDmaAddress
+              );
+            ASSERT_RETURN_ERROR (PcdStatus);
+            DEBUG ((DEBUG_INFO, "%a: fw_cfg DMA interface at 0x%Lx\n",
+              __FUNCTION__, (UINT64)mFwCfgDmaAddress));
+          }
+        }
         break;
       } else {
         DEBUG ((DEBUG_ERROR, "%a: Failed to parse FDT QemuCfg node\n",
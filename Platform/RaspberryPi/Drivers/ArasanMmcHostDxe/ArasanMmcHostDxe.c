@@ -14,6 +14,8 @@
 STATIC BOOLEAN mCardIsPresent = FALSE;
 STATIC CARD_DETECT_STATE mCardDetectState = CardDetectRequired;
 UINT32 LastExecutedCommand = (UINT32) -1;
+// Block count of the last CMD23, programmed into MMCHS_BLK for the next CMD18/CMD25
+STATIC UINT32 mBlockCount;
 
 STATIC RASPBERRY_PI_FIRMWARE_PROTOCOL *mFwProtocol;
 STATIC UINTN mMmcHsBase;
@@ -339,6 +341,7 @@ MMCSendCommand (
   BOOLEAN IsAppCmd = (LastExecutedCommand == CMD55);
   BOOLEAN IsDATCmd = FALSE;
   BOOLEAN IsADTCCmd = FALSE;
+  UINT32 CmdFlags = 0;
 
   DEBUG ((DEBUG_MMCHOST_SD, "ArasanMMCHost: MMCSendCommand(MmcCmd: %08x, Argument: %08x)\n", MmcCmd, Argument));
 
@@ -387,10 +390,22 @@ MMCSendCommand (
     SdMmioWrite32 (MMCHS_BLK, 8);
   } else if (!IsAppCmd && MmcCmd == CMD6) {
     SdMmioWrite32 (MMCHS_BLK, 64);
+  } else if (IsADTCCmd && (MmcCmd & MSBS_MULTBLK) != 0 &&
+             LastExecutedCommand == CMD23 && mBlockCount != 0) {
+    /*
+     * Stop the host after the block count set with CMD23 as well, so
+     * the transfer ends cleanly without CMD12.
+     */
+    SdMmioWrite32 (MMCHS_BLK, BLEN_512BYTES | (mBlockCount << 16));
+    CmdFlags = BCE_ENABLE;
   } else if (IsADTCCmd) {
     SdMmioWrite32 (MMCHS_BLK, BLEN_512BYTES);
   }
 
+  if (MmcCmd == CMD23) {
+    mBlockCount = Argument & 0xFFFF;
+  }
+
   // Set Data timeout counter value to max value.
   SdMmioAndThenOr32 (MMCHS_SYSCTL, (UINT32) ~DTO_MASK, DTO_VAL);
 
@@ -404,7 +419,7 @@ MMCSendCommand (
   SdMmioWrite32 (MMCHS_ARG, Argument);
 
   // Send the command
-  SdMmioWrite32 (MMCHS_CMD, MmcCmd);
+  SdMmioWrite32 (MMCHS_CMD, MmcCmd | CmdFlags);
 
   // Check for the command status.
   while (RetryCount < MAX_RETRY_COUNT) {
@@ -814,6 +829,14 @@ MMCIsMultiBlock (
   return TRUE;
 }
 
+BOOLEAN
+MMCProgramsBlockCount (
+  IN EFI_MMC_HOST_PROTOCOL *This
+  )
+{
+  return TRUE;
+}
+
 EFI_MMC_HOST_PROTOCOL gMMCHost =
 {
   MMC_HOST_PROTOCOL_REVISION,
@@ -826,7 +849,8 @@ EFI_MMC_HOST_PROTOCOL gMMCHost =
   MMCReadBlockData,
   MMCWriteBlockData,
   NULL,
-  MMCIsMultiBlock
+  MMCIsMultiBlock,
+  MMCProgramsBlockCount
 };
 
 EFI_STATUS
@@ -7,6 +7,7 @@
  **/
 
 #include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
 
 #include "Mmc.h"
 
@@ -213,6 +214,27 @@ MmcStopTransmission (
   return Status;
 }
 
+/**
+  Tell whether multi-block transfers can be bounded with CMD23.
+
+  Both the card and the host must support it: the card returns to TRAN on
+  its own only if the host also stops after the programmed block count, so
+  hosts that do not program it keep ending transfers with CMD12.
+
+**/
+STATIC
+BOOLEAN
+MmcUseCmd23 (
+  IN MMC_HOST_INSTANCE *MmcHostInstance
+  )
+{
+  EFI_MMC_HOST_PROTOCOL *MmcHost = MmcHostInstance->MmcHost;
+
+  return MmcHostInstance->CardInfo.Cmd23Supported &&
+         MMC_HOST_HAS_PROGRAMSBLOCKCOUNT (MmcHost) &&
+         MmcHost->ProgramsBlockCount (MmcHost);
+}
+
 STATIC
 EFI_STATUS
 MmcTransferBlock (
@@ -230,6 +252,7 @@ MmcTransferBlock (
   MMC_HOST_INSTANCE       *MmcHostInstance;
   EFI_MMC_HOST_PROTOCOL   *MmcHost;
   UINTN                   CmdArg;
+  BOOLEAN                 UseCmd23;
 
   MmcHostInstance = MMC_HOST_INSTANCE_FROM_BLOCK_IO_THIS (This);
   MmcHost = MmcHostInstance->MmcHost;
@@ -242,6 +265,28 @@ MmcTransferBlock (
     CmdArg = Lba * This->Media->BlockSize;
   }
 
+  //
+  // The card leaves TRAN for the duration of the transfer, and only gets
+  // flagged as being back there once the transfer has completed cleanly.
+  //
+  MmcHostInstance->CardInTran = FALSE;
+
+  //
+  // With SET_BLOCK_COUNT the card returns to TRAN by itself after the
+  // last block, so no CMD12 is needed to end the multi-block transfer, as
+  // long as the host stops after the same count (see MmcUseCmd23).
+  //
+  UseCmd23 = (BufferSize > This->Media->BlockSize) &&
+             MmcUseCmd23 (MmcHostInstance);
+  if (UseCmd23) {
+    Status = MmcHost->SendCommand (MmcHost, MMC_CMD23,
+                        (UINT32)(BufferSize / This->Media->BlockSize));
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a(MMC_CMD23): Error %r\n", __func__, Status));
+      return Status;
+    }
+  }
+
   Status = MmcHost->SendCommand (MmcHost, Cmd, CmdArg);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a(MMC_CMD%d): Error %r\n", __func__, MMC_INDX (Cmd), Status));
@@ -262,10 +307,10 @@ MmcTransferBlock (
   }
 
   if (EFI_ERROR (Status) ||
-      BufferSize > This->Media->BlockSize) {
+      (BufferSize > This->Media->BlockSize && !UseCmd23)) {
     /*
-     * CMD12 needs to be set for multiblock (to transition from
-     * RECV to PROG) or for errors.
+     * CMD12 needs to be set for multiblock without CMD23 (to
+     * transition from RECV to PROG) or for errors.
      */
     EFI_STATUS Status2 = MmcStopTransmission (MmcHost);
     if (EFI_ERROR (Status2)) {
@@ -284,13 +329,15 @@ MmcTransferBlock (
   }
 
   //
-  // For reads, should be already in TRAN. For writes, wait
+  // For reads, the card is already back in TRAN. For writes, wait
   // until programming finishes.
   //
-  Status = WaitUntilTran (MmcHostInstance);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "WaitUntilTran after write failed\n"));
-    return Status;
+  if (Transfer != MMC_IOBLOCKS_READ) {
+    Status = WaitUntilTran (MmcHostInstance);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "WaitUntilTran after write failed\n"));
+      return Status;
+    }
   }
 
   Status = MmcNotifyState (MmcHostInstance, MmcTransferState);
@@ -311,28 +358,27 @@ MmcTransferBlock (
     *TransferredSize = BufferSize;
   }
 
+  if (!EFI_ERROR (Status)) {
+    MmcHostInstance->CardInTran = TRUE;
+  }
+
   return Status;
 }
 
+STATIC
 EFI_STATUS
-MmcIoBlocks (
+MmcValidateRequest (
   IN EFI_BLOCK_IO_PROTOCOL    *This,
   IN UINTN                    Transfer,
   IN UINT32                   MediaId,
   IN EFI_LBA                  Lba,
   IN UINTN                    BufferSize,
-  OUT VOID                    *Buffer
+  IN VOID                     *Buffer
   )
 {
-  EFI_STATUS              Status;
-  UINTN                   Cmd;
   MMC_HOST_INSTANCE       *MmcHostInstance;
   EFI_MMC_HOST_PROTOCOL   *MmcHost;
-  UINTN                   BytesRemainingToBeTransfered;
-  UINTN                   BlockCount;
-  UINTN                   ConsumeSize;
 
-  BlockCount = 1;
   MmcHostInstance = MMC_HOST_INSTANCE_FROM_BLOCK_IO_THIS (This);
   ASSERT (MmcHostInstance != NULL);
   MmcHost = MmcHostInstance->MmcHost;
@@ -351,12 +397,6 @@ MmcIoBlocks (
     return EFI_NO_MEDIA;
   }
 
-  if (PcdGet32 (PcdMmcDisableMulti) == 0 &&
-      MMC_HOST_HAS_ISMULTIBLOCK (MmcHost) &&
-      MmcHost->IsMultiBlock (MmcHost)) {
-    BlockCount = (BufferSize + This->Media->BlockSize - 1) / This->Media->BlockSize;
-  }
-
   // All blocks must be within the device
   if ((Lba + (BufferSize / This->Media->BlockSize)) > (This->Media->LastBlock + 1)) {
     return EFI_INVALID_PARAMETER;
@@ -381,12 +421,57 @@ MmcIoBlocks (
     return EFI_INVALID_PARAMETER;
   }
 
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+MmcIoBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL    *This,
+  IN UINTN                    Transfer,
+  IN UINT32                   MediaId,
+  IN EFI_LBA                  Lba,
+  IN UINTN                    BufferSize,
+  OUT VOID                    *Buffer
+  )
+{
+  EFI_STATUS              Status;
+  UINTN                   Cmd;
+  MMC_HOST_INSTANCE       *MmcHostInstance;
+  EFI_MMC_HOST_PROTOCOL   *MmcHost;
+  UINTN                   BytesRemainingToBeTransfered;
+  UINTN                   BlockCount;
+  UINTN                   ConsumeSize;
+
+  Status = MmcValidateRequest (This, Transfer, MediaId, Lba, BufferSize, Buffer);
+  if (EFI_ERROR (Status) || BufferSize == 0) {
+    return Status;
+  }
+
+  BlockCount = 1;
+  MmcHostInstance = MMC_HOST_INSTANCE_FROM_BLOCK_IO_THIS (This);
+  MmcHost = MmcHostInstance->MmcHost;
+
+  if (PcdGet32 (PcdMmcDisableMulti) == 0 &&
+      MMC_HOST_HAS_ISMULTIBLOCK (MmcHost) &&
+      MmcHost->IsMultiBlock (MmcHost)) {
+    BlockCount = (BufferSize + This->Media->BlockSize - 1) / This->Media->BlockSize;
+    if (MmcUseCmd23 (MmcHostInstance)) {
+      BlockCount = MIN (BlockCount, MMC_CMD23_MAX_BLOCK_COUNT);
+    }
+  }
+
   BytesRemainingToBeTransfered = BufferSize;
   while (BytesRemainingToBeTransfered > 0) {
-    Status = WaitUntilTran (MmcHostInstance);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "WaitUntilTran before IO failed"));
-      return Status;
+    //
+    // Only poll the card status if the previous transfer didn't leave
+    // the card in a known good state.
+    //
+    if (!MmcHostInstance->CardInTran) {
+      Status = WaitUntilTran (MmcHostInstance);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "WaitUntilTran before IO failed"));
+        return Status;
+      }
     }
 
     if (Transfer == MMC_IOBLOCKS_READ) {
@@ -420,7 +505,7 @@ MmcIoBlocks (
 
     BytesRemainingToBeTransfered -= ConsumeSize;
     if (BytesRemainingToBeTransfered > 0) {
-      Lba += BlockCount;
+      Lba += ConsumeSize / This->Media->BlockSize;
       Buffer = (UINT8*)Buffer + ConsumeSize;
     }
   }
@@ -428,6 +513,33 @@ MmcIoBlocks (
   return EFI_SUCCESS;
 }
 
+/**
+  Perform a blocking transfer. Any queued BLOCK_IO2 requests are completed
+  first, so that the transfer is ordered after them.
+**/
+STATIC
+EFI_STATUS
+MmcIoBlocksSync (
+  IN MMC_HOST_INSTANCE        *MmcHostInstance,
+  IN UINTN                    Transfer,
+  IN UINT32                   MediaId,
+  IN EFI_LBA                  Lba,
+  IN UINTN                    BufferSize,
+  IN OUT VOID                 *Buffer
+  )
+{
+  EFI_STATUS              Status;
+  EFI_TPL                 OldTpl;
+
+  // Don't let the queue timer interleave commands with this transfer
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  MmcProcessQueue (NULL, MmcHostInstance);
+  Status = MmcIoBlocks (&MmcHostInstance->BlockIo, Transfer, MediaId, Lba, BufferSize, Buffer);
+  gBS->RestoreTPL (OldTpl);
+
+  return Status;
+}
+
 EFI_STATUS
 EFIAPI
 MmcReadBlocks (
@@ -438,7 +550,8 @@ MmcReadBlocks (
   OUT VOID                    *Buffer
   )
 {
-  return MmcIoBlocks (This, MMC_IOBLOCKS_READ, MediaId, Lba, BufferSize, Buffer);
+  return MmcIoBlocksSync (MMC_HOST_INSTANCE_FROM_BLOCK_IO_THIS (This),
+           MMC_IOBLOCKS_READ, MediaId, Lba, BufferSize, Buffer);
 }
 
 EFI_STATUS
@@ -451,7 +564,8 @@ MmcWriteBlocks (
   IN VOID                     *Buffer
   )
 {
-  return MmcIoBlocks (This, MMC_IOBLOCKS_WRITE, MediaId, Lba, BufferSize, Buffer);
+  return MmcIoBlocksSync (MMC_HOST_INSTANCE_FROM_BLOCK_IO_THIS (This),
+           MMC_IOBLOCKS_WRITE, MediaId, Lba, BufferSize, Buffer);
 }
 
 EFI_STATUS
@@ -462,3 +576,203 @@ MmcFlushBlocks (
 {
   return EFI_SUCCESS;
 }
+
+VOID
+EFIAPI
+MmcProcessQueue (
+  IN  EFI_EVENT   Event,
+  IN  VOID        *Context
+  )
+{
+  MMC_HOST_INSTANCE       *MmcHostInstance;
+  MMC_REQUEST             *Request;
+
+  MmcHostInstance = (MMC_HOST_INSTANCE *)Context;
+
+  while (!IsListEmpty (&MmcHostInstance->Queue)) {
+    Request = MMC_REQUEST_FROM_LINK (GetFirstNode (&MmcHostInstance->Queue));
+    RemoveEntryList (&Request->Link);
+
+    Request->Token->TransactionStatus = MmcIoBlocks (
+                                          &MmcHostInstance->BlockIo,
+                                          Request->Transfer,
+                                          Request->MediaId,
+                                          Request->Lba,
+                                          Request->BufferSize,
+                                          Request->Buffer
+                                          );
+    gBS->SignalEvent (Request->Token->Event);
+    FreePool (Request);
+  }
+
+  // The queue may have been drained before the timer went off
+  gBS->SetTimer (MmcHostInstance->QueueTimer, TimerCancel, 0);
+}
+
+VOID
+MmcAbortQueue (
+  IN MMC_HOST_INSTANCE      *MmcHostInstance,
+  IN EFI_STATUS             Status
+  )
+{
+  MMC_REQUEST             *Request;
+  EFI_TPL                 OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  while (!IsListEmpty (&MmcHostInstance->Queue)) {
+    Request = MMC_REQUEST_FROM_LINK (GetFirstNode (&MmcHostInstance->Queue));
+    RemoveEntryList (&Request->Link);
+
+    Request->Token->TransactionStatus = Status;
+    gBS->SignalEvent (Request->Token->Event);
+    FreePool (Request);
+  }
+  gBS->SetTimer (MmcHostInstance->QueueTimer, TimerCancel, 0);
+  gBS->RestoreTPL (OldTpl);
+}
+
+STATIC
+EFI_STATUS
+MmcQueueRequest (
+  IN     MMC_HOST_INSTANCE      *MmcHostInstance,
+  IN     UINTN                  Transfer,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN OUT VOID                   *Buffer
+  )
+{
+  EFI_STATUS              Status;
+  MMC_REQUEST             *Request;
+  EFI_TPL                 OldTpl;
+
+  if (Token == NULL || Token->Event == NULL) {
+    Status = MmcIoBlocksSync (MmcHostInstance, Transfer, MediaId, Lba, BufferSize, Buffer);
+    if (Token != NULL) {
+      Token->TransactionStatus = Status;
+    }
+    return Status;
+  }
+
+  //
+  // Report parameter errors straight away rather than through the token.
+  //
+  Status = MmcValidateRequest (&MmcHostInstance->BlockIo, Transfer, MediaId, Lba, BufferSize, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (BufferSize == 0) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+    return EFI_SUCCESS;
+  }
+
+  Request = AllocatePool (sizeof (MMC_REQUEST));
+  if (Request == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Request->Signature  = MMC_REQUEST_SIGNATURE;
+  Request->Transfer   = Transfer;
+  Request->MediaId    = MediaId;
+  Request->Lba        = Lba;
+  Request->BufferSize = BufferSize;
+  Request->Buffer     = Buffer;
+  Request->Token      = Token;
+
+  Token->TransactionStatus = EFI_NOT_READY;
+
+  //
+  // The host protocol only offers blocking transfers, so the request is
+  // not overlapped with anything: it is performed by MmcIoBlocks from the
+  // queue timer on its next tick, which only returns control to the
+  // caller earlier.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  InsertTailList (&MmcHostInstance->Queue, &Request->Link);
+  Status = gBS->SetTimer (MmcHostInstance->QueueTimer, TimerRelative, 0);
+  if (EFI_ERROR (Status)) {
+    RemoveEntryList (&Request->Link);
+    FreePool (Request);
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+MmcResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN BOOLEAN                  ExtendedVerification
+  )
+{
+  MMC_HOST_INSTANCE       *MmcHostInstance;
+
+  MmcHostInstance = MMC_HOST_INSTANCE_FROM_BLOCK_IO2_THIS (This);
+
+  MmcAbortQueue (MmcHostInstance, EFI_ABORTED);
+  MmcHostInstance->CardInTran = FALSE;
+
+  return MmcReset (&MmcHostInstance->BlockIo, ExtendedVerification);
+}
+
+EFI_STATUS
+EFIAPI
+MmcReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  )
+{
+  return MmcQueueRequest (MMC_HOST_INSTANCE_FROM_BLOCK_IO2_THIS (This),
+           MMC_IOBLOCKS_READ, MediaId, Lba, Token, BufferSize, Buffer);
+}
+
+EFI_STATUS
+EFIAPI
+MmcWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  )
+{
+  return MmcQueueRequest (MMC_HOST_INSTANCE_FROM_BLOCK_IO2_THIS (This),
+           MMC_IOBLOCKS_WRITE, MediaId, Lba, Token, BufferSize, Buffer);
+}
+
+EFI_STATUS
+EFIAPI
+MmcFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  )
+{
+  MMC_HOST_INSTANCE       *MmcHostInstance;
+  EFI_TPL                 OldTpl;
+
+  MmcHostInstance = MMC_HOST_INSTANCE_FROM_BLOCK_IO2_THIS (This);
+
+  //
+  // Writes go straight to the card, so flushing only means completing
+  // everything that is still queued.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  MmcProcessQueue (NULL, MmcHostInstance);
+  gBS->RestoreTPL (OldTpl);
+
+  if (Token != NULL && Token->Event != NULL) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return EFI_SUCCESS;
+}
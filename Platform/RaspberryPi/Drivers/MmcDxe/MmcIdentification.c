@@ -42,6 +42,7 @@ typedef union {
 
 #define SD_BUS_WIDTH_1BIT       (1 << 0)
 #define SD_BUS_WIDTH_4BIT       (1 << 2)
+#define SD_CMD_SUPPORT_CMD23    (1 << 1)
 
 #define SD_CCC_SWITCH           (1 << 10)
 
@@ -670,11 +671,15 @@ InitializeSdMmcDevice (
     return Status;
   }
 
+  ZeroMem (&Scr, sizeof (Scr));
   Status = SdExecuteScr (MmcHostInstance, &Scr);
   if (EFI_ERROR (Status)) {
      return Status;
   }
 
+  MmcHostInstance->CardInfo.Cmd23Supported =
+    (Scr.CMD_SUPPORT & SD_CMD_SUPPORT_CMD23) != 0;
+
   if (Scr.SD_SPEC == 2) {
     if (Scr.SD_SPEC3 == 1) {
       if (Scr.SD_SPEC4 == 1) {
@@ -969,10 +974,13 @@ InitializeMmcDevice (
     return Status;
   }
 
+  MmcHostInstance->CardInfo.Cmd23Supported = FALSE;
   if (MmcHostInstance->CardInfo.CardType != EMMC_CARD) {
     Status = InitializeSdMmcDevice (MmcHostInstance);
   } else {
     Status = InitializeEmmcDevice (MmcHostInstance);
+    // SET_BLOCK_COUNT is mandatory since eMMC 4.41
+    MmcHostInstance->CardInfo.Cmd23Supported = TRUE;
   }
   if (EFI_ERROR (Status)) {
     return Status;
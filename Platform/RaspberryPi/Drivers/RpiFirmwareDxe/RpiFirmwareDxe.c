@@ -11,6 +11,8 @@
 
 #include <PiDxe.h>
 
+#include <Guid/EventGroup.h>
+
 #include <Library/ArmLib.h>
 #include <Library/DmaLib.h>
 #include <Library/BaseLib.h>
@@ -18,6 +20,7 @@
 #include <Library/DebugLib.h>
 #include <Library/IoLib.h>
 #include <Library/SynchronizationLib.h>
+#include <Library/TimerLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
 
@@ -37,6 +40,181 @@ STATIC UINTN mDmaBufferBusAddress;
 
 STATIC SPIN_LOCK mMailboxLock;
 
+//
+// Properties that cannot change while UEFI is running are fetched from
+// the firmware once, in a single batched transaction, and then served
+// from here. A property is only used if its Status is EFI_SUCCESS.
+//
+typedef struct {
+  UINT32    FirmwareRevision;
+  UINT32    Model;
+  UINT32    ModelRevision;
+  UINT64    Serial;
+  UINT8     MacAddress[8];
+  UINT32    ArmMemory[2];       // Base, Size
+  UINT32    MaxArmClock[2];     // ClockId, ClockRate
+  UINT32    MinArmClock[2];     // ClockId, ClockRate
+} RPI_FW_PROPERTY_CACHE;
+
+typedef enum {
+  RpiFwCacheFirmwareRevision,
+  RpiFwCacheModel,
+  RpiFwCacheModelRevision,
+  RpiFwCacheSerial,
+  RpiFwCacheMacAddress,
+  RpiFwCacheArmMemory,
+  RpiFwCacheMaxArmClock,
+  RpiFwCacheMinArmClock,
+  RpiFwCacheMax
+} RPI_FW_CACHE_INDEX;
+
+STATIC RPI_FW_PROPERTY_CACHE mCache;
+
+STATIC RPI_FW_PROPERTY mCacheProperties[RpiFwCacheMax] = {
+  { RPI_MBOX_GET_REVISION,        sizeof (mCache.FirmwareRevision),
+    &mCache.FirmwareRevision,     0, EFI_NOT_READY },
+  { RPI_MBOX_GET_BOARD_MODEL,     sizeof (mCache.Model),
+    &mCache.Model,                0, EFI_NOT_READY },
+  { RPI_MBOX_GET_BOARD_REVISION,  sizeof (mCache.ModelRevision),
+    &mCache.ModelRevision,        0, EFI_NOT_READY },
+  { RPI_MBOX_GET_BOARD_SERIAL,    sizeof (mCache.Serial),
+    &mCache.Serial,               0, EFI_NOT_READY },
+  { RPI_MBOX_GET_MAC_ADDRESS,     sizeof (mCache.MacAddress),
+    mCache.MacAddress,            0, EFI_NOT_READY },
+  { RPI_MBOX_GET_ARM_MEMSIZE,     sizeof (mCache.ArmMemory),
+    mCache.ArmMemory,             0, EFI_NOT_READY },
+  { RPI_MBOX_GET_MAX_CLOCK_RATE,  sizeof (mCache.MaxArmClock),
+    mCache.MaxArmClock,           0, EFI_NOT_READY },
+  { RPI_MBOX_GET_MIN_CLOCK_RATE,  sizeof (mCache.MinArmClock),
+    mCache.MinArmClock,           0, EFI_NOT_READY },
+};
+
+//
+// Per-tag mailbox statistics, only maintained in DEBUG builds. Tags sent
+// together in a batched transaction are each charged the full latency.
+//
+#define RPI_FW_MAX_TAG_STATS  32
+
+typedef struct {
+  UINT32    TagId;
+  UINT32    Calls;
+  UINT32    CacheHits;
+  UINT64    Nanoseconds;
+} RPI_FW_TAG_STATS;
+
+STATIC RPI_FW_TAG_STATS mTagStats[RPI_FW_MAX_TAG_STATS];
+
+STATIC
+RPI_FW_TAG_STATS *
+GetTagStats (
+  IN  UINT32  TagId
+  )
+{
+  UINTN   Index;
+
+  for (Index = 0; Index < RPI_FW_MAX_TAG_STATS; Index++) {
+    if (mTagStats[Index].TagId == TagId) {
+      return &mTagStats[Index];
+    }
+    if (mTagStats[Index].TagId == 0) {
+      mTagStats[Index].TagId = TagId;
+      return &mTagStats[Index];
+    }
+  }
+  return NULL;
+}
+
+STATIC
+VOID
+RecordTransactionStats (
+  IN  UINT64  Nanoseconds
+  )
+{
+  UINT32            *Words;
+  UINTN             Offset;
+  UINTN             Count;
+  RPI_FW_TAG_STATS  *Stats;
+
+  //
+  // Walk the tags of the property buffer that was just processed:
+  // each one is a TagId, TagSize, TagValueSize header followed by
+  // TagSize bytes of value.
+  //
+  Words = mDmaBuffer;
+  Count = Words[0] / sizeof (UINT32);
+  Offset = 2;
+  while (Offset + 3 <= Count && Words[Offset] != 0) {
+    Stats = GetTagStats (Words[Offset]);
+    if (Stats != NULL) {
+      Stats->Calls++;
+      Stats->Nanoseconds += Nanoseconds;
+    }
+    Offset += 3 + Words[Offset + 1] / sizeof (UINT32);
+  }
+}
+
+STATIC
+BOOLEAN
+IsPropertyCached (
+  IN  RPI_FW_CACHE_INDEX  Index
+  )
+{
+  RPI_FW_TAG_STATS  *Stats;
+
+  if (mCacheProperties[Index].Status != EFI_SUCCESS) {
+    return FALSE;
+  }
+
+  DEBUG_CODE_BEGIN ();
+  Stats = GetTagStats (mCacheProperties[Index].TagId);
+  if (Stats != NULL) {
+    Stats->CacheHits++;
+  }
+  DEBUG_CODE_END ();
+
+  return TRUE;
+}
+
+STATIC
+VOID
+EFIAPI
+DumpTagStats (
+  IN  EFI_EVENT   Event,
+  IN  VOID        *Context
+  )
+{
+  UINTN   Index;
+
+  DEBUG ((DEBUG_INFO, "RPi firmware mailbox statistics:\n"));
+  for (Index = 0; Index < RPI_FW_MAX_TAG_STATS; Index++) {
+    if (mTagStats[Index].TagId == 0) {
+      break;
+    }
+    DEBUG ((DEBUG_INFO, "  Tag 0x%08x: %u calls, %u cache hits, %Lu ns total\n",
+      mTagStats[Index].TagId, mTagStats[Index].Calls,
+      mTagStats[Index].CacheHits, mTagStats[Index].Nanoseconds));
+  }
+  gBS->CloseEvent (Event);
+}
+
+STATIC
+UINT64
+ElapsedNanoseconds (
+  IN  UINT64  StartTicks
+  )
+{
+  UINT64  EndTicks;
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+
+  EndTicks = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterEnd < CounterStart) {
+    return GetTimeInNanoSecond (StartTicks - EndTicks);
+  }
+  return GetTimeInNanoSecond (EndTicks - StartTicks);
+}
+
 STATIC
 BOOLEAN
 DrainMailbox (
@@ -94,10 +272,15 @@ MailboxTransaction (
   OUT   UINT32  *Result
   )
 {
+  UINT64  StartTicks;
+
   if (Channel >= BCM2836_MBOX_NUM_CHANNELS) {
     return EFI_INVALID_PARAMETER;
   }
 
+  StartTicks = 0;
+  DEBUG_CODE (StartTicks = GetPerformanceCounter (););
+
   //
   // Get rid of stale response data in the mailbox
   //
@@ -142,6 +325,8 @@ MailboxTransaction (
   *Result = MmioRead32 (BCM2836_MBOX_BASE_ADDRESS + BCM2836_MBOX_READ_OFFSET);
   ArmDataSynchronizationBarrier ();
 
+  DEBUG_CODE (RecordTransactionStats (ElapsedNanoseconds (StartTicks)););
+
   return EFI_SUCCESS;
 }
 
@@ -161,6 +346,113 @@ typedef struct {
   UINT32                    DeviceId;
   UINT32                    PowerState;
 } RPI_FW_POWER_STATE_TAG;
+#pragma pack()
+
+/**
+  Query or set several firmware properties in a single mailbox transaction.
+
+  @param[in,out]  Properties    Array of tags to process. On output, each
+                                entry's Value, ResponseSize and Status are
+                                updated with the firmware's answer.
+  @param[in]      Count         Number of entries in Properties.
+
+  @retval EFI_SUCCESS           All tags were processed successfully.
+  @retval EFI_INVALID_PARAMETER Properties is NULL or Count is 0.
+  @retval EFI_BAD_BUFFER_SIZE   The tags do not fit in the mailbox buffer.
+  @retval EFI_DEVICE_ERROR      The transaction failed, or at least one tag
+                                was not processed; see the per-tag Status.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+RpiFirmwareGetProperties (
+  IN OUT RPI_FW_PROPERTY  *Properties,
+  IN     UINTN            Count
+  )
+{
+  RPI_FW_BUFFER_HEAD          *Head;
+  RPI_FW_TAG_HEAD             *Tag;
+  UINT8                       *Ptr;
+  UINTN                       Index;
+  UINTN                       Size;
+  EFI_STATUS                  Status;
+  UINT32                      Result;
+
+  if (Properties == NULL || Count == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Size = sizeof (RPI_FW_BUFFER_HEAD) + sizeof (UINT32);
+  for (Index = 0; Index < Count; Index++) {
+    Size += sizeof (RPI_FW_TAG_HEAD) + ALIGN_VALUE (Properties[Index].ValueSize,
+                                                    sizeof (UINT32));
+  }
+  if (Size > EFI_PAGES_TO_SIZE (NUM_PAGES)) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  if (!AcquireSpinLockOrFail (&mMailboxLock)) {
+    DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
+    return EFI_DEVICE_ERROR;
+  }
+
+  Head = mDmaBuffer;
+  ZeroMem (Head, Size);
+
+  Head->BufferSize = (UINT32)Size;
+  Head->Response   = 0;
+  Ptr = (UINT8 *)(Head + 1);
+  for (Index = 0; Index < Count; Index++) {
+    Tag = (RPI_FW_TAG_HEAD *)Ptr;
+    Tag->TagId        = Properties[Index].TagId;
+    Tag->TagSize      = ALIGN_VALUE (Properties[Index].ValueSize, sizeof (UINT32));
+    Tag->TagValueSize = 0;
+    CopyMem (Tag + 1, Properties[Index].Value, Properties[Index].ValueSize);
+    Ptr += sizeof (*Tag) + Tag->TagSize;
+  }
+  //
+  // The end tag is already zero.
+  //
+
+  Status = MailboxTransaction (Head->BufferSize, RPI_MBOX_VC_CHANNEL, &Result);
+
+  if (EFI_ERROR (Status) ||
+      Head->Response != RPI_MBOX_RESP_SUCCESS) {
+    DEBUG ((DEBUG_ERROR,
+      "%a: mailbox transaction error: Status == %r, Response == 0x%x\n",
+      __FUNCTION__, Status, Head->Response));
+    ReleaseSpinLock (&mMailboxLock);
+    for (Index = 0; Index < Count; Index++) {
+      Properties[Index].ResponseSize = 0;
+      Properties[Index].Status = EFI_DEVICE_ERROR;
+    }
+    return EFI_DEVICE_ERROR;
+  }
+
+  Status = EFI_SUCCESS;
+  Ptr = (UINT8 *)(Head + 1);
+  for (Index = 0; Index < Count; Index++) {
+    Tag = (RPI_FW_TAG_HEAD *)Ptr;
+    if ((Tag->TagValueSize & RPI_MBOX_VALUE_SIZE_RESPONSE_MASK) == 0) {
+      Properties[Index].ResponseSize = 0;
+      Properties[Index].Status = EFI_DEVICE_ERROR;
+      Status = EFI_DEVICE_ERROR;
+    } else {
+      Properties[Index].ResponseSize = Tag->TagValueSize &
+                                       ~RPI_MBOX_VALUE_SIZE_RESPONSE_MASK;
+      CopyMem (Properties[Index].Value, Tag + 1,
+        MIN (Properties[Index].ResponseSize, Properties[Index].ValueSize));
+      Properties[Index].Status = EFI_SUCCESS;
+    }
+    Ptr += sizeof (*Tag) + Tag->TagSize;
+  }
+  ReleaseSpinLock (&mMailboxLock);
+
+  return Status;
+}
+
+#pragma pack(1)
 
 typedef struct {
   RPI_FW_BUFFER_HEAD        BufferHead;
@@ -249,6 +541,12 @@ RpiFirmwareGetArmMemory (
   EFI_STATUS                  Status;
   UINT32                      Result;
 
+  if (IsPropertyCached (RpiFwCacheArmMemory)) {
+    *Base = mCache.ArmMemory[0];
+    *Size = mCache.ArmMemory[1];
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -308,6 +606,11 @@ RpiFirmwareGetMacAddress (
   EFI_STATUS                  Status;
   UINT32                      Result;
 
+  if (IsPropertyCached (RpiFwCacheMacAddress)) {
+    CopyMem (MacAddress, mCache.MacAddress, 6);
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -364,34 +667,40 @@ RpiFirmwareGetSerial (
   EFI_STATUS                  Status;
   UINT32                      Result;
 
-  if (!AcquireSpinLockOrFail (&mMailboxLock)) {
-    DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
-    return EFI_DEVICE_ERROR;
-  }
-
-  Cmd = mDmaBuffer;
-  ZeroMem (Cmd, sizeof (*Cmd));
-
-  Cmd->BufferHead.BufferSize  = sizeof (*Cmd);
-  Cmd->BufferHead.Response    = 0;
-  Cmd->TagHead.TagId          = RPI_MBOX_GET_BOARD_SERIAL;
-  Cmd->TagHead.TagSize        = sizeof (Cmd->TagBody);
-  Cmd->TagHead.TagValueSize   = 0;
-  Cmd->EndTag                 = 0;
+  Status = EFI_SUCCESS;
+  if (IsPropertyCached (RpiFwCacheSerial)) {
+    *Serial = mCache.Serial;
+  } else {
+    if (!AcquireSpinLockOrFail (&mMailboxLock)) {
+      DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
+      return EFI_DEVICE_ERROR;
+    }
 
-  Status = MailboxTransaction (Cmd->BufferHead.BufferSize, RPI_MBOX_VC_CHANNEL, &Result);
+    Cmd = mDmaBuffer;
+    ZeroMem (Cmd, sizeof (*Cmd));
+
+    Cmd->BufferHead.BufferSize  = sizeof (*Cmd);
+    Cmd->BufferHead.Response    = 0;
+    Cmd->TagHead.TagId          = RPI_MBOX_GET_BOARD_SERIAL;
+    Cmd->TagHead.TagSize        = sizeof (Cmd->TagBody);
+    Cmd->TagHead.TagValueSize   = 0;
+    Cmd->EndTag                 = 0;
+
+    Status = MailboxTransaction (Cmd->BufferHead.BufferSize, RPI_MBOX_VC_CHANNEL, &Result);
+
+    if (EFI_ERROR (Status) ||
+        Cmd->BufferHead.Response != RPI_MBOX_RESP_SUCCESS) {
+      DEBUG ((DEBUG_ERROR,
+        "%a: mailbox transaction error: Status == %r, Response == 0x%x\n",
+        __FUNCTION__, Status, Cmd->BufferHead.Response));
+      ReleaseSpinLock (&mMailboxLock);
+      return EFI_DEVICE_ERROR;
+    }
 
-  if (EFI_ERROR (Status) ||
-      Cmd->BufferHead.Response != RPI_MBOX_RESP_SUCCESS) {
-    DEBUG ((DEBUG_ERROR,
-      "%a: mailbox transaction error: Status == %r, Response == 0x%x\n",
-      __FUNCTION__, Status, Cmd->BufferHead.Response));
+    *Serial = Cmd->TagBody.Serial;
     ReleaseSpinLock (&mMailboxLock);
-    return EFI_DEVICE_ERROR;
   }
 
-  *Serial = Cmd->TagBody.Serial;
-  ReleaseSpinLock (&mMailboxLock);
   // Some platforms return 0 or 0x0000000010000000 for serial.
   // For those, try to use the MAC address.
   if ((*Serial == 0) || ((*Serial & 0xFFFFFFFF0FFFFFFFULL) == 0)) {
@@ -427,6 +736,11 @@ RpiFirmwareGetModel (
   EFI_STATUS                  Status;
   UINT32                      Result;
 
+  if (IsPropertyCached (RpiFwCacheModel)) {
+    *Model = mCache.Model;
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -483,6 +797,11 @@ RpiFirmwareGetModelRevision (
   EFI_STATUS                    Status;
   UINT32                        Result;
 
+  if (IsPropertyCached (RpiFwCacheModelRevision)) {
+    *Revision = mCache.ModelRevision;
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -526,6 +845,11 @@ RpiFirmwareGetFirmwareRevision (
   EFI_STATUS                    Status;
   UINT32                        Result;
 
+  if (IsPropertyCached (RpiFwCacheFirmwareRevision)) {
+    *Revision = mCache.FirmwareRevision;
+    return EFI_SUCCESS;
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -1129,6 +1453,19 @@ RpiFirmwareGetClockRate (
   EFI_STATUS                  Status;
   UINT32                      Result;
 
+  if (ClockId == RPI_MBOX_CLOCK_RATE_ARM) {
+    if (ClockKind == RPI_MBOX_GET_MAX_CLOCK_RATE &&
+        IsPropertyCached (RpiFwCacheMaxArmClock)) {
+      *ClockRate = mCache.MaxArmClock[1];
+      return EFI_SUCCESS;
+    }
+    if (ClockKind == RPI_MBOX_GET_MIN_CLOCK_RATE &&
+        IsPropertyCached (RpiFwCacheMinArmClock)) {
+      *ClockRate = mCache.MinArmClock[1];
+      return EFI_SUCCESS;
+    }
+  }
+
   if (!AcquireSpinLockOrFail (&mMailboxLock)) {
     DEBUG ((DEBUG_ERROR, "%a: failed to acquire spinlock\n", __FUNCTION__));
     return EFI_DEVICE_ERROR;
@@ -1557,9 +1894,36 @@ STATIC RASPBERRY_PI_FIRMWARE_PROTOCOL mRpiFirmwareProtocol = {
   RpiFirmwareNotifyXhciReset,
   RpiFirmwareGetCurrentClockState,
   RpiFirmwareSetClockState,
-  RpiFirmwareNotifyGpioSetCfg
+  RpiFirmwareNotifyGpioSetCfg,
+  RpiFirmwareGetProperties
 };
 
+/**
+  Populate the immutable property cache using a single batched mailbox
+  transaction. Properties the firmware fails to return are simply left
+  uncached and will be queried on demand.
+
+**/
+STATIC
+VOID
+FillPropertyCache (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  mCache.MaxArmClock[0] = RPI_MBOX_CLOCK_RATE_ARM;
+  mCache.MinArmClock[0] = RPI_MBOX_CLOCK_RATE_ARM;
+
+  Status = RpiFirmwareGetProperties (mCacheProperties,
+             ARRAY_SIZE (mCacheProperties));
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN,
+      "%a: not all firmware properties could be cached (Status == %r)\n",
+      __FUNCTION__, Status));
+  }
+}
+
 /**
   Initialize the state information for the CPU Architectural Protocol
 
@@ -1579,6 +1943,7 @@ RpiFirmwareDxeInitialize (
 {
   EFI_STATUS      Status;
   UINTN           BufferSize;
+  EFI_EVENT       Event;
 
   //
   // We only need one of these
@@ -1607,6 +1972,14 @@ RpiFirmwareDxeInitialize (
   //
   ASSERT (!(mDmaBufferBusAddress & (BCM2836_MBOX_NUM_CHANNELS - 1)));
 
+  FillPropertyCache ();
+
+  DEBUG_CODE_BEGIN ();
+  Status = gBS->CreateEventEx (EVT_NOTIFY_SIGNAL, TPL_CALLBACK, DumpTagStats,
+                  NULL, &gEfiEventReadyToBootGuid, &Event);
+  ASSERT_EFI_ERROR (Status);
+  DEBUG_CODE_END ();
+
   Status = gBS->InstallProtocolInterface (&ImageHandle,
                   &gRaspberryPiFirmwareProtocolGuid, EFI_NATIVE_INTERFACE,
                   &mRpiFirmwareProtocol);
@@ -799,7 +799,8 @@ EFI_MMC_HOST_PROTOCOL gMmcHost =
     SdReadBlockData,
     SdWriteBlockData,
     SdSetIos,
-    SdIsMultiBlock
+    SdIsMultiBlock,
+    NULL                // HBLC is not programmed, transfers end with CMD12
   };
 
 EFI_STATUS
@@ -86,6 +86,89 @@ EFI_FW_VOL_BLOCK_DEVICE mFvbDeviceTemplate = {
 };
 
 
+STATIC
+VOID
+VarStoreMarkDirty (
+  IN UINTN Address,
+  IN UINTN Length
+  )
+/*++
+
+  Routine Description:
+
+    Records the blocks covering [Address, Address + Length) as needing
+    to be written back to the backing file. The dirty ranges are kept
+    sorted, with overlapping and adjacent ranges merged together.
+
+  Arguments:
+
+    Address               - Start address of the modified region
+    Length                - Length of the modified region in bytes
+
+  Returns:
+
+    None
+
+--*/
+{
+  UINTN StartLba;
+  UINTN EndLba;
+  UINTN Index;
+  UINTN Count;
+  VAR_STORE_DIRTY_RANGE *Ranges;
+
+  mFvInstance->Dirty = TRUE;
+
+  if (Length == 0) {
+    return;
+  }
+
+  StartLba = (Address - mFvInstance->FvBase) /
+             FixedPcdGet32 (PcdFirmwareBlockSize);
+  EndLba = (Address - mFvInstance->FvBase + Length - 1) /
+           FixedPcdGet32 (PcdFirmwareBlockSize) + 1;
+  Ranges = mFvInstance->DirtyRanges;
+  Count = mFvInstance->NumDirtyRanges;
+
+  //
+  // Absorb every existing range that overlaps or touches the new one.
+  //
+  Index = 0;
+  while (Index < Count) {
+    if (Ranges[Index].StartLba <= EndLba && Ranges[Index].EndLba >= StartLba) {
+      StartLba = MIN (StartLba, Ranges[Index].StartLba);
+      EndLba = MAX (EndLba, Ranges[Index].EndLba);
+      CopyMem (&Ranges[Index], &Ranges[Index + 1],
+        (Count - Index - 1) * sizeof (Ranges[0]));
+      Count--;
+    } else {
+      Index++;
+    }
+  }
+
+  if (Count == VAR_STORE_MAX_DIRTY_RANGES) {
+    //
+    // Out of slots: fall back to one range spanning everything pending.
+    //
+    StartLba = MIN (StartLba, Ranges[0].StartLba);
+    EndLba = MAX (EndLba, Ranges[Count - 1].EndLba);
+    Count = 0;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    if (Ranges[Index].StartLba > EndLba) {
+      break;
+    }
+  }
+
+  CopyMem (&Ranges[Index + 1], &Ranges[Index],
+    (Count - Index) * sizeof (Ranges[0]));
+  Ranges[Index].StartLba = StartLba;
+  Ranges[Index].EndLba = EndLba;
+  mFvInstance->NumDirtyRanges = Count + 1;
+}
+
+
 EFI_STATUS
 VarStoreWrite (
   IN     UINTN Address,
@@ -94,7 +177,7 @@ VarStoreWrite (
   )
 {
   CopyMem ((VOID*)Address, Buffer, *NumBytes);
-  mFvInstance->Dirty = TRUE;
+  VarStoreMarkDirty (Address, *NumBytes);
 
   return EFI_SUCCESS;
 }
@@ -107,7 +190,7 @@ VarStoreErase (
   )
 {
   SetMem ((VOID*)Address, LbaLength, 0xff);
-  mFvInstance->Dirty = TRUE;
+  VarStoreMarkDirty (Address, LbaLength);
 
   return EFI_SUCCESS;
 }
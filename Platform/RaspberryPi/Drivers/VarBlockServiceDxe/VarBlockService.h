@@ -22,6 +22,17 @@
 #include <Protocol/BlockIo.h>
 #include <Protocol/LoadedImage.h>
 
+//
+// Maximum number of discontiguous block ranges tracked before they are
+// collapsed into a single range covering all of them.
+//
+#define VAR_STORE_MAX_DIRTY_RANGES  8
+
+typedef struct {
+  UINTN                      StartLba;
+  UINTN                      EndLba;      // exclusive
+} VAR_STORE_DIRTY_RANGE;
+
 typedef struct {
   union {
     UINTN                      FvBase;
@@ -33,6 +44,8 @@ typedef struct {
   EFI_DEVICE_PATH_PROTOCOL   *Device;
   CHAR16                     *MappedFile;
   BOOLEAN                    Dirty;
+  UINTN                      NumDirtyRanges;
+  VAR_STORE_DIRTY_RANGE      DirtyRanges[VAR_STORE_MAX_DIRTY_RANGES];
 } EFI_FW_VOL_INSTANCE;
 
 extern EFI_FW_VOL_INSTANCE *mFvInstance;
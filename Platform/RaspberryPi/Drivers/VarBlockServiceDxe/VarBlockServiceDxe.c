@@ -8,6 +8,8 @@
  *
  **/
 
+#include <Library/BaseLib.h>
+
 #include "VarBlockService.h"
 
 //
@@ -22,6 +24,12 @@
 #define PLATFORM_RESET_DELAY    3500000
 #endif
 
+//
+// The delay above is sized for a rewrite of the whole variable store.
+// Smaller updates get a proportional share of it, but never less than this.
+//
+#define PLATFORM_RESET_MIN_DELAY  (PLATFORM_RESET_DELAY / 8)
+
 VOID *mSFSRegistration;
 
 
@@ -133,11 +141,17 @@ InstallVirtualAddressChangeHandler (
 STATIC
 EFI_STATUS
 DoDump (
-  IN EFI_DEVICE_PATH_PROTOCOL *Device
+  IN  EFI_DEVICE_PATH_PROTOCOL *Device,
+  IN  BOOLEAN                  DirtyOnly,
+  OUT UINTN                    *BytesWritten OPTIONAL
   )
 {
   EFI_STATUS Status;
   EFI_FILE_PROTOCOL *File;
+  UINTN Index;
+  UINTN Start;
+  UINTN Length;
+  UINTN Written;
 
   Status = FileOpen (Device,
              mFvInstance->MappedFile,
@@ -148,11 +162,41 @@ DoDump (
     return Status;
   }
 
-  Status = FileWrite (File,
-             mFvInstance->Offset,
-             mFvInstance->FvBase,
-             mFvInstance->FvLength);
+  Written = 0;
+  if (!DirtyOnly) {
+    Status = FileWrite (File,
+               mFvInstance->Offset,
+               mFvInstance->FvBase,
+               mFvInstance->FvLength);
+    Written = mFvInstance->FvLength;
+  } else {
+    //
+    // The ranges are kept sorted and merged by VarStoreWrite/VarStoreErase,
+    // so each one turns into a single contiguous file write.
+    //
+    for (Index = 0; Index < mFvInstance->NumDirtyRanges; Index++) {
+      Start = mFvInstance->DirtyRanges[Index].StartLba *
+              FixedPcdGet32 (PcdFirmwareBlockSize);
+      Length = (mFvInstance->DirtyRanges[Index].EndLba -
+                mFvInstance->DirtyRanges[Index].StartLba) *
+               FixedPcdGet32 (PcdFirmwareBlockSize);
+      Length = MIN (Length, mFvInstance->FvLength - Start);
+
+      Status = FileWrite (File,
+                 mFvInstance->Offset + Start,
+                 mFvInstance->FvBase + Start,
+                 Length);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+      Written += Length;
+    }
+  }
   FileClose (File);
+
+  if (BytesWritten != NULL) {
+    *BytesWritten = Written;
+  }
   return Status;
 }
 
@@ -167,6 +211,8 @@ DumpVars (
 {
   EFI_STATUS Status;
   RETURN_STATUS PcdStatus;
+  UINTN BytesWritten;
+  UINT32 Delay;
 
   if (mFvInstance->Device == NULL) {
     DEBUG ((DEBUG_INFO, "Variable store not found?\n"));
@@ -178,25 +224,34 @@ DumpVars (
     return;
   }
 
-  Status = DoDump (mFvInstance->Device);
+  Status = DoDump (mFvInstance->Device, TRUE, &BytesWritten);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Couldn't dump '%s'\n", mFvInstance->MappedFile));
     ASSERT_EFI_ERROR (Status);
     return;
   }
 
-  DEBUG ((DEBUG_INFO, "Variables dumped!\n"));
+  DEBUG ((DEBUG_INFO, "Variables dumped (%Lu bytes in %Lu ranges)!\n",
+    (UINT64)BytesWritten, (UINT64)mFvInstance->NumDirtyRanges));
 
   //
   // Add a reset delay to give time for slow/cached devices
   // to flush the NV variables write to permanent storage.
+  // The delay scales with the amount of data actually written.
   // But only do so if this won't reduce an existing user-set delay.
   //
-  if (PcdGet32 (PcdPlatformResetDelay) < PLATFORM_RESET_DELAY) {
-    PcdStatus = PcdSet32S (PcdPlatformResetDelay, PLATFORM_RESET_DELAY);
+  Delay = (UINT32)DivU64x64Remainder (
+                    MultU64x32 (BytesWritten, PLATFORM_RESET_DELAY),
+                    mFvInstance->FvLength,
+                    NULL
+                    );
+  Delay = MAX (Delay, PLATFORM_RESET_MIN_DELAY);
+  if (PcdGet32 (PcdPlatformResetDelay) < Delay) {
+    PcdStatus = PcdSet32S (PcdPlatformResetDelay, Delay);
     ASSERT_RETURN_ERROR (PcdStatus);
   }
 
+  mFvInstance->NumDirtyRanges = 0;
   mFvInstance->Dirty = FALSE;
 }
 
@@ -305,7 +360,7 @@ OnSimpleFileSystemInstall (
       continue;
     }
 
-    Status = DoDump (Device);
+    Status = DoDump (Device, FALSE, NULL);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "Couldn't update '%s'\n", mFvInstance->MappedFile));
       ASSERT_EFI_ERROR (Status);
@@ -171,6 +171,26 @@ EFI_STATUS
   UINTN State
   );
 
+//
+// One tag of a batched property transaction. Value holds the request
+// arguments on input and the firmware response on output; it must be
+// ValueSize bytes long, large enough for the larger of the two.
+//
+typedef struct {
+  UINT32                 TagId;
+  UINT32                 ValueSize;
+  VOID                   *Value;
+  UINT32                 ResponseSize;    // OUT: bytes returned by firmware
+  EFI_STATUS             Status;          // OUT: per-tag result
+} RPI_FW_PROPERTY;
+
+typedef
+EFI_STATUS
+(EFIAPI *GET_PROPERTIES) (
+  IN OUT RPI_FW_PROPERTY *Properties,
+  IN     UINTN           Count
+  );
+
 typedef struct {
   SET_POWER_STATE        SetPowerState;
   GET_MAC_ADDRESS        GetMacAddress;
@@ -197,6 +217,7 @@ typedef struct {
   GET_CLOCK_STATE        GetClockState;
   SET_CLOCK_STATE        SetClockState;
   GPIO_SET_CFG           SetGpioConfig;
+  GET_PROPERTIES         GetProperties;
 } RASPBERRY_PI_FIRMWARE_PROTOCOL;
 
 extern EFI_GUID gRaspberryPiFirmwareProtocolGuid;
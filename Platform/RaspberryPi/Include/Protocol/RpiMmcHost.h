@@ -178,6 +178,17 @@ BOOLEAN
   IN  EFI_MMC_HOST_PROTOCOL     *This
   );
 
+/**
+  Tell whether the host programs the block count of multi-block transfers,
+  so that a transfer preceded by CMD23 ends without CMD12.
+
+**/
+typedef
+BOOLEAN
+(EFIAPI *MMC_PROGRAMSBLOCKCOUNT) (
+  IN  EFI_MMC_HOST_PROTOCOL     *This
+  );
+
 struct _EFI_MMC_HOST_PROTOCOL {
   UINT32                  Revision;
   MMC_ISCARDPRESENT       IsCardPresent;
@@ -194,13 +205,17 @@ struct _EFI_MMC_HOST_PROTOCOL {
 
   MMC_SETIOS              SetIos;
   MMC_ISMULTIBLOCK        IsMultiBlock;
+
+  MMC_PROGRAMSBLOCKCOUNT  ProgramsBlockCount;
 };
 
-#define MMC_HOST_PROTOCOL_REVISION    0x00010002    // 1.2
+#define MMC_HOST_PROTOCOL_REVISION    0x00010003    // 1.3
 
-#define MMC_HOST_HAS_SETIOS(Host)       (Host->Revision >= MMC_HOST_PROTOCOL_REVISION && \
+#define MMC_HOST_HAS_SETIOS(Host)       (Host->Revision >= 0x00010002 && \
                                          Host->SetIos != NULL)
-#define MMC_HOST_HAS_ISMULTIBLOCK(Host) (Host->Revision >= MMC_HOST_PROTOCOL_REVISION && \
+#define MMC_HOST_HAS_ISMULTIBLOCK(Host) (Host->Revision >= 0x00010002 && \
                                          Host->IsMultiBlock != NULL)
+#define MMC_HOST_HAS_PROGRAMSBLOCKCOUNT(Host) (Host->Revision >= 0x00010003 && \
+                                         Host->ProgramsBlockCount != NULL)
 
 #endif /* __RASPBERRY_PI_MMC_HOST_PROTOCOL_H__ */
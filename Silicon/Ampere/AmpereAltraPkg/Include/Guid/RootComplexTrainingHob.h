@@ -0,0 +1,36 @@
+/** @file
+
+  Copyright (c) 2020 - 2023, Ampere Computing LLC. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef ROOT_COMPLEX_TRAINING_HOB_H_
+#define ROOT_COMPLEX_TRAINING_HOB_H_
+
+#include <Guid/RootComplexInfoHob.h>
+
+#define ROOT_COMPLEX_TRAINING_HOB_GUID \
+  { 0x08d4ab6f, 0x18c0, 0x47f9, { 0x8a, 0xc8, 0x37, 0x01, 0xa9, 0xd5, 0xd3, 0xbc } }
+
+extern GUID gRootComplexTrainingHobGuid;
+
+#pragma pack(1)
+
+//
+// Link training time of a Root Complex, the HOB carries one entry
+// per Root Complex in the same order as the Root Complex info HOB.
+//
+typedef struct {
+  UINT8     Socket;
+  UINT8     ID;
+  BOOLEAN   Active;
+  UINT8     ReInitCount;                      // Number of link re-initialization rounds
+  UINT32    TrainingTimeUs;                   // From Root Complex setup until its last controller settled
+  UINT32    LinkUpTimeUs[MaxPcieController];  // From last training start until link up, 0 if link is down
+} AC01_ROOT_COMPLEX_TRAINING_INFO;
+
+#pragma pack()
+
+#endif /* ROOT_COMPLEX_TRAINING_HOB_H_ */
@@ -1,6 +1,6 @@
 /** @file
 
-  Copyright (c) 2020 - 2021, Ampere Computing LLC. All rights reserved.<BR>
+  Copyright (c) 2020 - 2023, Ampere Computing LLC. All rights reserved.<BR>
 
   SPDX-License-Identifier: BSD-2-Clause-Patent
 
@@ -26,6 +26,17 @@ Ac01PcieCoreSetupRC (
   IN UINT8             ReInitPcieIndex
   );
 
+/**
+  Setup and initialize all active Root Complexes and start link training on
+  their controllers. The links are polled by Ac01PcieCorePostSetupRC.
+
+  @param RootComplexList      Pointer to the Root Complex list
+**/
+VOID
+Ac01PcieCoreSetupAllRC (
+  IN AC01_ROOT_COMPLEX *RootComplexList
+  );
+
 /**
   Verify the link status and retry to initialize the Root Complex if there's any issue.
 
@@ -10,6 +10,7 @@
 
 #include <Guid/PlatformInfoHob.h>
 #include <Guid/RootComplexInfoHob.h>
+#include <Guid/RootComplexTrainingHob.h>
 #include <IndustryStandard/Pci.h>
 #include <Library/ArmGenericTimerCounterLib.h>
 #include <Library/BaseLib.h>
@@ -43,6 +44,13 @@ PcieLinkUpCheck (
   IN AC01_PCIE_CONTROLLER *Pcie
   );
 
+//
+// Link training bookkeeping, indexed as the Root Complex list
+//
+STATIC AC01_PCIE_LINK_TRAINING          mLinkTraining[AC01_PCIE_MAX_ROOT_COMPLEX][MaxPcieController];
+STATIC UINT64                           mRootComplexStartTick[AC01_PCIE_MAX_ROOT_COMPLEX];
+STATIC AC01_ROOT_COMPLEX_TRAINING_INFO  mTrainingInfo[AC01_PCIE_MAX_ROOT_COMPLEX];
+
 /**
   Return the next extended capability base address
 
@@ -926,285 +934,506 @@ Ac01PcieCorrectBifurcation (
 }
 
 /**
-  Setup and initialize the AC01 PCIe Root Complex and underneath PCIe controllers
+  Return the index of a Root Complex in the Root Complex list.
 
   @param RootComplex           Pointer to Root Complex structure
-  @param ReInit                Re-init status
-  @param ReInitPcieIndex       PCIe controller index
+**/
+STATIC
+UINTN
+RootComplexIndex (
+  IN AC01_ROOT_COMPLEX *RootComplex
+  )
+{
+  return RootComplex->Socket * AC01_PCIE_MAX_RCS_PER_SOCKET + RootComplex->ID;
+}
 
-  @retval RETURN_SUCCESS       The Root Complex has been initialized successfully.
-  @retval RETURN_DEVICE_ERROR  PHY, Memory or PIPE is not ready.
+/**
+  Convert a number of microseconds to system counter ticks.
 **/
-RETURN_STATUS
-Ac01PcieCoreSetupRC (
+STATIC
+UINT64
+MicroSecondsToTicks (
+  IN UINT64 MicroSeconds
+  )
+{
+  return DivU64x32 (MultU64x64 (ArmGenericTimerGetTimerFreq (), MicroSeconds), 1000000);
+}
+
+/**
+  Convert a number of system counter ticks to microseconds.
+**/
+STATIC
+UINT32
+TicksToMicroSeconds (
+  IN UINT64 Ticks
+  )
+{
+  return (UINT32)DivU64x64Remainder (MultU64x32 (Ticks, 1000000), ArmGenericTimerGetTimerFreq (), NULL);
+}
+
+/**
+  Put a controller into reset if not in reset already.
+
+  @param RootComplex           Pointer to Root Complex structure
+  @param PcieIndex             PCIe controller index
+
+  @retval TRUE                 The reset has just been asserted, the caller must let
+                               the controller settle before programming it.
+  @retval FALSE                The controller was already in reset.
+**/
+STATIC
+BOOLEAN
+AssertControllerReset (
   IN AC01_ROOT_COMPLEX *RootComplex,
-  IN BOOLEAN           ReInit,
-  IN UINT8             ReInitPcieIndex
+  IN UINT8             PcieIndex
   )
 {
-  PHYSICAL_ADDRESS     CfgBase;
-  PHYSICAL_ADDRESS     CsrBase;
   PHYSICAL_ADDRESS     TargetAddress;
-  RETURN_STATUS        Status;
   UINT32               Val;
-  UINT8                PcieIndex;
-  BOOLEAN                       AutoLaneBifurcationEnabled = FALSE;
-  PCI_REG_PCIE_LINK_CAPABILITY  LinkCap[MaxPcieController];
-  AC01_PCIE_CONTROLLER          *Pcie;
-  DEV_MAP_MODE                  DevMapMode;
 
-  DEBUG ((DEBUG_INFO, "Initializing Socket%d RootComplex%d\n", RootComplex->Socket, RootComplex->ID));
-
-AutoLaneBifurcationRetry:
-  if (!ReInit) {
-    if (AutoLaneBifurcationEnabled) {
-      //
-      // We are here after the first round
-      //
-      // As per 2.7.2. AC Specifications of PCIe card specification this TPVPERL time and
-      // should be minimum 100ms. So this is minimum time we need add and found during test.
-      //
-      MicroSecondDelay (100000);
-      SetMem ((VOID *)LinkCap, sizeof (LinkCap), 0);
-      for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
-        Pcie = &RootComplex->Pcie[PcieIndex];
-        if (!Pcie->Active || !PcieLinkUpCheck (Pcie)) {
-          continue;
-        }
-        DEBUG ((DEBUG_INFO, "RootComplex->ID:%d Port:%d link up\n", RootComplex->ID, PcieIndex));
-        TargetAddress = GetCapabilityBase (RootComplex, PcieIndex, FALSE, EFI_PCI_CAPABILITY_ID_PCIEXP);
-        if (TargetAddress == 0) {
-          continue;
-        }
-        LinkCap[PcieIndex].Uint32 = MmioRead32 (TargetAddress + LINK_CAPABILITIES_REG);
-      }
+  TargetAddress = RootComplex->Pcie[PcieIndex].CsrBase + AC01_PCIE_CORE_RESET_REG;
+  Val = MmioRead32 (TargetAddress);
+  if (Val & RESET_MASK) {
+    return FALSE;
+  }
 
-      Status = Ac01PcieCorrectBifurcation (RootComplex, LinkCap, MaxPcieControllerOfRootComplexA, &DevMapMode);
-      if (!EFI_ERROR (Status)) {
-        RootComplex->DevMapLow = DevMapMode;
-        DEBUG ((
-          DEBUG_INFO,
-          "RootComplex->ID:%d Auto Bifurcation done, DevMapMode:%d\n",
-          RootComplex->ID,
-          RootComplex->DevMapLow
-          ));
-      } else {
-        RootComplex->DevMapLow = DevMapMode1;
-        DEBUG ((
-          DEBUG_INFO,
-          "RootComplex->ID:%d Auto Bifurcation failed, revert to DevMapMode1\n",
-          RootComplex->ID
-          ));
-      }
+  Val = DWC_PCIE_SET (Val, ASSERT_RESET);
+  MmioWrite32 (TargetAddress, Val);
 
-      AutoLaneBifurcationEnabled = FALSE;
+  return TRUE;
+}
 
-      if (DevMapMode == DevMapMode4) {
-        // Return directly as the RootComplex already initialized in this mode
-        return EFI_SUCCESS;
-      }
+/**
+  Program a controller which is held in reset and start its link training.
 
-      //
-      // Update the RootComplex data with new DevMapMode
-      //
-      Ac01PcieUpdateActive (RootComplex);
-      Ac01PcieUpdateMaxWidth (RootComplex);
-    } else {
-      if (RootComplex->DevMapLow == DevMapModeAuto) {
-        // Set lowest bifurcation mode
-        RootComplex->DevMapLow = DevMapMode4;
+  @param RootComplex           Pointer to Root Complex structure
+  @param PcieIndex             PCIe controller index
 
-        AutoLaneBifurcationEnabled = TRUE;
-        DEBUG ((
-          DEBUG_INFO,
-          "RootComplex->ID:%d Auto Bifurcation enabled\n",
-          RootComplex->ID
-          ));
-      }
-    }
+  @retval RETURN_SUCCESS       Link training has been started.
+  @retval RETURN_DEVICE_ERROR  Memory or PIPE is not ready.
+**/
+STATIC
+RETURN_STATUS
+SetupController (
+  IN AC01_ROOT_COMPLEX *RootComplex,
+  IN UINT8             PcieIndex
+  )
+{
+  AC01_PCIE_LINK_TRAINING  *Training;
+  PHYSICAL_ADDRESS         CfgBase;
+  PHYSICAL_ADDRESS         CsrBase;
+  PHYSICAL_ADDRESS         TargetAddress;
+  UINT32                   Val;
 
-    ProgramHostBridgeInfo (RootComplex);
+  DEBUG ((DEBUG_INFO, "Initializing Controller %d\n", PcieIndex));
 
-    // Fix for UEFI hang due to timing change with bifurcation
-    // register moved very close to PHY initialization.
-    MicroSecondDelay (100000);
+  CsrBase = RootComplex->Pcie[PcieIndex].CsrBase;
+  CfgBase = RootComplex->MmcfgBase + (RootComplex->Pcie[PcieIndex].DevNum << DEV_SHIFT);
 
-    Status = PciePhyInit (RootComplex->SerdesBase);
-    if (RETURN_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: Failed to initialize the PCIe PHY\n", __FUNCTION__));
-      return RETURN_DEVICE_ERROR;
-    }
+  if (!EnableItsMemory (RootComplex, PcieIndex)) {
+    DEBUG ((DEBUG_ERROR, "- Pcie[%d] - ITS Memory is not ready\n", PcieIndex));
+    return RETURN_DEVICE_ERROR;
   }
 
-  // Setup each controller
-  for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
+  // Hold link training
+  StartLinkTraining (RootComplex, PcieIndex, FALSE);
+
+  // Clear BUSCTRL.CfgUrMask to set CRS (Configuration Request Retry Status) to 0xFFFF.FFFF
+  // rather than 0xFFFF.0001 as per PCIe specification requirement. Otherwise, this causes
+  // device drivers respond incorrectly on timeout due to long device operations.
+  TargetAddress = CsrBase + AC01_PCIE_CORE_BUS_CONTROL_REG;
+  Val           = MmioRead32 (TargetAddress);
+  Val          &= ~BUS_CTL_CFG_UR_MASK;
+  MmioWrite32 (TargetAddress, Val);
 
-    if (ReInit) {
-      PcieIndex = ReInitPcieIndex;
+  if (!EnableAxiPipeClock (RootComplex, PcieIndex)) {
+    DEBUG ((DEBUG_ERROR, "- Pcie[%d] - PIPE clock is not stable\n", PcieIndex));
+    return RETURN_DEVICE_ERROR;
+  }
+
+  // Start PERST pulse
+  BoardPcieAssertPerst (RootComplex, PcieIndex, TRUE);
+
+  // Allow programming to config space
+  EnableDbiAccess (RootComplex, PcieIndex, TRUE);
+
+  // Program the power limit
+  TargetAddress = CfgBase + PCIE_CAPABILITY_BASE + SLOT_CAPABILITIES_REG;
+  Val = MmioRead32 (TargetAddress);
+  // In order to detect the NVMe after OS boots successfully but
+  // that NVMe's not present previously. Hot Plug Slot Capable
+  // will help PCI Linux driver to initialize its slot iomem resource
+  // which is used for detecting the disk when it's inserted.
+  Val = SLOT_HPC_SET(Val, 1);
+  Val = SLOT_CAP_SLOT_POWER_LIMIT_VALUE_SET (Val, SLOT_POWER_LIMIT_75W);
+  MmioWrite32 (TargetAddress, Val);
+
+  // Program DTI for ATS support
+  TargetAddress = CfgBase + DTIM_CTRL0_OFF;
+  Val = MmioRead32 (TargetAddress);
+  Val = DTIM_CTRL0_ROOT_PORT_ID_SET (Val, 0);
+  MmioWrite32 (TargetAddress, Val);
+
+  //
+  // Program number of lanes used
+  // - Reprogram LINK_CAPABLE of PORT_LINK_CTRL_OFF
+  // - Reprogram NUM_OF_LANES of GEN2_CTRL_OFF
+  // - Reprogram CAP_MAX_LINK_WIDTH of LINK_CAPABILITIES_REG
+  //
+  ProgramLinkCapabilities (RootComplex, PcieIndex);
+
+  // Set Zero byte request handling
+  TargetAddress = CfgBase + FILTER_MASK_2_OFF;
+  Val = MmioRead32 (TargetAddress);
+  Val = CX_FLT_MASK_VENMSG0_DROP_SET (Val, 0);
+  Val = CX_FLT_MASK_VENMSG1_DROP_SET (Val, 0);
+  Val = CX_FLT_MASK_DABORT_4UCPL_SET (Val, 0);
+  MmioWrite32 (TargetAddress, Val);
+
+  TargetAddress = CfgBase + AMBA_ORDERING_CTRL_OFF;
+  Val = MmioRead32 (TargetAddress);
+  Val = AX_MSTR_ZEROLREAD_FW_SET (Val, 0);
+  MmioWrite32 (TargetAddress, Val);
+
+  //
+  // Set Completion with CRS handling for CFG Request
+  // Set Completion with CA/UR handling non-CFG Request
+  //
+  TargetAddress = CfgBase + AMBA_ERROR_RESPONSE_DEFAULT_OFF;
+  Val = MmioRead32 (TargetAddress);
+  // 0x2: OKAY with FFFF_0001 and FFFF_FFFF
+  Val = AMBA_ERROR_RESPONSE_CRS_SET (Val, 0x2);
+  MmioWrite32 (TargetAddress, Val);
+
+  // Set Legacy PCIE interrupt map to INTA
+  TargetAddress = CfgBase + BRIDGE_CTRL_INT_PIN_INT_LINE_REG;
+  Val = MmioRead32 (TargetAddress);
+  Val = INT_PIN_SET (Val, IRQ_INT_A);
+  MmioWrite32 (TargetAddress, Val);
+
+  TargetAddress = CsrBase + AC01_PCIE_CORE_IRQ_SEL_REG;
+  Val = MmioRead32 (TargetAddress);
+  Val = INTPIN_SET (Val, IRQ_INT_A);
+  MmioWrite32 (TargetAddress, Val);
+
+  if (RootComplex->Pcie[PcieIndex].MaxGen >= LINK_SPEED_GEN2) {
+    ConfigureEqualization (RootComplex, PcieIndex);
+    if (RootComplex->Pcie[PcieIndex].MaxGen >= LINK_SPEED_GEN3) {
+      ConfigurePresetGen3 (RootComplex, PcieIndex);
+      if (RootComplex->Pcie[PcieIndex].MaxGen >= LINK_SPEED_GEN4) {
+        ConfigurePresetGen4 (RootComplex, PcieIndex);
+      }
     }
+  }
 
-    if (!RootComplex->Pcie[PcieIndex].Active) {
+  //
+  // As AMBA_LINK_TIMEOUT_OFF spec, it impacts OS HP removal delay.
+  // The greater value the longer delay it is. Per discussion,
+  // set it 2 from beginning of RP initialization.
+  //
+  SetLinkTimeout (RootComplex, PcieIndex, 2);
+
+  DisableCompletionTimeOut (RootComplex, PcieIndex, TRUE);
+
+  ProgramRootPortInfo (RootComplex, PcieIndex);
+
+  // Enable common clock for downstream
+  TargetAddress = CfgBase + PCIE_CAPABILITY_BASE + LINK_CONTROL_LINK_STATUS_REG;
+  Val = MmioRead32 (TargetAddress);
+  Val = CAP_SLOT_CLK_CONFIG_SET (Val, 1);
+  Val = CAP_COMMON_CLK_SET (Val, 1);
+  MmioWrite32 (TargetAddress, Val);
+
+  // Match aux_clk to system
+  TargetAddress = CfgBase + AUX_CLK_FREQ_OFF;
+  Val = MmioRead32 (TargetAddress);
+  Val = AUX_CLK_FREQ_SET (Val, AUX_CLK_500MHZ);
+  MmioWrite32 (TargetAddress, Val);
+
+  // Assert PERST low to reset endpoint
+  BoardPcieAssertPerst (RootComplex, PcieIndex, FALSE);
+
+  // Complete the PERST pulse
+  BoardPcieAssertPerst (RootComplex, PcieIndex, TRUE);
+
+  // Start link training
+  StartLinkTraining (RootComplex, PcieIndex, TRUE);
+
+  Training = &mLinkTraining[RootComplexIndex (RootComplex)][PcieIndex];
+  Training->State     = LinkTrainingStarted;
+  Training->StartTick = ArmGenericTimerGetSystemCount ();
+
+  // Lock programming of config space
+  EnableDbiAccess  (RootComplex, PcieIndex, FALSE);
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Select the bifurcation mode of a Root Complex from the links trained in DevMapMode4.
+
+  @param RootComplex           Pointer to Root Complex structure
+
+  @retval TRUE                 The Root Complex must be set up again in the new mode.
+  @retval FALSE                The Root Complex is already initialized in the selected mode.
+**/
+STATIC
+BOOLEAN
+UpdateAutoBifurcation (
+  IN AC01_ROOT_COMPLEX *RootComplex
+  )
+{
+  PHYSICAL_ADDRESS              TargetAddress;
+  RETURN_STATUS                 Status;
+  UINT8                         PcieIndex;
+  PCI_REG_PCIE_LINK_CAPABILITY  LinkCap[MaxPcieController];
+  AC01_PCIE_CONTROLLER          *Pcie;
+  DEV_MAP_MODE                  DevMapMode;
+
+  SetMem ((VOID *)LinkCap, sizeof (LinkCap), 0);
+  for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
+    Pcie = &RootComplex->Pcie[PcieIndex];
+    if (!Pcie->Active || !PcieLinkUpCheck (Pcie)) {
+      continue;
+    }
+    DEBUG ((DEBUG_INFO, "RootComplex->ID:%d Port:%d link up\n", RootComplex->ID, PcieIndex));
+    TargetAddress = GetCapabilityBase (RootComplex, PcieIndex, FALSE, EFI_PCI_CAPABILITY_ID_PCIEXP);
+    if (TargetAddress == 0) {
       continue;
     }
+    LinkCap[PcieIndex].Uint32 = MmioRead32 (TargetAddress + LINK_CAPABILITIES_REG);
+  }
 
-    DEBUG ((DEBUG_INFO, "Initializing Controller %d\n", PcieIndex));
+  Status = Ac01PcieCorrectBifurcation (RootComplex, LinkCap, MaxPcieControllerOfRootComplexA, &DevMapMode);
+  if (!EFI_ERROR (Status)) {
+    RootComplex->DevMapLow = DevMapMode;
+    DEBUG ((
+      DEBUG_INFO,
+      "RootComplex->ID:%d Auto Bifurcation done, DevMapMode:%d\n",
+      RootComplex->ID,
+      RootComplex->DevMapLow
+      ));
+  } else {
+    RootComplex->DevMapLow = DevMapMode1;
+    DEBUG ((
+      DEBUG_INFO,
+      "RootComplex->ID:%d Auto Bifurcation failed, revert to DevMapMode1\n",
+      RootComplex->ID
+      ));
+  }
 
-    CsrBase = RootComplex->Pcie[PcieIndex].CsrBase;
-    CfgBase = RootComplex->MmcfgBase + (RootComplex->Pcie[PcieIndex].DevNum << DEV_SHIFT);
+  if (DevMapMode == DevMapMode4) {
+    // The RootComplex already initialized in this mode
+    return FALSE;
+  }
 
-    // Put Controller into reset if not in reset already
-    TargetAddress = CsrBase + AC01_PCIE_CORE_RESET_REG;
-    Val = MmioRead32 (TargetAddress);
-    if (!(Val & RESET_MASK)) {
-      Val = DWC_PCIE_SET (Val, ASSERT_RESET);
-      MmioWrite32 (TargetAddress, Val);
+  //
+  // Update the RootComplex data with new DevMapMode
+  //
+  Ac01PcieUpdateActive (RootComplex);
+  Ac01PcieUpdateMaxWidth (RootComplex);
 
-      // Delay 50ms to ensure controller finish its reset
-      MicroSecondDelay (50000);
-    }
+  return TRUE;
+}
 
-    if (!EnableItsMemory (RootComplex, PcieIndex)) {
-      DEBUG ((DEBUG_ERROR, "- Pcie[%d] - ITS Memory is not ready\n", PcieIndex));
-      return RETURN_DEVICE_ERROR;
-    }
+/**
+  Setup the Root Complexes of a list and start link training on all of their
+  controllers. Each step is applied to every Root Complex before moving to the
+  next one so that the settle delays are only paid once for the whole list.
 
-    // Hold link training
-    StartLinkTraining (RootComplex, PcieIndex, FALSE);
+  A Root Complex which fails to initialize is marked inactive.
 
-    // Clear BUSCTRL.CfgUrMask to set CRS (Configuration Request Retry Status) to 0xFFFF.FFFF
-    // rather than 0xFFFF.0001 as per PCIe specification requirement. Otherwise, this causes
-    // device drivers respond incorrectly on timeout due to long device operations.
-    TargetAddress = CsrBase + AC01_PCIE_CORE_BUS_CONTROL_REG;
-    Val           = MmioRead32 (TargetAddress);
-    Val          &= ~BUS_CTL_CFG_UR_MASK;
-    MmioWrite32 (TargetAddress, Val);
+  @param RootComplexList       Pointer to the Root Complex list
+  @param Count                 Number of Root Complexes in the list
+**/
+STATIC
+VOID
+SetupRootComplexes (
+  IN AC01_ROOT_COMPLEX *RootComplexList,
+  IN UINTN             Count
+  )
+{
+  AC01_ROOT_COMPLEX    *RootComplex;
+  RETURN_STATUS        Status;
+  UINT32               Pending;
+  UINT32               AutoLaneBifurcation;
+  BOOLEAN              ResetAsserted;
+  UINTN                Index;
+  UINT8                PcieIndex;
 
-    if (!EnableAxiPipeClock (RootComplex, PcieIndex)) {
-      DEBUG ((DEBUG_ERROR, "- Pcie[%d] - PIPE clock is not stable\n", PcieIndex));
-      return RETURN_DEVICE_ERROR;
+  ASSERT (Count <= AC01_PCIE_MAX_ROOT_COMPLEX);
+
+  Pending             = 0;
+  AutoLaneBifurcation = 0;
+  for (Index = 0; Index < Count; Index++) {
+    RootComplex = &RootComplexList[Index];
+    if (!RootComplex->Active) {
+      continue;
     }
 
-    // Start PERST pulse
-    BoardPcieAssertPerst (RootComplex, PcieIndex, TRUE);
+    DEBUG ((DEBUG_INFO, "Initializing Socket%d RootComplex%d\n", RootComplex->Socket, RootComplex->ID));
 
-    // Allow programming to config space
-    EnableDbiAccess (RootComplex, PcieIndex, TRUE);
+    mRootComplexStartTick[RootComplexIndex (RootComplex)] = ArmGenericTimerGetSystemCount ();
+    Pending |= (1 << Index);
 
-    // Program the power limit
-    TargetAddress = CfgBase + PCIE_CAPABILITY_BASE + SLOT_CAPABILITIES_REG;
-    Val = MmioRead32 (TargetAddress);
-    // In order to detect the NVMe after OS boots successfully but
-    // that NVMe's not present previously. Hot Plug Slot Capable
-    // will help PCI Linux driver to initialize its slot iomem resource
-    // which is used for detecting the disk when it's inserted.
-    Val = SLOT_HPC_SET(Val, 1);
-    Val = SLOT_CAP_SLOT_POWER_LIMIT_VALUE_SET (Val, SLOT_POWER_LIMIT_75W);
-    MmioWrite32 (TargetAddress, Val);
+    if (RootComplex->DevMapLow == DevMapModeAuto) {
+      // Set lowest bifurcation mode
+      RootComplex->DevMapLow = DevMapMode4;
 
-    // Program DTI for ATS support
-    TargetAddress = CfgBase + DTIM_CTRL0_OFF;
-    Val = MmioRead32 (TargetAddress);
-    Val = DTIM_CTRL0_ROOT_PORT_ID_SET (Val, 0);
-    MmioWrite32 (TargetAddress, Val);
+      AutoLaneBifurcation |= (1 << Index);
+      DEBUG ((
+        DEBUG_INFO,
+        "RootComplex->ID:%d Auto Bifurcation enabled\n",
+        RootComplex->ID
+        ));
+    }
+  }
 
-    //
-    // Program number of lanes used
-    // - Reprogram LINK_CAPABLE of PORT_LINK_CTRL_OFF
-    // - Reprogram NUM_OF_LANES of GEN2_CTRL_OFF
-    // - Reprogram CAP_MAX_LINK_WIDTH of LINK_CAPABILITIES_REG
-    //
-    ProgramLinkCapabilities (RootComplex, PcieIndex);
+  while (Pending != 0) {
+    for (Index = 0; Index < Count; Index++) {
+      if ((Pending & (1 << Index)) != 0) {
+        ProgramHostBridgeInfo (&RootComplexList[Index]);
+      }
+    }
 
-    // Set Zero byte request handling
-    TargetAddress = CfgBase + FILTER_MASK_2_OFF;
-    Val = MmioRead32 (TargetAddress);
-    Val = CX_FLT_MASK_VENMSG0_DROP_SET (Val, 0);
-    Val = CX_FLT_MASK_VENMSG1_DROP_SET (Val, 0);
-    Val = CX_FLT_MASK_DABORT_4UCPL_SET (Val, 0);
-    MmioWrite32 (TargetAddress, Val);
+    // Fix for UEFI hang due to timing change with bifurcation
+    // register moved very close to PHY initialization.
+    MicroSecondDelay (100000);
 
-    TargetAddress = CfgBase + AMBA_ORDERING_CTRL_OFF;
-    Val = MmioRead32 (TargetAddress);
-    Val = AX_MSTR_ZEROLREAD_FW_SET (Val, 0);
-    MmioWrite32 (TargetAddress, Val);
+    ResetAsserted = FALSE;
+    for (Index = 0; Index < Count; Index++) {
+      if ((Pending & (1 << Index)) == 0) {
+        continue;
+      }
 
-    //
-    // Set Completion with CRS handling for CFG Request
-    // Set Completion with CA/UR handling non-CFG Request
-    //
-    TargetAddress = CfgBase + AMBA_ERROR_RESPONSE_DEFAULT_OFF;
-    Val = MmioRead32 (TargetAddress);
-    // 0x2: OKAY with FFFF_0001 and FFFF_FFFF
-    Val = AMBA_ERROR_RESPONSE_CRS_SET (Val, 0x2);
-    MmioWrite32 (TargetAddress, Val);
+      RootComplex = &RootComplexList[Index];
+      Status = PciePhyInit (RootComplex->SerdesBase);
+      if (RETURN_ERROR (Status)) {
+        DEBUG ((
+          DEBUG_ERROR,
+          "%a: Failed to initialize the PCIe PHY of Socket%d RootComplex%d\n",
+          __FUNCTION__,
+          RootComplex->Socket,
+          RootComplex->ID
+          ));
+        RootComplex->Active = FALSE;
+        Pending &= ~(1 << Index);
+        continue;
+      }
 
-    // Set Legacy PCIE interrupt map to INTA
-    TargetAddress = CfgBase + BRIDGE_CTRL_INT_PIN_INT_LINE_REG;
-    Val = MmioRead32 (TargetAddress);
-    Val = INT_PIN_SET (Val, IRQ_INT_A);
-    MmioWrite32 (TargetAddress, Val);
+      for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
+        if (RootComplex->Pcie[PcieIndex].Active
+            && AssertControllerReset (RootComplex, PcieIndex))
+        {
+          ResetAsserted = TRUE;
+        }
+      }
+    }
 
-    TargetAddress = CsrBase + AC01_PCIE_CORE_IRQ_SEL_REG;
-    Val = MmioRead32 (TargetAddress);
-    Val = INTPIN_SET (Val, IRQ_INT_A);
-    MmioWrite32 (TargetAddress, Val);
+    if (ResetAsserted) {
+      // Delay 50ms to ensure controllers finish their reset
+      MicroSecondDelay (50000);
+    }
+
+    for (Index = 0; Index < Count; Index++) {
+      if ((Pending & (1 << Index)) == 0) {
+        continue;
+      }
 
-    if (RootComplex->Pcie[PcieIndex].MaxGen >= LINK_SPEED_GEN2) {
-      ConfigureEqualization (RootComplex, PcieIndex);
-      if (RootComplex->Pcie[PcieIndex].MaxGen >= LINK_SPEED_GEN3) {
-        ConfigurePresetGen3 (RootComplex, PcieIndex);
-        if (RootComplex->Pcie[PcieIndex].MaxGen >= LINK_SPEED_GEN4) {
-          ConfigurePresetGen4 (RootComplex, PcieIndex);
+      RootComplex = &RootComplexList[Index];
+      for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
+        if (!RootComplex->Pcie[PcieIndex].Active) {
+          continue;
+        }
+
+        Status = SetupController (RootComplex, PcieIndex);
+        if (RETURN_ERROR (Status)) {
+          DEBUG ((
+            DEBUG_ERROR,
+            "%a: Failed to initialize Socket%d RootComplex%d\n",
+            __FUNCTION__,
+            RootComplex->Socket,
+            RootComplex->ID
+            ));
+          RootComplex->Active = FALSE;
+          Pending &= ~(1 << Index);
+          break;
         }
       }
     }
 
     //
-    // As AMBA_LINK_TIMEOUT_OFF spec, it impacts OS HP removal delay.
-    // The greater value the longer delay it is. Per discussion,
-    // set it 2 from beginning of RP initialization.
+    // Only the Root Complexes in auto bifurcation mode need another round
     //
-    SetLinkTimeout (RootComplex, PcieIndex, 2);
+    Pending &= AutoLaneBifurcation;
+    AutoLaneBifurcation = 0;
+    if (Pending == 0) {
+      break;
+    }
 
-    DisableCompletionTimeOut (RootComplex, PcieIndex, TRUE);
+    //
+    // As per 2.7.2. AC Specifications of PCIe card specification this TPVPERL time and
+    // should be minimum 100ms. So this is minimum time we need add and found during test.
+    //
+    MicroSecondDelay (100000);
 
-    ProgramRootPortInfo (RootComplex, PcieIndex);
+    for (Index = 0; Index < Count; Index++) {
+      if (((Pending & (1 << Index)) != 0)
+          && !UpdateAutoBifurcation (&RootComplexList[Index]))
+      {
+        Pending &= ~(1 << Index);
+      }
+    }
+  }
+}
 
-    // Enable common clock for downstream
-    TargetAddress = CfgBase + PCIE_CAPABILITY_BASE + LINK_CONTROL_LINK_STATUS_REG;
-    Val = MmioRead32 (TargetAddress);
-    Val = CAP_SLOT_CLK_CONFIG_SET (Val, 1);
-    Val = CAP_COMMON_CLK_SET (Val, 1);
-    MmioWrite32 (TargetAddress, Val);
+/**
+  Setup and initialize the AC01 PCIe Root Complex and underneath PCIe controllers
 
-    // Match aux_clk to system
-    TargetAddress = CfgBase + AUX_CLK_FREQ_OFF;
-    Val = MmioRead32 (TargetAddress);
-    Val = AUX_CLK_FREQ_SET (Val, AUX_CLK_500MHZ);
-    MmioWrite32 (TargetAddress, Val);
+  @param RootComplex           Pointer to Root Complex structure
+  @param ReInit                Re-init status
+  @param ReInitPcieIndex       PCIe controller index
 
-    // Assert PERST low to reset endpoint
-    BoardPcieAssertPerst (RootComplex, PcieIndex, FALSE);
+  @retval RETURN_SUCCESS       The Root Complex has been initialized successfully.
+  @retval RETURN_DEVICE_ERROR  PHY, Memory or PIPE is not ready.
+**/
+RETURN_STATUS
+Ac01PcieCoreSetupRC (
+  IN AC01_ROOT_COMPLEX *RootComplex,
+  IN BOOLEAN           ReInit,
+  IN UINT8             ReInitPcieIndex
+  )
+{
+  if (ReInit) {
+    if (!RootComplex->Pcie[ReInitPcieIndex].Active) {
+      return RETURN_SUCCESS;
+    }
 
-    // Complete the PERST pulse
-    BoardPcieAssertPerst (RootComplex, PcieIndex, TRUE);
+    if (AssertControllerReset (RootComplex, ReInitPcieIndex)) {
+      // Delay 50ms to ensure controller finish its reset
+      MicroSecondDelay (50000);
+    }
 
-    // Start link training
-    StartLinkTraining (RootComplex, PcieIndex, TRUE);
+    return SetupController (RootComplex, ReInitPcieIndex);
+  }
 
-    // Lock programming of config space
-    EnableDbiAccess  (RootComplex, PcieIndex, FALSE);
+  SetupRootComplexes (RootComplex, 1);
 
-    if (ReInit) {
-      return RETURN_SUCCESS;
-    }
-  }
+  return RootComplex->Active ? RETURN_SUCCESS : RETURN_DEVICE_ERROR;
+}
 
-  if (AutoLaneBifurcationEnabled) {
-    goto AutoLaneBifurcationRetry;
-  }
+/**
+  Setup and initialize all active Root Complexes and start link training on
+  their controllers. The links are polled by Ac01PcieCorePostSetupRC.
 
-  return RETURN_SUCCESS;
+  @param RootComplexList      Pointer to the Root Complex list
+**/
+VOID
+Ac01PcieCoreSetupAllRC (
+  IN AC01_ROOT_COMPLEX *RootComplexList
+  )
+{
+  SetupRootComplexes (RootComplexList, AC01_PCIE_MAX_ROOT_COMPLEX);
 }
 
 BOOLEAN
@@ -1482,11 +1711,14 @@ Ac01PFACommand (
   return Ret;
 }
 
+/**
+  Check once whether the EP config space answers with a valid value.
+**/
+STATIC
 BOOLEAN
-EndpointCfgReady (
+EndpointCfgAccessible (
   IN AC01_ROOT_COMPLEX *RootComplex,
-  IN UINT8             PcieIndex,
-  IN UINT32            TimeOut
+  IN UINT8             PcieIndex
   )
 {
   PHYSICAL_ADDRESS      CfgBase;
@@ -1494,11 +1726,21 @@ EndpointCfgReady (
 
   CfgBase = RootComplex->MmcfgBase + (RootComplex->Pcie[PcieIndex].DevNum << BUS_SHIFT);
 
+  Val = MmioRead32 (CfgBase);
+  return (Val != 0xFFFF0001 && Val != 0xFFFFFFFF);
+}
+
+BOOLEAN
+EndpointCfgReady (
+  IN AC01_ROOT_COMPLEX *RootComplex,
+  IN UINT8             PcieIndex,
+  IN UINT32            TimeOut
+  )
+{
   // Loop read CfgBase value until got valid value or
   // reach to Timeout (or more depend on card)
   do {
-    Val = MmioRead32 (CfgBase);
-    if (Val != 0xFFFF0001 && Val != 0xFFFFFFFF) {
+    if (EndpointCfgAccessible (RootComplex, PcieIndex)) {
       return TRUE;
     }
 
@@ -1509,6 +1751,69 @@ EndpointCfgReady (
   return FALSE;
 }
 
+/**
+  Route the secondary bus of a root port to its EP so that the EP config space
+  can be accessed.
+
+  @param RootComplex[in]  Pointer to AC01_ROOT_COMPLEX structure
+  @param PcieIndex[in]    PCIe controller index
+
+  @return                 The bus numbers to pass to EndpointConfigClose.
+**/
+STATIC
+UINT32
+EndpointConfigOpen (
+  IN AC01_ROOT_COMPLEX  *RootComplex,
+  IN UINT8              PcieIndex
+  )
+{
+  PHYSICAL_ADDRESS      SecLatTimerAddr;
+  UINT32                RestoreVal;
+  UINT32                Val;
+
+  SecLatTimerAddr = RootComplex->MmcfgBase + (RootComplex->Pcie[PcieIndex].DevNum << DEV_SHIFT)
+                    + SEC_LAT_TIMER_SUB_BUS_SEC_BUS_PRI_BUS_REG;
+
+  // Allow programming to config space
+  EnableDbiAccess (RootComplex, PcieIndex, TRUE);
+
+  Val = MmioRead32 (SecLatTimerAddr);
+  RestoreVal = Val;
+  Val = SUB_BUS_SET (Val, DEFAULT_SUB_BUS);
+  Val = SEC_BUS_SET (Val, RootComplex->Pcie[PcieIndex].DevNum);
+  Val = PRIM_BUS_SET (Val, DEFAULT_PRIM_BUS);
+  MmioWrite32 (SecLatTimerAddr, Val);
+
+  return RestoreVal;
+}
+
+/**
+  Restore the bus numbers saved by EndpointConfigOpen.
+
+  @param RootComplex[in]  Pointer to AC01_ROOT_COMPLEX structure
+  @param PcieIndex[in]    PCIe controller index
+  @param RestoreVal[in]   Value returned by EndpointConfigOpen
+**/
+STATIC
+VOID
+EndpointConfigClose (
+  IN AC01_ROOT_COMPLEX  *RootComplex,
+  IN UINT8              PcieIndex,
+  IN UINT32             RestoreVal
+  )
+{
+  PHYSICAL_ADDRESS      SecLatTimerAddr;
+
+  SecLatTimerAddr = RootComplex->MmcfgBase + (RootComplex->Pcie[PcieIndex].DevNum << DEV_SHIFT)
+                    + SEC_LAT_TIMER_SUB_BUS_SEC_BUS_PRI_BUS_REG;
+
+  // Restore value in order to not affect enumeration process
+  MmioWrite32 (SecLatTimerAddr, RestoreVal);
+
+  // Disable programming to config space
+  EnableDbiAccess (RootComplex, PcieIndex, FALSE);
+}
+
 /**
    Get link capabilities link width and speed of endpoint
 
@@ -1525,29 +1830,16 @@ Ac01PcieCoreGetEndpointInfo (
   OUT UINT8              *EpMaxGen
   )
 {
-  PHYSICAL_ADDRESS      CfgBase;
   PHYSICAL_ADDRESS      EpCfgAddr;
   PHYSICAL_ADDRESS      PcieCapBase;
-  PHYSICAL_ADDRESS      SecLatTimerAddr;
   PHYSICAL_ADDRESS      TargetAddress;
   UINT32                RestoreVal;
   UINT32                Val;
 
-  CfgBase = RootComplex->MmcfgBase + (RootComplex->Pcie[PcieIndex].DevNum << DEV_SHIFT);
-  SecLatTimerAddr  = CfgBase + SEC_LAT_TIMER_SUB_BUS_SEC_BUS_PRI_BUS_REG;
-
   *EpMaxWidth = 0;
   *EpMaxGen = 0;
 
-  // Allow programming to config space
-  EnableDbiAccess (RootComplex, PcieIndex, TRUE);
-
-  Val = MmioRead32 (SecLatTimerAddr);
-  RestoreVal = Val;
-  Val = SUB_BUS_SET (Val, DEFAULT_SUB_BUS);
-  Val = SEC_BUS_SET (Val, RootComplex->Pcie[PcieIndex].DevNum);
-  Val = PRIM_BUS_SET (Val, DEFAULT_PRIM_BUS);
-  MmioWrite32 (SecLatTimerAddr, Val);
+  RestoreVal = EndpointConfigOpen (RootComplex, PcieIndex);
   EpCfgAddr = RootComplex->MmcfgBase + (RootComplex->Pcie[PcieIndex].DevNum << BUS_SHIFT);
 
   if (!EndpointCfgReady (RootComplex, PcieIndex, EP_LINKUP_EXTRA_TIMEOUT)) {
@@ -1595,11 +1887,7 @@ Ac01PcieCoreGetEndpointInfo (
   }
 
 Exit:
-  // Restore value in order to not affect enumeration process
-  MmioWrite32 (SecLatTimerAddr, RestoreVal);
-
-  // Disable programming to config space
-  EnableDbiAccess (RootComplex, PcieIndex, FALSE);
+  EndpointConfigClose (RootComplex, PcieIndex, RestoreVal);
 }
 
 VOID
@@ -1735,51 +2023,94 @@ Ac01PcieCoreCheckCardPresent (
   return FALSE;
 }
 
+/**
+  Check the quality of the links which came up in the last polling round. The
+  RASDES evaluation delay is shared by all of them, only the links failing the
+  check go through the soft reset recovery one by one.
+
+  @param RootComplexList      Pointer to the Root Complex list
+**/
+STATIC
 VOID
-Ac01PcieCoreUpdateLink (
-  IN  AC01_ROOT_COMPLEX *RootComplex,
-  OUT BOOLEAN           *IsNextRoundNeeded,
-  OUT INT8              *FailedPciePtr,
-  OUT INT8              *FailedPcieCount
+Ac01PcieCoreQoSLinkCheckAll (
+  IN AC01_ROOT_COMPLEX *RootComplexList
   )
 {
-  AC01_PCIE_CONTROLLER      *Pcie;
-  UINT8                     PcieIndex;
-  UINT32                    Index;
-
-  *IsNextRoundNeeded = FALSE;
-  *FailedPcieCount   = 0;
-  for (Index = 0; Index < MaxPcieControllerOfRootComplexB; Index++) {
-    FailedPciePtr[Index] = -1;
+  AC01_ROOT_COMPLEX        *RootComplex;
+  AC01_PCIE_LINK_TRAINING  *Training;
+  INT32                    RasdesChecking;
+  UINTN                    Checking;
+  UINT8                    RCIndex;
+  UINT8                    PcieIndex;
+  UINT8                    EpMaxWidth, EpMaxGen;
+
+  Checking = 0;
+  for (RCIndex = 0; RCIndex < AC01_PCIE_MAX_ROOT_COMPLEX; RCIndex++) {
+    RootComplex = &RootComplexList[RCIndex];
+    if (!RootComplex->Active) {
+      continue;
+    }
+
+    for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
+      Training = &mLinkTraining[RootComplexIndex (RootComplex)][PcieIndex];
+      if (!RootComplex->Pcie[PcieIndex].Active || Training->State != LinkTrainingDone) {
+        continue;
+      }
+
+      // Enable all of RASDES register to detect any training error
+      Ac01PFACommand (RootComplex, PcieIndex, PFA_MODE_ENABLE);
+
+      // Accessing Endpoint and checking current link capabilities
+      EpMaxWidth = 0;
+      EpMaxGen   = 0;
+      if (Training->CfgReady) {
+        Ac01PcieCoreGetEndpointInfo (RootComplex, PcieIndex, &EpMaxWidth, &EpMaxGen);
+      }
+      Training->LinkCheck = Ac01PcieCoreLinkCheck (RootComplex, PcieIndex, EpMaxWidth, EpMaxGen);
+      Checking++;
+    }
   }
 
-  if (!RootComplex->Active) {
+  if (Checking == 0) {
     return;
   }
 
-  // Loop for all controllers
-  for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
-    Pcie = &RootComplex->Pcie[PcieIndex];
+  // Delay to allow the links to perform internal operation and generate
+  // any error status update. This allows detection of any error observed
+  // during initial link training. Possible evaluation time can be
+  // between 100ms to 200ms.
+  MicroSecondDelay (100000);
 
-    if (Pcie->Active && !Pcie->LinkUp) {
-      if (PcieLinkUpCheck (Pcie)) {
-        Pcie->LinkUp = TRUE;
+  for (RCIndex = 0; RCIndex < AC01_PCIE_MAX_ROOT_COMPLEX; RCIndex++) {
+    RootComplex = &RootComplexList[RCIndex];
+    if (!RootComplex->Active) {
+      continue;
+    }
 
-        // Doing link checking and recovery if needed
-        Ac01PcieCoreQoSLinkCheckRecovery (RootComplex, PcieIndex);
+    for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
+      Training = &mLinkTraining[RootComplexIndex (RootComplex)][PcieIndex];
+      if (!RootComplex->Pcie[PcieIndex].Active || Training->State != LinkTrainingDone) {
+        continue;
+      }
 
-        // Un-mask Completion Timeout
-        DisableCompletionTimeOut (RootComplex, PcieIndex, FALSE);
+      // Check for error
+      RasdesChecking = Ac01PFACommand (RootComplex, PcieIndex, PFA_MODE_READ);
 
-      } else {
-        FailedPciePtr[*FailedPcieCount] = PcieIndex;
-        *FailedPcieCount += 1;
+      // Clear error counter
+      Ac01PFACommand (RootComplex, PcieIndex, PFA_MODE_CLEAR);
 
-        if (Ac01PcieCoreCheckCardPresent (Pcie)) {
-          *IsNextRoundNeeded = TRUE;
-          DEBUG ((DEBUG_INFO, "PCIE%d.%d Link retry\n", RootComplex->ID, PcieIndex));
-        }
+      // If link check functions return failed, go to soft reset
+      if (Training->LinkCheck == LINK_CHECK_FAILED ||
+          RasdesChecking == LINK_CHECK_FAILED ||
+          !PcieLinkUpCheck (&RootComplex->Pcie[PcieIndex]))
+      {
+        Ac01PcieCoreQoSLinkCheckRecovery (RootComplex, PcieIndex);
       }
+
+      // Un-mask Completion Timeout
+      DisableCompletionTimeOut (RootComplex, PcieIndex, FALSE);
+
+      Training->State = LinkTrainingChecked;
     }
   }
 }
@@ -1787,6 +2118,11 @@ Ac01PcieCoreUpdateLink (
 /**
   Verify the link status and retry to initialize the Root Complex if there's any issue.
 
+  All controllers are polled in one loop, each one against its own deadline:
+  link up within LINK_TRAINING_TIMEOUT of its training start, then EP config
+  space ready within EP_LINKUP_EXTRA_TIMEOUT. The training time of each Root
+  Complex is reported through the gRootComplexTrainingHobGuid HOB.
+
   @param RootComplexList      Pointer to the Root Complex list
 **/
 VOID
@@ -1794,64 +2130,208 @@ Ac01PcieCorePostSetupRC (
   IN AC01_ROOT_COMPLEX *RootComplexList
   )
 {
-  UINT8   RCIndex, Idx;
-  BOOLEAN IsNextRoundNeeded, NextRoundNeeded;
-  UINT64  PrevTick, CurrTick, ElapsedCycle;
-  UINT64  TimerTicks64;
-  UINT8   ReInit;
-  INT8    FailedPciePtr[MaxPcieControllerOfRootComplexB];
-  INT8    FailedPcieCount;
-
-  ReInit = 0;
-
-_link_polling:
-  NextRoundNeeded = FALSE;
+  AC01_ROOT_COMPLEX                *RootComplex;
+  AC01_PCIE_CONTROLLER             *Pcie;
+  AC01_PCIE_LINK_TRAINING          *Training;
+  AC01_ROOT_COMPLEX_TRAINING_INFO  *TrainingInfo;
+  UINT64                           LinkTimeout;
+  UINT64                           CfgTimeout;
+  UINT64                           CurrTick;
+  UINTN                            Pending;
+  UINT8                            RCIndex;
+  UINT8                            PcieIndex;
+  UINT8                            ReInit;
+  BOOLEAN                          ResetAsserted;
+  BOOLEAN                          NextRoundNeeded;
+  BOOLEAN                          CardPresent;
+  UINT8                            RetryMask[AC01_PCIE_MAX_ROOT_COMPLEX];
+
+  for (RCIndex = 0; RCIndex < AC01_PCIE_MAX_ROOT_COMPLEX; RCIndex++) {
+    RootComplex  = &RootComplexList[RCIndex];
+    TrainingInfo = &mTrainingInfo[RCIndex];
+    TrainingInfo->Socket = RootComplex->Socket;
+    TrainingInfo->ID     = RootComplex->ID;
+  }
+
   //
   // It is not guaranteed the timer service is ready prior to PCI Dxe.
   // Calculate system ticks for link training.
   //
-  TimerTicks64 = ArmGenericTimerGetTimerFreq (); /* 1 Second */
-  PrevTick = ArmGenericTimerGetSystemCount ();
-  ElapsedCycle = 0;
+  LinkTimeout = MicroSecondsToTicks (LINK_TRAINING_TIMEOUT);
+  CfgTimeout  = MicroSecondsToTicks (EP_LINKUP_EXTRA_TIMEOUT);
+  ReInit      = 0;
 
   do {
-    CurrTick = ArmGenericTimerGetSystemCount ();
-    if (CurrTick < PrevTick) {
-      ElapsedCycle += MAX_UINT64 - PrevTick;
-      PrevTick = 0;
+    Pending = 0;
+    for (RCIndex = 0; RCIndex < AC01_PCIE_MAX_ROOT_COMPLEX; RCIndex++) {
+      RootComplex = &RootComplexList[RCIndex];
+      if (!RootComplex->Active) {
+        continue;
+      }
+
+      for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
+        Training = &mLinkTraining[RootComplexIndex (RootComplex)][PcieIndex];
+        if (RootComplex->Pcie[PcieIndex].Active && Training->State == LinkTrainingStarted) {
+          Training->Deadline = Training->StartTick + LinkTimeout;
+          Pending++;
+        }
+      }
     }
-    ElapsedCycle += (CurrTick - PrevTick);
-    PrevTick = CurrTick;
-  } while (ElapsedCycle < TimerTicks64);
 
-  for (RCIndex = 0; RCIndex < AC01_PCIE_MAX_ROOT_COMPLEX; RCIndex++) {
-    Ac01PcieCoreUpdateLink (&RootComplexList[RCIndex], &IsNextRoundNeeded, FailedPciePtr, &FailedPcieCount);
-    if (IsNextRoundNeeded) {
-      NextRoundNeeded = TRUE;
+    //
+    // Poll every training controller until its link and EP config space
+    // are up or its deadline expires
+    //
+    while (Pending > 0) {
+      CurrTick = ArmGenericTimerGetSystemCount ();
+
+      for (RCIndex = 0; RCIndex < AC01_PCIE_MAX_ROOT_COMPLEX; RCIndex++) {
+        RootComplex = &RootComplexList[RCIndex];
+        if (!RootComplex->Active) {
+          continue;
+        }
+
+        TrainingInfo = &mTrainingInfo[RCIndex];
+        for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
+          Pcie     = &RootComplex->Pcie[PcieIndex];
+          Training = &mLinkTraining[RootComplexIndex (RootComplex)][PcieIndex];
+          if (!Pcie->Active) {
+            continue;
+          }
+
+          if (Training->State == LinkTrainingStarted) {
+            if (PcieLinkUpCheck (Pcie)) {
+              Pcie->LinkUp = TRUE;
+              TrainingInfo->LinkUpTimeUs[PcieIndex] = TicksToMicroSeconds (CurrTick - Training->StartTick);
+
+              Training->CfgRestore = EndpointConfigOpen (RootComplex, PcieIndex);
+              Training->Deadline   = CurrTick + CfgTimeout;
+              Training->State      = LinkTrainingCfgWait;
+              continue;
+            }
+
+            if (CurrTick < Training->Deadline) {
+              continue;
+            }
+
+            Training->State = LinkTrainingFailed;
+          } else if (Training->State == LinkTrainingCfgWait) {
+            Training->CfgReady = EndpointCfgAccessible (RootComplex, PcieIndex);
+            if (!Training->CfgReady && CurrTick < Training->Deadline) {
+              continue;
+            }
+
+            EndpointConfigClose (RootComplex, PcieIndex, Training->CfgRestore);
+            Training->State = LinkTrainingDone;
+          } else {
+            continue;
+          }
+
+          TrainingInfo->TrainingTimeUs = TicksToMicroSeconds (CurrTick - mRootComplexStartTick[RootComplexIndex (RootComplex)]);
+          Pending--;
+        }
+      }
+
+      if (Pending > 0) {
+        MicroSecondDelay (LINK_WAIT_INTERVAL_US);
+      }
     }
-  }
 
-  if (NextRoundNeeded && ReInit < MAX_REINIT) {
+    Ac01PcieCoreQoSLinkCheckAll (RootComplexList);
+
     //
-    // Timer is up. Give another chance to re-program controller
+    // Timer is up. Give another chance to re-program the controllers of
+    // the Root Complexes where a link partner is connected but the link is down.
     //
+    NextRoundNeeded = FALSE;
+    for (RCIndex = 0; RCIndex < AC01_PCIE_MAX_ROOT_COMPLEX; RCIndex++) {
+      RootComplex        = &RootComplexList[RCIndex];
+      RetryMask[RCIndex] = 0;
+      if (!RootComplex->Active) {
+        continue;
+      }
+
+      CardPresent = FALSE;
+      for (PcieIndex = 0; PcieIndex < RootComplex->MaxPcieController; PcieIndex++) {
+        Pcie = &RootComplex->Pcie[PcieIndex];
+        if (!Pcie->Active || Pcie->LinkUp) {
+          continue;
+        }
+
+        RetryMask[RCIndex] |= (1 << PcieIndex);
+        if (Ac01PcieCoreCheckCardPresent (Pcie)) {
+          CardPresent = TRUE;
+          DEBUG ((DEBUG_INFO, "PCIE%d.%d Link retry\n", RootComplex->ID, PcieIndex));
+        }
+      }
+
+      if (CardPresent) {
+        NextRoundNeeded = TRUE;
+      } else {
+        RetryMask[RCIndex] = 0;
+      }
+    }
+
+    if (!NextRoundNeeded || ReInit >= MAX_REINIT) {
+      break;
+    }
+
     ReInit++;
+
+    //
+    // Some controllers still observe link-down. Re-init them
+    //
+    ResetAsserted = FALSE;
     for (RCIndex = 0; RCIndex < AC01_PCIE_MAX_ROOT_COMPLEX; RCIndex++) {
-      Ac01PcieCoreUpdateLink (&RootComplexList[RCIndex], &IsNextRoundNeeded, FailedPciePtr, &FailedPcieCount);
-      if (IsNextRoundNeeded) {
-        for (Idx = 0; Idx < FailedPcieCount; Idx++) {
-          if (FailedPciePtr[Idx] == -1) {
-            continue;
-          }
+      for (PcieIndex = 0; PcieIndex < MaxPcieController; PcieIndex++) {
+        if (((RetryMask[RCIndex] & (1 << PcieIndex)) != 0)
+            && AssertControllerReset (&RootComplexList[RCIndex], PcieIndex))
+        {
+          ResetAsserted = TRUE;
+        }
+      }
+    }
+
+    if (ResetAsserted) {
+      // Delay 50ms to ensure controllers finish their reset
+      MicroSecondDelay (50000);
+    }
 
-          //
-          // Some controller still observes link-down. Re-init controller
-          //
-          Ac01PcieCoreSetupRC (&RootComplexList[RCIndex], TRUE, FailedPciePtr[Idx]);
+    for (RCIndex = 0; RCIndex < AC01_PCIE_MAX_ROOT_COMPLEX; RCIndex++) {
+      if (RetryMask[RCIndex] == 0) {
+        continue;
+      }
+
+      mTrainingInfo[RCIndex].ReInitCount++;
+      for (PcieIndex = 0; PcieIndex < MaxPcieController; PcieIndex++) {
+        if ((RetryMask[RCIndex] & (1 << PcieIndex)) != 0) {
+          SetupController (&RootComplexList[RCIndex], PcieIndex);
         }
       }
     }
+  } while (TRUE);
 
-    goto _link_polling;
+  for (RCIndex = 0; RCIndex < AC01_PCIE_MAX_ROOT_COMPLEX; RCIndex++) {
+    TrainingInfo         = &mTrainingInfo[RCIndex];
+    TrainingInfo->Active = RootComplexList[RCIndex].Active;
+    if (TrainingInfo->Active) {
+      DEBUG ((
+        DEBUG_INFO,
+        "S%d-RC%d link training took %d us, %d re-init round(s)\n",
+        TrainingInfo->Socket,
+        TrainingInfo->ID,
+        TrainingInfo->TrainingTimeUs,
+        TrainingInfo->ReInitCount
+        ));
+    }
   }
+
+  //
+  // Build Root Complex training info Hob
+  //
+  BuildGuidDataHob (
+    &gRootComplexTrainingHobGuid,
+    (VOID *)mTrainingInfo,
+    sizeof (mTrainingInfo)
+    );
 }
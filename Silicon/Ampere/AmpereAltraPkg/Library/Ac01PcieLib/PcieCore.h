@@ -41,6 +41,28 @@
 #define EP_LINKUP_TIMEOUT                (10 * 1000) // 10ms
 #define EP_LINKUP_EXTRA_TIMEOUT          (500 * 1000) // 500ms
 #define LINK_WAIT_INTERVAL_US            50
+#define LINK_TRAINING_TIMEOUT            1000000     // 1 s per controller
+
+//
+// Link training state of a controller
+//
+typedef enum {
+  LinkTrainingIdle = 0,
+  LinkTrainingStarted,      // LTSSM enabled, waiting for link up
+  LinkTrainingCfgWait,      // Link up, waiting for EP config space
+  LinkTrainingDone,         // Link and EP config space settled
+  LinkTrainingFailed,       // No link before the deadline
+  LinkTrainingChecked       // Link quality has been checked
+} AC01_PCIE_LINK_TRAINING_STATE;
+
+typedef struct {
+  AC01_PCIE_LINK_TRAINING_STATE    State;
+  UINT64                           StartTick;    // System count when link training was started
+  UINT64                           Deadline;     // System count the current state has to settle by
+  UINT32                           CfgRestore;   // Bus numbers saved while EP config space is polled
+  BOOLEAN                          CfgReady;     // EP config space answered
+  INT32                            LinkCheck;    // Result of Ac01PcieCoreLinkCheck
+} AC01_PCIE_LINK_TRAINING;
 
 #define PFA_MODE_ENABLE                  0
 #define PFA_MODE_CLEAR                   1
@@ -302,6 +302,23 @@ GpioRegisterAccessAndThenOr32 (
   IN  UINT32                  OrValue
   );
 
+/**
+  This procedure writes GPIO register without reading it first
+
+  @param[in] GpioGroupInfo           Pointer to GPIO group table info
+  @param[in] Register                Register offset
+  @param[in] Value                   Value to write
+
+  @retval EFI_DEVICE_ERROR           vGPIO BAR not programmed
+          EFI_SUCCESS                Operation completed successfully
+**/
+EFI_STATUS
+GpioRegisterAccessWrite32 (
+  IN  CONST GPIO_GROUP_INFO   *GpioGroupInfo,
+  IN  UINT32                  Register,
+  IN  UINT32                  Value
+  );
+
 /**
   This procedure will calculate PADCFG register value based on GpioConfig data
   The procedure can be various depending on chipset generation.
@@ -109,23 +109,55 @@ GpioDwRegValueFromGpioConfig (
   }
 }
 
+/**
+  Read-modify-write a GPIO register, skipping the write if the value is unchanged.
+
+  @param[in] GpioGroupInfo      Pointer to GPIO group table info
+  @param[in] Register           Register offset
+  @param[in] AndValue           Value ANDed with the current register value
+  @param[in] OrValue            Value ORed with the result of the AND
+
+  @retval TRUE                  The register was written
+  @retval FALSE                 The register already held the value
+**/
+STATIC
+BOOLEAN
+GpioRegisterAndThenOr32IfChanged (
+  IN CONST GPIO_GROUP_INFO     *GpioGroupInfo,
+  IN UINT32                    Register,
+  IN UINT32                    AndValue,
+  IN UINT32                    OrValue
+  )
+{
+  UINT32  Value;
+  UINT32  NewValue;
+
+  Value    = GpioRegisterAccessRead32 (GpioGroupInfo, Register);
+  NewValue = (Value & AndValue) | OrValue;
+  if (NewValue == Value) {
+    return FALSE;
+  }
+  GpioRegisterAccessWrite32 (GpioGroupInfo, Register, NewValue);
+  return TRUE;
+}
+
 /**
   This internal procedure will scan GPIO initialization table and unlock
-  all pads present in it
+  all pads of one group present in it. Pads of the group do not need to
+  be adjacent in the table.
 
-  @param[in] NumberOfItem               Number of GPIO pad records in table
+  @param[in] NumberOfItems              Number of GPIO pad records in table
   @param[in] GpioInitTableAddress       GPIO initialization table
-  @param[in] Index                      Index of GPIO Initialization table record
+  @param[in] GroupIndex                 GPIO group index
 
-  @retval EFI_SUCCESS                   The function completed successfully
-  @retval EFI_INVALID_PARAMETER         Invalid group or pad number
+  @retval Number of table records for pads of the group
 **/
 STATIC
-EFI_STATUS
+UINT32
 GpioUnlockPadsForAGroup (
   IN UINT32                    NumberOfItems,
   IN GPIO_INIT_CONFIG          *GpioInitTableAddress,
-  IN UINT32                    Index
+  IN UINT32                    GroupIndex
   )
 {
   UINT32                 PadsToUnlock[GPIO_GROUP_DW_NUMBER];
@@ -135,51 +167,44 @@ GpioUnlockPadsForAGroup (
   UINT32                 GpioGroupInfoLength;
   CONST GPIO_INIT_CONFIG *GpioData;
   GPIO_GROUP             Group;
-  UINT32                 GroupIndex;
+  UINT32                 Index;
   UINT32                 PadNumber;
+  UINT32                 PadCount;
 
   GpioGroupInfo = GpioGetGroupInfoTable (&GpioGroupInfoLength);
 
-  GpioData   = &GpioInitTableAddress[Index];
-  Group      = GpioGetGroupFromGpioPad (GpioData->GpioPad);
-  GroupIndex = GpioGetGroupIndexFromGpioPad (GpioData->GpioPad);
-
+  Group    = 0;
+  PadCount = 0;
   ZeroMem (PadsToUnlock, sizeof (PadsToUnlock));
   //
-  // Loop through pads for one group. If pad belongs to a different group then
-  // break and move to register programming.
+  // Loop through the whole table collecting pads of this group
   //
-  while (Index < NumberOfItems) {
+  for (Index = 0; Index < NumberOfItems; Index++) {
 
     GpioData   = &GpioInitTableAddress[Index];
     if (GroupIndex != GpioGetGroupIndexFromGpioPad (GpioData->GpioPad)) {
-      //if next pad is from different group then break loop
-      break;
+      continue;
     }
 
+    Group      = GpioGetGroupFromGpioPad (GpioData->GpioPad);
     PadNumber  = GpioGetPadNumberFromGpioPad (GpioData->GpioPad);
-    //
-    // Check if legal pin number
-    //
-    if (PadNumber >= GpioGroupInfo[GroupIndex].PadPerGroup) {
-      DEBUG ((DEBUG_ERROR, "GPIO ERROR: Pin number (%d) exceeds possible range for group %d\n", PadNumber, GroupIndex));
-      return EFI_INVALID_PARAMETER;
-    }
 
     PadBitPosition = GPIO_GET_PAD_POSITION (PadNumber);
     DwNum = GPIO_GET_DW_NUM (PadNumber);
 
     if (DwNum >= GPIO_GROUP_DW_NUMBER) {
       ASSERT (FALSE);
-      return EFI_UNSUPPORTED;
+      continue;
     }
     //
     // Update pads which need to be unlocked
     //
     PadsToUnlock[DwNum] |= 0x1 << PadBitPosition;
+    PadCount++;
+  }
 
-    //Move to next item
-    Index++;
+  if (PadCount == 0) {
+    return 0;
   }
 
   for (DwNum = 0; DwNum <= GPIO_GET_DW_NUM (GpioGroupInfo[GroupIndex].PadPerGroup - 1); DwNum++) {
@@ -192,7 +217,7 @@ GpioUnlockPadsForAGroup (
     }
   }
 
-  return EFI_SUCCESS;
+  return PadCount;
 }
 
 /**
@@ -224,16 +249,20 @@ GpioConfigurePch (
   UINT32                 GroupIndex;
   UINT32                 PadNumber;
   UINT32                 DwRegIndex;
+  UINT32                 PadCount;
 
   PadOwnVal = GpioPadOwnHost;
 
   GpioGroupInfo = GpioGetGroupInfoTable (&GpioGroupInfoLength);
 
-  Index = 0;
-  while (Index < NumberOfItems) {
+  //
+  // Validate the whole table first. Pads are then programmed one group at a time,
+  // so the registers shared by a group are accessed once even when the pads of
+  // the group are scattered in the table.
+  //
+  for (Index = 0; Index < NumberOfItems; Index++) {
 
     GpioData   = &GpioInitTableAddress[Index];
-    GroupIndex = GpioGetGroupIndexFromGpioPad (GpioData->GpioPad);
 
     DEBUG_CODE_BEGIN();
     if (!GpioIsCorrectPadForThisChipset (GpioData->GpioPad)) {
@@ -243,6 +272,23 @@ GpioConfigurePch (
     }
     DEBUG_CODE_END ();
 
+    GroupIndex = GpioGetGroupIndexFromGpioPad (GpioData->GpioPad);
+    if (GroupIndex >= GpioGroupInfoLength) {
+      DEBUG ((DEBUG_ERROR, "GPIO ERROR: Invalid group %d\n", GroupIndex));
+      return EFI_INVALID_PARAMETER;
+    }
+
+    //
+    // Check if legal pin number
+    //
+    PadNumber  = GpioGetPadNumberFromGpioPad (GpioData->GpioPad);
+    if (PadNumber >= GpioGroupInfo[GroupIndex].PadPerGroup) {
+      DEBUG ((DEBUG_ERROR, "GPIO ERROR: Pin number (%d) exceeds possible range for group %d\n", PadNumber, GroupIndex));
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  for (GroupIndex = 0; GroupIndex < GpioGroupInfoLength; GroupIndex++) {
     //
     // Unlock pads for a given group which are going to be reconfigured
     //
@@ -253,32 +299,25 @@ GpioConfigurePch (
     // PadRstCfg != Powergood GpioPad will have its configuration locked despite it being not the
     // one desired by BIOS. Before reconfiguring all pads they will get unlocked.
     //
-    GpioUnlockPadsForAGroup (NumberOfItems, GpioInitTableAddress, Index);
+    PadCount = GpioUnlockPadsForAGroup (NumberOfItems, GpioInitTableAddress, GroupIndex);
+    if (PadCount == 0) {
+      continue;
+    }
 
     ZeroMem (GroupDwData, sizeof (GroupDwData));
     //
-    // Loop through pads for one group. If pad belongs to a different group then
-    // break and move to register programming.
+    // Loop through the pads of this group, wherever they are in the table
     //
-    while (Index < NumberOfItems) {
+    for (Index = 0; Index < NumberOfItems; Index++) {
 
       GpioData   = &GpioInitTableAddress[Index];
       if (GroupIndex != GpioGetGroupIndexFromGpioPad (GpioData->GpioPad)) {
-        //if next pad is from different group then break loop
-        break;
+        continue;
       }
 
       PadNumber  = GpioGetPadNumberFromGpioPad (GpioData->GpioPad);
 
       DEBUG_CODE_BEGIN ();
-      //
-      // Check if legal pin number
-      //
-      if (PadNumber >= GpioGroupInfo[GroupIndex].PadPerGroup) {
-        DEBUG ((DEBUG_ERROR, "GPIO ERROR: Pin number (%d) exceeds possible range for group %d\n", PadNumber, GroupIndex));
-        return EFI_INVALID_PARAMETER;
-      }
-
       //
       // Check if selected GPIO Pad is not owned by CSME/ISH
       //
@@ -288,8 +327,7 @@ GpioConfigurePch (
         DEBUG ((DEBUG_ERROR, "GPIO ERROR: Accessing pad not owned by host (Group=%d, Pad=%d)!\n", GroupIndex, PadNumber));
         DEBUG ((DEBUG_ERROR, "** Please make sure the GPIO usage in sync between CSME and BIOS configuration. \n"));
         DEBUG ((DEBUG_ERROR, "** All the GPIO occupied by CSME should not do any configuration by BIOS.\n"));
-        //Move to next item
-        goto move_to_next_index;
+        continue;
       }
 
       //
@@ -321,7 +359,7 @@ GpioConfigurePch (
       for (DwRegIndex = 0; DwRegIndex <= 2; DwRegIndex++) {
         PadCfgReg = GpioGetGpioPadCfgAddressFromGpioPad (GpioData->GpioPad, DwRegIndex);
         if (PadCfgReg != 0) {
-          GpioRegisterAccessAndThenOr32 (&GpioGroupInfo[GroupIndex], PadCfgReg, ~PadCfgDwRegMask[DwRegIndex], PadCfgDwReg[DwRegIndex]);
+          GpioRegisterAndThenOr32IfChanged (&GpioGroupInfo[GroupIndex], PadCfgReg, ~PadCfgDwRegMask[DwRegIndex], PadCfgDwReg[DwRegIndex]);
         }
       }
 
@@ -333,10 +371,6 @@ GpioConfigurePch (
         &GpioData->GpioConfig,
         GroupDwData
         );
-
-    move_to_next_index:
-      //Move to next item
-      Index++;
     }
 
     for (DwNum = 0; DwNum <= GPIO_GET_DW_NUM (GpioGroupInfo[GroupIndex].PadPerGroup); DwNum++) {
@@ -344,7 +378,7 @@ GpioConfigurePch (
       // Write HOSTSW_OWN registers
       //
       if (GpioGroupInfo[GroupIndex].HostOwnOffset != NO_REGISTER_FOR_PROPERTY) {
-        GpioRegisterAccessAndThenOr32 (
+        GpioRegisterAndThenOr32IfChanged (
           &GpioGroupInfo[GroupIndex],
           GpioGroupInfo[GroupIndex].HostOwnOffset + DwNum * 0x4,
           ~GroupDwData[DwNum].HostSoftOwnRegMask,
@@ -356,7 +390,7 @@ GpioConfigurePch (
       // Write GPI_GPE_EN registers
       //
       if (GpioGroupInfo[GroupIndex].GpiGpeEnOffset != NO_REGISTER_FOR_PROPERTY) {
-        GpioRegisterAccessAndThenOr32 (
+        GpioRegisterAndThenOr32IfChanged (
           &GpioGroupInfo[GroupIndex],
           GpioGroupInfo[GroupIndex].GpiGpeEnOffset + DwNum * 0x4,
           ~GroupDwData[DwNum].GpiGpeEnRegMask,
@@ -368,7 +402,7 @@ GpioConfigurePch (
       // Write GPI_NMI_EN registers
       //
       if (GpioGroupInfo[GroupIndex].NmiEnOffset != NO_REGISTER_FOR_PROPERTY) {
-        GpioRegisterAccessAndThenOr32 (
+        GpioRegisterAndThenOr32IfChanged (
           &GpioGroupInfo[GroupIndex],
           GpioGroupInfo[GroupIndex].NmiEnOffset + DwNum * 0x4,
           ~GroupDwData[DwNum].GpiNmiEnRegMask,
@@ -383,7 +417,7 @@ GpioConfigurePch (
       // Write GPI_SMI_EN registers
       //
       if (GpioGroupInfo[GroupIndex].SmiEnOffset != NO_REGISTER_FOR_PROPERTY) {
-        GpioRegisterAccessAndThenOr32 (
+        GpioRegisterAndThenOr32IfChanged (
           &GpioGroupInfo[GroupIndex],
           GpioGroupInfo[GroupIndex].SmiEnOffset + DwNum * 0x4,
           ~GroupDwData[DwNum].GpiSmiEnRegMask,
@@ -520,8 +554,8 @@ GpioClearAllGpioInterrupts (
   Pad not configured using GPIO_INIT_CONFIG will be left with hardware default values.
   Separate fields could be set to hardware default if it does not matter, except
   GpioPad and PadMode.
-  Function will work in most efficient way if pads which belong to the same group are
-  placed in adjacent records of the table.
+  Pads which belong to the same group are programmed together wherever they are
+  placed in the table, registers which already hold the requested value are not written.
   Although function can enable pads for Native mode, such programming is done
   by reference code when enabling related silicon feature.
 
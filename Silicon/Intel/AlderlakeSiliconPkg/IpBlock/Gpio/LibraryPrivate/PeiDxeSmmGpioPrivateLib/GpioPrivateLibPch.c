@@ -90,6 +90,26 @@ GpioRegisterAccessAndThenOr32 (
   return EFI_SUCCESS;
 }
 
+/**
+  This procedure writes GPIO register without reading it first
+
+  @param[in] GpioGroupInfo           Pointer to GPIO group table info
+  @param[in] Register                Register offset
+  @param[in] Value                   Value to write
+
+  @retval EFI_SUCCESS                Operation completed successfully
+**/
+EFI_STATUS
+GpioRegisterAccessWrite32 (
+  IN  CONST GPIO_GROUP_INFO   *GpioGroupInfo,
+  IN  UINT32                  Register,
+  IN  UINT32                  Value
+  )
+{
+  MmioWrite32 (PCH_PCR_ADDRESS (GpioGroupInfo->Community, Register), Value);
+  return EFI_SUCCESS;
+}
+
 /**
   This procedure will calculate PADCFG register value based on GpioConfig data
 
@@ -112,23 +112,53 @@ GpioDwRegValueFromGpioConfig (
   }
 }
 
+/**
+  Read-modify-write a GPIO register, skipping the write if the value is unchanged.
+
+  @param[in] Address            PCR address of the register
+  @param[in] AndData            Value ANDed with the current register value
+  @param[in] OrData             Value ORed with the result of the AND
+
+  @retval TRUE                  The register was written
+  @retval FALSE                 The register already held the value
+**/
+STATIC
+BOOLEAN
+GpioMmioAndThenOr32IfChanged (
+  IN UINTN                     Address,
+  IN UINT32                    AndData,
+  IN UINT32                    OrData
+  )
+{
+  UINT32  Value;
+  UINT32  NewValue;
+
+  Value    = MmioRead32 (Address);
+  NewValue = (Value & AndData) | OrData;
+  if (NewValue == Value) {
+    return FALSE;
+  }
+  MmioWrite32 (Address, NewValue);
+  return TRUE;
+}
+
 /**
   This internal procedure will scan GPIO initialization table and unlock
-  all pads present in it
+  all pads of one group present in it. Pads of the group do not need to
+  be adjacent in the table.
 
-  @param[in] NumberOfItem               Number of GPIO pad records in table
+  @param[in] NumberOfItems              Number of GPIO pad records in table
   @param[in] GpioInitTableAddress       GPIO initialization table
-  @param[in] Index                      Index of GPIO Initialization table record
+  @param[in] GroupIndex                 GPIO group index
 
-  @retval EFI_SUCCESS                   The function completed successfully
-  @retval EFI_INVALID_PARAMETER         Invalid group or pad number
+  @retval Number of table records for pads of the group
 **/
 STATIC
-EFI_STATUS
+UINT32
 GpioUnlockPadsForAGroup (
   IN UINT32                    NumberOfItems,
   IN GPIO_INIT_CONFIG          *GpioInitTableAddress,
-  IN UINT32                    Index
+  IN UINT32                    GroupIndex
   )
 {
   UINT32                 PadsToUnlock[GPIO_GROUP_DW_NUMBER];
@@ -138,51 +168,44 @@ GpioUnlockPadsForAGroup (
   UINT32                 GpioGroupInfoLength;
   CONST GPIO_INIT_CONFIG *GpioData;
   GPIO_GROUP             Group;
-  UINT32                 GroupIndex;
+  UINT32                 Index;
   UINT32                 PadNumber;
+  UINT32                 PadCount;
 
   GpioGroupInfo = GpioGetGroupInfoTable (&GpioGroupInfoLength);
 
-  GpioData   = &GpioInitTableAddress[Index];
-  Group      = GpioGetGroupFromGpioPad (GpioData->GpioPad);
-  GroupIndex = GpioGetGroupIndexFromGpioPad (GpioData->GpioPad);
-
+  Group    = 0;
+  PadCount = 0;
   ZeroMem (PadsToUnlock, sizeof (PadsToUnlock));
   //
-  // Loop through pads for one group. If pad belongs to a different group then
-  // break and move to register programming.
+  // Loop through the whole table collecting pads of this group
   //
-  while (Index < NumberOfItems) {
+  for (Index = 0; Index < NumberOfItems; Index++) {
 
     GpioData   = &GpioInitTableAddress[Index];
     if (GroupIndex != GpioGetGroupIndexFromGpioPad (GpioData->GpioPad)) {
-      //if next pad is from different group then break loop
-      break;
+      continue;
     }
 
+    Group      = GpioGetGroupFromGpioPad (GpioData->GpioPad);
     PadNumber  = GpioGetPadNumberFromGpioPad (GpioData->GpioPad);
-    //
-    // Check if legal pin number
-    //
-    if (PadNumber >= GpioGroupInfo[GroupIndex].PadPerGroup) {
-      DEBUG ((DEBUG_ERROR, "GPIO ERROR: Pin number (%d) exceeds possible range for group %d\n", PadNumber, GroupIndex));
-      return EFI_INVALID_PARAMETER;
-    }
 
     PadBitPosition = GPIO_GET_PAD_POSITION (PadNumber);
     DwNum = GPIO_GET_DW_NUM (PadNumber);
 
     if (DwNum >= GPIO_GROUP_DW_NUMBER) {
       ASSERT (FALSE);
-      return EFI_UNSUPPORTED;
+      continue;
     }
     //
     // Update pads which need to be unlocked
     //
     PadsToUnlock[DwNum] |= 0x1 << PadBitPosition;
+    PadCount++;
+  }
 
-    //Move to next item
-    Index++;
+  if (PadCount == 0) {
+    return 0;
   }
 
   for (DwNum = 0; DwNum <= GPIO_GET_DW_NUM (GpioGroupInfo[GroupIndex].PadPerGroup); DwNum++) {
@@ -195,7 +218,7 @@ GpioUnlockPadsForAGroup (
     }
   }
 
-  return EFI_SUCCESS;
+  return PadCount;
 }
 
 /**
@@ -227,17 +250,20 @@ GpioConfigurePch (
   UINT32                 GroupIndex;
   UINT32                 PadNumber;
   PCH_SBI_PID            GpioCom;
+  UINT32                 PadCount;
 
   PadOwnVal = GpioPadOwnHost;
 
   GpioGroupInfo = GpioGetGroupInfoTable (&GpioGroupInfoLength);
 
-  Index = 0;
-  while (Index < NumberOfItems) {
+  //
+  // Validate the whole table first. Pads are then programmed one group at a time,
+  // so the registers shared by a group are accessed once even when the pads of
+  // the group are scattered in the table.
+  //
+  for (Index = 0; Index < NumberOfItems; Index++) {
 
     GpioData   = &GpioInitTableAddress[Index];
-    GroupIndex = GpioGetGroupIndexFromGpioPad (GpioData->GpioPad);
-    GpioCom    = GpioGroupInfo[GroupIndex].Community;
 
     DEBUG_CODE_BEGIN();
     if (!GpioIsCorrectPadForThisChipset (GpioData->GpioPad)) {
@@ -247,6 +273,23 @@ GpioConfigurePch (
     }
     DEBUG_CODE_END ();
 
+    GroupIndex = GpioGetGroupIndexFromGpioPad (GpioData->GpioPad);
+    if (GroupIndex >= GpioGroupInfoLength) {
+      DEBUG ((DEBUG_ERROR, "GPIO ERROR: Invalid group %d\n", GroupIndex));
+      return EFI_INVALID_PARAMETER;
+    }
+
+    //
+    // Check if legal pin number
+    //
+    PadNumber  = GpioGetPadNumberFromGpioPad (GpioData->GpioPad);
+    if (PadNumber >= GpioGroupInfo[GroupIndex].PadPerGroup) {
+      DEBUG ((DEBUG_ERROR, "GPIO ERROR: Pin number (%d) exceeds possible range for group %d\n", PadNumber, GroupIndex));
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  for (GroupIndex = 0; GroupIndex < GpioGroupInfoLength; GroupIndex++) {
     //
     // Unlock pads for a given group which are going to be reconfigured
     //
@@ -257,32 +300,26 @@ GpioConfigurePch (
     // PadRstCfg != Powergood GpioPad will have its configuration locked despite it being not the
     // one desired by BIOS. Before reconfiguring all pads they will get unlocked.
     //
-    GpioUnlockPadsForAGroup (NumberOfItems, GpioInitTableAddress, Index);
+    PadCount = GpioUnlockPadsForAGroup (NumberOfItems, GpioInitTableAddress, GroupIndex);
+    if (PadCount == 0) {
+      continue;
+    }
+    GpioCom    = GpioGroupInfo[GroupIndex].Community;
 
     ZeroMem (GroupDwData, sizeof (GroupDwData));
     //
-    // Loop through pads for one group. If pad belongs to a different group then
-    // break and move to register programming.
+    // Loop through the pads of this group, wherever they are in the table
     //
-    while (Index < NumberOfItems) {
+    for (Index = 0; Index < NumberOfItems; Index++) {
 
       GpioData   = &GpioInitTableAddress[Index];
       if (GroupIndex != GpioGetGroupIndexFromGpioPad (GpioData->GpioPad)) {
-        //if next pad is from different group then break loop
-        break;
+        continue;
       }
 
       PadNumber  = GpioGetPadNumberFromGpioPad (GpioData->GpioPad);
 
       DEBUG_CODE_BEGIN ();
-      //
-      // Check if legal pin number
-      //
-      if (PadNumber >= GpioGroupInfo[GroupIndex].PadPerGroup) {
-        DEBUG ((DEBUG_ERROR, "GPIO ERROR: Pin number (%d) exceeds possible range for group %d\n", PadNumber, GroupIndex));
-        return EFI_INVALID_PARAMETER;
-      }
-
       //
       // Check if selected GPIO Pad is not owned by CSME/ISH
       //
@@ -292,8 +329,6 @@ GpioConfigurePch (
         DEBUG ((DEBUG_ERROR, "GPIO ERROR: Accessing pad not owned by host (Group=%d, Pad=%d)!\n", GroupIndex, PadNumber));
         DEBUG ((DEBUG_ERROR, "** Please make sure the GPIO usage in sync between CSME and BIOS configuration. \n"));
         DEBUG ((DEBUG_ERROR, "** All the GPIO occupied by CSME should not do any configuration by BIOS.\n"));
-        //Move to next item
-        Index++;
         continue;
       }
 
@@ -328,7 +363,7 @@ GpioConfigurePch (
       //
       // Write PADCFG DW0 register
       //
-      MmioAndThenOr32 (
+      GpioMmioAndThenOr32IfChanged (
         PCH_PCR_ADDRESS (GpioCom, PadCfgReg),
         ~PadCfgDwRegMask[0],
         PadCfgDwReg[0]
@@ -337,7 +372,7 @@ GpioConfigurePch (
       //
       // Write PADCFG DW1 register
       //
-      MmioAndThenOr32 (
+      GpioMmioAndThenOr32IfChanged (
         PCH_PCR_ADDRESS (GpioCom, PadCfgReg + 0x4),
         ~PadCfgDwRegMask[1],
         PadCfgDwReg[1]
@@ -346,7 +381,7 @@ GpioConfigurePch (
       //
       // Write PADCFG DW2 register
       //
-      MmioAndThenOr32 (
+      GpioMmioAndThenOr32IfChanged (
         PCH_PCR_ADDRESS (GpioCom, PadCfgReg + 0x8),
         ~PadCfgDwRegMask[2],
         PadCfgDwReg[2]
@@ -360,9 +395,6 @@ GpioConfigurePch (
         &GpioData->GpioConfig,
         GroupDwData
         );
-
-      //Move to next item
-      Index++;
     }
 
     for (DwNum = 0; DwNum <= GPIO_GET_DW_NUM (GpioGroupInfo[GroupIndex].PadPerGroup); DwNum++) {
@@ -370,7 +402,7 @@ GpioConfigurePch (
       // Write HOSTSW_OWN registers
       //
       if (GpioGroupInfo[GroupIndex].HostOwnOffset != NO_REGISTER_FOR_PROPERTY) {
-        MmioAndThenOr32 (
+        GpioMmioAndThenOr32IfChanged (
           PCH_PCR_ADDRESS (GpioCom, GpioGroupInfo[GroupIndex].HostOwnOffset + DwNum * 0x4),
           ~GroupDwData[DwNum].HostSoftOwnRegMask,
           GroupDwData[DwNum].HostSoftOwnReg
@@ -381,7 +413,7 @@ GpioConfigurePch (
       // Write GPI_GPE_EN registers
       //
       if (GpioGroupInfo[GroupIndex].GpiGpeEnOffset != NO_REGISTER_FOR_PROPERTY) {
-        MmioAndThenOr32 (
+        GpioMmioAndThenOr32IfChanged (
           PCH_PCR_ADDRESS (GpioCom, GpioGroupInfo[GroupIndex].GpiGpeEnOffset + DwNum * 0x4),
           ~GroupDwData[DwNum].GpiGpeEnRegMask,
           GroupDwData[DwNum].GpiGpeEnReg
@@ -392,7 +424,7 @@ GpioConfigurePch (
       // Write GPI_NMI_EN registers
       //
       if (GpioGroupInfo[GroupIndex].NmiEnOffset != NO_REGISTER_FOR_PROPERTY) {
-        MmioAndThenOr32 (
+        GpioMmioAndThenOr32IfChanged (
           PCH_PCR_ADDRESS (GpioCom, GpioGroupInfo[GroupIndex].NmiEnOffset + DwNum * 0x4),
           ~GroupDwData[DwNum].GpiNmiEnRegMask,
           GroupDwData[DwNum].GpiNmiEnReg
@@ -406,7 +438,7 @@ GpioConfigurePch (
       // Write GPI_SMI_EN registers
       //
       if (GpioGroupInfo[GroupIndex].SmiEnOffset != NO_REGISTER_FOR_PROPERTY) {
-        MmioAndThenOr32 (
+        GpioMmioAndThenOr32IfChanged (
           PCH_PCR_ADDRESS (GpioCom, GpioGroupInfo[GroupIndex].SmiEnOffset + DwNum * 0x4),
           ~GroupDwData[DwNum].GpiSmiEnRegMask,
           GroupDwData[DwNum].GpiSmiEnReg
@@ -528,8 +560,8 @@ GpioClearAllGpioInterrupts (
   Pad not configured using GPIO_INIT_CONFIG will be left with hardware default values.
   Separate fields could be set to hardware default if it does not matter, except
   GpioPad and PadMode.
-  Function will work in most efficient way if pads which belong to the same group are
-  placed in adjacent records of the table.
+  Pads which belong to the same group are programmed together wherever they are
+  placed in the table, registers which already hold the requested value are not written.
   Although function can enable pads for Native mode, such programming is done
   by reference code when enabling related silicon feature.
 
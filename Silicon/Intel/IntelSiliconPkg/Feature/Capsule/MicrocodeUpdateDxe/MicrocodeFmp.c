@@ -624,14 +624,33 @@ InitializedProcessorMicrocodeIndex (
   IN MICROCODE_FMP_PRIVATE_DATA *MicrocodeFmpPrivate
   )
 {
-  UINTN       CpuIndex;
-  UINTN       MicrocodeIndex;
-  UINTN       TargetCpuIndex;
-  UINT32      AttemptStatus;
-  EFI_STATUS  Status;
+  UINTN           CpuIndex;
+  UINTN           MicrocodeIndex;
+  UINTN           TargetCpuIndex;
+  UINTN           GroupIndex;
+  UINT32          AttemptStatus;
+  EFI_STATUS      Status;
+  PROCESSOR_INFO  *ProcessorInfo;
 
+  ProcessorInfo = MicrocodeFmpPrivate->ProcessorInfo;
   for (CpuIndex = 0; CpuIndex < MicrocodeFmpPrivate->ProcessorCount; CpuIndex++) {
-    if (MicrocodeFmpPrivate->ProcessorInfo[CpuIndex].MicrocodeIndex != (UINTN)-1) {
+    if (ProcessorInfo[CpuIndex].MicrocodeIndex != (UINTN)-1) {
+      continue;
+    }
+
+    //
+    // The processors with the same signature, platform ID and revision match the same Microcode.
+    // Only the first processor of such a group verifies the Microcode images.
+    //
+    for (GroupIndex = 0; GroupIndex < CpuIndex; GroupIndex++) {
+      if ((ProcessorInfo[GroupIndex].ProcessorSignature == ProcessorInfo[CpuIndex].ProcessorSignature) &&
+          (ProcessorInfo[GroupIndex].PlatformId == ProcessorInfo[CpuIndex].PlatformId) &&
+          (ProcessorInfo[GroupIndex].MicrocodeRevision == ProcessorInfo[CpuIndex].MicrocodeRevision)) {
+        break;
+      }
+    }
+    if (GroupIndex < CpuIndex) {
+      ProcessorInfo[CpuIndex].MicrocodeIndex = ProcessorInfo[GroupIndex].MicrocodeIndex;
       continue;
     }
     for (MicrocodeIndex = 0; MicrocodeIndex < MicrocodeFmpPrivate->DescriptorCount; MicrocodeIndex++) {
@@ -670,7 +689,9 @@ InitializeMicrocodeDescriptor (
 {
   EFI_STATUS Status;
   UINT8      CurrentMicrocodeCount;
+  UINT64     StartTicks;
 
+  StartTicks = GetPerformanceCounter ();
   CurrentMicrocodeCount = (UINT8)GetMicrocodeInfo (MicrocodeFmpPrivate, 0, NULL, NULL);
 
   if (CurrentMicrocodeCount > MicrocodeFmpPrivate->DescriptorCount) {
@@ -707,6 +728,7 @@ InitializeMicrocodeDescriptor (
   ASSERT(CurrentMicrocodeCount == MicrocodeFmpPrivate->DescriptorCount);
 
   InitializedProcessorMicrocodeIndex (MicrocodeFmpPrivate);
+  DEBUG((DEBUG_INFO, "MicrocodeFmp: %d Microcode verified in %ld us\n", MicrocodeFmpPrivate->DescriptorCount, GetElapsedMicroseconds (StartTicks)));
 
   Status = InitializeFitMicrocodeInfo (MicrocodeFmpPrivate);
   if (EFI_ERROR(Status)) {
@@ -738,6 +760,7 @@ InitializeProcessorInfo (
   UINTN                                NumberOfEnabledProcessors;
   UINTN                                Index;
   UINTN                                BspIndex;
+  UINT64                               StartTicks;
 
   Status = gBS->LocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **)&MpService);
   ASSERT_EFI_ERROR(Status);
@@ -759,25 +782,30 @@ InitializeProcessorInfo (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  StartTicks = GetPerformanceCounter ();
   for (Index = 0; Index < NumberOfProcessors; Index++) {
     MicrocodeFmpPrivate->ProcessorInfo[Index].CpuIndex = Index;
     MicrocodeFmpPrivate->ProcessorInfo[Index].MicrocodeIndex = (UINTN)-1;
-    if (Index == BspIndex) {
-      CollectProcessorInfo (&MicrocodeFmpPrivate->ProcessorInfo[Index]);
-    } else {
-      Status = MpService->StartupThisAP (
-                            MpService,
-                            CollectProcessorInfo,
-                            Index,
-                            NULL,
-                            0,
-                            &MicrocodeFmpPrivate->ProcessorInfo[Index],
-                            NULL
-                            );
-      ASSERT_EFI_ERROR(Status);
-    }
   }
 
+  //
+  // All APs fill in their own slot at the same time
+  //
+  CollectProcessorInfo (&MicrocodeFmpPrivate->ProcessorInfo[BspIndex]);
+  if (NumberOfProcessors > 1) {
+    Status = MpService->StartupAllAPs (
+                          MpService,
+                          CollectProcessorInfoAp,
+                          FALSE,
+                          NULL,
+                          0,
+                          MicrocodeFmpPrivate,
+                          NULL
+                          );
+    ASSERT (!EFI_ERROR (Status) || (Status == EFI_NOT_STARTED));
+  }
+  DEBUG((DEBUG_INFO, "MicrocodeFmp: %d processors collected in %ld us\n", NumberOfProcessors, GetElapsedMicroseconds (StartTicks)));
+
   return EFI_SUCCESS;
 }
 
@@ -107,11 +107,61 @@ LoadMicrocode (
   return GetCurrentMicrocodeSignature();
 }
 
+/**
+  Get the elapsed time since a performance counter value.
+
+  @param[in] StartTicks  The performance counter value at the start.
+
+  @return The elapsed time in microseconds.
+**/
+UINT64
+GetElapsedMicroseconds (
+  IN UINT64  StartTicks
+  )
+{
+  UINT64  CurrentTicks;
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+  UINT64  Ticks;
+
+  CurrentTicks = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterEnd >= CounterStart) {
+    Ticks = CurrentTicks - StartTicks;
+  } else {
+    Ticks = StartTicks - CurrentTicks;
+  }
+  return DivU64x32 (GetTimeInNanoSecond (Ticks), 1000);
+}
+
+/**
+  Return TRUE if two processors have the same signature and platform ID,
+  so that they accept the same Microcode.
+
+  @param[in] ProcessorInfo1  The information of the first processor.
+  @param[in] ProcessorInfo2  The information of the second processor.
+
+  @retval TRUE   The processors accept the same Microcode.
+  @retval FALSE  The processors may accept different Microcode.
+**/
+BOOLEAN
+IsSameProcessorType (
+  IN PROCESSOR_INFO  *ProcessorInfo1,
+  IN PROCESSOR_INFO  *ProcessorInfo2
+  )
+{
+  return (BOOLEAN)((ProcessorInfo1->ProcessorSignature == ProcessorInfo2->ProcessorSignature) &&
+                   (ProcessorInfo1->PlatformId == ProcessorInfo2->PlatformId));
+}
+
 /**
   Load Microcode on an Application Processor.
-  The function prototype for invoking a function on an Application Processor.
+  The function prototype for invoking a function on all Application Processors.
 
-  @param[in,out] Buffer  The pointer to private data buffer.
+  Only the processors of the same type as the target processor load the Microcode,
+  each one records the loaded revision in its own PROCESSOR_INFO.
+
+  @param[in,out] Buffer  The pointer to MICROCODE_LOAD_BUFFER.
 **/
 VOID
 EFIAPI
@@ -120,23 +170,40 @@ MicrocodeLoadAp (
   )
 {
   MICROCODE_LOAD_BUFFER                *MicrocodeLoadBuffer;
+  MICROCODE_FMP_PRIVATE_DATA           *MicrocodeFmpPrivate;
+  EFI_STATUS                           Status;
+  UINTN                                CpuIndex;
+  PROCESSOR_INFO                       *ProcessorInfo;
 
   MicrocodeLoadBuffer = Buffer;
-  MicrocodeLoadBuffer->Revision = LoadMicrocode (MicrocodeLoadBuffer->Address);
+  MicrocodeFmpPrivate = MicrocodeLoadBuffer->MicrocodeFmpPrivate;
+  Status = MicrocodeFmpPrivate->MpService->WhoAmI (MicrocodeFmpPrivate->MpService, &CpuIndex);
+  if (EFI_ERROR (Status) || (CpuIndex >= MicrocodeFmpPrivate->ProcessorCount)) {
+    return;
+  }
+
+  ProcessorInfo = &MicrocodeFmpPrivate->ProcessorInfo[CpuIndex];
+  if (!IsSameProcessorType (ProcessorInfo, &MicrocodeFmpPrivate->ProcessorInfo[MicrocodeLoadBuffer->TargetCpuIndex])) {
+    return;
+  }
+  ProcessorInfo->MicrocodeRevision = LoadMicrocode (MicrocodeLoadBuffer->Address);
 }
 
 /**
-  Load new Microcode on this processor
+  Load new Microcode on all processors of the same type as the target processor.
+
+  The Application Processors load the Microcode in parallel, then the BSP
+  loads it if it is of the same type.
 
   @param[in]  MicrocodeFmpPrivate        The Microcode driver private data
-  @param[in]  CpuIndex                   The index of the processor.
+  @param[in]  CpuIndex                   The index of the target processor.
   @param[in]  Address                    The address of new Microcode.
 
-  @return  Loaded Microcode signature.
+  @return  Loaded Microcode signature of the target processor.
 
 **/
 UINT32
-LoadMicrocodeOnThis (
+LoadMicrocodeOnMatchedProcessors (
   IN  MICROCODE_FMP_PRIVATE_DATA  *MicrocodeFmpPrivate,
   IN  UINTN                       CpuIndex,
   IN  UINT64                      Address
@@ -145,25 +212,48 @@ LoadMicrocodeOnThis (
   EFI_STATUS                           Status;
   EFI_MP_SERVICES_PROTOCOL             *MpService;
   MICROCODE_LOAD_BUFFER                MicrocodeLoadBuffer;
+  PROCESSOR_INFO                       *TargetProcessorInfo;
+  UINTN                                Index;
+  UINTN                                MatchedCount;
+  UINT64                               StartTicks;
 
-  if (CpuIndex == MicrocodeFmpPrivate->BspIndex) {
-    return LoadMicrocode (Address);
-  } else {
+  StartTicks = GetPerformanceCounter ();
+  TargetProcessorInfo = &MicrocodeFmpPrivate->ProcessorInfo[CpuIndex];
+
+  if (MicrocodeFmpPrivate->ProcessorCount > 1) {
     MpService = MicrocodeFmpPrivate->MpService;
+    MicrocodeLoadBuffer.MicrocodeFmpPrivate = MicrocodeFmpPrivate;
+    MicrocodeLoadBuffer.TargetCpuIndex = CpuIndex;
     MicrocodeLoadBuffer.Address = Address;
-    MicrocodeLoadBuffer.Revision = 0;
-    Status = MpService->StartupThisAP (
+    Status = MpService->StartupAllAPs (
                           MpService,
                           MicrocodeLoadAp,
-                          CpuIndex,
+                          FALSE,
                           NULL,
                           0,
                           &MicrocodeLoadBuffer,
                           NULL
                           );
-    ASSERT_EFI_ERROR(Status);
-    return MicrocodeLoadBuffer.Revision;
+    ASSERT (!EFI_ERROR (Status) || (Status == EFI_NOT_STARTED));
+  }
+
+  if (IsSameProcessorType (&MicrocodeFmpPrivate->ProcessorInfo[MicrocodeFmpPrivate->BspIndex], TargetProcessorInfo)) {
+    MicrocodeFmpPrivate->ProcessorInfo[MicrocodeFmpPrivate->BspIndex].MicrocodeRevision = LoadMicrocode (Address);
+  }
+
+  MatchedCount = 0;
+  for (Index = 0; Index < MicrocodeFmpPrivate->ProcessorCount; Index++) {
+    if (!IsSameProcessorType (&MicrocodeFmpPrivate->ProcessorInfo[Index], TargetProcessorInfo)) {
+      continue;
+    }
+    MatchedCount++;
+    if (MicrocodeFmpPrivate->ProcessorInfo[Index].MicrocodeRevision != TargetProcessorInfo->MicrocodeRevision) {
+      DEBUG((DEBUG_ERROR, "LoadMicrocode - Cpu 0x%x revision 0x%x is different from target 0x%x\n", Index, MicrocodeFmpPrivate->ProcessorInfo[Index].MicrocodeRevision, TargetProcessorInfo->MicrocodeRevision));
+    }
   }
+  DEBUG((DEBUG_INFO, "LoadMicrocode - 0x%x loaded on %d processors in %ld us\n", TargetProcessorInfo->MicrocodeRevision, MatchedCount, GetElapsedMicroseconds (StartTicks)));
+
+  return TargetProcessorInfo->MicrocodeRevision;
 }
 
 /**
@@ -186,6 +276,30 @@ CollectProcessorInfo (
   ProcessorInfo->MicrocodeRevision = GetCurrentMicrocodeSignature();
 }
 
+/**
+  Collect processor information into the slot of the executing processor.
+  The function prototype for invoking a function on all Application Processors.
+
+  @param[in,out] Buffer  The pointer to MICROCODE_FMP_PRIVATE_DATA.
+**/
+VOID
+EFIAPI
+CollectProcessorInfoAp (
+  IN OUT VOID  *Buffer
+  )
+{
+  MICROCODE_FMP_PRIVATE_DATA  *MicrocodeFmpPrivate;
+  EFI_STATUS                  Status;
+  UINTN                       CpuIndex;
+
+  MicrocodeFmpPrivate = Buffer;
+  Status = MicrocodeFmpPrivate->MpService->WhoAmI (MicrocodeFmpPrivate->MpService, &CpuIndex);
+  if (EFI_ERROR (Status) || (CpuIndex >= MicrocodeFmpPrivate->ProcessorCount)) {
+    return;
+  }
+  CollectProcessorInfo (&MicrocodeFmpPrivate->ProcessorInfo[CpuIndex]);
+}
+
 /**
   Get current Microcode information.
 
@@ -578,7 +692,7 @@ VerifyMicrocode (
   // try load MCU
   //
   if (TryLoad) {
-    CurrentRevision = LoadMicrocodeOnThis(MicrocodeFmpPrivate, ProcessorInfo->CpuIndex, (UINTN)MicrocodeEntryPoint + sizeof(CPU_MICROCODE_HEADER));
+    CurrentRevision = LoadMicrocodeOnMatchedProcessors(MicrocodeFmpPrivate, ProcessorInfo->CpuIndex, (UINTN)MicrocodeEntryPoint + sizeof(CPU_MICROCODE_HEADER));
     if (MicrocodeEntryPoint->UpdateRevision != CurrentRevision) {
       DEBUG((DEBUG_ERROR, "VerifyMicrocode - fail on LoadMicrocode\n"));
       *LastAttemptStatus = LAST_ATTEMPT_STATUS_ERROR_AUTH_ERROR;
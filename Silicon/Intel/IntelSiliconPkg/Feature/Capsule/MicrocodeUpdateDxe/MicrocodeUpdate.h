@@ -31,6 +31,7 @@
 #include <Library/DevicePathLib.h>
 #include <Library/HobLib.h>
 #include <Library/MicrocodeFlashAccessLib.h>
+#include <Library/TimerLib.h>
 
 #include <Register/Cpuid.h>
 #include <Register/Msr.h>
@@ -69,8 +70,9 @@ typedef struct {
 } PROCESSOR_INFO;
 
 typedef struct {
-  UINT64                 Address;
-  UINT32                 Revision;
+  struct _MICROCODE_FMP_PRIVATE_DATA   *MicrocodeFmpPrivate;
+  UINTN                                TargetCpuIndex;
+  UINT64                               Address;
 } MICROCODE_LOAD_BUFFER;
 
 struct _MICROCODE_FMP_PRIVATE_DATA {
@@ -142,6 +144,30 @@ CollectProcessorInfo (
   IN OUT VOID  *Buffer
   );
 
+/**
+  Collect processor information into the slot of the executing processor.
+  The function prototype for invoking a function on all Application Processors.
+
+  @param[in,out] Buffer  The pointer to MICROCODE_FMP_PRIVATE_DATA.
+**/
+VOID
+EFIAPI
+CollectProcessorInfoAp (
+  IN OUT VOID  *Buffer
+  );
+
+/**
+  Get the elapsed time since a performance counter value.
+
+  @param[in] StartTicks  The performance counter value at the start.
+
+  @return The elapsed time in microseconds.
+**/
+UINT64
+GetElapsedMicroseconds (
+  IN UINT64  StartTicks
+  );
+
 /**
   Get current Microcode information.
 
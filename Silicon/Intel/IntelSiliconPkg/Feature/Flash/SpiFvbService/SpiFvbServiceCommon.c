@@ -270,6 +270,50 @@ FvbReadBlock (
   }
 }
 
+/**
+  Check whether a memory mapped flash range is erased (all bytes 0xFF).
+
+  @param[in]  Address               The memory mapped address of the range.
+  @param[in]  Length                The length in bytes of the range.
+
+  @retval     TRUE                  Every byte of the range is erased.
+  @retval     FALSE                 At least one byte of the range is programmed.
+
+**/
+STATIC
+BOOLEAN
+IsFlashRangeErased (
+  IN UINTN                                Address,
+  IN UINTN                                Length
+  )
+{
+  while ((Length > 0) && ((Address & (sizeof (UINT64) - 1)) != 0)) {
+    if (*(UINT8 *) Address != 0xFF) {
+      return FALSE;
+    }
+    Address++;
+    Length--;
+  }
+
+  while (Length >= sizeof (UINT64)) {
+    if (*(UINT64 *) Address != MAX_UINT64) {
+      return FALSE;
+    }
+    Address += sizeof (UINT64);
+    Length  -= sizeof (UINT64);
+  }
+
+  while (Length > 0) {
+    if (*(UINT8 *) Address != 0xFF) {
+      return FALSE;
+    }
+    Address++;
+    Length--;
+  }
+
+  return TRUE;
+}
+
 /**
   Writes specified number of bytes from the input buffer to the block.
 
@@ -306,6 +350,15 @@ FvbWriteBlock (
   UINTN                                   LbaLength;
   EFI_STATUS                              Status;
   BOOLEAN                                 BadBufferSize = FALSE;
+  BOOLEAN                                 PageDiffers;
+  BOOLEAN                                 Programmed;
+  UINTN                                   Address;
+  UINTN                                   End;
+  UINTN                                   PageStart;
+  UINTN                                   PageEnd;
+  UINTN                                   RunStart;
+  UINTN                                   RunLength;
+  UINT32                                  Length;
 
   if ((FvbInstance == NULL) || (NumBytes == NULL) || (Buffer == NULL)) {
     return EFI_INVALID_PARAMETER;
@@ -344,17 +397,50 @@ FvbWriteBlock (
     BadBufferSize = TRUE;
   }
 
-  Status = SpiFlashWrite (LbaAddress + BlockOffset, (UINT32 *)NumBytes, Buffer);
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
+  //
+  // Compare the request against the memory mapped flash one program page at a
+  // time. Pages that already hold the data are skipped, adjacent pages that
+  // differ are programmed with a single SpiFlashWrite.
+  //
+  Status     = EFI_SUCCESS;
+  Programmed = FALSE;
+  Address    = LbaAddress + BlockOffset;
+  End        = Address + *NumBytes;
+  RunStart   = Address;
+  RunLength  = 0;
+  for (PageStart = Address; PageStart < End; PageStart = PageEnd) {
+    PageEnd = MIN ((PageStart & ~((UINTN) SPI_FVB_PROGRAM_PAGE_SIZE - 1)) + SPI_FVB_PROGRAM_PAGE_SIZE, End);
+    PageDiffers = (BOOLEAN) (CompareMem ((VOID *) PageStart, Buffer + (PageStart - Address), PageEnd - PageStart) != 0);
+    if (PageDiffers) {
+      if (RunLength == 0) {
+        RunStart = PageStart;
+      }
+      RunLength += PageEnd - PageStart;
+      mFvbModuleGlobal.FlashStatistics.PagesProgrammed++;
+    } else {
+      mFvbModuleGlobal.FlashStatistics.PageProgramsAvoided++;
+    }
 
-  Status = SpiFlashLock ();
-  if (EFI_ERROR (Status)) {
-    return Status;
+    if ((RunLength != 0) && (!PageDiffers || (PageEnd == End))) {
+      Length = (UINT32) RunLength;
+      Status = SpiFlashWrite (RunStart, &Length, Buffer + (RunStart - Address));
+      if (EFI_ERROR (Status)) {
+        *NumBytes = (RunStart - Address) + Length;
+        return Status;
+      }
+      Programmed = TRUE;
+      RunLength  = 0;
+    }
   }
 
-  WriteBackInvalidateDataCacheRange ((VOID *) (LbaAddress + BlockOffset), *NumBytes);
+  if (Programmed) {
+    Status = SpiFlashLock ();
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    WriteBackInvalidateDataCacheRange ((VOID *) Address, *NumBytes);
+  }
 
   if (!EFI_ERROR (Status) && BadBufferSize) {
     return EFI_BAD_BUFFER_SIZE;
@@ -410,6 +496,16 @@ FvbEraseBlock (
     return Status;
   }
 
+  //
+  // Variable reclaim erases blocks that are often still erased, don't spend an
+  // erase cycle on them
+  //
+  if (IsFlashRangeErased (LbaAddress, LbaLength)) {
+    mFvbModuleGlobal.FlashStatistics.BlockErasesAvoided++;
+    return EFI_SUCCESS;
+  }
+
+  mFvbModuleGlobal.FlashStatistics.BlocksErased++;
   Status = SpiFlashBlockErase (LbaAddress, &LbaLength);
   if (EFI_ERROR (Status)) {
     return Status;
@@ -952,6 +1048,15 @@ FvbProtocolEraseBlocks (
 
   VA_END (Args);
 
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "FvbProtocolEraseBlocks: erased %ld blocks (%ld avoided), programmed %ld pages (%ld avoided)\n",
+    mFvbModuleGlobal.FlashStatistics.BlocksErased,
+    mFvbModuleGlobal.FlashStatistics.BlockErasesAvoided,
+    mFvbModuleGlobal.FlashStatistics.PagesProgrammed,
+    mFvbModuleGlobal.FlashStatistics.PageProgramsAvoided
+    ));
+
   return EFI_SUCCESS;
 }
 
@@ -46,6 +46,11 @@
 
 #define FVB_INSTANCE_SIGNATURE       SIGNATURE_32('F','V','B','I')
 
+//
+// Flash program page size. Writes only program the pages whose content changes.
+//
+#define SPI_FVB_PROGRAM_PAGE_SIZE    256
+
 typedef struct {
   UINT32                                Signature;
   UINTN                                 FvBase;
@@ -55,9 +60,21 @@ typedef struct {
   EFI_FIRMWARE_VOLUME_HEADER            FvHeader;
 } EFI_FVB_INSTANCE;
 
+//
+// Counters of the flash operations issued and of the ones avoided because
+// the flash already held the requested content
+//
+typedef struct {
+  UINT64                      BlocksErased;
+  UINT64                      BlockErasesAvoided;
+  UINT64                      PagesProgrammed;
+  UINT64                      PageProgramsAvoided;
+} FVB_FLASH_STATISTICS;
+
 typedef struct {
   EFI_FVB_INSTANCE            *FvbInstance;
   UINT32                      NumFv;
+  FVB_FLASH_STATISTICS        FlashStatistics;
 } FVB_GLOBAL;
 
 //
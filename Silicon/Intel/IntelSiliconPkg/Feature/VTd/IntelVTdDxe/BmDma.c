@@ -25,16 +25,196 @@ typedef struct {
 typedef struct {
   UINT32                                    Signature;
   LIST_ENTRY                                Link;
+  LIST_ENTRY                                AddressLink;
   EDKII_IOMMU_OPERATION                     Operation;
   UINTN                                     NumberOfBytes;
   UINTN                                     NumberOfPages;
   EFI_PHYSICAL_ADDRESS                      HostAddress;
   EFI_PHYSICAL_ADDRESS                      DeviceAddress;
+  UINTN                                     BounceBufferClass;
   LIST_ENTRY                                HandleList;
 } MAP_INFO;
 #define MAP_INFO_FROM_LINK(a) CR (a, MAP_INFO, Link, MAP_INFO_SIGNATURE)
+#define MAP_INFO_FROM_ADDRESS_LINK(a) CR (a, MAP_INFO, AddressLink, MAP_INFO_SIGNATURE)
 
-LIST_ENTRY                        gMaps = INITIALIZE_LIST_HEAD_VARIABLE(gMaps);
+//
+// The MAP_INFO structures are hashed by the mapping handle and by the device address,
+// the buckets are power of 2 so the hash is a mask.
+//
+#define MAP_INFO_HASH_SIZE  64
+
+LIST_ENTRY                        mMapHandleHash[MAP_INFO_HASH_SIZE];
+LIST_ENTRY                        mMapAddressHash[MAP_INFO_HASH_SIZE];
+BOOLEAN                           mMapHashInitialized = FALSE;
+
+#define MAP_HANDLE_HASH(Mapping)  ((((UINTN) (Mapping)) >> 4) & (MAP_INFO_HASH_SIZE - 1))
+#define MAP_ADDRESS_HASH(Address) ((UINTN) RShiftU64 ((Address), EFI_PAGE_SHIFT) & (MAP_INFO_HASH_SIZE - 1))
+
+//
+// Bounce buffers below 4GB are kept in power of 2 size classes from 1 to 64 pages
+// and recycled by the following maps instead of going back to the page allocator.
+//
+#define BOUNCE_BUFFER_NOT_POOLED     MAX_UINTN
+#define BOUNCE_BUFFER_CLASS_NUMBER   7
+#define BOUNCE_BUFFER_POOL_DEPTH     4
+
+EFI_PHYSICAL_ADDRESS              mBounceBufferPool[BOUNCE_BUFFER_CLASS_NUMBER][BOUNCE_BUFFER_POOL_DEPTH];
+UINTN                             mBounceBufferPoolCount[BOUNCE_BUFFER_CLASS_NUMBER];
+
+/**
+  Initialize the MAP_INFO hash buckets on first use.
+  The caller must hold VTD_TPL_LEVEL.
+**/
+VOID
+InitializeMapHash (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  if (mMapHashInitialized) {
+    return ;
+  }
+  for (Index = 0; Index < MAP_INFO_HASH_SIZE; Index++) {
+    InitializeListHead (&mMapHandleHash[Index]);
+    InitializeListHead (&mMapAddressHash[Index]);
+  }
+  mMapHashInitialized = TRUE;
+}
+
+/**
+  Find the MAP_INFO structure of a mapping.
+  The caller must hold VTD_TPL_LEVEL.
+
+  @param[in]  Mapping           The mapping value returned from Map().
+
+  @return The MAP_INFO structure, or NULL if Mapping is not a valid mapping.
+**/
+MAP_INFO *
+FindMapInfoByMapping (
+  IN VOID                  *Mapping
+  )
+{
+  LIST_ENTRY               *Bucket;
+  LIST_ENTRY               *Link;
+
+  InitializeMapHash ();
+
+  //
+  // Compare the pointers before touching the structure, Mapping might be garbage.
+  //
+  Bucket = &mMapHandleHash[MAP_HANDLE_HASH (Mapping)];
+  for (Link = GetFirstNode (Bucket)
+       ; !IsNull (Bucket, Link)
+       ; Link = GetNextNode (Bucket, Link)
+       ) {
+    if (Link == &((MAP_INFO *) Mapping)->Link) {
+      return MAP_INFO_FROM_LINK (Link);
+    }
+  }
+  return NULL;
+}
+
+/**
+  Get a bounce buffer below 4GB for a remapped transfer.
+
+  The buffer is taken from the pool of its size class if possible. Transfers larger
+  than the biggest class, or a failed pool allocation, go to the page allocator with
+  the DmaMemoryTop of the transfer.
+
+  @param[in]  NumberOfPages     The number of pages of the transfer.
+  @param[in]  DmaMemoryTop      The highest address the device can access.
+  @param[out] DeviceAddress     The base of the bounce buffer.
+  @param[out] BounceBufferClass The size class of the bounce buffer, or
+                                BOUNCE_BUFFER_NOT_POOLED.
+
+  @retval EFI_SUCCESS           The bounce buffer is allocated.
+  @retval other                 The page allocator failed.
+**/
+EFI_STATUS
+AllocateBounceBuffer (
+  IN  UINTN                 NumberOfPages,
+  IN  EFI_PHYSICAL_ADDRESS  DmaMemoryTop,
+  OUT EFI_PHYSICAL_ADDRESS  *DeviceAddress,
+  OUT UINTN                 *BounceBufferClass
+  )
+{
+  EFI_STATUS                Status;
+  UINTN                     Class;
+  EFI_TPL                   OriginalTpl;
+
+  Class = (UINTN) HighBitSet64 (NumberOfPages);
+  if ((NumberOfPages & (NumberOfPages - 1)) != 0) {
+    Class++;
+  }
+
+  if (Class < BOUNCE_BUFFER_CLASS_NUMBER) {
+    OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
+    if (mBounceBufferPoolCount[Class] != 0) {
+      mBounceBufferPoolCount[Class]--;
+      *DeviceAddress     = mBounceBufferPool[Class][mBounceBufferPoolCount[Class]];
+      *BounceBufferClass = Class;
+      gBS->RestoreTPL (OriginalTpl);
+      return EFI_SUCCESS;
+    }
+    gBS->RestoreTPL (OriginalTpl);
+
+    *DeviceAddress = SIZE_4GB - 1;
+    Status = gBS->AllocatePages (
+                    AllocateMaxAddress,
+                    EfiBootServicesData,
+                    (UINTN) LShiftU64 (1, Class),
+                    DeviceAddress
+                    );
+    if (!EFI_ERROR (Status)) {
+      *BounceBufferClass = Class;
+      return EFI_SUCCESS;
+    }
+  }
+
+  *DeviceAddress     = DmaMemoryTop;
+  *BounceBufferClass = BOUNCE_BUFFER_NOT_POOLED;
+  return gBS->AllocatePages (
+                AllocateMaxAddress,
+                EfiBootServicesData,
+                NumberOfPages,
+                DeviceAddress
+                );
+}
+
+/**
+  Release the bounce buffer of a remapped transfer.
+
+  @param[in]  DeviceAddress     The base of the bounce buffer.
+  @param[in]  NumberOfPages     The number of pages of the transfer.
+  @param[in]  BounceBufferClass The size class of the bounce buffer, or
+                                BOUNCE_BUFFER_NOT_POOLED.
+**/
+VOID
+FreeBounceBuffer (
+  IN EFI_PHYSICAL_ADDRESS  DeviceAddress,
+  IN UINTN                 NumberOfPages,
+  IN UINTN                 BounceBufferClass
+  )
+{
+  EFI_TPL                  OriginalTpl;
+
+  if (BounceBufferClass == BOUNCE_BUFFER_NOT_POOLED) {
+    gBS->FreePages (DeviceAddress, NumberOfPages);
+    return ;
+  }
+
+  OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
+  if (mBounceBufferPoolCount[BounceBufferClass] < BOUNCE_BUFFER_POOL_DEPTH) {
+    mBounceBufferPool[BounceBufferClass][mBounceBufferPoolCount[BounceBufferClass]] = DeviceAddress;
+    mBounceBufferPoolCount[BounceBufferClass]++;
+    gBS->RestoreTPL (OriginalTpl);
+    return ;
+  }
+  gBS->RestoreTPL (OriginalTpl);
+
+  gBS->FreePages (DeviceAddress, (UINTN) LShiftU64 (1, BounceBufferClass));
+}
 
 /**
   This function fills DeviceHandle/IoMmuAccess to the MAP_HANDLE_INFO,
@@ -56,6 +236,7 @@ SyncDeviceHandleToMapInfo (
 {
   MAP_INFO                 *MapInfo;
   MAP_HANDLE_INFO          *MapHandleInfo;
+  LIST_ENTRY               *Bucket;
   LIST_ENTRY               *Link;
   EFI_TPL                  OriginalTpl;
 
@@ -63,12 +244,14 @@ SyncDeviceHandleToMapInfo (
   // Find MapInfo according to DeviceAddress
   //
   OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
+  InitializeMapHash ();
   MapInfo = NULL;
-  for (Link = GetFirstNode (&gMaps)
-       ; !IsNull (&gMaps, Link)
-       ; Link = GetNextNode (&gMaps, Link)
+  Bucket = &mMapAddressHash[MAP_ADDRESS_HASH (DeviceAddress)];
+  for (Link = GetFirstNode (Bucket)
+       ; !IsNull (Bucket, Link)
+       ; Link = GetNextNode (Bucket, Link)
        ) {
-    MapInfo = MAP_INFO_FROM_LINK (Link);
+    MapInfo = MAP_INFO_FROM_ADDRESS_LINK (Link);
     if (MapInfo->DeviceAddress == DeviceAddress) {
       break;
     }
@@ -243,18 +426,19 @@ IoMmuMap (
   MapInfo->NumberOfPages     = EFI_SIZE_TO_PAGES (MapInfo->NumberOfBytes);
   MapInfo->HostAddress       = PhysicalAddress;
   MapInfo->DeviceAddress     = DmaMemoryTop;
+  MapInfo->BounceBufferClass = BOUNCE_BUFFER_NOT_POOLED;
   InitializeListHead(&MapInfo->HandleList);
 
   //
   // Allocate a buffer below 4GB to map the transfer to.
   //
   if (NeedRemap) {
-    Status = gBS->AllocatePages (
-                    AllocateMaxAddress,
-                    EfiBootServicesData,
-                    MapInfo->NumberOfPages,
-                    &MapInfo->DeviceAddress
-                    );
+    Status = AllocateBounceBuffer (
+               MapInfo->NumberOfPages,
+               DmaMemoryTop,
+               &MapInfo->DeviceAddress,
+               &MapInfo->BounceBufferClass
+               );
     if (EFI_ERROR (Status)) {
       FreePool (MapInfo);
       *NumberOfBytes = 0;
@@ -280,7 +464,9 @@ IoMmuMap (
   }
 
   OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
-  InsertTailList (&gMaps, &MapInfo->Link);
+  InitializeMapHash ();
+  InsertTailList (&mMapHandleHash[MAP_HANDLE_HASH (MapInfo)], &MapInfo->Link);
+  InsertTailList (&mMapAddressHash[MAP_ADDRESS_HASH (MapInfo->DeviceAddress)], &MapInfo->AddressLink);
   gBS->RestoreTPL (OriginalTpl);
 
   //
@@ -316,7 +502,6 @@ IoMmuUnmap (
 {
   MAP_INFO                 *MapInfo;
   MAP_HANDLE_INFO          *MapHandleInfo;
-  LIST_ENTRY               *Link;
   EFI_TPL                  OriginalTpl;
 
   DEBUG ((DEBUG_VERBOSE, "IoMmuUnmap: 0x%08x\n", Mapping));
@@ -327,25 +512,17 @@ IoMmuUnmap (
   }
 
   OriginalTpl = gBS->RaiseTPL (VTD_TPL_LEVEL);
-  MapInfo = NULL;
-  for (Link = GetFirstNode (&gMaps)
-       ; !IsNull (&gMaps, Link)
-       ; Link = GetNextNode (&gMaps, Link)
-       ) {
-    MapInfo = MAP_INFO_FROM_LINK (Link);
-    if (MapInfo == Mapping) {
-      break;
-    }
-  }
+  MapInfo = FindMapInfoByMapping (Mapping);
   //
   // Mapping is not a valid value returned by Map()
   //
-  if (MapInfo != Mapping) {
+  if (MapInfo == NULL) {
     gBS->RestoreTPL (OriginalTpl);
     DEBUG ((DEBUG_ERROR, "IoMmuUnmap: %r\n", EFI_INVALID_PARAMETER));
     return EFI_INVALID_PARAMETER;
   }
   RemoveEntryList (&MapInfo->Link);
+  RemoveEntryList (&MapInfo->AddressLink);
   gBS->RestoreTPL (OriginalTpl);
 
   //
@@ -375,7 +552,7 @@ IoMmuUnmap (
     //
     // Free the mapped buffer and the MAP_INFO structure.
     //
-    gBS->FreePages (MapInfo->DeviceAddress, MapInfo->NumberOfPages);
+    FreeBounceBuffer (MapInfo->DeviceAddress, MapInfo->NumberOfPages, MapInfo->BounceBufferClass);
   }
 
   FreePool (Mapping);
@@ -508,26 +685,16 @@ GetDeviceInfoFromMapping (
   )
 {
   MAP_INFO                 *MapInfo;
-  LIST_ENTRY               *Link;
 
   if (Mapping == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  MapInfo = NULL;
-  for (Link = GetFirstNode (&gMaps)
-       ; !IsNull (&gMaps, Link)
-       ; Link = GetNextNode (&gMaps, Link)
-       ) {
-    MapInfo = MAP_INFO_FROM_LINK (Link);
-    if (MapInfo == Mapping) {
-      break;
-    }
-  }
+  MapInfo = FindMapInfoByMapping (Mapping);
   //
   // Mapping is not a valid value returned by Map()
   //
-  if (MapInfo != Mapping) {
+  if (MapInfo == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
@@ -591,6 +591,8 @@ OnExitBootServices (
 
   DEBUG ((DEBUG_INFO, "Vtd OnExitBootServices\n"));
   DumpVtdRegsAll ();
+  DumpVtdInvalidationStatistics ();
+  DumpVtdPageTableStatistics ();
 
   DEBUG ((DEBUG_INFO, "Invalidate all\n"));
   for (VtdIndex = 0; VtdIndex < mVtdUnitNumber; VtdIndex++) {
@@ -53,6 +53,18 @@
 #define VTD_QUEUED_INVALIDATION_DESCRIPTOR_WIDTH 1
 #define VTD_INVALIDATION_QUEUE_SIZE 0
 
+//
+// Number of page-selective IOTLB invalidations batched per VTd engine.
+// A larger batch is escalated to a domain-selective or global invalidation.
+//
+#define VTD_IOTLB_INVALIDATION_BATCH_SIZE 16
+
+//
+// Number of released page table pages per VTd engine waiting for their IOTLB
+// invalidation to complete before they can be reused.
+//
+#define VTD_PENDING_FREE_PAGE_TABLE_MAX 32
+
 //
 // This is the initial max PCI DATA number.
 // The number may be enlarged later.
@@ -74,6 +86,29 @@ typedef struct {
   PCI_DEVICE_DATA                  *PciDeviceData;
 } PCI_DEVICE_INFORMATION;
 
+typedef struct {
+  UINT16                           DomainIdentifier;
+  UINT8                            AddressMask;        // 2^AddressMask pages are invalidated
+  UINT64                           Address;
+} VTD_IOTLB_INVALIDATION;
+
+typedef struct {
+  UINT64                           MapCount;               // Access attribute updates
+  UINT64                           InvalidationIssued;     // IOTLB invalidation requests sent to hardware
+  UINT64                           InvalidationCoalesced;  // Page invalidations covered by another request or not needed
+  UINT64                           WaitCount;              // Invalidation wait descriptors
+  UINT64                           DomainEscalation;
+  UINT64                           GlobalEscalation;
+} VTD_INVALIDATION_STATISTICS;
+
+typedef struct {
+  UINT64                           TablePages;             // Second level page table pages in use
+  UINT64                           PeakTablePages;
+  UINT64                           FreeTablePages;         // Pages kept for reuse after a coalesce
+  UINT64                           SplitCount;
+  UINT64                           CoalesceCount;
+} VTD_PAGE_TABLE_STATISTICS;
+
 typedef struct {
   UINTN                            VtdUnitBaseAddress;
   UINT16                           Segment;
@@ -90,6 +125,18 @@ typedef struct {
   UINT8                            EnableQueuedInvalidation;
   VOID                             *QiDescBuffer;
   UINTN                            QiDescBufferSize;
+  volatile UINT32                  QiWaitStatus;
+  VTD_IOTLB_INVALIDATION           PendingIotlb[VTD_IOTLB_INVALIDATION_BATCH_SIZE];
+  UINTN                            PendingIotlbCount;
+  UINT64                           PendingIotlbPages;
+  UINT16                           PendingIotlbDomain;
+  BOOLEAN                          PendingIotlbOverflow;
+  BOOLEAN                          PendingIotlbMultiDomain;
+  VTD_INVALIDATION_STATISTICS      InvalidationStatistics;
+  VOID                             *FreePageTableList;
+  VOID                             *PendingFreePageTable[VTD_PENDING_FREE_PAGE_TABLE_MAX];
+  UINTN                            PendingFreePageTableCount;
+  VTD_PAGE_TABLE_STATISTICS        PageTableStatistics;
 } VTD_UNIT_INFORMATION;
 
 //
@@ -225,6 +272,61 @@ InvalidateIOTLB (
   IN UINTN  VtdIndex
   );
 
+/**
+  Queue the IOTLB invalidation of a range of DMA addresses.
+
+  @param[in]  VtdIndex          The index used to identify a VTd engine.
+  @param[in]  DomainIdentifier  The domain ID of the translation.
+  @param[in]  BaseAddress       The base of DMA address to be invalidated.
+  @param[in]  Length            The length of DMA address to be invalidated.
+**/
+VOID
+QueueIotlbInvalidation (
+  IN UINTN   VtdIndex,
+  IN UINT16  DomainIdentifier,
+  IN UINT64  BaseAddress,
+  IN UINT64  Length
+  );
+
+/**
+  Discard the queued IOTLB invalidations, they are covered by a global invalidation.
+
+  @param[in]  VtdIndex          The index used to identify a VTd engine.
+**/
+VOID
+DiscardIotlbInvalidation (
+  IN UINTN  VtdIndex
+  );
+
+/**
+  Submit the queued IOTLB invalidations and wait for their completion.
+
+  @param[in]  VtdIndex          The index used to identify a VTd engine.
+
+  @retval EFI_SUCCESS           The queued invalidations are completed.
+  @retval EFI_DEVICE_ERROR      The IOTLB is not invalidated.
+**/
+EFI_STATUS
+FlushIotlbInvalidation (
+  IN UINTN  VtdIndex
+  );
+
+/**
+  Dump the IOTLB invalidation statistics of all VTd engines.
+**/
+VOID
+DumpVtdInvalidationStatistics (
+  VOID
+  );
+
+/**
+  Dump the second level page table usage of all VTd engines.
+**/
+VOID
+DumpVtdPageTableStatistics (
+  VOID
+  );
+
 /**
   Invalid VTd global IOTLB.
 
@@ -449,6 +551,19 @@ DumpDmarExtContextEntryTable (
   IN BOOLEAN Is5LevelPaging
   );
 
+/**
+  Invalid page entry.
+
+  Completes the queued IOTLB invalidations and releases the page table pages
+  which were waiting for them.
+
+  @param VtdIndex  The VTd engine index.
+**/
+VOID
+InvalidatePageEntry (
+  IN UINTN                 VtdIndex
+  );
+
 /**
   Dump DMAR second level paging entry.
 
@@ -7,6 +7,40 @@
 
 #include "DmaProtection.h"
 
+//
+// Cache of the (Segment, SourceId) to VTd engine and PCI data lookup.
+// It only holds successful lookups and is flushed when a device is registered.
+//
+#define VTD_SOURCE_CACHE_SIZE  64
+
+typedef struct {
+  BOOLEAN          Valid;
+  UINT16           Segment;
+  VTD_SOURCE_ID    SourceId;
+  UINTN            VtdIndex;
+  UINTN            PciDataIndex;
+} VTD_SOURCE_CACHE_ENTRY;
+
+STATIC VTD_SOURCE_CACHE_ENTRY  mVtdSourceCache[VTD_SOURCE_CACHE_SIZE];
+
+/**
+  Return the cache entry for the Segment and SourceId.
+
+  @param[in]  Segment           The Segment used to identify a VTd engine.
+  @param[in]  SourceId          The SourceId used to identify a VTd engine and table entry.
+
+  @return The cache entry, which may hold another source.
+**/
+STATIC
+VTD_SOURCE_CACHE_ENTRY *
+GetVtdSourceCacheEntry (
+  IN UINT16         Segment,
+  IN VTD_SOURCE_ID  SourceId
+  )
+{
+  return &mVtdSourceCache[(SourceId.Uint16 ^ (SourceId.Uint16 >> 8) ^ Segment) % VTD_SOURCE_CACHE_SIZE];
+}
+
 /**
   Return the index of PCI data.
 
@@ -24,13 +58,20 @@ GetPciDataIndex (
   IN VTD_SOURCE_ID  SourceId
   )
 {
-  UINTN          Index;
-  VTD_SOURCE_ID  *PciSourceId;
+  UINTN                   Index;
+  VTD_SOURCE_ID           *PciSourceId;
+  VTD_SOURCE_CACHE_ENTRY  *CacheEntry;
 
   if (Segment != mVtdUnitInformation[VtdIndex].Segment) {
     return (UINTN)-1;
   }
 
+  CacheEntry = GetVtdSourceCacheEntry (Segment, SourceId);
+  if (CacheEntry->Valid && (CacheEntry->VtdIndex == VtdIndex) &&
+      (CacheEntry->Segment == Segment) && (CacheEntry->SourceId.Uint16 == SourceId.Uint16)) {
+    return CacheEntry->PciDataIndex;
+  }
+
   for (Index = 0; Index < mVtdUnitInformation[VtdIndex].PciDeviceInfo.PciDeviceDataNumber; Index++) {
     PciSourceId = &mVtdUnitInformation[VtdIndex].PciDeviceInfo.PciDeviceData[Index].PciSourceId;
     if ((PciSourceId->Bits.Bus == SourceId.Bits.Bus) &&
@@ -75,6 +116,11 @@ RegisterPciDevice (
 
   PciDeviceInfo = &mVtdUnitInformation[VtdIndex].PciDeviceInfo;
 
+  //
+  // A new registration may change the result of a cached lookup
+  //
+  ZeroMem (mVtdSourceCache, sizeof (mVtdSourceCache));
+
   if (PciDeviceInfo->IncludeAllFlag) {
     //
     // Do not register device in other VTD Unit
@@ -375,6 +421,56 @@ DumpPciDeviceInfo (
   }
 }
 
+/**
+  Get the context entry of a source in the translation table of a VTd engine.
+
+  @param[in]  VtdIndex          The index used to identify a VTd engine.
+  @param[in]  SourceId          The SourceId used to identify a table entry.
+  @param[out] ExtContextEntry   The ExtContextEntry of the source.
+  @param[out] ContextEntry      The ContextEntry of the source.
+
+  @retval TRUE   The context entry is present.
+  @retval FALSE  The context entry is not present.
+**/
+STATIC
+BOOLEAN
+GetVtdContextEntry (
+  IN  UINTN                   VtdIndex,
+  IN  VTD_SOURCE_ID           SourceId,
+  OUT VTD_EXT_CONTEXT_ENTRY   **ExtContextEntry,
+  OUT VTD_CONTEXT_ENTRY       **ContextEntry
+  )
+{
+  VTD_ROOT_ENTRY          *RootEntry;
+  VTD_CONTEXT_ENTRY       *ContextEntryTable;
+  VTD_CONTEXT_ENTRY       *ThisContextEntry;
+  VTD_EXT_ROOT_ENTRY      *ExtRootEntry;
+  VTD_EXT_CONTEXT_ENTRY   *ExtContextEntryTable;
+  VTD_EXT_CONTEXT_ENTRY   *ThisExtContextEntry;
+
+  if (mVtdUnitInformation[VtdIndex].ExtRootEntryTable != 0) {
+    ExtRootEntry = &mVtdUnitInformation[VtdIndex].ExtRootEntryTable[SourceId.Index.RootIndex];
+    ExtContextEntryTable = (VTD_EXT_CONTEXT_ENTRY *)(UINTN)VTD_64BITS_ADDRESS(ExtRootEntry->Bits.LowerContextTablePointerLo, ExtRootEntry->Bits.LowerContextTablePointerHi) ;
+    ThisExtContextEntry  = &ExtContextEntryTable[SourceId.Index.ContextIndex];
+    if (ThisExtContextEntry->Bits.AddressWidth == 0) {
+      return FALSE;
+    }
+    *ExtContextEntry = ThisExtContextEntry;
+    *ContextEntry    = NULL;
+  } else {
+    RootEntry = &mVtdUnitInformation[VtdIndex].RootEntryTable[SourceId.Index.RootIndex];
+    ContextEntryTable = (VTD_CONTEXT_ENTRY *)(UINTN)VTD_64BITS_ADDRESS(RootEntry->Bits.ContextTablePointerLo, RootEntry->Bits.ContextTablePointerHi) ;
+    ThisContextEntry  = &ContextEntryTable[SourceId.Index.ContextIndex];
+    if (ThisContextEntry->Bits.AddressWidth == 0) {
+      return FALSE;
+    }
+    *ExtContextEntry = NULL;
+    *ContextEntry    = ThisContextEntry;
+  }
+
+  return TRUE;
+}
+
 /**
   Find the VTd index by the Segment and SourceId.
 
@@ -395,13 +491,19 @@ FindVtdIndexByPciDevice (
   )
 {
   UINTN                   VtdIndex;
-  VTD_ROOT_ENTRY          *RootEntry;
-  VTD_CONTEXT_ENTRY       *ContextEntryTable;
-  VTD_CONTEXT_ENTRY       *ThisContextEntry;
-  VTD_EXT_ROOT_ENTRY      *ExtRootEntry;
-  VTD_EXT_CONTEXT_ENTRY   *ExtContextEntryTable;
-  VTD_EXT_CONTEXT_ENTRY   *ThisExtContextEntry;
   UINTN                   PciDataIndex;
+  VTD_SOURCE_CACHE_ENTRY  *CacheEntry;
+
+  //
+  // Try the engine of the last successful lookup for this source first
+  //
+  CacheEntry = GetVtdSourceCacheEntry (Segment, SourceId);
+  if (CacheEntry->Valid && (CacheEntry->Segment == Segment) && (CacheEntry->SourceId.Uint16 == SourceId.Uint16)) {
+    if (GetVtdContextEntry (CacheEntry->VtdIndex, SourceId, ExtContextEntry, ContextEntry)) {
+      return CacheEntry->VtdIndex;
+    }
+    CacheEntry->Valid = FALSE;
+  }
 
   for (VtdIndex = 0; VtdIndex < mVtdUnitNumber; VtdIndex++) {
     if (Segment != mVtdUnitInformation[VtdIndex].Segment) {
@@ -415,26 +517,16 @@ FindVtdIndexByPciDevice (
 
 //    DEBUG ((DEBUG_INFO,"FindVtdIndex(0x%x) for S%04x B%02x D%02x F%02x\n", VtdIndex, Segment, SourceId.Bits.Bus, SourceId.Bits.Device, SourceId.Bits.Function));
 
-    if (mVtdUnitInformation[VtdIndex].ExtRootEntryTable != 0) {
-      ExtRootEntry = &mVtdUnitInformation[VtdIndex].ExtRootEntryTable[SourceId.Index.RootIndex];
-      ExtContextEntryTable = (VTD_EXT_CONTEXT_ENTRY *)(UINTN)VTD_64BITS_ADDRESS(ExtRootEntry->Bits.LowerContextTablePointerLo, ExtRootEntry->Bits.LowerContextTablePointerHi) ;
-      ThisExtContextEntry  = &ExtContextEntryTable[SourceId.Index.ContextIndex];
-      if (ThisExtContextEntry->Bits.AddressWidth == 0) {
-        continue;
-      }
-      *ExtContextEntry = ThisExtContextEntry;
-      *ContextEntry    = NULL;
-    } else {
-      RootEntry = &mVtdUnitInformation[VtdIndex].RootEntryTable[SourceId.Index.RootIndex];
-      ContextEntryTable = (VTD_CONTEXT_ENTRY *)(UINTN)VTD_64BITS_ADDRESS(RootEntry->Bits.ContextTablePointerLo, RootEntry->Bits.ContextTablePointerHi) ;
-      ThisContextEntry  = &ContextEntryTable[SourceId.Index.ContextIndex];
-      if (ThisContextEntry->Bits.AddressWidth == 0) {
-        continue;
-      }
-      *ExtContextEntry = NULL;
-      *ContextEntry    = ThisContextEntry;
+    if (!GetVtdContextEntry (VtdIndex, SourceId, ExtContextEntry, ContextEntry)) {
+      continue;
     }
 
+    CacheEntry->Valid        = TRUE;
+    CacheEntry->Segment      = Segment;
+    CacheEntry->SourceId     = SourceId;
+    CacheEntry->VtdIndex     = VtdIndex;
+    CacheEntry->PciDataIndex = PciDataIndex;
+
     return VtdIndex;
   }
 
@@ -44,6 +44,111 @@ AllocateZeroPages (
   return Addr;
 }
 
+/**
+  Allocate a zero page for a second level page table.
+
+  A page released by a coalesce is reused first. The caller flushes the page.
+
+  @param[in]  VtdIndex  The index of the VTd engine.
+
+  @return the page address.
+  @retval NULL No resource to allocate pages.
+**/
+VOID *
+AllocatePageTablePage (
+  IN UINTN  VtdIndex
+  )
+{
+  VOID                       *Addr;
+  VTD_PAGE_TABLE_STATISTICS  *Statistics;
+
+  Statistics = &mVtdUnitInformation[VtdIndex].PageTableStatistics;
+  Addr = mVtdUnitInformation[VtdIndex].FreePageTableList;
+  if (Addr != NULL) {
+    mVtdUnitInformation[VtdIndex].FreePageTableList = (VOID *)(UINTN)(*(UINT64 *)Addr);
+    ZeroMem (Addr, SIZE_4KB);
+    Statistics->FreeTablePages--;
+  } else {
+    Addr = AllocateZeroPages (1);
+    if (Addr == NULL) {
+      return NULL;
+    }
+  }
+
+  Statistics->TablePages++;
+  if (Statistics->TablePages > Statistics->PeakTablePages) {
+    Statistics->PeakTablePages = Statistics->TablePages;
+  }
+  return Addr;
+}
+
+/**
+  Move the released page table pages to the free list.
+
+  Must only be called once the IOTLB invalidation of their ranges has completed,
+  as the free list link is written into the pages.
+
+  @param[in]  VtdIndex  The index of the VTd engine.
+**/
+VOID
+ReleasePendingPageTables (
+  IN UINTN  VtdIndex
+  )
+{
+  VTD_UNIT_INFORMATION  *VTdUnitInfo;
+  VOID                  *Addr;
+
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+  while (VTdUnitInfo->PendingFreePageTableCount != 0) {
+    Addr = VTdUnitInfo->PendingFreePageTable[--VTdUnitInfo->PendingFreePageTableCount];
+    *(UINT64 *)Addr = (UINT64)(UINTN)VTdUnitInfo->FreePageTableList;
+    VTdUnitInfo->FreePageTableList = Addr;
+    VTdUnitInfo->PageTableStatistics.FreeTablePages++;
+  }
+}
+
+/**
+  Release a second level page table page.
+
+  The hardware may still walk the old table, so the page is left untouched until
+  the queued IOTLB invalidation has completed in InvalidatePageEntry. The
+  invalidation of the range must be queued before the page is released.
+
+  @param[in]  VtdIndex  The index of the VTd engine.
+  @param[in]  Addr      The page address.
+**/
+VOID
+FreePageTablePage (
+  IN UINTN  VtdIndex,
+  IN VOID   *Addr
+  )
+{
+  VTD_UNIT_INFORMATION  *VTdUnitInfo;
+
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+  if (VTdUnitInfo->PendingFreePageTableCount >= VTD_PENDING_FREE_PAGE_TABLE_MAX) {
+    InvalidatePageEntry (VtdIndex);
+  }
+  VTdUnitInfo->PendingFreePageTable[VTdUnitInfo->PendingFreePageTableCount++] = Addr;
+  VTdUnitInfo->PageTableStatistics.TablePages--;
+}
+
+/**
+  Return if the VTd engine supports 1GB second level pages.
+
+  @param[in]  VtdIndex  The index of the VTd engine.
+
+  @retval TRUE   1GB pages are supported.
+  @retval FALSE  1GB pages are not supported.
+**/
+BOOLEAN
+IsSecondLevel1GPageSupported (
+  IN UINTN  VtdIndex
+  )
+{
+  return (BOOLEAN)((mVtdUnitInformation[VtdIndex].CapReg.Bits.SLLPS & BIT1) != 0);
+}
+
 /**
   Set second level paging entry attribute based upon IoMmuAccess.
 
@@ -209,7 +314,7 @@ CreateSecondLevelPagingEntryTable (
   DEBUG ((DEBUG_INFO,"CreateSecondLevelPagingEntryTable: BaseAddress - 0x%016lx, EndAddress - 0x%016lx\n", BaseAddress, EndAddress));
 
   if (SecondLevelPagingEntry == NULL) {
-    SecondLevelPagingEntry = AllocateZeroPages (1);
+    SecondLevelPagingEntry = AllocatePageTablePage (VtdIndex);
     if (SecondLevelPagingEntry == NULL) {
       DEBUG ((DEBUG_ERROR,"Could not Alloc LVL4 or LVL5 PT. \n"));
       return NULL;
@@ -251,7 +356,7 @@ CreateSecondLevelPagingEntryTable (
   for (Index5 = Lvl5Start; Index5 <= Lvl5End; Index5++) {
     if (Is5LevelPaging) {
       if (Lvl5PtEntry[Index5].Uint64 == 0) {
-        Lvl5PtEntry[Index5].Uint64 = (UINT64)(UINTN)AllocateZeroPages (1);
+        Lvl5PtEntry[Index5].Uint64 = (UINT64)(UINTN)AllocatePageTablePage (VtdIndex);
         if (Lvl5PtEntry[Index5].Uint64 == 0) {
           DEBUG ((DEBUG_ERROR,"!!!!!! ALLOCATE LVL4 PAGE FAIL (0x%x)!!!!!!\n", Index5));
           ASSERT(FALSE);
@@ -273,7 +378,7 @@ CreateSecondLevelPagingEntryTable (
 
     for (Index4 = Lvl4Start; Index4 <= Lvl4End; Index4++) {
       if (Lvl4PtEntry[Index4].Uint64 == 0) {
-        Lvl4PtEntry[Index4].Uint64 = (UINT64)(UINTN)AllocateZeroPages (1);
+        Lvl4PtEntry[Index4].Uint64 = (UINT64)(UINTN)AllocatePageTablePage (VtdIndex);
         if (Lvl4PtEntry[Index4].Uint64 == 0) {
           DEBUG ((DEBUG_ERROR,"!!!!!! ALLOCATE LVL4 PAGE FAIL (0x%x)!!!!!!\n", Index4));
           ASSERT(FALSE);
@@ -293,8 +398,22 @@ CreateSecondLevelPagingEntryTable (
 
       Lvl3PtEntry = (VTD_SECOND_LEVEL_PAGING_ENTRY *)(UINTN)VTD_64BITS_ADDRESS(Lvl4PtEntry[Index4].Bits.AddressLo, Lvl4PtEntry[Index4].Bits.AddressHi);
       for (Index3 = Lvl3Start; Index3 <= Lvl3End; Index3++) {
+        if ((Lvl3PtEntry[Index3].Uint64 == 0) && IsSecondLevel1GPageSupported (VtdIndex) &&
+            ((BaseAddress & (SIZE_1GB - 1)) == 0) && (BaseAddress + SIZE_1GB <= EndAddress)) {
+          //
+          // Map the whole 1GB with one entry
+          //
+          Lvl3PtEntry[Index3].Uint64 = BaseAddress;
+          SetSecondLevelPagingEntryAttribute (&Lvl3PtEntry[Index3], IoMmuAccess);
+          Lvl3PtEntry[Index3].Bits.PageSize = 1;
+          BaseAddress += SIZE_1GB;
+          if (BaseAddress >= MemoryLimit) {
+            break;
+          }
+          continue;
+        }
         if (Lvl3PtEntry[Index3].Uint64 == 0) {
-          Lvl3PtEntry[Index3].Uint64 = (UINT64)(UINTN)AllocateZeroPages (1);
+          Lvl3PtEntry[Index3].Uint64 = (UINT64)(UINTN)AllocatePageTablePage (VtdIndex);
           if (Lvl3PtEntry[Index3].Uint64 == 0) {
             DEBUG ((DEBUG_ERROR,"!!!!!! ALLOCATE LVL3 PAGE FAIL (0x%x, 0x%x)!!!!!!\n", Index4, Index3));
             ASSERT(FALSE);
@@ -513,6 +632,12 @@ DumpSecondLevelPagingEntry (
         if (Lvl3PtEntry[Index3].Uint64 == 0) {
           continue;
         }
+        if (Lvl3PtEntry[Index3].Bits.PageSize != 0) {
+          //
+          // 1G page, no lower level table
+          //
+          continue;
+        }
 
         Lvl2PtEntry = (VTD_SECOND_LEVEL_PAGING_ENTRY *)(UINTN)VTD_64BITS_ADDRESS(Lvl3PtEntry[Index3].Bits.AddressLo, Lvl3PtEntry[Index3].Bits.AddressHi);
         for (Index2 = 0; Index2 < SIZE_4KB/sizeof(VTD_SECOND_LEVEL_PAGING_ENTRY); Index2++) {
@@ -547,11 +672,23 @@ InvalidatePageEntry (
   IN UINTN                 VtdIndex
   )
 {
-  if (mVtdUnitInformation[VtdIndex].HasDirtyContext || mVtdUnitInformation[VtdIndex].HasDirtyPages) {
+  if (mVtdUnitInformation[VtdIndex].HasDirtyContext) {
+    //
+    // The global invalidation covers the queued page invalidations
+    //
     InvalidateVtdIOTLBGlobal (VtdIndex);
+    DiscardIotlbInvalidation (VtdIndex);
+  } else if (mVtdUnitInformation[VtdIndex].HasDirtyPages) {
+    FlushWriteBuffer (VtdIndex);
+    FlushIotlbInvalidation (VtdIndex);
   }
   mVtdUnitInformation[VtdIndex].HasDirtyContext = FALSE;
   mVtdUnitInformation[VtdIndex].HasDirtyPages = FALSE;
+
+  //
+  // The hardware no longer walks the released page tables
+  //
+  ReleasePendingPageTables (VtdIndex);
 }
 
 #define VTD_PG_R                   BIT0
@@ -654,7 +791,7 @@ GetSecondLevelPageTableEntry (
   if (Is5LevelPaging) {
     L5PageTable = (UINT64 *)SecondLevelPagingEntry;
     if (L5PageTable[Index5] == 0) {
-      L5PageTable[Index5] = (UINT64)(UINTN)AllocateZeroPages (1);
+      L5PageTable[Index5] = (UINT64)(UINTN)AllocatePageTablePage (VtdIndex);
       if (L5PageTable[Index5] == 0) {
         DEBUG ((DEBUG_ERROR,"!!!!!! ALLOCATE LVL5 PAGE FAIL (0x%x)!!!!!!\n", Index4));
         ASSERT(FALSE);
@@ -671,7 +808,7 @@ GetSecondLevelPageTableEntry (
   }
 
   if (L4PageTable[Index4] == 0) {
-    L4PageTable[Index4] = (UINT64)(UINTN)AllocateZeroPages (1);
+    L4PageTable[Index4] = (UINT64)(UINTN)AllocatePageTablePage (VtdIndex);
     if (L4PageTable[Index4] == 0) {
       DEBUG ((DEBUG_ERROR,"!!!!!! ALLOCATE LVL4 PAGE FAIL (0x%x)!!!!!!\n", Index4));
       ASSERT(FALSE);
@@ -684,8 +821,17 @@ GetSecondLevelPageTableEntry (
   }
 
   L3PageTable = (UINT64 *)(UINTN)(L4PageTable[Index4] & PAGING_4K_ADDRESS_MASK_64);
+  if ((L3PageTable[Index3] == 0) && IsSecondLevel1GPageSupported (VtdIndex)) {
+    //
+    // Start with a not present 1GB page, it is split only when a part of it changes.
+    //
+    L3PageTable[Index3] = Address & PAGING_1G_ADDRESS_MASK_64;
+    SetSecondLevelPagingEntryAttribute ((VTD_SECOND_LEVEL_PAGING_ENTRY *)&L3PageTable[Index3], 0);
+    L3PageTable[Index3] |= VTD_PG_PS;
+    FlushPageTableMemory (VtdIndex, (UINTN)&L3PageTable[Index3], sizeof(L3PageTable[Index3]));
+  }
   if (L3PageTable[Index3] == 0) {
-    L3PageTable[Index3] = (UINT64)(UINTN)AllocateZeroPages (1);
+    L3PageTable[Index3] = (UINT64)(UINTN)AllocatePageTablePage (VtdIndex);
     if (L3PageTable[Index3] == 0) {
       DEBUG ((DEBUG_ERROR,"!!!!!! ALLOCATE LVL3 PAGE FAIL (0x%x, 0x%x)!!!!!!\n", Index4, Index3));
       ASSERT(FALSE);
@@ -820,7 +966,7 @@ SplitSecondLevelPage (
     //
     ASSERT (SplitAttribute == Page4K);
     if (SplitAttribute == Page4K) {
-      NewPageEntry = AllocateZeroPages (1);
+      NewPageEntry = AllocatePageTablePage (VtdIndex);
       DEBUG ((DEBUG_VERBOSE, "Split - 0x%x\n", NewPageEntry));
       if (NewPageEntry == NULL) {
         return RETURN_OUT_OF_RESOURCES;
@@ -834,6 +980,7 @@ SplitSecondLevelPage (
       PageEntry->Uint64 = (UINT64)(UINTN)NewPageEntry;
       SetSecondLevelPagingEntryAttribute (PageEntry, EDKII_IOMMU_ACCESS_READ | EDKII_IOMMU_ACCESS_WRITE);
       FlushPageTableMemory (VtdIndex, (UINTN)PageEntry, sizeof(*PageEntry));
+      mVtdUnitInformation[VtdIndex].PageTableStatistics.SplitCount++;
       return RETURN_SUCCESS;
     } else {
       return RETURN_UNSUPPORTED;
@@ -845,7 +992,7 @@ SplitSecondLevelPage (
     //
     ASSERT (SplitAttribute == Page2M || SplitAttribute == Page4K);
     if ((SplitAttribute == Page2M || SplitAttribute == Page4K)) {
-      NewPageEntry = AllocateZeroPages (1);
+      NewPageEntry = AllocatePageTablePage (VtdIndex);
       DEBUG ((DEBUG_VERBOSE, "Split - 0x%x\n", NewPageEntry));
       if (NewPageEntry == NULL) {
         return RETURN_OUT_OF_RESOURCES;
@@ -859,6 +1006,7 @@ SplitSecondLevelPage (
       PageEntry->Uint64 = (UINT64)(UINTN)NewPageEntry;
       SetSecondLevelPagingEntryAttribute (PageEntry, EDKII_IOMMU_ACCESS_READ | EDKII_IOMMU_ACCESS_WRITE);
       FlushPageTableMemory (VtdIndex, (UINTN)PageEntry, sizeof(*PageEntry));
+      mVtdUnitInformation[VtdIndex].PageTableStatistics.SplitCount++;
       return RETURN_SUCCESS;
     } else {
       return RETURN_UNSUPPORTED;
@@ -868,6 +1016,143 @@ SplitSecondLevelPage (
   }
 }
 
+/**
+  This function returns if all entries of a page table map one contiguous
+  region with the same attributes, so it can be replaced by a large page entry.
+
+  @param[in]  PageTable        The page table.
+  @param[in]  BaseAddress      The base address of the region.
+  @param[in]  EntryLength      The length mapped by each entry.
+  @param[in]  LeafBits         The bits every leaf entry of the table has set.
+
+  @retval TRUE   The page table is uniform.
+  @retval FALSE  The page table is not uniform.
+**/
+BOOLEAN
+IsUniformPageTable (
+  IN UINT64                            *PageTable,
+  IN UINT64                            BaseAddress,
+  IN UINT64                            EntryLength,
+  IN UINT64                            LeafBits
+  )
+{
+  UINT64   Attributes;
+  UINTN    Index;
+
+  Attributes = (PageTable[0] & PAGE_PROGATE_BITS) | LeafBits;
+  for (Index = 0; Index < SIZE_4KB / sizeof(UINT64); Index++) {
+    if (PageTable[Index] != ((BaseAddress + EntryLength * Index) | Attributes)) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+  This function merges the split page tables of an address back into 2M and 1G
+  page entries when the whole region has the same attributes again.
+
+  The released page tables are invalidated with the region and reused by later splits.
+
+  @param[in]  VtdIndex                The index used to identify a VTd engine.
+  @param[in]  DomainIdentifier        The domain ID of the source.
+  @param[in]  SecondLevelPagingEntry  The second level paging entry in VTd table for the device.
+  @param[in]  Address                 The address to be merged.
+**/
+VOID
+CoalesceSecondLevelPage (
+  IN UINTN                         VtdIndex,
+  IN UINT16                        DomainIdentifier,
+  IN VTD_SECOND_LEVEL_PAGING_ENTRY *SecondLevelPagingEntry,
+  IN PHYSICAL_ADDRESS              Address
+  )
+{
+  UINTN                 Index2;
+  UINTN                 Index3;
+  UINTN                 Index4;
+  UINTN                 Index5;
+  UINT64                *L1PageTable;
+  UINT64                *L2PageTable;
+  UINT64                *L3PageTable;
+  UINT64                *L4PageTable;
+  UINT64                *L5PageTable;
+
+  Index5 = ((UINTN)RShiftU64 (Address, 48)) & PAGING_VTD_INDEX_MASK;
+  Index4 = ((UINTN)RShiftU64 (Address, 39)) & PAGING_VTD_INDEX_MASK;
+  Index3 = ((UINTN)Address >> 30) & PAGING_VTD_INDEX_MASK;
+  Index2 = ((UINTN)Address >> 21) & PAGING_VTD_INDEX_MASK;
+
+  if (mVtdUnitInformation[VtdIndex].Is5LevelPaging) {
+    L5PageTable = (UINT64 *)SecondLevelPagingEntry;
+    if (L5PageTable[Index5] == 0) {
+      return ;
+    }
+    L4PageTable = (UINT64 *)(UINTN)(L5PageTable[Index5] & PAGING_4K_ADDRESS_MASK_64);
+  } else {
+    L4PageTable = (UINT64 *)SecondLevelPagingEntry;
+  }
+  if (L4PageTable[Index4] == 0) {
+    return ;
+  }
+  L3PageTable = (UINT64 *)(UINTN)(L4PageTable[Index4] & PAGING_4K_ADDRESS_MASK_64);
+  if ((L3PageTable[Index3] == 0) || ((L3PageTable[Index3] & VTD_PG_PS) != 0)) {
+    return ;
+  }
+
+  //
+  // 4K -> 2M
+  //
+  L2PageTable = (UINT64 *)(UINTN)(L3PageTable[Index3] & PAGING_4K_ADDRESS_MASK_64);
+  if ((L2PageTable[Index2] != 0) && ((L2PageTable[Index2] & VTD_PG_PS) == 0)) {
+    L1PageTable = (UINT64 *)(UINTN)(L2PageTable[Index2] & PAGING_4K_ADDRESS_MASK_64);
+    if (!IsUniformPageTable (L1PageTable, Address & PAGING_2M_ADDRESS_MASK_64, SIZE_4KB, 0)) {
+      return ;
+    }
+    L2PageTable[Index2] = (Address & PAGING_2M_ADDRESS_MASK_64) | (L1PageTable[0] & PAGE_PROGATE_BITS) | VTD_PG_PS;
+    FlushPageTableMemory (VtdIndex, (UINTN)&L2PageTable[Index2], sizeof(L2PageTable[Index2]));
+    QueueIotlbInvalidation (VtdIndex, DomainIdentifier, Address & PAGING_2M_ADDRESS_MASK_64, SIZE_2MB);
+    mVtdUnitInformation[VtdIndex].HasDirtyPages = TRUE;
+    FreePageTablePage (VtdIndex, L1PageTable);
+    mVtdUnitInformation[VtdIndex].PageTableStatistics.CoalesceCount++;
+    DEBUG ((DEBUG_VERBOSE, "Coalesce 2M - 0x%lx\n", Address & PAGING_2M_ADDRESS_MASK_64));
+  }
+
+  //
+  // 2M -> 1G
+  //
+  if (!IsSecondLevel1GPageSupported (VtdIndex)) {
+    return ;
+  }
+  if (!IsUniformPageTable (L2PageTable, Address & PAGING_1G_ADDRESS_MASK_64, SIZE_2MB, VTD_PG_PS)) {
+    return ;
+  }
+  L3PageTable[Index3] = (Address & PAGING_1G_ADDRESS_MASK_64) | (L2PageTable[0] & PAGE_PROGATE_BITS) | VTD_PG_PS;
+  FlushPageTableMemory (VtdIndex, (UINTN)&L3PageTable[Index3], sizeof(L3PageTable[Index3]));
+  QueueIotlbInvalidation (VtdIndex, DomainIdentifier, Address & PAGING_1G_ADDRESS_MASK_64, SIZE_1GB);
+  mVtdUnitInformation[VtdIndex].HasDirtyPages = TRUE;
+  FreePageTablePage (VtdIndex, L2PageTable);
+  mVtdUnitInformation[VtdIndex].PageTableStatistics.CoalesceCount++;
+  DEBUG ((DEBUG_VERBOSE, "Coalesce 1G - 0x%lx\n", Address & PAGING_1G_ADDRESS_MASK_64));
+}
+
+/**
+  Dump the second level page table usage of all VTd engines.
+**/
+VOID
+DumpVtdPageTableStatistics (
+  VOID
+  )
+{
+  UINTN                      Num;
+  VTD_PAGE_TABLE_STATISTICS  *Statistics;
+
+  for (Num = 0; Num < mVtdUnitNumber; Num++) {
+    Statistics = &mVtdUnitInformation[Num].PageTableStatistics;
+    DEBUG ((DEBUG_INFO, "VTd(%d) Page Table - %ld pages (peak %ld), Free - %ld pages\n", Num, Statistics->TablePages, Statistics->PeakTablePages, Statistics->FreeTablePages));
+    DEBUG ((DEBUG_INFO, "        Split - %ld, Coalesce - %ld\n", Statistics->SplitCount, Statistics->CoalesceCount));
+  }
+}
+
 /**
   Set VTd attribute for a system memory on second level page entry
 
@@ -904,6 +1189,12 @@ SetSecondLevelPagingAttribute (
   PAGE_ATTRIBUTE                 SplitAttribute;
   EFI_STATUS                     Status;
   BOOLEAN                        IsEntryModified;
+  UINT64                         CurrentPageEntry;
+  UINT64                         InvalidateBase;
+  UINT64                         InvalidateLength;
+  UINT64                         CoalesceBase;
+  UINT64                         CoalesceEnd;
+  BOOLEAN                        IsModified;
 
   DEBUG ((DEBUG_VERBOSE,"SetSecondLevelPagingAttribute (%d) (0x%016lx - 0x%016lx : %x) \n", VtdIndex, BaseAddress, Length, IoMmuAccess));
   DEBUG ((DEBUG_VERBOSE,"  SecondLevelPagingEntry Base - 0x%x\n", SecondLevelPagingEntry));
@@ -917,18 +1208,46 @@ SetSecondLevelPagingAttribute (
     return EFI_UNSUPPORTED;
   }
 
+  Status           = EFI_SUCCESS;
+  InvalidateBase   = BaseAddress;
+  InvalidateLength = 0;
+  CoalesceBase     = BaseAddress & PAGING_2M_ADDRESS_MASK_64;
+  CoalesceEnd      = BaseAddress + Length;
+  IsModified       = FALSE;
+
   while (Length != 0) {
     PageEntry = GetSecondLevelPageTableEntry (VtdIndex, SecondLevelPagingEntry, BaseAddress, mVtdUnitInformation[VtdIndex].Is5LevelPaging, &PageAttribute);
     if (PageEntry == NULL) {
       DEBUG ((DEBUG_ERROR, "PageEntry - NULL\n"));
-      return RETURN_UNSUPPORTED;
+      Status = RETURN_UNSUPPORTED;
+      break;
     }
     PageEntryLength = PageAttributeToLength (PageAttribute);
     SplitAttribute = NeedSplitPage (BaseAddress, Length, PageAttribute);
     if (SplitAttribute == PageNone) {
+      CurrentPageEntry = PageEntry->Uint64;
       ConvertSecondLevelPageEntryAttribute (VtdIndex, PageEntry, IoMmuAccess, &IsEntryModified);
       if (IsEntryModified) {
+        IsModified = TRUE;
         mVtdUnitInformation[VtdIndex].HasDirtyPages = TRUE;
+        //
+        // Hardware does not cache not-present entries unless Caching Mode is reported,
+        // so only a present entry needs its IOTLB entries invalidated.
+        // Contiguous entries are merged into one invalidation range.
+        //
+        if (((CurrentPageEntry & (VTD_PG_R | VTD_PG_W)) != 0) ||
+            (mVtdUnitInformation[VtdIndex].CapReg.Bits.CM != 0)) {
+          if ((InvalidateLength != 0) && (InvalidateBase + InvalidateLength != BaseAddress)) {
+            QueueIotlbInvalidation (VtdIndex, DomainIdentifier, InvalidateBase, InvalidateLength);
+            InvalidateLength = 0;
+          }
+          if (InvalidateLength == 0) {
+            InvalidateBase = BaseAddress;
+          }
+          InvalidateLength += PageEntryLength;
+        } else {
+          mVtdUnitInformation[VtdIndex].InvalidationStatistics.InvalidationCoalesced += PageEntryLength / SIZE_4KB;
+        }
       }
       //
       // Convert success, move to next
@@ -939,7 +1258,8 @@ SetSecondLevelPagingAttribute (
       Status = SplitSecondLevelPage (VtdIndex, PageEntry, PageAttribute, SplitAttribute);
       if (RETURN_ERROR (Status)) {
         DEBUG ((DEBUG_ERROR, "SplitSecondLevelPage - %r\n", Status));
-        return RETURN_UNSUPPORTED;
+        Status = RETURN_UNSUPPORTED;
+        break;
       }
       mVtdUnitInformation[VtdIndex].HasDirtyPages = TRUE;
       //
@@ -949,7 +1269,20 @@ SetSecondLevelPagingAttribute (
     }
   }
 
-  return EFI_SUCCESS;
+  if (InvalidateLength != 0) {
+    QueueIotlbInvalidation (VtdIndex, DomainIdentifier, InvalidateBase, InvalidateLength);
+  }
+
+  //
+  // Merge the regions whose pages have the same attributes again
+  //
+  if (!EFI_ERROR (Status) && IsModified) {
+    for (; CoalesceBase < CoalesceEnd; CoalesceBase += SIZE_2MB) {
+      CoalesceSecondLevelPage (VtdIndex, DomainIdentifier, SecondLevelPagingEntry, CoalesceBase);
+    }
+  }
+
+  return Status;
 }
 
 /**
@@ -1039,6 +1372,7 @@ SetAccessAttribute (
 
   PciDataIndex = GetPciDataIndex (VtdIndex, Segment, SourceId);
   mVtdUnitInformation[VtdIndex].PciDeviceInfo.PciDeviceData[PciDataIndex].AccessCount++;
+  mVtdUnitInformation[VtdIndex].InvalidationStatistics.MapCount++;
   //
   // DomainId should not be 0.
   //
@@ -208,38 +208,44 @@ QueuedInvalidationCheckFault (
 }
 
 /**
-  Submit the queued invalidation descriptor to the remapping
-   hardware unit and wait for its completion.
+  Submit a batch of queued invalidation descriptors to the remapping hardware
+  unit followed by a single invalidation wait descriptor, and wait for the
+  completion of the whole batch.
 
   @param[in]  VtdIndex          The index used to identify a VTd engine.
-  @param[in]  Desc              The invalidate descriptor
+  @param[in]  Desc              The invalidate descriptors.
+  @param[in]  Count             The number of descriptors in Desc.
 
   @retval EFI_SUCCESS           The operation was successful.
   @retval RETURN_DEVICE_ERROR   A fault is detected.
   @retval EFI_INVALID_PARAMETER Parameter is invalid.
 **/
 EFI_STATUS
-SubmitQueuedInvalidationDescriptor (
+SubmitQueuedInvalidationDescriptors (
   IN UINTN        VtdIndex,
-  IN QI_256_DESC  *Desc
+  IN QI_256_DESC  *Desc,
+  IN UINTN        Count
   )
 {
-  EFI_STATUS     Status;
-  UINTN          VtdUnitBaseAddress;
-  UINTN          QueueSize;
-  UINTN          QueueTail;
-  UINTN          QueueHead;
-  QI_DESC        *Qi128Desc;
-  QI_256_DESC    *Qi256Desc;
-  VTD_IQA_REG    IqaReg;
-  VTD_IQT_REG    IqtReg;
-  VTD_IQH_REG    IqhReg;
-
-  if (Desc == NULL) {
+  EFI_STATUS            Status;
+  VTD_UNIT_INFORMATION  *VTdUnitInfo;
+  UINTN                 VtdUnitBaseAddress;
+  UINTN                 QueueSize;
+  UINTN                 QueueTail;
+  UINTN                 Index;
+  QI_DESC               *Qi128Desc;
+  QI_256_DESC           *Qi256Desc;
+  QI_256_DESC           WaitDesc;
+  QI_256_DESC           *CurrentDesc;
+  VTD_IQA_REG           IqaReg;
+  VTD_IQT_REG           IqtReg;
+
+  if ((Desc == NULL) || (Count == 0)) {
     return EFI_INVALID_PARAMETER;
   }
 
-  VtdUnitBaseAddress = mVtdUnitInformation[VtdIndex].VtdUnitBaseAddress;
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+  VtdUnitBaseAddress = VTdUnitInfo->VtdUnitBaseAddress;
   IqaReg.Uint64 = MmioRead64 (VtdUnitBaseAddress + R_IQA_REG);
   if (IqaReg.Bits.IQA == 0) {
     DEBUG ((DEBUG_ERROR,"Invalidation Queue Buffer not ready [0x%lx]\n", IqaReg.Uint64));
@@ -248,48 +254,76 @@ SubmitQueuedInvalidationDescriptor (
   IqtReg.Uint64 = MmioRead64 (VtdUnitBaseAddress + R_IQT_REG);
 
   if (IqaReg.Bits.DW == 0) {
-    //
-    // 128-bit descriptor
-    //
     QueueSize = (UINTN) (1 << (IqaReg.Bits.QS + 8));
-    Qi128Desc = (QI_DESC *) (UINTN) (IqaReg.Bits.IQA << VTD_PAGE_SHIFT);
     QueueTail = (UINTN) IqtReg.Bits128Desc.QT;
-    Qi128Desc += QueueTail;
-    Qi128Desc->Low = Desc->Uint64[0];
-    Qi128Desc->High = Desc->Uint64[1];
-    FlushPageTableMemory (VtdIndex, (UINTN) Qi128Desc, sizeof(QI_DESC));
-    QueueTail = (QueueTail + 1) % QueueSize;
-
-    DEBUG ((DEBUG_VERBOSE, "[0x%x] Submit QI Descriptor 0x%x [0x%016lx, 0x%016lx]\n",
-            VtdUnitBaseAddress,
-            QueueTail,
-            Desc->Uint64[0],
-            Desc->Uint64[1]));
-
-    IqtReg.Bits128Desc.QT = QueueTail;
   } else {
-    //
-    // 256-bit descriptor
-    //
     QueueSize = (UINTN) (1 << (IqaReg.Bits.QS + 7));
-    Qi256Desc = (QI_256_DESC *) (UINTN) (IqaReg.Bits.IQA << VTD_PAGE_SHIFT);
     QueueTail = (UINTN) IqtReg.Bits256Desc.QT;
-    Qi256Desc += QueueTail;
-    Qi256Desc->Uint64[0] = Desc->Uint64[0];
-    Qi256Desc->Uint64[1] = Desc->Uint64[1];
-    Qi256Desc->Uint64[2] = Desc->Uint64[2];
-    Qi256Desc->Uint64[3] = Desc->Uint64[3];
-    FlushPageTableMemory (VtdIndex, (UINTN) Qi256Desc, sizeof(QI_256_DESC));
-    QueueTail = (QueueTail + 1) % QueueSize;
+  }
+
+  //
+  // The queue is drained after each batch, keep one free slot so that
+  // the tail never catches up with the head.
+  //
+  if (Count + 1 >= QueueSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Invalidation wait descriptor, the hardware writes the status data once
+  // all the descriptors submitted before it have completed.
+  //
+  VTdUnitInfo->QiWaitStatus = 0;
+  WaitDesc.Uint64[0] = QI_IWD_TYPE | QI_IWD_STATUS_WRITE | QI_IWD_STATUS_DATA (1);
+  WaitDesc.Uint64[1] = (UINT64) (UINTN) &VTdUnitInfo->QiWaitStatus;
+  WaitDesc.Uint64[2] = 0;
+  WaitDesc.Uint64[3] = 0;
+
+  for (Index = 0; Index <= Count; Index++) {
+    CurrentDesc = (Index < Count) ? &Desc[Index] : &WaitDesc;
 
-    DEBUG ((DEBUG_VERBOSE, "[0x%x] Submit QI Descriptor 0x%x [0x%016lx, 0x%016lx, 0x%016lx, 0x%016lx]\n",
-            VtdUnitBaseAddress,
-            QueueTail,
-            Desc->Uint64[0],
-            Desc->Uint64[1],
-            Desc->Uint64[2],
-            Desc->Uint64[3]));
+    if (IqaReg.Bits.DW == 0) {
+      //
+      // 128-bit descriptor
+      //
+      Qi128Desc = (QI_DESC *) (UINTN) (IqaReg.Bits.IQA << VTD_PAGE_SHIFT);
+      Qi128Desc += QueueTail;
+      Qi128Desc->Low = CurrentDesc->Uint64[0];
+      Qi128Desc->High = CurrentDesc->Uint64[1];
+      FlushPageTableMemory (VtdIndex, (UINTN) Qi128Desc, sizeof(QI_DESC));
+
+      DEBUG ((DEBUG_VERBOSE, "[0x%x] Submit QI Descriptor 0x%x [0x%016lx, 0x%016lx]\n",
+              VtdUnitBaseAddress,
+              QueueTail,
+              CurrentDesc->Uint64[0],
+              CurrentDesc->Uint64[1]));
+    } else {
+      //
+      // 256-bit descriptor
+      //
+      Qi256Desc = (QI_256_DESC *) (UINTN) (IqaReg.Bits.IQA << VTD_PAGE_SHIFT);
+      Qi256Desc += QueueTail;
+      Qi256Desc->Uint64[0] = CurrentDesc->Uint64[0];
+      Qi256Desc->Uint64[1] = CurrentDesc->Uint64[1];
+      Qi256Desc->Uint64[2] = CurrentDesc->Uint64[2];
+      Qi256Desc->Uint64[3] = CurrentDesc->Uint64[3];
+      FlushPageTableMemory (VtdIndex, (UINTN) Qi256Desc, sizeof(QI_256_DESC));
+
+      DEBUG ((DEBUG_VERBOSE, "[0x%x] Submit QI Descriptor 0x%x [0x%016lx, 0x%016lx, 0x%016lx, 0x%016lx]\n",
+              VtdUnitBaseAddress,
+              QueueTail,
+              CurrentDesc->Uint64[0],
+              CurrentDesc->Uint64[1],
+              CurrentDesc->Uint64[2],
+              CurrentDesc->Uint64[3]));
+    }
+
+    QueueTail = (QueueTail + 1) % QueueSize;
+  }
 
+  if (IqaReg.Bits.DW == 0) {
+    IqtReg.Bits128Desc.QT = QueueTail;
+  } else {
     IqtReg.Bits256Desc.QT = QueueTail;
   }
 
@@ -298,25 +332,42 @@ SubmitQueuedInvalidationDescriptor (
   //
   MmioWrite64 (VtdUnitBaseAddress + R_IQT_REG, IqtReg.Uint64);
 
+  VTdUnitInfo->InvalidationStatistics.WaitCount++;
+
   Status = EFI_SUCCESS;
-  do {
+  while (VTdUnitInfo->QiWaitStatus == 0) {
     Status = QueuedInvalidationCheckFault(VtdIndex);
     if (Status != EFI_SUCCESS) {
       DEBUG((DEBUG_ERROR,"Detect Queued Invalidation Fault.\n"));
       break;
     }
 
-    IqhReg.Uint64 = MmioRead64 (VtdUnitBaseAddress + R_IQH_REG);
-    if (IqaReg.Bits.DW == 0) {
-      QueueHead = (UINTN) IqhReg.Bits128Desc.QH;
-    } else {
-      QueueHead = (UINTN) IqhReg.Bits256Desc.QH;
-    }
-  } while (QueueTail != QueueHead);
+    CpuPause ();
+  }
 
   return Status;
 }
 
+/**
+  Submit the queued invalidation descriptor to the remapping
+   hardware unit and wait for its completion.
+
+  @param[in]  VtdIndex          The index used to identify a VTd engine.
+  @param[in]  Desc              The invalidate descriptor
+
+  @retval EFI_SUCCESS           The operation was successful.
+  @retval RETURN_DEVICE_ERROR   A fault is detected.
+  @retval EFI_INVALID_PARAMETER Parameter is invalid.
+**/
+EFI_STATUS
+SubmitQueuedInvalidationDescriptor (
+  IN UINTN        VtdIndex,
+  IN QI_256_DESC  *Desc
+  )
+{
+  return SubmitQueuedInvalidationDescriptors (VtdIndex, Desc, 1);
+}
+
 /**
   Invalidate VTd context cache.
 
@@ -406,6 +457,174 @@ InvalidateIOTLB (
   return EFI_SUCCESS;
 }
 
+/**
+  Queue the IOTLB invalidation of a range of DMA addresses.
+
+  The range is split into naturally aligned page-selective invalidations. When the
+  batch is full it is escalated to a domain-selective or global invalidation by
+  FlushIotlbInvalidation.
+
+  @param[in]  VtdIndex          The index used to identify a VTd engine.
+  @param[in]  DomainIdentifier  The domain ID of the translation.
+  @param[in]  BaseAddress       The base of DMA address to be invalidated.
+  @param[in]  Length            The length of DMA address to be invalidated.
+**/
+VOID
+QueueIotlbInvalidation (
+  IN UINTN   VtdIndex,
+  IN UINT16  DomainIdentifier,
+  IN UINT64  BaseAddress,
+  IN UINT64  Length
+  )
+{
+  VTD_UNIT_INFORMATION    *VTdUnitInfo;
+  VTD_IOTLB_INVALIDATION  *Pending;
+  UINT64                  PageNumber;
+  UINT64                  PageCount;
+  UINTN                   AddressMask;
+
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+
+  if (VTdUnitInfo->PendingIotlbCount == 0 && !VTdUnitInfo->PendingIotlbOverflow) {
+    VTdUnitInfo->PendingIotlbDomain = DomainIdentifier;
+  } else if (VTdUnitInfo->PendingIotlbDomain != DomainIdentifier) {
+    VTdUnitInfo->PendingIotlbMultiDomain = TRUE;
+  }
+
+  PageNumber = RShiftU64 (BaseAddress, VTD_PAGE_SHIFT);
+  PageCount  = RShiftU64 (ALIGN_VALUE_UP (BaseAddress + Length, SIZE_4KB) - BaseAddress, VTD_PAGE_SHIFT);
+  VTdUnitInfo->PendingIotlbPages += PageCount;
+
+  while (PageCount != 0 && !VTdUnitInfo->PendingIotlbOverflow) {
+    //
+    // The largest naturally aligned block at PageNumber that fits in the range
+    //
+    AddressMask = (UINTN)HighBitSet64 (PageCount);
+    if (PageNumber != 0) {
+      AddressMask = MIN (AddressMask, (UINTN)LowBitSet64 (PageNumber));
+    }
+    AddressMask = MIN (AddressMask, (UINTN)VTdUnitInfo->CapReg.Bits.MAMV);
+
+    if (VTdUnitInfo->PendingIotlbCount >= VTD_IOTLB_INVALIDATION_BATCH_SIZE) {
+      VTdUnitInfo->PendingIotlbOverflow = TRUE;
+      break;
+    }
+
+    Pending = &VTdUnitInfo->PendingIotlb[VTdUnitInfo->PendingIotlbCount++];
+    Pending->DomainIdentifier = DomainIdentifier;
+    Pending->Address          = LShiftU64 (PageNumber, VTD_PAGE_SHIFT);
+    Pending->AddressMask      = (UINT8)AddressMask;
+
+    PageNumber += LShiftU64 (1, AddressMask);
+    PageCount  -= LShiftU64 (1, AddressMask);
+  }
+}
+
+/**
+  Discard the queued IOTLB invalidations, they are covered by a global invalidation.
+
+  @param[in]  VtdIndex          The index used to identify a VTd engine.
+**/
+VOID
+DiscardIotlbInvalidation (
+  IN UINTN  VtdIndex
+  )
+{
+  VTD_UNIT_INFORMATION  *VTdUnitInfo;
+
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+
+  VTdUnitInfo->InvalidationStatistics.InvalidationCoalesced += VTdUnitInfo->PendingIotlbPages;
+  VTdUnitInfo->PendingIotlbCount       = 0;
+  VTdUnitInfo->PendingIotlbPages       = 0;
+  VTdUnitInfo->PendingIotlbOverflow    = FALSE;
+  VTdUnitInfo->PendingIotlbMultiDomain = FALSE;
+}
+
+/**
+  Submit the queued IOTLB invalidations and wait for their completion.
+
+  The page-selective invalidations are submitted together and completed by a single
+  invalidation wait descriptor. A batch which overflowed is replaced by one
+  domain-selective invalidation, or a global one if it spans several domains.
+  Hardware without queued or page-selective invalidation support gets a global
+  IOTLB invalidation.
+
+  @param[in]  VtdIndex          The index used to identify a VTd engine.
+
+  @retval EFI_SUCCESS           The queued invalidations are completed.
+  @retval EFI_DEVICE_ERROR      The IOTLB is not invalidated.
+**/
+EFI_STATUS
+FlushIotlbInvalidation (
+  IN UINTN  VtdIndex
+  )
+{
+  EFI_STATUS              Status;
+  VTD_UNIT_INFORMATION    *VTdUnitInfo;
+  VTD_IOTLB_INVALIDATION  *Pending;
+  QI_256_DESC             QiDesc[VTD_IOTLB_INVALIDATION_BATCH_SIZE];
+  UINT64                  Drain;
+  UINTN                   Count;
+  UINTN                   Index;
+
+  VTdUnitInfo = &mVtdUnitInformation[VtdIndex];
+
+  if (VTdUnitInfo->PendingIotlbCount == 0 && !VTdUnitInfo->PendingIotlbOverflow) {
+    return EFI_SUCCESS;
+  }
+
+  if (!mVtdEnabled) {
+    //
+    // EnableDmar () invalidates everything
+    //
+    DiscardIotlbInvalidation (VtdIndex);
+    return EFI_SUCCESS;
+  }
+
+  if (VTdUnitInfo->EnableQueuedInvalidation == 0 || VTdUnitInfo->CapReg.Bits.PSI == 0 ||
+      (VTdUnitInfo->PendingIotlbOverflow && VTdUnitInfo->PendingIotlbMultiDomain)) {
+    VTdUnitInfo->InvalidationStatistics.GlobalEscalation++;
+    VTdUnitInfo->InvalidationStatistics.InvalidationIssued++;
+    DiscardIotlbInvalidation (VtdIndex);
+    return InvalidateIOTLB (VtdIndex);
+  }
+
+  Drain = QI_IOTLB_DR (CAP_READ_DRAIN (VTdUnitInfo->CapReg.Uint64)) | QI_IOTLB_DW (CAP_WRITE_DRAIN (VTdUnitInfo->CapReg.Uint64));
+  ZeroMem (QiDesc, sizeof (QiDesc));
+
+  if (VTdUnitInfo->PendingIotlbOverflow) {
+    //
+    // Domain-selective invalidation
+    //
+    QiDesc[0].Uint64[0] = QI_IOTLB_DID (VTdUnitInfo->PendingIotlbDomain) | Drain | QI_IOTLB_GRAN (2) | QI_IOTLB_TYPE;
+    Count = 1;
+    VTdUnitInfo->InvalidationStatistics.DomainEscalation++;
+  } else {
+    //
+    // Page-selective-within-domain invalidations
+    //
+    for (Index = 0; Index < VTdUnitInfo->PendingIotlbCount; Index++) {
+      Pending = &VTdUnitInfo->PendingIotlb[Index];
+      QiDesc[Index].Uint64[0] = QI_IOTLB_DID (Pending->DomainIdentifier) | Drain | QI_IOTLB_GRAN (3) | QI_IOTLB_TYPE;
+      QiDesc[Index].Uint64[1] = QI_IOTLB_ADDR (Pending->Address) | QI_IOTLB_IH (0) | QI_IOTLB_AM (Pending->AddressMask);
+    }
+    Count = VTdUnitInfo->PendingIotlbCount;
+  }
+
+  VTdUnitInfo->InvalidationStatistics.InvalidationIssued    += Count;
+  VTdUnitInfo->InvalidationStatistics.InvalidationCoalesced += VTdUnitInfo->PendingIotlbPages - Count;
+  VTdUnitInfo->PendingIotlbPages = 0;
+  DiscardIotlbInvalidation (VtdIndex);
+
+  Status = SubmitQueuedInvalidationDescriptors (VtdIndex, QiDesc, Count);
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Invalid VTd global IOTLB.
 
@@ -946,6 +1165,24 @@ DumpVtdRegsAll (
   }
 }
 
+/**
+  Dump the IOTLB invalidation statistics of all VTd engines.
+**/
+VOID
+DumpVtdInvalidationStatistics (
+  VOID
+  )
+{
+  UINTN                        Num;
+  VTD_INVALIDATION_STATISTICS  *Statistics;
+
+  for (Num = 0; Num < mVtdUnitNumber; Num++) {
+    Statistics = &mVtdUnitInformation[Num].InvalidationStatistics;
+    DEBUG ((DEBUG_INFO, "VTd(%d) Map - %ld, Invalidation Issued - %ld, Coalesced - %ld\n", Num, Statistics->MapCount, Statistics->InvalidationIssued, Statistics->InvalidationCoalesced));
+    DEBUG ((DEBUG_INFO, "        Wait - %ld, Domain Escalation - %ld, Global Escalation - %ld\n", Statistics->WaitCount, Statistics->DomainEscalation, Statistics->GlobalEscalation));
+  }
+}
+
 /**
   Dump VTd registers if there is error.
 **/
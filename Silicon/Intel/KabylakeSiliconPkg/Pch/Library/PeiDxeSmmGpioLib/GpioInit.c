@@ -158,6 +158,36 @@ GpioDwRegValueFromGpioConfig (
   DwRegsValues[DwNum].PadsToLockTx |= ((GpioConfig->LockConfig >> 0x2) & 0x1) << PadBitPosition;
 }
 
+/**
+  Read-modify-write a GPIO register, skipping the write if the value is unchanged.
+
+  @param[in] Address            PCR address of the register
+  @param[in] AndData            Value ANDed with the current register value
+  @param[in] OrData             Value ORed with the result of the AND
+
+  @retval TRUE                  The register was written
+  @retval FALSE                 The register already held the value
+**/
+STATIC
+BOOLEAN
+GpioMmioAndThenOr32IfChanged (
+  IN UINTN                     Address,
+  IN UINT32                    AndData,
+  IN UINT32                    OrData
+  )
+{
+  UINT32  Value;
+  UINT32  NewValue;
+
+  Value    = MmioRead32 (Address);
+  NewValue = (Value & AndData) | OrData;
+  if (NewValue == Value) {
+    return FALSE;
+  }
+  MmioWrite32 (Address, NewValue);
+  return TRUE;
+}
+
 /**
   This SKL PCH specific procedure will initialize multiple SKL PCH GPIO pins
 
@@ -190,6 +220,7 @@ GpioConfigureSklPch (
   UINT32               GroupIndex;
   UINT32               PadNumber;
   PCH_SERIES           PchSeries;
+  UINT32               PadCount;
 
   PchSeries = GetPchSeries ();
   PadOwnVal = GpioPadOwnHost;
@@ -199,8 +230,12 @@ GpioConfigureSklPch (
   GpioGroupOffset = GpioGetLowestGroup ();
   NumberOfGroups = GpioGetNumberOfGroups ();
 
-  Index = 0;
-  while (Index < NumberOfItems) {
+  //
+  // Validate the whole table first. Pads are then programmed one group at a time,
+  // so the registers shared by a group are accessed once even when the pads of
+  // the group are scattered in the table.
+  //
+  for (Index = 0; Index < NumberOfItems; Index++) {
 
     GpioData   = &GpioInitTableAddress[Index];
     Group      = GpioGetGroupFromGpioPad (GpioData->GpioPad);
@@ -229,27 +264,31 @@ GpioConfigureSklPch (
       return EFI_INVALID_PARAMETER;
     }
 
+    //
+    // Check if legal pin number
+    //
+    if (PadNumber >= GpioGroupInfo[GroupIndex].PadPerGroup) {
+      DEBUG ((DEBUG_ERROR, "GPIO ERROR: Pin number (%d) exceeds possible range for group %d\n", PadNumber, GroupIndex));
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  for (GroupIndex = 0; GroupIndex < GpioGroupInfoLength; GroupIndex++) {
+
+    PadCount = 0;
     ZeroMem (DwRegsValues, sizeof (DwRegsValues));
     //
-    // Loop through pads for one group. If pad belongs to a different group then
-    // break and move to register programming.
+    // Loop through the pads of this group, wherever they are in the table
     //
-    while (Index < NumberOfItems) {
+    for (Index = 0; Index < NumberOfItems; Index++) {
 
       GpioData   = &GpioInitTableAddress[Index];
       if (GroupIndex != GpioGetGroupIndexFromGpioPad (GpioData->GpioPad)) {
-        //if next pad is from different group then break loop
-        break;
+        continue;
       }
 
       PadNumber  = GpioGetPadNumberFromGpioPad (GpioData->GpioPad);
-      //
-      // Check if legal pin number
-      //
-      if (PadNumber >= GpioGroupInfo[GroupIndex].PadPerGroup) {
-        DEBUG ((DEBUG_ERROR, "GPIO ERROR: Pin number (%d) exceeds possible range for group %d\n", PadNumber, GroupIndex));
-        return EFI_INVALID_PARAMETER;
-      }
+      PadCount++;
 
       DEBUG_CODE_BEGIN ();
       //
@@ -261,8 +300,6 @@ GpioConfigureSklPch (
         DEBUG ((DEBUG_ERROR, "GPIO ERROR: Accessing pad not owned by host (Group=%d, Pad=%d)!\n", GroupIndex, PadNumber));
         DEBUG ((DEBUG_ERROR, "** Please make sure the GPIO usage in sync between CSME and BIOS configuration. \n"));
         DEBUG ((DEBUG_ERROR, "** All the GPIO occupied by CSME should not do any configuration by BIOS.\n"));
-        //Move to next item
-        Index++;
         continue;
       }
       DEBUG_CODE_END ();
@@ -293,7 +330,7 @@ GpioConfigureSklPch (
       //
       // Write PADCFG DW0 register
       //
-      MmioAndThenOr32 (
+      GpioMmioAndThenOr32IfChanged (
         PCH_PCR_ADDRESS (GpioGroupInfo[GroupIndex].Community, PadCfgReg),
         ~PadCfgDwRegMask[0],
         PadCfgDwReg[0]
@@ -302,7 +339,7 @@ GpioConfigureSklPch (
       //
       // Write PADCFG DW1 register
       //
-      MmioAndThenOr32 (
+      GpioMmioAndThenOr32IfChanged (
         PCH_PCR_ADDRESS (GpioGroupInfo[GroupIndex].Community, PadCfgReg + 0x4),
         ~PadCfgDwRegMask[1],
         PadCfgDwReg[1]
@@ -316,9 +353,10 @@ GpioConfigureSklPch (
         &GpioData->GpioConfig,
         DwRegsValues
         );
+    }
 
-      //Move to next item
-      Index++;
+    if (PadCount == 0) {
+      continue;
     }
 
     for (DwNum = 0; DwNum <= GPIO_GET_DW_NUM (GpioGroupInfo[GroupIndex].PadPerGroup); DwNum++) {
@@ -326,7 +364,7 @@ GpioConfigureSklPch (
       // Write HOSTSW_OWN registers
       //
       if (GpioGroupInfo[GroupIndex].HostOwnOffset != NO_REGISTER_FOR_PROPERTY) {
-        MmioAndThenOr32 (
+        GpioMmioAndThenOr32IfChanged (
           PCH_PCR_ADDRESS (GpioGroupInfo[GroupIndex].Community, GpioGroupInfo[GroupIndex].HostOwnOffset + DwNum * 0x4),
           ~DwRegsValues[DwNum].HostSoftOwnRegMask,
           DwRegsValues[DwNum].HostSoftOwnReg
@@ -337,7 +375,7 @@ GpioConfigureSklPch (
       // Write GPI_GPE_EN registers
       //
       if (GpioGroupInfo[GroupIndex].GpiGpeEnOffset != NO_REGISTER_FOR_PROPERTY) {
-        MmioAndThenOr32 (
+        GpioMmioAndThenOr32IfChanged (
           PCH_PCR_ADDRESS (GpioGroupInfo[GroupIndex].Community, GpioGroupInfo[GroupIndex].GpiGpeEnOffset + DwNum * 0x4),
           ~DwRegsValues[DwNum].GpiGpeEnRegMask,
           DwRegsValues[DwNum].GpiGpeEnReg
@@ -348,7 +386,7 @@ GpioConfigureSklPch (
       // Write GPI_NMI_EN registers
       //
       if (GpioGroupInfo[GroupIndex].NmiEnOffset != NO_REGISTER_FOR_PROPERTY) {
-        MmioAndThenOr32 (
+        GpioMmioAndThenOr32IfChanged (
           PCH_PCR_ADDRESS (GpioGroupInfo[GroupIndex].Community, GpioGroupInfo[GroupIndex].NmiEnOffset + DwNum * 0x4),
           ~DwRegsValues[DwNum].GpiNmiEnRegMask,
           DwRegsValues[DwNum].GpiNmiEnReg
@@ -0,0 +1,46 @@
+/** @file
+  Definitions of the PCH SMM dispatch statistics SMM communicate interface.
+
+  The PCH SMI dispatcher registers an SMI handler for gPchSmmDispatchStatisticsGuid.
+  A caller places PCH_SMM_DISPATCH_STATISTICS_COMMUNICATE in the data area of an
+  EFI_SMM_COMMUNICATE_HEADER to read or reset the per source dispatch counters
+  and the SMM residency time spent in the dispatcher.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#ifndef _PCH_SMM_DISPATCH_STATISTICS_H_
+#define _PCH_SMM_DISPATCH_STATISTICS_H_
+
+extern EFI_GUID gPchSmmDispatchStatisticsGuid;
+
+///
+/// Statistics are kept per ACPI SMI_STS bit. The last slot collects the sources
+/// that are not gated by a SMI_STS bit.
+///
+#define PCH_SMM_SMI_STS_SOURCE_OTHER                 32
+#define PCH_SMM_SMI_STS_SOURCE_MAX                   33
+
+#define PCH_SMM_DISPATCH_STATISTICS_FUNCTION_GET     1
+#define PCH_SMM_DISPATCH_STATISTICS_FUNCTION_RESET   2
+
+typedef struct {
+  UINT64                      DispatchCount;      ///< Number of child callbacks dispatched for this source
+  UINT64                      DispatchTicks;      ///< TSC ticks spent in those callbacks
+} PCH_SMM_SOURCE_STATISTICS;
+
+typedef struct {
+  UINT64                      SmiCount;           ///< Number of times the dispatcher was entered
+  UINT64                      UnclaimedCount;     ///< Dispatcher passes that found no active source
+  UINT64                      ResidencyTicks;     ///< TSC ticks spent in the dispatcher
+  UINT64                      MaxResidencyTicks;  ///< Longest single dispatcher run in TSC ticks
+  PCH_SMM_SOURCE_STATISTICS   Source[PCH_SMM_SMI_STS_SOURCE_MAX];
+} PCH_SMM_DISPATCH_STATISTICS;
+
+typedef struct {
+  UINT64                      Function;           ///< PCH_SMM_DISPATCH_STATISTICS_FUNCTION_*
+  UINT64                      ReturnStatus;       ///< EFI_STATUS of the request
+  PCH_SMM_DISPATCH_STATISTICS Statistics;         ///< Filled for PCH_SMM_DISPATCH_STATISTICS_FUNCTION_GET
+} PCH_SMM_DISPATCH_STATISTICS_COMMUNICATE;
+
+#endif
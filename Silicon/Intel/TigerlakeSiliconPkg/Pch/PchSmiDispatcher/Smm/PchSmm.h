@@ -44,6 +44,7 @@
 #include <Protocol/PchEspiSmiDispatch.h>
 #include <Protocol/IoTrapExDispatch.h>
 #include <Library/PmcLib.h>
+#include <Guid/PchSmmDispatchStatistics.h>
 #include "IoTrap.h"
 
 #define EFI_BAD_POINTER          0xAFAFAFAFAFAFAFAFULL
@@ -426,6 +427,15 @@ struct _DATABASE_RECORD {
   LIST_ENTRY                    Link;
   BOOLEAN                       Processed;
   ///
+  /// Link in the per SMI_STS bit source index, see PRIVATE_DATA.SourceIndex
+  ///
+  LIST_ENTRY                    SourceLink;
+  UINTN                         SourceIndex;
+  ///
+  /// Registration order, keeps dispatch priority equal to CallbackDataBase order
+  ///
+  UINTN                         Sequence;
+  ///
   /// Status and Enable bit description
   ///
   PCH_SMM_SOURCE_DESC           SrcDesc;
@@ -468,6 +478,7 @@ struct _DATABASE_RECORD {
 };
 
 #define DATABASE_RECORD_FROM_LINK(_record)  CR (_record, DATABASE_RECORD, Link, DATABASE_RECORD_SIGNATURE)
+#define DATABASE_RECORD_FROM_SOURCE_LINK(_record)  CR (_record, DATABASE_RECORD, SourceLink, DATABASE_RECORD_SIGNATURE)
 #define DATABASE_RECORD_FROM_CHILDCONTEXT(_record)  CR (_record, DATABASE_RECORD, ChildContext, DATABASE_RECORD_SIGNATURE)
 
 ///
@@ -601,6 +612,14 @@ typedef struct {
   EFI_HANDLE                  SmiHandle;
   EFI_HANDLE                  InstallMultProtHandle;
   PCH_SMM_QUALIFIED_PROTOCOL  Protocols[PCH_SMM_PROTOCOL_TYPE_MAX];
+  ///
+  /// Records of CallbackDataBase indexed by the ACPI SMI_STS bit gating their source,
+  /// so the dispatcher only evaluates the records whose top level status is pending.
+  /// SourceIndexMask has a bit set for every non-empty SMI_STS bit list.
+  ///
+  LIST_ENTRY                  SourceIndex[PCH_SMM_SMI_STS_SOURCE_MAX];
+  UINT32                      SourceIndexMask;
+  UINTN                       NextSequence;
 } PRIVATE_DATA;
 
 extern PRIVATE_DATA           mPrivateData;
@@ -623,6 +642,17 @@ SmmCoreInsertRecord (
   OUT EFI_HANDLE                        *DispatchHandle
   );
 
+/**
+  The internal function used to take a database record out of the database
+  and its SMI_STS bit source index. The record is not freed.
+
+  @param[in] Record                     Record to remove from database.
+**/
+VOID
+SmmCoreRemoveRecord (
+  IN DATABASE_RECORD                    *Record
+  );
+
 /**
   Get the Sleep type
 
@@ -9,6 +9,7 @@
 #include "PchSmmHelpers.h"
 #include "PchSmmEspi.h"
 #include <Library/SmiHandlerProfileLib.h>
+#include <Library/SmmMemLib.h>
 #include <Register/GpioRegs.h>
 #include <Register/PmcRegs.h>
 #include <Register/RtcRegs.h>
@@ -25,6 +26,11 @@ GLOBAL_REMOVE_IF_UNREFERENCED UINT16                mTcoBaseAddr;
 GLOBAL_REMOVE_IF_UNREFERENCED BOOLEAN               mReadyToLock;
 GLOBAL_REMOVE_IF_UNREFERENCED BOOLEAN               mS3SusStart;
 
+//
+// Dispatch counters and residency time reported through gPchSmmDispatchStatisticsGuid
+//
+GLOBAL_REMOVE_IF_UNREFERENCED PCH_SMM_DISPATCH_STATISTICS  mPchSmmDispatchStatistics;
+
 GLOBAL_REMOVE_IF_UNREFERENCED PRIVATE_DATA          mPrivateData = {
   {
     NULL,
@@ -169,6 +175,63 @@ SmmReadyToLockCallback (
   return EFI_SUCCESS;
 }
 
+/**
+  SMM communicate handler reporting the PCH SMI dispatch statistics.
+
+  @param[in]     DispatchHandle  The unique handle assigned to this handler by SmiHandlerRegister().
+  @param[in]     Context         Not used.
+  @param[in,out] CommBuffer      Points to PCH_SMM_DISPATCH_STATISTICS_COMMUNICATE.
+  @param[in,out] CommBufferSize  The size of the CommBuffer.
+
+  @retval EFI_SUCCESS            The request was handled, see ReturnStatus for the result.
+**/
+EFI_STATUS
+EFIAPI
+PchSmmDispatchStatisticsHandler (
+  IN     EFI_HANDLE                       DispatchHandle,
+  IN     CONST VOID                       *Context         OPTIONAL,
+  IN OUT VOID                             *CommBuffer      OPTIONAL,
+  IN OUT UINTN                            *CommBufferSize  OPTIONAL
+  )
+{
+  PCH_SMM_DISPATCH_STATISTICS_COMMUNICATE *Parameter;
+  UINTN                                   TempCommBufferSize;
+
+  if ((CommBuffer == NULL) || (CommBufferSize == NULL)) {
+    return EFI_SUCCESS;
+  }
+
+  TempCommBufferSize = *CommBufferSize;
+  if (TempCommBufferSize < sizeof (PCH_SMM_DISPATCH_STATISTICS_COMMUNICATE)) {
+    DEBUG ((DEBUG_ERROR, "PchSmmDispatchStatisticsHandler: SMM communication buffer size invalid!\n"));
+    return EFI_SUCCESS;
+  }
+
+  if (!SmmIsBufferOutsideSmmValid ((UINTN) CommBuffer, TempCommBufferSize)) {
+    DEBUG ((DEBUG_ERROR, "PchSmmDispatchStatisticsHandler: SMM communication buffer in SMRAM or overflow!\n"));
+    return EFI_SUCCESS;
+  }
+
+  Parameter = (PCH_SMM_DISPATCH_STATISTICS_COMMUNICATE *) CommBuffer;
+  switch (Parameter->Function) {
+    case PCH_SMM_DISPATCH_STATISTICS_FUNCTION_GET:
+      CopyMem (&Parameter->Statistics, &mPchSmmDispatchStatistics, sizeof (PCH_SMM_DISPATCH_STATISTICS));
+      Parameter->ReturnStatus = EFI_SUCCESS;
+      break;
+
+    case PCH_SMM_DISPATCH_STATISTICS_FUNCTION_RESET:
+      ZeroMem (&mPchSmmDispatchStatistics, sizeof (PCH_SMM_DISPATCH_STATISTICS));
+      Parameter->ReturnStatus = EFI_SUCCESS;
+      break;
+
+    default:
+      Parameter->ReturnStatus = (UINT64) EFI_UNSUPPORTED;
+      break;
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   <b>PchSmiDispatcher SMM Module Entry Point</b>\n
   - <b>Introduction</b>\n
@@ -219,6 +282,8 @@ InitializePchSmmDispatcher (
 {
   EFI_STATUS           Status;
   VOID                 *SmmReadyToLockRegistration;
+  EFI_HANDLE           StatisticsHandle;
+  UINTN                SourceIndex;
 
   mS3SusStart = FALSE;
   //
@@ -241,9 +306,21 @@ InitializePchSmmDispatcher (
   Status = gSmst->SmiHandlerRegister (PchSmmCoreDispatcher, NULL, &mPrivateData.SmiHandle);
   ASSERT_EFI_ERROR (Status);
   //
-  // Initialize Callback DataBase
+  // Initialize Callback DataBase and its SMI_STS bit index
   //
   InitializeListHead (&mPrivateData.CallbackDataBase);
+  for (SourceIndex = 0; SourceIndex < PCH_SMM_SMI_STS_SOURCE_MAX; SourceIndex++) {
+    InitializeListHead (&mPrivateData.SourceIndex[SourceIndex]);
+  }
+  mPrivateData.SourceIndexMask = 0;
+  mPrivateData.NextSequence    = 0;
+
+  //
+  // Report dispatch counters and residency time through SMM communicate
+  //
+  StatisticsHandle = NULL;
+  Status = gSmst->SmiHandlerRegister (PchSmmDispatchStatisticsHandler, &gPchSmmDispatchStatisticsGuid, &StatisticsHandle);
+  ASSERT_EFI_ERROR (Status);
 
   //
   // Enable SMIs on the PCH now that we have a callback
@@ -273,6 +350,40 @@ InitializePchSmmDispatcher (
   return EFI_SUCCESS;
 }
 
+/**
+  Get the slot of the SMI_STS bit source index a source description belongs to.
+
+  A source is indexed by the ACPI SMI_STS bit that must be set for it to be active.
+  Its own status bit is preferred over the top level PMC status, so sources that
+  CompareSources () reports as equal always end up in the same slot.
+
+  @param[in] SrcDesc                    Pointer to the PCH SMI source description table
+
+  @retval SMI_STS bit number, or PCH_SMM_SMI_STS_SOURCE_OTHER if no SMI_STS bit gates the source.
+**/
+STATIC
+UINTN
+GetSourceIndex (
+  IN CONST PCH_SMM_SOURCE_DESC          *SrcDesc
+  )
+{
+  if (!IS_BIT_DESC_NULL (SrcDesc->Sts[0]) &&
+      (SrcDesc->Sts[0].Reg.Type == ACPI_ADDR_TYPE) &&
+      (SrcDesc->Sts[0].Reg.Data.acpi == R_ACPI_IO_SMI_STS) &&
+      (SrcDesc->Sts[0].Bit < 32))
+  {
+    return SrcDesc->Sts[0].Bit;
+  }
+  if (!IS_BIT_DESC_NULL (SrcDesc->PmcSmiSts) &&
+      (SrcDesc->PmcSmiSts.Reg.Type == ACPI_ADDR_TYPE) &&
+      (SrcDesc->PmcSmiSts.Reg.Data.acpi == R_ACPI_IO_SMI_STS) &&
+      (SrcDesc->PmcSmiSts.Bit < 32))
+  {
+    return SrcDesc->PmcSmiSts.Bit;
+  }
+  return PCH_SMM_SMI_STS_SOURCE_OTHER;
+}
+
 /**
   The internal function used to create and insert a database record
 
@@ -311,6 +422,17 @@ SmmCoreInsertRecord (
   //
   InsertTailList (&mPrivateData.CallbackDataBase, &Record->Link);
 
+  //
+  // Index the record by the SMI_STS bit of its source. Records are appended in
+  // registration order, so each index list stays sorted by Sequence.
+  //
+  Record->Sequence    = mPrivateData.NextSequence++;
+  Record->SourceIndex = GetSourceIndex (&Record->SrcDesc);
+  InsertTailList (&mPrivateData.SourceIndex[Record->SourceIndex], &Record->SourceLink);
+  if (Record->SourceIndex != PCH_SMM_SMI_STS_SOURCE_OTHER) {
+    mPrivateData.SourceIndexMask |= (1u << Record->SourceIndex);
+  }
+
   //
   // Child's handle will be the address linked list link in the record
   //
@@ -319,6 +441,26 @@ SmmCoreInsertRecord (
   return EFI_SUCCESS;
 }
 
+/**
+  The internal function used to take a database record out of the database
+  and its SMI_STS bit source index. The record is not freed.
+
+  @param[in] Record                     Record to remove from database.
+**/
+VOID
+SmmCoreRemoveRecord (
+  IN DATABASE_RECORD                    *Record
+  )
+{
+  RemoveEntryList (&Record->Link);
+  RemoveEntryList (&Record->SourceLink);
+  if ((Record->SourceIndex != PCH_SMM_SMI_STS_SOURCE_OTHER) &&
+      IsListEmpty (&mPrivateData.SourceIndex[Record->SourceIndex]))
+  {
+    mPrivateData.SourceIndexMask &= ~(1u << Record->SourceIndex);
+  }
+}
+
 /**
   Unregister a child SMI source dispatch function with a parent SMM driver
 
@@ -582,7 +724,7 @@ PchSmmCoreUnRegister (
     return EFI_INVALID_PARAMETER;
   }
 
-  RemoveEntryList (&RecordToDelete->Link);
+  SmmCoreRemoveRecord (RecordToDelete);
 
   //
   // Loop through all the souces in record linked list to see if any source enable is equal.
@@ -659,6 +801,92 @@ ClearPendingSmiStatus (
   }
 }
 
+/**
+  Find the first registered record in one SMI_STS bit index list whose source is active.
+
+  @param[in] SourceList                 Index list to search
+  @param[in] SciEn                      Sci Enable status
+  @param[in] SmiEnValue                 Value from R_ACPI_IO_SMI_EN
+  @param[in] SmiStsValue                Value from R_ACPI_IO_SMI_STS
+  @param[in] Candidate                  Active record found so far, or NULL
+
+  @retval The active record registered first among Candidate and the records of SourceList.
+**/
+STATIC
+DATABASE_RECORD *
+FindActiveRecordInSource (
+  IN LIST_ENTRY                         *SourceList,
+  IN BOOLEAN                            SciEn,
+  IN UINT32                             SmiEnValue,
+  IN UINT32                             SmiStsValue,
+  IN DATABASE_RECORD                    *Candidate
+  )
+{
+  LIST_ENTRY                            *Link;
+  DATABASE_RECORD                       *Record;
+
+  Link = GetFirstNode (SourceList);
+  while (!IsNull (SourceList, Link)) {
+    Record = DATABASE_RECORD_FROM_SOURCE_LINK (Link);
+    //
+    // The list is sorted by Sequence, nothing after a later record can win
+    //
+    if ((Candidate != NULL) && (Record->Sequence > Candidate->Sequence)) {
+      break;
+    }
+    if (SourceIsActive (&Record->SrcDesc, SciEn, SmiEnValue, SmiStsValue)) {
+      return Record;
+    }
+    Link = GetNextNode (SourceList, Link);
+  }
+  return Candidate;
+}
+
+/**
+  Find the active record registered first, looking only at the records whose
+  SMI_STS bit is set in the cached SMI_STS value and at the records that are
+  not gated by a SMI_STS bit.
+
+  @param[in] SciEn                      Sci Enable status
+  @param[in] SmiEnValue                 Value from R_ACPI_IO_SMI_EN
+  @param[in] SmiStsValue                Value from R_ACPI_IO_SMI_STS
+
+  @retval The first active record in CallbackDataBase order, NULL if no source is active.
+**/
+STATIC
+DATABASE_RECORD *
+FindActiveRecord (
+  IN BOOLEAN                            SciEn,
+  IN UINT32                             SmiEnValue,
+  IN UINT32                             SmiStsValue
+  )
+{
+  DATABASE_RECORD                       *ActiveRecord;
+  UINT32                                PendingSources;
+  UINTN                                 SourceIndex;
+
+  ActiveRecord   = NULL;
+  PendingSources = SmiStsValue & mPrivateData.SourceIndexMask;
+  while (PendingSources != 0) {
+    SourceIndex     = (UINTN) LowBitSet32 (PendingSources);
+    PendingSources &= PendingSources - 1;
+    ActiveRecord    = FindActiveRecordInSource (
+                        &mPrivateData.SourceIndex[SourceIndex],
+                        SciEn,
+                        SmiEnValue,
+                        SmiStsValue,
+                        ActiveRecord
+                        );
+  }
+  return FindActiveRecordInSource (
+           &mPrivateData.SourceIndex[PCH_SMM_SMI_STS_SOURCE_OTHER],
+           SciEn,
+           SmiEnValue,
+           SmiStsValue,
+           ActiveRecord
+           );
+}
+
 /**
   The callback function to handle subsequent SMIs.  This callback will be called by SmmCoreDispatcher.
 
@@ -688,9 +916,11 @@ PchSmmCoreDispatcher (
   BOOLEAN             SxChildWasDispatched;
 
   DATABASE_RECORD     *RecordInDb;
-  LIST_ENTRY          *LinkInDb;
   DATABASE_RECORD     *RecordToExhaust;
   LIST_ENTRY          *LinkToExhaust;
+  LIST_ENTRY          *SourceList;
+  UINTN               SourceIndex;
+  PCH_SMM_CLEAR_SOURCE ClearSource;
 
   PCH_SMM_CONTEXT     Context;
   VOID                *CommBuffer;
@@ -702,9 +932,14 @@ PchSmmCoreDispatcher (
   UINT32              SmiStsValue;
   UINT8               Port74Save;
   UINT8               Port76Save;
+  UINT64              DispatchStartTick;
+  UINT64              CallbackStartTick;
+  UINT64              Ticks;
 
   PCH_SMM_SOURCE_DESC ActiveSource;
 
+  DispatchStartTick = AsmReadTsc ();
+
   //
   // Initialize ActiveSource
   //
@@ -732,8 +967,6 @@ PchSmmCoreDispatcher (
     while ((!EosSet) && (EscapeCount > 0)) {
       EscapeCount--;
 
-      LinkInDb = GetFirstNode (&mPrivateData.CallbackDataBase);
-
       //
       // Cache SciEn, SmiEnValue and SmiStsValue to determine if source is active
       //
@@ -741,151 +974,144 @@ PchSmmCoreDispatcher (
       SmiEnValue  = IoRead32 ((UINTN) (mAcpiBaseAddr + R_ACPI_IO_SMI_EN));
       SmiStsValue = IoRead32 ((UINTN) (mAcpiBaseAddr + R_ACPI_IO_SMI_STS));
 
-      while (!IsNull (&mPrivateData.CallbackDataBase, LinkInDb)) {
-        RecordInDb = DATABASE_RECORD_FROM_LINK (LinkInDb);
+      //
+      // look for the first active source, only the records indexed under a
+      // pending SMI_STS bit need to be checked
+      //
+      RecordInDb = FindActiveRecord (SciEn, SmiEnValue, SmiStsValue);
+      if (RecordInDb == NULL) {
+        mPchSmmDispatchStatistics.UnclaimedCount++;
+        //
+        // Clear pending SMI status before EOS
+        //
+        ClearPendingSmiStatus (SmiStsValue, SciEn);
+        EosSet = PchSmmSetAndCheckEos ();
+        continue;
+      }
+
+      //
+      // We found a source. If this is a sleep type, we have to go to
+      // appropriate sleep state anyway.No matter there is sleep child or not
+      //
+      if (RecordInDb->ProtocolType == SxType) {
+        SxChildWasDispatched = TRUE;
+      }
+      //
+      // "cache" the source description and don't query I/O anymore
+      //
+      CopyMem ((VOID *) &ActiveSource, (VOID *) &(RecordInDb->SrcDesc), sizeof (PCH_SMM_SOURCE_DESC));
+      ClearSource   = RecordInDb->ClearSource;
+      SourceIndex   = RecordInDb->SourceIndex;
+      SourceList    = &mPrivateData.SourceIndex[SourceIndex];
+      LinkToExhaust = &RecordInDb->SourceLink;
 
+      //
+      // exhaust the rest of the index list looking for the same source, records of
+      // the same source always share an index list
+      //
+      while (!IsNull (SourceList, LinkToExhaust)) {
+        RecordToExhaust = DATABASE_RECORD_FROM_SOURCE_LINK (LinkToExhaust);
         //
-        // look for the first active source
+        // RecordToExhaust->SourceLink might be removed (unregistered) by Callback function, and then the
+        // system will hang in ASSERT() while calling GetNextNode().
+        // To prevent the issue, we need to get next record in DB here (before Callback function).
         //
-        if (!SourceIsActive (&RecordInDb->SrcDesc, SciEn, SmiEnValue, SmiStsValue)) {
-          //
-          // Didn't find the source yet, keep looking
-          //
-          LinkInDb = GetNextNode (&mPrivateData.CallbackDataBase, &RecordInDb->Link);
+        LinkToExhaust = GetNextNode (SourceList, &RecordToExhaust->SourceLink);
 
+        if (CompareSources (&RecordToExhaust->SrcDesc, &ActiveSource)) {
           //
-          // if it's the last one, try to clear EOS
+          // These source descriptions are equal, so this callback should be
+          // dispatched.
           //
-          if (IsNull (&mPrivateData.CallbackDataBase, LinkInDb)) {
+          if (RecordToExhaust->ContextFunctions.GetContext != NULL) {
             //
-            // Clear pending SMI status before EOS
+            // This child requires that we get a calling context from
+            // hardware and compare that context to the one supplied
+            // by the child.
             //
-            ClearPendingSmiStatus (SmiStsValue, SciEn);
-            EosSet = PchSmmSetAndCheckEos ();
-          }
-        } else {
-          //
-          // We found a source. If this is a sleep type, we have to go to
-          // appropriate sleep state anyway.No matter there is sleep child or not
-          //
-          if (RecordInDb->ProtocolType == SxType) {
-            SxChildWasDispatched = TRUE;
-          }
-          //
-          // "cache" the source description and don't query I/O anymore
-          //
-          CopyMem ((VOID *) &ActiveSource, (VOID *) &(RecordInDb->SrcDesc), sizeof (PCH_SMM_SOURCE_DESC));
-          LinkToExhaust = LinkInDb;
+            ASSERT (RecordToExhaust->ContextFunctions.CmpContext != NULL);
 
-          //
-          // exhaust the rest of the queue looking for the same source
-          //
-          while (!IsNull (&mPrivateData.CallbackDataBase, LinkToExhaust)) {
-            RecordToExhaust = DATABASE_RECORD_FROM_LINK (LinkToExhaust);
             //
-            // RecordToExhaust->Link might be removed (unregistered) by Callback function, and then the
-            // system will hang in ASSERT() while calling GetNextNode().
-            // To prevent the issue, we need to get next record in DB here (before Callback function).
+            // Make sure contexts match before dispatching event to child
             //
-            LinkToExhaust = GetNextNode (&mPrivateData.CallbackDataBase, &RecordToExhaust->Link);
+            RecordToExhaust->ContextFunctions.GetContext (RecordToExhaust, &Context);
+            ContextsMatch = RecordToExhaust->ContextFunctions.CmpContext (&Context, &RecordToExhaust->ChildContext);
 
-            if (CompareSources (&RecordToExhaust->SrcDesc, &ActiveSource)) {
+          } else {
+            //
+            // This child doesn't require any more calling context beyond what
+            // it supplied in registration.  Simply pass back what it gave us.
+            //
+            Context       = RecordToExhaust->ChildContext;
+            ContextsMatch = TRUE;
+          }
+
+          if (ContextsMatch) {
+            CallbackStartTick = AsmReadTsc ();
+            if (RecordToExhaust->ProtocolType == PchSmiDispatchType) {
               //
-              // These source descriptions are equal, so this callback should be
-              // dispatched.
+              // For PCH SMI dispatch protocols
               //
-              if (RecordToExhaust->ContextFunctions.GetContext != NULL) {
-                //
-                // This child requires that we get a calling context from
-                // hardware and compare that context to the one supplied
-                // by the child.
-                //
-                ASSERT (RecordToExhaust->ContextFunctions.CmpContext != NULL);
-
-                //
-                // Make sure contexts match before dispatching event to child
-                //
-                RecordToExhaust->ContextFunctions.GetContext (RecordToExhaust, &Context);
-                ContextsMatch = RecordToExhaust->ContextFunctions.CmpContext (&Context, &RecordToExhaust->ChildContext);
-
-              } else {
-                //
-                // This child doesn't require any more calling context beyond what
-                // it supplied in registration.  Simply pass back what it gave us.
-                //
-                Context       = RecordToExhaust->ChildContext;
-                ContextsMatch = TRUE;
+              PchSmiTypeCallbackDispatcher (RecordToExhaust);
+            } else {
+              if ((RecordToExhaust->ProtocolType == SxType) && (Context.Sx.Type == SxS3) && (Context.Sx.Phase == SxEntry) && !mS3SusStart) {
+                REPORT_STATUS_CODE (EFI_PROGRESS_CODE, PROGRESS_CODE_S3_SUSPEND_START);
+                mS3SusStart = TRUE;
               }
-
-              if (ContextsMatch) {
-                if (RecordToExhaust->ProtocolType == PchSmiDispatchType) {
+              //
+              // For EFI standard SMI dispatch protocols
+              //
+              if (RecordToExhaust->Callback != NULL) {
+                if (RecordToExhaust->ContextFunctions.GetCommBuffer != NULL) {
                   //
-                  // For PCH SMI dispatch protocols
+                  // This callback function needs CommBuffer and CommBufferSize.
+                  // Get those from child and then pass to callback function.
                   //
-                  PchSmiTypeCallbackDispatcher (RecordToExhaust);
+                  RecordToExhaust->ContextFunctions.GetCommBuffer (RecordToExhaust, &CommBuffer, &CommBufferSize);
                 } else {
-                  if ((RecordToExhaust->ProtocolType == SxType) && (Context.Sx.Type == SxS3) && (Context.Sx.Phase == SxEntry) && !mS3SusStart) {
-                    REPORT_STATUS_CODE (EFI_PROGRESS_CODE, PROGRESS_CODE_S3_SUSPEND_START);
-                    mS3SusStart = TRUE;
-                  }
                   //
-                  // For EFI standard SMI dispatch protocols
+                  // Child doesn't support the CommBuffer and CommBufferSize.
+                  // Just pass NULL value to callback function.
                   //
-                  if (RecordToExhaust->Callback != NULL) {
-                    if (RecordToExhaust->ContextFunctions.GetCommBuffer != NULL) {
-                      //
-                      // This callback function needs CommBuffer and CommBufferSize.
-                      // Get those from child and then pass to callback function.
-                      //
-                      RecordToExhaust->ContextFunctions.GetCommBuffer (RecordToExhaust, &CommBuffer, &CommBufferSize);
-                    } else {
-                      //
-                      // Child doesn't support the CommBuffer and CommBufferSize.
-                      // Just pass NULL value to callback function.
-                      //
-                      CommBuffer     = NULL;
-                      CommBufferSize = 0;
-                    }
-
-                    PERF_START_EX (NULL, "SmmFunction", NULL, AsmReadTsc (), RecordToExhaust->ProtocolType);
-                    RecordToExhaust->Callback ((EFI_HANDLE) & RecordToExhaust->Link, &Context, CommBuffer, &CommBufferSize);
-                    PERF_END_EX (NULL, "SmmFunction", NULL, AsmReadTsc (), RecordToExhaust->ProtocolType);
-                    if (RecordToExhaust->ProtocolType == SxType) {
-                      SxChildWasDispatched = TRUE;
-                    }
-                  } else {
-                    ASSERT (FALSE);
-                  }
+                  CommBuffer     = NULL;
+                  CommBufferSize = 0;
                 }
+
+                PERF_START_EX (NULL, "SmmFunction", NULL, AsmReadTsc (), RecordToExhaust->ProtocolType);
+                RecordToExhaust->Callback ((EFI_HANDLE) & RecordToExhaust->Link, &Context, CommBuffer, &CommBufferSize);
+                PERF_END_EX (NULL, "SmmFunction", NULL, AsmReadTsc (), RecordToExhaust->ProtocolType);
+                if (RecordToExhaust->ProtocolType == SxType) {
+                  SxChildWasDispatched = TRUE;
+                }
+              } else {
+                ASSERT (FALSE);
               }
             }
+            mPchSmmDispatchStatistics.Source[SourceIndex].DispatchCount++;
+            mPchSmmDispatchStatistics.Source[SourceIndex].DispatchTicks += AsmReadTsc () - CallbackStartTick;
           }
-
-          if (RecordInDb->ClearSource == NULL) {
-            //
-            // Clear the SMI associated w/ the source using the default function
-            //
-            PchSmmClearSource (&ActiveSource);
-          } else {
-            //
-            // This source requires special handling to clear
-            //
-            RecordInDb->ClearSource (&ActiveSource);
-          }
-          //
-          // Clear pending SMI status before EOS
-          //
-          ClearPendingSmiStatus (SmiStsValue, SciEn);
-          //
-          // Also, try to clear EOS
-          //
-          EosSet = PchSmmSetAndCheckEos ();
-          //
-          // Queue is empty, reset the search
-          //
-          break;
         }
       }
+
+      if (ClearSource == NULL) {
+        //
+        // Clear the SMI associated w/ the source using the default function
+        //
+        PchSmmClearSource (&ActiveSource);
+      } else {
+        //
+        // This source requires special handling to clear
+        //
+        ClearSource (&ActiveSource);
+      }
+      //
+      // Clear pending SMI status before EOS
+      //
+      ClearPendingSmiStatus (SmiStsValue, SciEn);
+      //
+      // Also, try to clear EOS
+      //
+      EosSet = PchSmmSetAndCheckEos ();
     }
   }
   //
@@ -922,5 +1148,12 @@ PchSmmCoreDispatcher (
   IoWrite8 (R_RTC_IO_EXT_INDEX_ALT, Port76Save);
   IoWrite8 (R_RTC_IO_INDEX_ALT, Port74Save);
 
+  Ticks = AsmReadTsc () - DispatchStartTick;
+  mPchSmmDispatchStatistics.SmiCount++;
+  mPchSmmDispatchStatistics.ResidencyTicks += Ticks;
+  if (Ticks > mPchSmmDispatchStatistics.MaxResidencyTicks) {
+    mPchSmmDispatchStatistics.MaxResidencyTicks = Ticks;
+  }
+
   return Status;
 }
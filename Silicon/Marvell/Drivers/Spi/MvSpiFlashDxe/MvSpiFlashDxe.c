@@ -283,46 +283,57 @@ MvSpiFlashWrite (
   return EFI_SUCCESS;
 }
 
+STATIC
+BOOLEAN
+MvSpiFlashIsErased (
+  IN UINT8 *Buf,
+  IN UINTN Length
+  )
+{
+  while (Length--) {
+    if (*Buf++ != 0xFF) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+  Program the pages of a range that need it.
+
+  With Current given, only pages whose data differs from it are programmed.
+  Without it the range is assumed erased and only pages holding data other
+  than 0xFF are programmed.
+**/
 STATIC
 EFI_STATUS
-MvSpiFlashUpdateBlock (
+MvSpiFlashProgramPages (
   IN SPI_DEVICE *Slave,
   IN UINT32 Offset,
-  IN UINTN ToUpdate,
+  IN UINTN Length,
   IN UINT8 *Buf,
-  IN UINT8 *TmpBuf,
-  IN UINTN EraseSize
+  IN UINT8 *Current OPTIONAL
   )
 {
   EFI_STATUS Status;
+  UINTN PageSize, Index, ChunkLength;
 
-  // Read backup
-  Status = MvSpiFlashRead (Slave, Offset, EraseSize, TmpBuf);
-    if (EFI_ERROR (Status)) {
-      DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while reading old data\n"));
-      return Status;
-    }
+  PageSize = Slave->Info->PageSize;
 
-  // Erase entire sector
-  Status = MvSpiFlashErase (Slave, Offset, EraseSize);
-  if (EFI_ERROR (Status)) {
-      DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while erasing block\n"));
-      return Status;
-    }
+  for (Index = 0; Index < Length; Index += ChunkLength) {
+    ChunkLength = MIN (Length - Index, PageSize - ((Offset + Index) % PageSize));
 
-  // Write new data
-  MvSpiFlashWrite (Slave, Offset, ToUpdate, Buf);
-  if (EFI_ERROR (Status)) {
-      DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while writing new data\n"));
-      return Status;
+    if (Current != NULL) {
+      if (CompareMem (&Buf[Index], &Current[Index], ChunkLength) == 0) {
+        continue;
+      }
+    } else if (MvSpiFlashIsErased (&Buf[Index], ChunkLength)) {
+      continue;
     }
 
-  // Write backup
-  if (ToUpdate != EraseSize) {
-    Status = MvSpiFlashWrite (Slave, Offset + ToUpdate, EraseSize - ToUpdate,
-      &TmpBuf[ToUpdate]);
+    Status = MvSpiFlashWrite (Slave, (UINT32)(Offset + Index), ChunkLength,
+               &Buf[Index]);
     if (EFI_ERROR (Status)) {
-      DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while writing backup\n"));
       return Status;
     }
   }
@@ -330,50 +341,81 @@ MvSpiFlashUpdateBlock (
   return EFI_SUCCESS;
 }
 
+/**
+  Update the beginning of one sector, touching the flash only as needed.
+
+  The sector is read once and compared with the new data:
+  - identical: nothing is done,
+  - new data only clears bits: the changed pages are programmed without erase,
+  - otherwise: the sector is erased and the pages that are not blank in the
+    merged image of new data and preserved old data are programmed.
+**/
+STATIC
 EFI_STATUS
-MvSpiFlashUpdate (
+MvSpiFlashUpdateBlock (
   IN SPI_DEVICE *Slave,
   IN UINT32 Offset,
-  IN UINTN ByteCount,
-  IN UINT8 *Buf
+  IN UINTN ToUpdate,
+  IN UINT8 *Buf,
+  IN UINT8 *TmpBuf,
+  IN UINTN EraseSize
   )
 {
   EFI_STATUS Status;
-  UINT64 SectorSize, ToUpdate, Scale = 1;
-  UINT8 *TmpBuf, *End;
-
-  SectorSize = Slave->Info->SectorSize;
-
-  End = Buf + ByteCount;
+  BOOLEAN NeedErase;
+  UINTN Index;
 
-  TmpBuf = (UINT8 *)AllocateZeroPool (SectorSize);
-  if (TmpBuf == NULL) {
-    DEBUG((DEBUG_ERROR, "SpiFlash: Cannot allocate memory\n"));
-    return EFI_OUT_OF_RESOURCES;
+  // Read current content
+  Status = MvSpiFlashRead (Slave, Offset, EraseSize, TmpBuf);
+  if (EFI_ERROR (Status)) {
+    DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while reading old data\n"));
+    return Status;
   }
 
-  if (End - Buf >= 200)
-    Scale = (End - Buf) / 100;
+  if (CompareMem (TmpBuf, Buf, ToUpdate) == 0) {
+    return EFI_SUCCESS;
+  }
 
-  for (; Buf < End; Buf += ToUpdate, Offset += ToUpdate) {
-    ToUpdate = MIN((UINT64)(End - Buf), SectorSize);
-    Print (L"   \rUpdating, %d%%", 100 - (End - Buf) / Scale);
-    Status = MvSpiFlashUpdateBlock (Slave, Offset, ToUpdate, Buf, TmpBuf, SectorSize);
+  // NOR programming can only clear bits
+  NeedErase = FALSE;
+  for (Index = 0; Index < ToUpdate; Index++) {
+    if ((TmpBuf[Index] & Buf[Index]) != Buf[Index]) {
+      NeedErase = TRUE;
+      break;
+    }
+  }
 
+  if (!NeedErase) {
+    Status = MvSpiFlashProgramPages (Slave, Offset, ToUpdate, Buf, TmpBuf);
     if (EFI_ERROR (Status)) {
-      DEBUG((DEBUG_ERROR, "SpiFlash: Error while updating\n"));
-      return Status;
+      DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while writing new data\n"));
     }
+    return Status;
   }
 
-  Print(L"\n");
-  FreePool (TmpBuf);
+  // Build the new sector image, keeping the old data past the update
+  CopyMem (TmpBuf, Buf, ToUpdate);
+
+  // Erase entire sector
+  Status = MvSpiFlashErase (Slave, Offset, EraseSize);
+  if (EFI_ERROR (Status)) {
+    DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while erasing block\n"));
+    return Status;
+  }
+
+  // Write new data and backup
+  Status = MvSpiFlashProgramPages (Slave, Offset, EraseSize, TmpBuf, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG((DEBUG_ERROR, "SpiFlash: Update: Error while writing new data\n"));
+    return Status;
+  }
 
   return EFI_SUCCESS;
 }
 
+STATIC
 EFI_STATUS
-MvSpiFlashUpdateWithProgress (
+MvSpiFlashUpdateSectors (
   IN SPI_DEVICE                                    *Slave,
   IN UINT32                                         Offset,
   IN UINTN                                          ByteCount,
@@ -385,14 +427,11 @@ MvSpiFlashUpdateWithProgress (
 {
   EFI_STATUS Status;
   UINTN SectorSize;
-  UINTN SectorNum;
   UINTN ToUpdate;
   UINTN Index;
   UINT8 *TmpBuf;
 
   SectorSize = Slave->Info->SectorSize;
-  SectorNum = (ByteCount / SectorSize) + 1;
-  ToUpdate = SectorSize;
 
   TmpBuf = (UINT8 *)AllocateZeroPool (SectorSize);
   if (TmpBuf == NULL) {
@@ -400,25 +439,24 @@ MvSpiFlashUpdateWithProgress (
     return EFI_OUT_OF_RESOURCES;
   }
 
-  for (Index = 0; Index < SectorNum; Index++) {
+  for (Index = 0; Index < ByteCount; Index += ToUpdate) {
     if (Progress != NULL) {
       Progress (StartPercentage +
-                ((Index * (EndPercentage - StartPercentage)) / SectorNum));
+                ((Index * (EndPercentage - StartPercentage)) / ByteCount));
     }
 
     // In the last chunk update only an actual number of remaining bytes.
-    if (Index + 1 == SectorNum) {
-      ToUpdate = ByteCount % SectorSize;
-    }
+    ToUpdate = MIN (ByteCount - Index, SectorSize);
 
     Status = MvSpiFlashUpdateBlock (Slave,
-               Offset + Index * SectorSize,
+               (UINT32)(Offset + Index),
                ToUpdate,
-               Buffer + Index * SectorSize,
+               Buffer + Index,
                TmpBuf,
                SectorSize);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a: Error while updating\n", __FUNCTION__));
+      FreePool (TmpBuf);
       return Status;
     }
   }
@@ -431,6 +469,62 @@ MvSpiFlashUpdateWithProgress (
   return EFI_SUCCESS;
 }
 
+STATIC UINTN mMvSpiFlashLastPercentage;
+
+STATIC
+EFI_STATUS
+EFIAPI
+MvSpiFlashPrintProgress (
+  IN UINTN Completion
+  )
+{
+  if (Completion != mMvSpiFlashLastPercentage) {
+    mMvSpiFlashLastPercentage = Completion;
+    Print (L"   \rUpdating, %d%%", Completion);
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+MvSpiFlashUpdate (
+  IN SPI_DEVICE *Slave,
+  IN UINT32 Offset,
+  IN UINTN ByteCount,
+  IN UINT8 *Buf
+  )
+{
+  EFI_STATUS Status;
+
+  // Print only when the percentage changes, not for every sector
+  mMvSpiFlashLastPercentage = MAX_UINTN;
+  Status = MvSpiFlashUpdateSectors (Slave, Offset, ByteCount, Buf,
+             MvSpiFlashPrintProgress, 0, 100);
+  if (EFI_ERROR (Status)) {
+    DEBUG((DEBUG_ERROR, "SpiFlash: Error while updating\n"));
+    return Status;
+  }
+
+  Print(L"\n");
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+MvSpiFlashUpdateWithProgress (
+  IN SPI_DEVICE                                    *Slave,
+  IN UINT32                                         Offset,
+  IN UINTN                                          ByteCount,
+  IN UINT8                                         *Buffer,
+  IN EFI_FIRMWARE_MANAGEMENT_UPDATE_IMAGE_PROGRESS  Progress,        OPTIONAL
+  IN UINTN                                          StartPercentage,
+  IN UINTN                                          EndPercentage
+  )
+{
+  return MvSpiFlashUpdateSectors (Slave, Offset, ByteCount, Buffer,
+           Progress, StartPercentage, EndPercentage);
+}
+
 EFI_STATUS
 EFIAPI
 MvSpiFlashReadId (